@@ -0,0 +1,111 @@
+// AltTripRouter.cpp
+//
+// ICS 46 Winter 2019
+// Project #4: Rock and Roll Stops the Traffic
+
+#include <cstdio>
+#include <fstream>
+#include "AltTripRouter.hpp"
+#include "RoadMapWeights.hpp"
+
+
+AltTripRouter::AltTripRouter(
+    const RoadMap& roadMap, int landmarkCount, const std::string& tableFile)
+    : distanceGraph{compactRoadMap(roadMap, TripMetric::Distance)},
+      timeGraph{compactRoadMap(roadMap, TripMetric::Time)},
+      loaded{false}, saved{false}
+{
+    if(!tableFile.empty())
+    {
+        std::ifstream in{tableFile, std::ios::binary};
+        if(in)
+        {
+            try
+            {
+                LandmarkTable savedDistanceTable;
+                LandmarkTable savedTimeTable;
+                savedDistanceTable.load(in, distanceGraph);
+                savedTimeTable.load(in, timeGraph);
+
+                if(savedDistanceTable.landmarkCount() == landmarkCount &&
+                   savedTimeTable.landmarkCount() == landmarkCount)
+                {
+                    distanceTable = std::move(savedDistanceTable);
+                    timeTable = std::move(savedTimeTable);
+                    loaded = true;
+                }
+            }
+            catch(LandmarkTableException&)
+            {
+                //stale or damaged, so it's rebuilt below
+            }
+        }
+    }
+
+    if(!loaded)
+    {
+        distanceTable = LandmarkTable{distanceGraph, landmarkCount};
+        timeTable = LandmarkTable{timeGraph, landmarkCount};
+
+        //the tables are written to a partial file that's renamed only
+        //once it's complete, so a failed or interrupted save never leaves
+        //a damaged file in place of a good one
+        if(!tableFile.empty())
+        {
+            std::string partialName = tableFile + ".partial";
+            std::ofstream out{partialName, std::ios::binary | std::ios::trunc};
+            if(out)
+            {
+                distanceTable.save(out);
+                timeTable.save(out);
+                out.close();
+            }
+            saved = out && std::rename(partialName.c_str(), tableFile.c_str()) == 0;
+            if(!saved)
+            {
+                std::remove(partialName.c_str());
+            }
+        }
+    }
+}
+
+
+void AltTripRouter::findPath(const Trip& trip, std::vector<int>& path) const
+{
+    thread_local SearchWorkspace<double> workspace;
+
+    bool byTime = trip.metric == TripMetric::Time;
+    const CompactDigraph<double>& graph = byTime ? timeGraph : distanceGraph;
+
+    findShortestPathAlt(
+        graph, byTime ? timeTable : distanceTable,
+        graph.indexOf(trip.startVertex), graph.indexOf(trip.endVertex), workspace, path);
+
+    for(int& vertex : path)
+    {
+        vertex = graph.vertexNumber(vertex);
+    }
+}
+
+
+bool AltTripRouter::loadedFromFile() const noexcept
+{
+    return loaded;
+}
+
+
+bool AltTripRouter::savedToFile() const noexcept
+{
+    return saved;
+}
+
+
+MemoryUsage AltTripRouter::memoryUsage() const
+{
+    MemoryUsage usage;
+    usage.add("distance snapshot", distanceGraph.byteCount());
+    usage.add("time snapshot", timeGraph.byteCount());
+    usage.add("distance landmarks", distanceTable.byteCount());
+    usage.add("time landmarks", timeTable.byteCount());
+    return usage;
+}
@@ -0,0 +1,61 @@
+// AltTripRouter.hpp
+//
+// ICS 46 Winter 2019
+// Project #4: Rock and Roll Stops the Traffic
+//
+// An AltTripRouter is a TripRouter that uses landmark lower bounds (see
+// LandmarkTable.hpp) to steer each search toward the trip's destination,
+// keeping one LandmarkTable per TripMetric.  Because the maps this program
+// reads have no coordinates, landmarks are the only source of such bounds.
+//
+// The tables can be kept in a file so that they survive restarts: if the
+// file holds tables built for the same map, they're loaded from it;
+// otherwise they're built from scratch and written to it.
+
+#ifndef ALTTRIPROUTER_HPP
+#define ALTTRIPROUTER_HPP
+
+#include <string>
+#include <vector>
+#include "CompactDigraph.hpp"
+#include "LandmarkTable.hpp"
+#include "RoadMap.hpp"
+#include "TripRouter.hpp"
+
+
+
+class AltTripRouter : public TripRouter
+{
+public:
+    // Initializes an AltTripRouter for the given RoadMap with the given
+    // number of landmarks per metric.  If tableFile is not empty, tables
+    // are loaded from that file when possible and saved to it otherwise;
+    // they're written to tableFile + ".partial" first and renamed once
+    // they're complete.
+    AltTripRouter(const RoadMap& roadMap, int landmarkCount, const std::string& tableFile);
+
+    using TripRouter::findPath;
+    void findPath(const Trip& trip, std::vector<int>& path) const override;
+    MemoryUsage memoryUsage() const override;
+
+    // loadedFromFile() returns true if the tables were loaded from the
+    // table file rather than built.
+    bool loadedFromFile() const noexcept;
+
+    // savedToFile() returns true if the tables were built and then saved
+    // to the table file; if saving failed, the file is left as it was.
+    bool savedToFile() const noexcept;
+
+
+private:
+    CompactDigraph<double> distanceGraph;
+    CompactDigraph<double> timeGraph;
+    LandmarkTable distanceTable;
+    LandmarkTable timeTable;
+    bool loaded;
+    bool saved;
+};
+
+
+
+#endif // ALTTRIPROUTER_HPP
@@ -0,0 +1,41 @@
+// CachedTripRouter.cpp
+//
+// ICS 46 Winter 2019
+// Project #4: Rock and Roll Stops the Traffic
+
+#include <utility>
+#include "CachedTripRouter.hpp"
+
+
+CachedTripRouter::CachedTripRouter(TreeCache cache, const TripRouter& otherTrips)
+    : cache{std::move(cache)}, otherTrips{otherTrips}, cachedTrips{0}
+{
+}
+
+
+void CachedTripRouter::findPath(const Trip& trip, std::vector<int>& path) const
+{
+    if(trip.departureTime == noDepartureTime && cache.findPath(trip, path))
+    {
+        cachedTrips.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    otherTrips.findPath(trip, path);
+}
+
+
+MemoryUsage CachedTripRouter::memoryUsage() const
+{
+    //the trees are mapped from their file rather than allocated, so the
+    //operating system can drop them and read them back as it needs to
+    MemoryUsage usage;
+    usage.add("cached trees (mapped)", cache.byteCount());
+    return usage;
+}
+
+
+long CachedTripRouter::cachedTripCount() const noexcept
+{
+    return cachedTrips.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,48 @@
+// CachedTripRouter.hpp
+//
+// ICS 46 Winter 2019
+// Project #4: Rock and Roll Stops the Traffic
+//
+// A CachedTripRouter is a TripRouter that answers trips from the start
+// locations and metrics in a TreeCache (see TreeCache.hpp) by walking the
+// cached trees, and hands every other trip -- including every trip that
+// says when it leaves, since the trees are built from the segments' usual
+// speeds -- to another TripRouter.  Its paths are the ones
+// DijkstraTripRouter would find.
+
+#ifndef CACHEDTRIPROUTER_HPP
+#define CACHEDTRIPROUTER_HPP
+
+#include <atomic>
+#include <vector>
+#include "TreeCache.hpp"
+#include "TripRouter.hpp"
+
+
+
+class CachedTripRouter : public TripRouter
+{
+public:
+    // Initializes a CachedTripRouter that answers trips from the given
+    // cache's trees, and hands the rest to otherTrips, which must outlive
+    // it.
+    CachedTripRouter(TreeCache cache, const TripRouter& otherTrips);
+
+    using TripRouter::findPath;
+    void findPath(const Trip& trip, std::vector<int>& path) const override;
+    MemoryUsage memoryUsage() const override;
+
+    // cachedTripCount() returns the number of trips answered from the
+    // cache so far.
+    long cachedTripCount() const noexcept;
+
+
+private:
+    TreeCache cache;
+    const TripRouter& otherTrips;
+    mutable std::atomic<long> cachedTrips;
+};
+
+
+
+#endif // CACHEDTRIPROUTER_HPP
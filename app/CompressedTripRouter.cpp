@@ -0,0 +1,73 @@
+// CompressedTripRouter.cpp
+//
+// ICS 46 Winter 2019
+// Project #4: Rock and Roll Stops the Traffic
+
+#include <cmath>
+#include "CompressedTripRouter.hpp"
+#include "RoadMapWeights.hpp"
+
+
+namespace
+{
+    const double milesScale = 100.0;
+    const double speedScale = 100.0;
+
+
+    CompressedDigraph<2>::EdgeValues encodeSegment(const RoadSegment& segment)
+    {
+        return {static_cast<std::uint32_t>(std::lround(segment.miles * milesScale)),
+                static_cast<std::uint32_t>(std::lround(segment.milesPerHour * speedScale))};
+    }
+
+
+    RoadSegment decodeSegment(const CompressedDigraph<2>::EdgeValues& values)
+    {
+        return RoadSegment{values[0] / milesScale, values[1] / speedScale};
+    }
+}
+
+
+CompressedTripRouter::CompressedTripRouter(const RoadMap& roadMap)
+    : graph{roadMap, encodeSegment}
+{
+}
+
+
+void CompressedTripRouter::findPath(const Trip& trip, std::vector<int>& path) const
+{
+    thread_local SearchWorkspace<double> workspace;
+
+    int start = graph.indexOf(trip.startVertex);
+    int end = graph.indexOf(trip.endVertex);
+
+    withMetricWeight(trip.metric,
+        [&](auto weight)
+        {
+            findShortestPath(graph,
+                [&](const CompressedDigraph<2>::EdgeValues& values)
+                {
+                    return weight(decodeSegment(values));
+                },
+                start, end, workspace, path);
+        });
+
+    for(int& vertex : path)
+    {
+        vertex = graph.vertexNumber(vertex);
+    }
+}
+
+
+std::size_t CompressedTripRouter::byteCount() const noexcept
+{
+    return graph.byteCount();
+}
+
+
+MemoryUsage CompressedTripRouter::memoryUsage() const
+{
+    MemoryUsage usage;
+    usage.add("compressed segments", graph.byteCount());
+    return usage;
+}
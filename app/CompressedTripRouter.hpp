@@ -0,0 +1,46 @@
+// CompressedTripRouter.hpp
+//
+// ICS 46 Winter 2019
+// Project #4: Rock and Roll Stops the Traffic
+//
+// A CompressedTripRouter is a TripRouter that keeps the map in a single
+// CompressedDigraph (see CompressedDigraph.hpp) shared by both metrics,
+// rather than in a CompactDigraph per metric, so that it needs several
+// times less memory per road segment.  Each segment's length and speed are
+// stored in fixed point, in hundredths of a mile and hundredths of a mile
+// per hour, and turned back into a weight as the search reaches them; so
+// its paths match DijkstraTripRouter's for any map whose lengths and
+// speeds have no more than two decimal places.
+
+#ifndef COMPRESSEDTRIPROUTER_HPP
+#define COMPRESSEDTRIPROUTER_HPP
+
+#include <cstddef>
+#include <vector>
+#include "CompressedDigraph.hpp"
+#include "RoadMap.hpp"
+#include "TripRouter.hpp"
+
+
+
+class CompressedTripRouter : public TripRouter
+{
+public:
+    explicit CompressedTripRouter(const RoadMap& roadMap);
+
+    using TripRouter::findPath;
+    void findPath(const Trip& trip, std::vector<int>& path) const override;
+    MemoryUsage memoryUsage() const override;
+
+    // byteCount() returns the number of bytes the compressed map uses.
+    std::size_t byteCount() const noexcept;
+
+
+private:
+    // Each edge's values are its length and its speed.
+    CompressedDigraph<2> graph;
+};
+
+
+
+#endif // COMPRESSEDTRIPROUTER_HPP
@@ -0,0 +1,53 @@
+// ContractedTripRouter.cpp
+//
+// ICS 46 Winter 2019
+// Project #4: Rock and Roll Stops the Traffic
+
+#include "ContractedTripRouter.hpp"
+#include "RoadMapWeights.hpp"
+
+
+ContractedTripRouter::ContractedTripRouter(const RoadMap& roadMap)
+    : distanceGraph{compactRoadMap(roadMap, TripMetric::Distance)},
+      timeGraph{compactRoadMap(roadMap, TripMetric::Time)},
+      contraction{distanceGraph},
+      contractedDistanceGraph{contraction.contract(distanceGraph)},
+      contractedTimeGraph{contraction.contract(timeGraph)}
+{
+}
+
+
+void ContractedTripRouter::findPath(const Trip& trip, std::vector<int>& path) const
+{
+    thread_local SearchWorkspace<double> workspace;
+
+    bool byTime = trip.metric == TripMetric::Time;
+    const CompactDigraph<double>& graph = byTime ? timeGraph : distanceGraph;
+
+    contraction.findShortestPath(
+        graph, byTime ? contractedTimeGraph : contractedDistanceGraph,
+        graph.indexOf(trip.startVertex), graph.indexOf(trip.endVertex), workspace, path);
+
+    for(int& vertex : path)
+    {
+        vertex = graph.vertexNumber(vertex);
+    }
+}
+
+
+int ContractedTripRouter::keptLocationCount() const noexcept
+{
+    return contraction.keptVertexCount();
+}
+
+
+MemoryUsage ContractedTripRouter::memoryUsage() const
+{
+    MemoryUsage usage;
+    usage.add("distance snapshot", distanceGraph.byteCount());
+    usage.add("time snapshot", timeGraph.byteCount());
+    usage.add("chains", contraction.byteCount());
+    usage.add("contracted distance snapshot", contractedDistanceGraph.byteCount());
+    usage.add("contracted time snapshot", contractedTimeGraph.byteCount());
+    return usage;
+}
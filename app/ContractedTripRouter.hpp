@@ -0,0 +1,48 @@
+// ContractedTripRouter.hpp
+//
+// ICS 46 Winter 2019
+// Project #4: Rock and Roll Stops the Traffic
+//
+// A ContractedTripRouter searches a copy of the map in which the runs of
+// locations that merely join two road segments have been collapsed into
+// single segments (see ChainContraction.hpp), which leaves far fewer
+// locations for each search to visit on real road data.  The paths it
+// finds are expanded back out, so they still list every location along
+// the way.
+
+#ifndef CONTRACTEDTRIPROUTER_HPP
+#define CONTRACTEDTRIPROUTER_HPP
+
+#include <vector>
+#include "ChainContraction.hpp"
+#include "CompactDigraph.hpp"
+#include "RoadMap.hpp"
+#include "TripRouter.hpp"
+
+
+
+class ContractedTripRouter : public TripRouter
+{
+public:
+    explicit ContractedTripRouter(const RoadMap& roadMap);
+
+    using TripRouter::findPath;
+    void findPath(const Trip& trip, std::vector<int>& path) const override;
+    MemoryUsage memoryUsage() const override;
+
+    // keptLocationCount() returns the number of locations left in the
+    // contracted map.
+    int keptLocationCount() const noexcept;
+
+
+private:
+    CompactDigraph<double> distanceGraph;
+    CompactDigraph<double> timeGraph;
+    ChainContraction contraction;
+    CompactDigraph<double> contractedDistanceGraph;
+    CompactDigraph<double> contractedTimeGraph;
+};
+
+
+
+#endif // CONTRACTEDTRIPROUTER_HPP
@@ -33,7 +33,11 @@ std::string InputReader::readLine()
 
     while (true)
     {
-        std::getline(in_, line);
+        if (!std::getline(in_, line))
+        {
+            throw InputReaderException("unexpected end of input");
+        }
+        ++lineNumber_;
         trimRight(line);
 
         if (line.length() > 0 && line[0] != '#')
@@ -47,7 +51,16 @@ std::string InputReader::readLine()
 int InputReader::readIntLine()
 {
     std::string line = readLine();
-    return std::stoi(line);
+
+    try
+    {
+        return std::stoi(line);
+    }
+    catch (std::logic_error&)
+    {
+        //std::stoi() found no number, or one too big for an int
+        throw InputReaderException("expected a number, not \"" + line + "\"");
+    }
 }
 
 
@@ -7,22 +7,39 @@
 // lines of text from it, skipping lines that are not a meaningful part of
 // the input.  In this project, that means blank lines, lines containing
 // only spaces, and lines that begin with a '#' character.
+//
+// Reading past the end of the input throws an InputReaderException.
 
 #ifndef INPUTREADER_HPP
 #define INPUTREADER_HPP
 
 #include <istream>
+#include <stdexcept>
 #include <string>
 
 
 
+class InputReaderException : public std::runtime_error
+{
+public:
+    InputReaderException(const std::string& reason);
+};
+
+
+inline InputReaderException::InputReaderException(const std::string& reason)
+    : std::runtime_error{reason}
+{
+}
+
+
+
 class InputReader
 {
 public:
     // Initializes an InputReader so that it reads from the given input
     // stream.  For example, pass std::cin as a parameter to the constructor
     // if you want to read input from std::cin.
-    InputReader(std::istream& in): in_{in} { }
+    InputReader(std::istream& in): in_{in}, lineNumber_{0} { }
 
     // readLine() reads a line of input from the input stream associated
     // with this InputReader, skipping non-meaningful lines.
@@ -30,11 +47,18 @@ public:
 
     // readLineInt() reads a line of input from the input stream associated
     // with this InputReader, assuming that the line of input contains an
-    // integer value (e.g., "7").
+    // integer value (e.g., "7").  If it doesn't start with one, an
+    // InputReaderException is thrown.
     int readIntLine();
 
+    // lineNumber() returns the line number (counting from 1, and counting
+    // the lines that were skipped) of the line most recently read, or 0
+    // if nothing has been read yet.
+    int lineNumber() const noexcept { return lineNumber_; }
+
 private:
     std::istream& in_;
+    int lineNumber_;
 };
 
 
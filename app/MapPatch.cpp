@@ -0,0 +1,337 @@
+// MapPatch.cpp
+//
+// ICS 46 Winter 2019
+// Project #4: Rock and Roll Stops the Traffic
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <map>
+#include <sstream>
+#include <system_error>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include "MapPatch.hpp"
+
+
+namespace
+{
+    bool isMeaningful(const std::string& line)
+    {
+        for (char c : line)
+        {
+            if (!std::isspace(static_cast<unsigned char>(c)))
+            {
+                return c != '#';
+            }
+        }
+        return false;
+    }
+
+
+    //checks that nothing but whitespace is left on the line
+    bool atEnd(std::istringstream& fields)
+    {
+        std::string extra;
+        return !(fields >> extra);
+    }
+
+
+    MapPatchChange parseChange(const std::string& line, int lineNumber)
+    {
+        std::istringstream fields{line};
+        std::string kind;
+        fields >> kind;
+
+        MapPatchChange change{};
+        change.lineNumber = lineNumber;
+
+        if (kind == "+V")
+        {
+            change.kind = MapPatchChange::Kind::AddLocation;
+            if (fields >> change.fromVertex)
+            {
+                std::getline(fields >> std::ws, change.name);
+                while (!change.name.empty() && std::isspace(static_cast<unsigned char>(change.name.back())))
+                {
+                    change.name.pop_back();
+                }
+                if (!change.name.empty())
+                {
+                    return change;
+                }
+            }
+            throw MapPatchException("expected +V number name", lineNumber);
+        }
+        else if (kind == "-V")
+        {
+            change.kind = MapPatchChange::Kind::RemoveLocation;
+            if (fields >> change.fromVertex && atEnd(fields))
+            {
+                return change;
+            }
+            throw MapPatchException("expected -V number", lineNumber);
+        }
+        else if (kind == "+E")
+        {
+            change.kind = MapPatchChange::Kind::AddRoadSegment;
+            if (fields >> change.fromVertex >> change.toVertex
+                       >> change.segment.miles >> change.segment.milesPerHour &&
+                change.segment.miles >= 0 && change.segment.milesPerHour > 0)
+            {
+                //the speed profile is optional
+                std::string profile;
+                if (!(fields >> profile))
+                {
+                    return change;
+                }
+
+                std::from_chars_result result = std::from_chars(
+                    profile.data(), profile.data() + profile.size(), change.segment.speedProfile);
+                if (result.ec == std::errc{} && result.ptr == profile.data() + profile.size() &&
+                    change.segment.speedProfile >= 0 && atEnd(fields))
+                {
+                    return change;
+                }
+            }
+            throw MapPatchException("expected +E from to miles mph [profile]", lineNumber);
+        }
+        else if (kind == "-E")
+        {
+            change.kind = MapPatchChange::Kind::RemoveRoadSegment;
+            if (fields >> change.fromVertex >> change.toVertex && atEnd(fields))
+            {
+                return change;
+            }
+            throw MapPatchException("expected -E from to", lineNumber);
+        }
+        else if (kind == "~E")
+        {
+            change.kind = MapPatchChange::Kind::ChangeSpeed;
+            if (fields >> change.fromVertex >> change.toVertex >> change.segment.milesPerHour &&
+                change.segment.milesPerHour > 0 && atEnd(fields))
+            {
+                return change;
+            }
+            throw MapPatchException("expected ~E from to mph", lineNumber);
+        }
+
+        throw MapPatchException("unknown change " + kind, lineNumber);
+    }
+
+
+    //Keeps track of which locations and road segments will exist at each
+    //point in the patch, without changing the RoadMap, so that the whole
+    //patch can be checked before any of it is applied.  Only the
+    //locations and road segments the patch mentions are ever looked up.
+    class PatchChecker
+    {
+    public:
+        PatchChecker(const RoadMap& roadMap)
+            : roadMap{roadMap}
+        {
+        }
+
+        void check(const MapPatchChange& change)
+        {
+            switch (change.kind)
+            {
+            case MapPatchChange::Kind::AddLocation:
+                if (removed.count(change.fromVertex) != 0)
+                {
+                    fail(change, "location " + std::to_string(change.fromVertex) +
+                                 " is removed earlier in the patch");
+                }
+                if (exists(change.fromVertex))
+                {
+                    fail(change, "location " + std::to_string(change.fromVertex) + " already exists");
+                }
+                locations[change.fromVertex] = true;
+                break;
+
+            case MapPatchChange::Kind::RemoveLocation:
+                requireLocation(change, change.fromVertex);
+                locations[change.fromVertex] = false;
+                removed.insert(change.fromVertex);
+                break;
+
+            case MapPatchChange::Kind::AddRoadSegment:
+                requireLocation(change, change.fromVertex);
+                requireLocation(change, change.toVertex);
+                ++segmentCount(change.fromVertex, change.toVertex);
+                break;
+
+            case MapPatchChange::Kind::RemoveRoadSegment:
+                requireSegment(change);
+                --segmentCount(change.fromVertex, change.toVertex);
+                break;
+
+            case MapPatchChange::Kind::ChangeSpeed:
+                requireSegment(change);
+                break;
+            }
+        }
+
+    private:
+        bool exists(int vertex)
+        {
+            auto found = locations.find(vertex);
+            if (found == locations.end())
+            {
+                found = locations.emplace(vertex, roadMap.hasVertex(vertex)).first;
+            }
+            return found->second;
+        }
+
+        //the number of road segments from one location to the other
+        //(there may be several), both of which are known to exist
+        int& segmentCount(int fromVertex, int toVertex)
+        {
+            auto found = segments.find({fromVertex, toVertex});
+            if (found == segments.end())
+            {
+                int count = 0;
+                if (roadMap.hasVertex(fromVertex))
+                {
+                    roadMap.forEachOutgoingEdge(fromVertex,
+                        [&](int to, const RoadSegment&)
+                        {
+                            count += to == toVertex;
+                        });
+                }
+                found = segments.emplace(std::make_pair(fromVertex, toVertex), count).first;
+            }
+            return found->second;
+        }
+
+        void requireLocation(const MapPatchChange& change, int vertex)
+        {
+            if (!exists(vertex))
+            {
+                fail(change, "no location numbered " + std::to_string(vertex));
+            }
+        }
+
+        void requireSegment(const MapPatchChange& change)
+        {
+            requireLocation(change, change.fromVertex);
+            requireLocation(change, change.toVertex);
+            if (segmentCount(change.fromVertex, change.toVertex) == 0)
+            {
+                fail(change, "no road segment from " + std::to_string(change.fromVertex) +
+                             " to " + std::to_string(change.toVertex));
+            }
+        }
+
+        [[noreturn]] void fail(const MapPatchChange& change, const std::string& reason)
+        {
+            throw MapPatchException(reason, change.lineNumber);
+        }
+
+        const RoadMap& roadMap;
+        std::unordered_map<int, bool> locations;
+        std::unordered_set<int> removed;
+        std::map<std::pair<int, int>, int> segments;
+    };
+}
+
+
+MapPatchException::MapPatchException(const std::string& reason, int lineNumber)
+    : std::runtime_error{lineNumber > 0 ? "line " + std::to_string(lineNumber) + ": " + reason : reason},
+      lineNumber_{lineNumber}
+{
+}
+
+
+int MapPatchException::lineNumber() const noexcept
+{
+    return lineNumber_;
+}
+
+
+MapPatch readMapPatch(std::istream& in)
+{
+    MapPatch patch;
+    std::string line;
+    int lineNumber = 0;
+
+    while (std::getline(in, line))
+    {
+        ++lineNumber;
+        if (isMeaningful(line))
+        {
+            patch.changes.push_back(parseChange(line, lineNumber));
+        }
+    }
+
+    return patch;
+}
+
+
+MapPatchSummary applyMapPatch(RoadMap& roadMap, const MapPatch& patch)
+{
+    PatchChecker checker{roadMap};
+    for (const MapPatchChange& change : patch.changes)
+    {
+        checker.check(change);
+    }
+
+    //from here on, nothing can fail
+    MapPatchSummary summary;
+    summary.oldVersion = roadMap.version();
+
+    std::vector<int> removedLocations;
+
+    for (const MapPatchChange& change : patch.changes)
+    {
+        switch (change.kind)
+        {
+        case MapPatchChange::Kind::AddLocation:
+            roadMap.addVertex(change.fromVertex, change.name);
+            ++summary.addedLocations;
+            break;
+
+        case MapPatchChange::Kind::RemoveLocation:
+            removedLocations.push_back(change.fromVertex);
+            break;
+
+        case MapPatchChange::Kind::AddRoadSegment:
+            roadMap.addEdge(change.fromVertex, change.toVertex, change.segment);
+            ++summary.addedRoadSegments;
+            break;
+
+        case MapPatchChange::Kind::RemoveRoadSegment:
+            roadMap.removeEdge(change.fromVertex, change.toVertex);
+            ++summary.removedRoadSegments;
+            break;
+
+        case MapPatchChange::Kind::ChangeSpeed:
+            //every road segment between the two locations is changed
+            summary.changedRoadSegments += roadMap.updateEdges(change.fromVertex, change.toVertex,
+                [&](RoadSegment& segment)
+                {
+                    segment.milesPerHour = change.segment.milesPerHour;
+                });
+            break;
+        }
+
+        summary.changedLocations.push_back(change.fromVertex);
+    }
+
+    if (!removedLocations.empty())
+    {
+        int edgesBefore = roadMap.edgeCount();
+        roadMap.removeVertices(removedLocations);
+        summary.removedLocations = removedLocations.size();
+        summary.removedRoadSegments += edgesBefore - roadMap.edgeCount();
+    }
+
+    std::sort(summary.changedLocations.begin(), summary.changedLocations.end());
+    summary.changedLocations.erase(
+        std::unique(summary.changedLocations.begin(), summary.changedLocations.end()),
+        summary.changedLocations.end());
+
+    summary.newVersion = roadMap.version();
+    return summary;
+}
@@ -0,0 +1,127 @@
+// MapPatch.hpp
+//
+// ICS 46 Winter 2019
+// Project #4: Rock and Roll Stops the Traffic
+//
+// A MapPatch is a small set of changes to a RoadMap -- new locations, new
+// road segments, removed ones, changed speeds -- that can be applied to a
+// RoadMap already in memory, rather than reading the whole changed map
+// again.  Patches are written one change per line, where blank lines and
+// lines beginning with '#' are skipped:
+//
+//     +V number name              add a location
+//     +E from to miles mph [profile]
+//                                 add a road segment
+//     -E from to                  remove a road segment
+//     ~E from to mph              change a road segment's speed
+//     -V number                   remove a location and its road segments
+//
+// There may be several road segments from one location to another.  -E
+// removes only one of them (so removing them all takes as many lines as
+// there are segments), while ~E changes the speed of every one of them,
+// each keeping its own length; the MapPatchSummary counts each segment
+// changed.
+//
+// readMapPatch() only checks that each line is well-formed; whether the
+// changes make sense for a particular RoadMap (e.g., that a road segment
+// being removed exists) is checked by applyMapPatch(), all at once, before
+// it changes anything, so that a patch is either applied in full or not at
+// all.  Changes are applied in order, except that the locations a patch
+// removes are all removed at the end, in one pass over the map.  Since the
+// RoadMap's version() changes along with it, anything built from the map
+// can tell that it needs rebuilding; the MapPatchSummary that
+// applyMapPatch() returns also says what changed.
+
+#ifndef MAPPATCH_HPP
+#define MAPPATCH_HPP
+
+#include <istream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "RoadMap.hpp"
+#include "RoadSegment.hpp"
+
+
+
+class MapPatchException : public std::runtime_error
+{
+public:
+    // lineNumber counts from 1; 0 means the problem isn't on any
+    // particular line.
+    MapPatchException(const std::string& reason, int lineNumber);
+
+    int lineNumber() const noexcept;
+
+private:
+    int lineNumber_;
+};
+
+
+
+struct MapPatchChange
+{
+    enum class Kind
+    {
+        AddLocation,
+        AddRoadSegment,
+        RemoveRoadSegment,
+        ChangeSpeed,
+        RemoveLocation
+    };
+
+    Kind kind;
+    int lineNumber;
+
+    // A location's number is its fromVertex.  Only the fields the kind
+    // of change needs are used; a ChangeSpeed only uses the segment's
+    // milesPerHour.
+    int fromVertex;
+    int toVertex;
+    RoadSegment segment;
+    std::string name;
+};
+
+
+struct MapPatch
+{
+    std::vector<MapPatchChange> changes;
+};
+
+
+struct MapPatchSummary
+{
+    int addedLocations = 0;
+    int removedLocations = 0;
+    int addedRoadSegments = 0;
+    int changedRoadSegments = 0;
+
+    // This includes the road segments to and from removed locations.
+    int removedRoadSegments = 0;
+
+    // The locations that were added or removed, or whose outgoing road
+    // segments were added, removed or changed by the patch's own lines,
+    // in increasing order.
+    std::vector<int> changedLocations;
+
+    // The RoadMap's version() before and after the patch.
+    unsigned long oldVersion = 0;
+    unsigned long newVersion = 0;
+};
+
+
+
+// readMapPatch() reads a patch in the format described above until the
+// input runs out.  If a line isn't well-formed, a MapPatchException is
+// thrown.
+MapPatch readMapPatch(std::istream& in);
+
+
+// applyMapPatch() applies the given patch to the given RoadMap.  If any of
+// its changes can't be made, a MapPatchException is thrown, and the RoadMap
+// is left unchanged.
+MapPatchSummary applyMapPatch(RoadMap& roadMap, const MapPatch& patch);
+
+
+
+#endif // MAPPATCH_HPP
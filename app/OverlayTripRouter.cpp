@@ -0,0 +1,164 @@
+// OverlayTripRouter.cpp
+//
+// ICS 46 Winter 2019
+// Project #4: Rock and Roll Stops the Traffic
+
+#include <utility>
+#include "OverlayTripRouter.hpp"
+#include "RoadMapWeights.hpp"
+
+
+namespace
+{
+    //whether two snapshots have the same vertices, with the same edges
+    //between them in the same order, whatever the edges weigh
+    bool sameShape(const CompactDigraph<double>& a, const CompactDigraph<double>& b)
+    {
+        if(a.vertexCount() != b.vertexCount() || a.edgeCount() != b.edgeCount())
+        {
+            return false;
+        }
+        for(int vertex = 0; vertex < a.vertexCount(); ++vertex)
+        {
+            if(a.vertexNumber(vertex) != b.vertexNumber(vertex) ||
+               a.edgesBegin(vertex) != b.edgesBegin(vertex))
+            {
+                return false;
+            }
+        }
+        for(int edge = 0; edge < a.edgeCount(); ++edge)
+        {
+            if(a.target(edge) != b.target(edge))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+
+    //whether two snapshots of the same map weigh every edge the same
+    bool sameWeights(const CompactDigraph<double>& a, const CompactDigraph<double>& b)
+    {
+        if(a.edgeCount() != b.edgeCount())
+        {
+            return false;
+        }
+        for(int edge = 0; edge < a.edgeCount(); ++edge)
+        {
+            if(a.weight(edge) != b.weight(edge))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+
+OverlayTripRouterException::OverlayTripRouterException(const std::string& reason)
+    : std::runtime_error{reason}
+{
+}
+
+
+OverlayTripRouter::OverlayTripRouter(
+    const RoadMap& roadMap, const std::vector<int>& cellSizes, unsigned int threadCount)
+    : threads{threadCount}
+{
+    //the partition only looks at which locations are connected, so either
+    //metric's snapshot will do
+    partition = CellPartition{compactRoadMap(roadMap, TripMetric::Distance), cellSizes};
+    customize(roadMap);
+}
+
+
+void OverlayTripRouter::findPath(const Trip& trip, std::vector<int>& path) const
+{
+    thread_local SearchWorkspace<double> workspace;
+    thread_local SearchWorkspace<double> unpackWorkspace;
+
+    std::shared_ptr<const Customization> costs = current();
+
+    const MetricCosts& metric = trip.metric == TripMetric::Time ? *costs->time : *costs->distance;
+    const CompactDigraph<double>& graph = metric.graph;
+
+    findShortestPathOverlay(
+        graph, partition, metric.costs,
+        graph.indexOf(trip.startVertex), graph.indexOf(trip.endVertex),
+        workspace, unpackWorkspace, path);
+
+    for(int& vertex : path)
+    {
+        vertex = graph.vertexNumber(vertex);
+    }
+}
+
+
+void OverlayTripRouter::customize(const RoadMap& roadMap)
+{
+    CompactDigraph<double> distanceGraph = compactRoadMap(roadMap, TripMetric::Distance);
+    CompactDigraph<double> timeGraph = compactRoadMap(roadMap, TripMetric::Time);
+
+    std::lock_guard<std::mutex> lock{customizationMutex};
+    std::shared_ptr<const Customization> old = current();
+
+    //the partition's cells are lists of vertex indexes, so they'd be
+    //talking about other locations if any had come or gone
+    if(old != nullptr && !sameShape(distanceGraph, old->distance->graph))
+    {
+        throw OverlayTripRouterException(
+            "the map's locations or road segments have changed since it was partitioned");
+    }
+
+    std::shared_ptr<Customization> next = std::make_shared<Customization>();
+    next->distance = customizeMetric(std::move(distanceGraph), old ? old->distance : nullptr);
+    next->time = customizeMetric(std::move(timeGraph), old ? old->time : nullptr);
+
+    std::atomic_store(&customization, std::shared_ptr<const Customization>{std::move(next)});
+}
+
+
+std::shared_ptr<const OverlayTripRouter::MetricCosts> OverlayTripRouter::customizeMetric(
+    CompactDigraph<double> graph, const std::shared_ptr<const MetricCosts>& old) const
+{
+    if(old != nullptr && sameWeights(graph, old->graph))
+    {
+        return old;
+    }
+
+    std::shared_ptr<MetricCosts> next = std::make_shared<MetricCosts>();
+    next->graph = std::move(graph);
+    next->costs = OverlayCosts{next->graph, partition, threads};
+    return next;
+}
+
+
+std::vector<int> OverlayTripRouter::defaultCellSizes()
+{
+    //the cost of customizing a level grows with the size of its cells
+    //(on a grid, with the square root of it), and bigger cells had no
+    //faster trips to show for it: on a 400-by-400 grid, {256, 4096}
+    //customized a metric in 4.7 seconds on one core, this in 0.7
+    return {32, 128};
+}
+
+
+std::shared_ptr<const OverlayTripRouter::Customization> OverlayTripRouter::current() const
+{
+    return std::atomic_load(&customization);
+}
+
+
+MemoryUsage OverlayTripRouter::memoryUsage() const
+{
+    std::shared_ptr<const Customization> costs = current();
+
+    MemoryUsage usage;
+    usage.add("cell partition", partition.byteCount());
+    usage.add("distance snapshot", costs->distance->graph.byteCount());
+    usage.add("time snapshot", costs->time->graph.byteCount());
+    usage.add("distance cell costs", costs->distance->costs.byteCount());
+    usage.add("time cell costs", costs->time->costs.byteCount());
+    return usage;
+}
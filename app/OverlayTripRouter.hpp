@@ -0,0 +1,102 @@
+// OverlayTripRouter.hpp
+//
+// ICS 46 Winter 2019
+// Project #4: Rock and Roll Stops the Traffic
+//
+// An OverlayTripRouter answers trips with multilevel overlay searches (see
+// MultilevelOverlay.hpp).  The map is partitioned into cells once, when
+// the router is constructed; after that, customize() brings the router up
+// to date with new speeds (or lengths) in the RoadMap without touching the
+// partition, which is what makes it a good fit for maps whose speeds
+// change often.  Only the metrics whose weights have changed are
+// customized again, so a change of speeds leaves the distance costs as
+// they were.  Trips find the current costs through an atomic shared_ptr,
+// so they never wait for each other or for a customization.
+
+#ifndef OVERLAYTRIPROUTER_HPP
+#define OVERLAYTRIPROUTER_HPP
+
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "CompactDigraph.hpp"
+#include "MultilevelOverlay.hpp"
+#include "RoadMap.hpp"
+#include "TripRouter.hpp"
+
+
+
+class OverlayTripRouterException : public std::runtime_error
+{
+public:
+    OverlayTripRouterException(const std::string& reason);
+};
+
+
+
+class OverlayTripRouter : public TripRouter
+{
+public:
+    // Initializes an OverlayTripRouter for the given RoadMap, with at most
+    // cellSizes[l] locations in one cell on level l, customizing with up
+    // to threadCount threads (0 means one per hardware thread).
+    OverlayTripRouter(const RoadMap& roadMap,
+                      const std::vector<int>& cellSizes = defaultCellSizes(),
+                      unsigned int threadCount = 0);
+
+    using TripRouter::findPath;
+    void findPath(const Trip& trip, std::vector<int>& path) const override;
+    MemoryUsage memoryUsage() const override;
+
+    // customize() recomputes the cell costs from the segments in the given
+    // RoadMap, for each metric whose weights are different than they were.
+    // The RoadMap must have the same locations and segments as the one the
+    // router was built for, since the partition is kept; if it doesn't, an
+    // OverlayTripRouterException is thrown and the costs are left as they
+    // were.  Trips already being routed finish with the old costs; it's
+    // safe to call while other threads call findPath() or customize().
+    void customize(const RoadMap& roadMap);
+
+    // defaultCellSizes() returns the cell sizes used when none are given.
+    static std::vector<int> defaultCellSizes();
+
+
+private:
+    //one metric's weights and the cell costs worked out from them
+    struct MetricCosts
+    {
+        CompactDigraph<double> graph;
+        OverlayCosts costs;
+    };
+
+    //both metrics, replaced as a whole by customize(), although a metric
+    //whose weights haven't changed is shared with the one before
+    struct Customization
+    {
+        std::shared_ptr<const MetricCosts> distance;
+        std::shared_ptr<const MetricCosts> time;
+    };
+
+    std::shared_ptr<const Customization> current() const;
+
+    //returns the costs for the given weights, which are the old ones if
+    //the weights are the same as theirs
+    std::shared_ptr<const MetricCosts> customizeMetric(
+        CompactDigraph<double> graph, const std::shared_ptr<const MetricCosts>& old) const;
+
+    CellPartition partition;
+    unsigned int threads;
+
+    //only read and written with std::atomic_load() and std::atomic_store()
+    std::shared_ptr<const Customization> customization;
+
+    //held by customize(), so that one customization is worked out from
+    //the last, but never by findPath()
+    std::mutex customizationMutex;
+};
+
+
+
+#endif // OVERLAYTRIPROUTER_HPP
@@ -0,0 +1,518 @@
+// QueryServer.cpp
+//
+// ICS 46 Winter 2019
+// Project #4: Rock and Roll Stops the Traffic
+
+#include <charconv>
+#include <chrono>
+#include <cctype>
+#include <cerrno>
+#include <exception>
+#include <iomanip>
+#include <list>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "BoundedQueue.hpp"
+#include "ParallelFor.hpp"
+#include "QueryServer.hpp"
+#include "RoadMapWeights.hpp"
+#include "TimeOfDay.hpp"
+#include "TripWriter.hpp"
+
+
+QueryServerException::QueryServerException(const std::string& reason)
+    : std::runtime_error{reason}
+{
+}
+
+
+namespace
+{
+    // isMeaningful() applies the same rules as InputReader: blank lines,
+    // lines of only spaces, and lines beginning with '#' are skipped.
+    bool isMeaningful(const std::string& line)
+    {
+        for(char c : line)
+        {
+            if(!std::isspace(static_cast<unsigned char>(c)))
+            {
+                return line[0] != '#';
+            }
+        }
+        return false;
+    }
+
+
+    //reads one location from the request starting at "position" -- a
+    //vertex number, or a name in double quotes -- moving past it
+    bool parseLocation(
+        const std::string& request, std::size_t& position, const RoadMap& roadMap, int& vertex)
+    {
+        while(position < request.size() && std::isspace(static_cast<unsigned char>(request[position])))
+        {
+            ++position;
+        }
+        if(position == request.size())
+        {
+            return false;
+        }
+
+        if(request[position] == '"')
+        {
+            std::size_t closingQuote = request.find('"', position + 1);
+            if(closingQuote == std::string::npos)
+            {
+                return false;
+            }
+
+            //throws DigraphException if there's no location by that name
+            vertex = roadMap.vertexNamed(
+                std::string_view{request}.substr(position + 1, closingQuote - position - 1));
+            position = closingQuote + 1;
+            return true;
+        }
+
+        const char* begin = request.data() + position;
+        const char* end = request.data() + request.size();
+        std::from_chars_result result = std::from_chars(begin, end, vertex);
+        if(result.ec != std::errc{} ||
+           (result.ptr != end && !std::isspace(static_cast<unsigned char>(*result.ptr))))
+        {
+            return false;
+        }
+
+        position = result.ptr - request.data();
+        return true;
+    }
+
+
+    bool parseRequest(const std::string& request, const RoadMap& roadMap, Trip& trip)
+    {
+        std::size_t position = 0;
+        if(!parseLocation(request, position, roadMap, trip.startVertex) ||
+           !parseLocation(request, position, roadMap, trip.endVertex))
+        {
+            return false;
+        }
+
+        std::istringstream rest{request.substr(position)};
+        std::string metricType;
+        std::string departure;
+        std::string extra;
+
+        if(!(rest >> metricType) || (metricType != "D" && metricType != "T"))
+        {
+            return false;
+        }
+
+        trip.metric = metricType == "D" ? TripMetric::Distance : TripMetric::Time;
+        trip.departureTime = noDepartureTime;
+
+        if(rest >> departure && (!parseTimeOfDay(departure, trip.departureTime) || (rest >> extra)))
+        {
+            return false;
+        }
+        return true;
+    }
+
+
+    bool isQuitRequest(const std::string& request)
+    {
+        std::size_t begin = request.find_first_not_of(" \t");
+        std::size_t end = request.find_last_not_of(" \t");
+        return begin != std::string::npos && request.compare(begin, end + 1 - begin, "QUIT") == 0;
+    }
+
+
+    bool isReachRequest(const std::string& request)
+    {
+        std::size_t position = request.find_first_not_of(" \t");
+        return position != std::string::npos && request.compare(position, 5, "REACH") == 0;
+    }
+
+
+    //parses "REACH from budget D|T", storing the budget and metric in
+    //"trip" (whose endVertex is unused)
+    bool parseReachRequest(
+        const std::string& request, const RoadMap& roadMap, Trip& trip, double& budget)
+    {
+        std::size_t position = request.find("REACH") + 5;
+
+        if(!parseLocation(request, position, roadMap, trip.startVertex))
+        {
+            return false;
+        }
+
+        std::istringstream rest{request.substr(position)};
+        std::string metricType;
+        std::string extra;
+
+        if(!(rest >> budget) || !(rest >> metricType) || (rest >> extra) ||
+           budget < 0 || (metricType != "D" && metricType != "T"))
+        {
+            return false;
+        }
+
+        trip.metric = metricType == "D" ? TripMetric::Distance : TripMetric::Time;
+        return true;
+    }
+
+
+    void writeReachable(
+        std::ostream& out, const RoadMap& roadMap, const Trip& trip, double budget,
+        const std::vector<std::pair<int, double>>& reachable)
+    {
+        const char* unit = trip.metric == TripMetric::Distance ? " miles" : " seconds";
+
+        out<<std::fixed<<std::setprecision(2);
+        out<<"Locations within "<<budget<<unit<<" of "
+           <<roadMap.vertexInfo(trip.startVertex)<<":\n";
+
+        for(const std::pair<int, double>& location : reachable)
+        {
+            out<<"\t"<<roadMap.vertexInfo(location.first)<<" ("<<location.second<<unit<<")\n";
+        }
+        out<<"Total: "<<reachable.size()<<" locations\n";
+    }
+
+
+    bool sendAll(int socket, const std::string& data)
+    {
+        std::size_t sent = 0;
+        while(sent < data.size())
+        {
+            ssize_t count = send(socket, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+            if(count <= 0)
+            {
+                return false;
+            }
+            sent += count;
+        }
+        return true;
+    }
+}
+
+
+QueryServer::QueryServer(
+    const RoadMap& roadMap, const TripRouter& router, const SpeedProfiles* profiles)
+    : roadMap{roadMap}, router{router}, profiles{profiles}
+{
+}
+
+
+bool QueryServer::answerQuery(const std::string& request, std::ostream& out)
+{
+    if(!isMeaningful(request))
+    {
+        return false;
+    }
+
+    auto started = std::chrono::steady_clock::now();
+    std::ostringstream reply;
+
+    try
+    {
+        Trip trip;
+        double budget;
+        if(isReachRequest(request))
+        {
+            if(!parseReachRequest(request, roadMap, trip, budget))
+            {
+                reply<<"ERROR malformed request: "<<request<<"\n";
+            }
+            else
+            {
+                thread_local SearchWorkspace<double> workspace;
+                writeReachable(reply, roadMap, trip, budget,
+                    findReachable(roadMap, trip.startVertex, trip.metric, budget, workspace));
+            }
+        }
+        else if(!parseRequest(request, roadMap, trip))
+        {
+            reply<<"ERROR malformed request: "<<request<<"\n";
+        }
+        else
+        {
+            thread_local std::vector<int> path;
+            router.findPath(trip, path);
+
+            TripWriter writer;
+            writer.writeTrip(reply, roadMap, trip, path, profiles);
+        }
+    }
+    catch(DigraphException&)
+    {
+        reply<<"ERROR no such location in: "<<request<<"\n";
+    }
+
+    long long microseconds = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - started).count();
+
+    ++queryCount;
+    totalMicroseconds += microseconds;
+    long long previousMax = maxMicroseconds;
+    while(microseconds > previousMax &&
+          !maxMicroseconds.compare_exchange_weak(previousMax, microseconds))
+    {
+    }
+
+    reply<<"LATENCY "<<microseconds<<" us\n";
+    out<<reply.str();
+    return true;
+}
+
+
+void QueryServer::serveConnection(int connection)
+{
+    std::string pending;
+    char buffer[4096];
+
+    while(true)
+    {
+        ssize_t count = recv(connection, buffer, sizeof(buffer), 0);
+        if(count < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if(count <= 0)
+        {
+            return;
+        }
+        pending.append(buffer, count);
+
+        std::size_t lineEnd;
+        while((lineEnd = pending.find('\n')) != std::string::npos)
+        {
+            std::string request = pending.substr(0, lineEnd);
+            pending.erase(0, lineEnd + 1);
+            if(!request.empty() && request.back() == '\r')
+            {
+                request.pop_back();
+            }
+
+            if(isQuitRequest(request))
+            {
+                sendAll(connection, "BYE\n");
+                stop();
+                return;
+            }
+
+            std::ostringstream reply;
+            if(answerQuery(request, reply) && !sendAll(connection, reply.str()))
+            {
+                return;
+            }
+        }
+    }
+}
+
+
+void QueryServer::serveStream(std::istream& in, std::ostream& out, unsigned int threadCount)
+{
+    if(threadCount == 0)
+    {
+        threadCount = defaultThreadCount();
+    }
+
+    //requests are numbered as they're read; finished replies wait in
+    //"finished" until every earlier reply has been written
+    BoundedQueue<std::pair<long, std::string>> requests(threadCount * 64);
+    std::map<long, std::string> finished;
+    long nextToWrite = 0;
+    std::mutex outputMutex;
+
+    std::vector<std::thread> workers;
+    for(unsigned int i = 0; i < threadCount; ++i)
+    {
+        workers.emplace_back(
+            [&]()
+            {
+                std::pair<long, std::string> request;
+                while(requests.pop(request))
+                {
+                    std::ostringstream reply;
+                    answerQuery(request.second, reply);
+
+                    std::lock_guard<std::mutex> lock{outputMutex};
+                    finished[request.first] = reply.str();
+                    while(!finished.empty() && finished.begin()->first == nextToWrite)
+                    {
+                        out<<finished.begin()->second;
+                        finished.erase(finished.begin());
+                        ++nextToWrite;
+                    }
+                    out.flush();
+                }
+            });
+    }
+
+    std::string line;
+    long sequence = 0;
+    while(std::getline(in, line))
+    {
+        requests.push({sequence++, line});
+    }
+    requests.close();
+
+    for(std::thread& worker : workers)
+    {
+        worker.join();
+    }
+}
+
+
+void QueryServer::serveSocket(const std::string& socketPath)
+{
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if(socketPath.size() >= sizeof(address.sun_path))
+    {
+        throw QueryServerException("Socket path too long: " + socketPath);
+    }
+    socketPath.copy(address.sun_path, socketPath.size());
+
+    int listener = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if(listener < 0)
+    {
+        throw QueryServerException("Could not create socket");
+    }
+
+    unlink(socketPath.c_str());
+    if(bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 ||
+       listen(listener, SOMAXCONN) < 0)
+    {
+        close(listener);
+        throw QueryServerException("Could not listen on " + socketPath);
+    }
+
+    int wakeup[2];
+    if(pipe2(wakeup, O_CLOEXEC | O_NONBLOCK) < 0)
+    {
+        close(listener);
+        unlink(socketPath.c_str());
+        throw QueryServerException("Could not create a pipe to stop the server with");
+    }
+    stopPipe = wakeup[1];
+
+    //a connection's socket is closed only once its thread has been
+    //joined, so that shutting it down at the end can never reach a
+    //socket number that's since been reused
+    struct Connection
+    {
+        int socket;
+        std::thread thread;
+        std::atomic<bool> finished{false};
+    };
+    std::list<Connection> connections;
+
+    auto reap = [&](bool all)
+    {
+        for(auto it = connections.begin(); it != connections.end(); )
+        {
+            if(all || it->finished)
+            {
+                it->thread.join();
+                close(it->socket);
+                it = connections.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+    };
+
+    while(!stopRequested)
+    {
+        pollfd waitingFor[2] = {{listener, POLLIN, 0}, {wakeup[0], POLLIN, 0}};
+        if(poll(waitingFor, 2, -1) < 0)
+        {
+            if(errno == EINTR)
+            {
+                continue;
+            }
+            break;
+        }
+        if(waitingFor[1].revents != 0)
+        {
+            break;
+        }
+
+        int connection = accept4(listener, nullptr, nullptr, SOCK_CLOEXEC);
+        if(connection < 0)
+        {
+            if(errno == EINTR || errno == ECONNABORTED)
+            {
+                continue;
+            }
+            break;
+        }
+
+        //threads whose clients have gone are joined as new ones arrive, so
+        //a long-running server holds only about as many as are connected
+        reap(false);
+
+        connections.emplace_back();
+        Connection& added = connections.back();
+        added.socket = connection;
+        added.thread = std::thread(
+            [this, &added]()
+            {
+                serveConnection(added.socket);
+                added.finished = true;
+            });
+    }
+
+    stopPipe = -1;
+    close(listener);
+
+    //connections waiting for their next request see the end of their
+    //input; one in the middle of a request finishes answering it first
+    for(Connection& connection : connections)
+    {
+        shutdown(connection.socket, SHUT_RD);
+    }
+    reap(true);
+
+    close(wakeup[0]);
+    close(wakeup[1]);
+    unlink(socketPath.c_str());
+}
+
+
+void QueryServer::stop() noexcept
+{
+    stopRequested = true;
+
+    int fd = stopPipe;
+    if(fd >= 0)
+    {
+        char byte = 0;
+        ssize_t written = write(fd, &byte, 1);
+        (void)written;
+    }
+}
+
+
+void QueryServer::writeStatistics(std::ostream& out) const
+{
+    long count = queryCount;
+    out<<"Answered "<<count<<" queries";
+    if(count > 0)
+    {
+        out<<" (mean latency "<<(totalMicroseconds / count)<<" us, max "
+           <<maxMicroseconds<<" us)";
+    }
+    out<<"\n";
+}
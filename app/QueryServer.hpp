@@ -0,0 +1,113 @@
+// QueryServer.hpp
+//
+// ICS 46 Winter 2019
+// Project #4: Rock and Roll Stops the Traffic
+//
+// A QueryServer answers trip queries against a RoadMap that has already
+// been loaded, for as long as queries keep arriving, so that the cost of
+// loading the map is paid once rather than once per batch of trips.
+//
+// Queries use a simple line protocol.  Each request is one line written
+// the same way as a trip in the input file ("from to D" or "from to T");
+// either location may instead be given by name, in double quotes, as in
+// "\"Loc 3\" \"Loc 7\" T", and a trip may end with the time it leaves,
+// as in "3 7 T 08:30".  A request of the form "REACH from budget D"
+// (or T) instead asks for every location within the budget of "from" --
+// in miles or seconds -- and the cost of reaching each.  Blank lines and
+// lines beginning with '#' are ignored.  Each reply is the directions for
+// the trip (as written by TripWriter) or the list of reachable locations,
+// or a line beginning with "ERROR" if the request couldn't be answered,
+// followed by a closing line of the form "LATENCY n us", where n is the
+// number of microseconds spent answering the request.
+//
+// Requests can arrive on an input stream (answered on several threads at
+// once, with replies written in the order the requests arrived) or on a
+// Unix domain socket (each connection answered on its own thread).  On a
+// socket, the request "QUIT" is answered with "BYE" and shuts the server
+// down, as stop() does.
+
+#ifndef QUERYSERVER_HPP
+#define QUERYSERVER_HPP
+
+#include <atomic>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include "RoadMap.hpp"
+#include "SpeedProfiles.hpp"
+#include "TripRouter.hpp"
+
+
+
+class QueryServerException : public std::runtime_error
+{
+public:
+    QueryServerException(const std::string& reason);
+};
+
+
+
+class QueryServer
+{
+public:
+    // Initializes a QueryServer that answers queries about the given
+    // RoadMap, finding paths with the given TripRouter and describing
+    // them by the given speed profiles, if any.  All of them must outlive
+    // the QueryServer, and the RoadMap must not change while it's in use.
+    QueryServer(
+        const RoadMap& roadMap, const TripRouter& router,
+        const SpeedProfiles* profiles = nullptr);
+
+    // answerQuery() answers one request line, writing the reply to the
+    // given output stream.  It returns false (writing nothing) if the line
+    // was blank or a comment.  Any number of threads may call it at once.
+    bool answerQuery(const std::string& request, std::ostream& out);
+
+    // serveStream() answers every request read from the given input
+    // stream until it runs out, using the given number of threads (0
+    // means one per hardware thread).  Replies are written to the given
+    // output stream in the same order as their requests.
+    void serveStream(std::istream& in, std::ostream& out, unsigned int threadCount);
+
+    // serveSocket() listens for connections on a Unix domain socket at
+    // the given path (replacing any socket already there) and answers the
+    // requests sent on each connection, one connection per thread.  It
+    // returns once the server is stopped (or the socket can no longer
+    // accept connections), after every connection has finished the
+    // request it was answering and the socket has been removed.  If it
+    // can't be set up in the first place, a QueryServerException is thrown.
+    void serveSocket(const std::string& socketPath);
+
+    // stop() asks serveSocket() to stop accepting connections and return.
+    // It only sets a flag and writes to a pipe, so it may be called from
+    // a signal handler, and before serveSocket() has started.
+    void stop() noexcept;
+
+    // writeStatistics() writes a summary of the number of requests
+    // answered so far and how long they took.
+    void writeStatistics(std::ostream& out) const;
+
+
+private:
+    //answers the requests sent on one connection to the socket until the
+    //client closes it, the server is stopped, or a reply can't be sent
+    void serveConnection(int connection);
+
+    const RoadMap& roadMap;
+    const TripRouter& router;
+    const SpeedProfiles* profiles;
+
+    //serveSocket() waits on the read end of a pipe that stop() writes
+    //to, so that it wakes up even while blocked waiting for a connection
+    std::atomic<bool> stopRequested{false};
+    std::atomic<int> stopPipe{-1};
+
+    std::atomic<long> queryCount{0};
+    std::atomic<long long> totalMicroseconds{0};
+    std::atomic<long long> maxMicroseconds{0};
+};
+
+
+
+#endif // QUERYSERVER_HPP
@@ -0,0 +1,76 @@
+// RoadClosures.cpp
+//
+// ICS 46 Winter 2019
+// Project #4: Rock and Roll Stops the Traffic
+
+#include <string>
+#include "MapPatch.hpp"
+#include "RoadClosures.hpp"
+
+
+namespace
+{
+    void requireLocation(const RoadMap& roadMap, const MapPatchChange& change, int vertex)
+    {
+        if (!roadMap.hasVertex(vertex))
+        {
+            throw MapPatchException("no location numbered " + std::to_string(vertex), change.lineNumber);
+        }
+    }
+
+
+    void requireSegment(const RoadMap& roadMap, const MapPatchChange& change)
+    {
+        requireLocation(roadMap, change, change.fromVertex);
+        requireLocation(roadMap, change, change.toVertex);
+
+        bool found = false;
+        roadMap.forEachOutgoingEdge(change.fromVertex,
+            [&](int to, const RoadSegment&)
+            {
+                found = found || to == change.toVertex;
+            });
+
+        if (!found)
+        {
+            throw MapPatchException("no road segment from " + std::to_string(change.fromVertex) +
+                                    " to " + std::to_string(change.toVertex), change.lineNumber);
+        }
+    }
+}
+
+
+RoadClosures readRoadClosures(std::istream& in, const RoadMap& roadMap)
+{
+    //the lines are parsed just as a patch's are, and only the kinds of
+    //change that close or slow something are kept
+    MapPatch patch = readMapPatch(in);
+    RoadClosures closures;
+
+    for (const MapPatchChange& change : patch.changes)
+    {
+        switch (change.kind)
+        {
+        case MapPatchChange::Kind::RemoveLocation:
+            requireLocation(roadMap, change, change.fromVertex);
+            closures.closedLocations.push_back(change.fromVertex);
+            break;
+
+        case MapPatchChange::Kind::RemoveRoadSegment:
+            requireSegment(roadMap, change);
+            closures.closedRoads.emplace_back(change.fromVertex, change.toVertex);
+            break;
+
+        case MapPatchChange::Kind::ChangeSpeed:
+            requireSegment(roadMap, change);
+            closures.speedChanges.push_back(
+                SpeedChange{change.fromVertex, change.toVertex, change.segment.milesPerHour});
+            break;
+
+        default:
+            throw MapPatchException("closures can't add locations or road segments", change.lineNumber);
+        }
+    }
+
+    return closures;
+}
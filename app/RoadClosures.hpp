@@ -0,0 +1,62 @@
+// RoadClosures.hpp
+//
+// ICS 46 Winter 2019
+// Project #4: Rock and Roll Stops the Traffic
+//
+// A RoadClosures object describes temporary changes to a RoadMap that a
+// trip should be routed around -- locations and road segments that are
+// closed, and road segments whose speeds are different -- without the
+// RoadMap itself being changed.  Locations are identified by their vertex
+// numbers, just as they are in a Trip.  See DijkstraTripRouter, which
+// can find paths subject to them.
+//
+// Closures can also be read from a file, written in the same format as a
+// MapPatch (see MapPatch.hpp) but with only these kinds of lines:
+//
+//     -V number                   close a location
+//     -E from to                  close a road segment
+//     ~E from to mph              change a road segment's speed
+//
+// A line naming a pair of locations applies to every road segment between
+// them, if there are several.
+
+#ifndef ROADCLOSURES_HPP
+#define ROADCLOSURES_HPP
+
+#include <istream>
+#include <utility>
+#include <vector>
+#include "RoadMap.hpp"
+
+
+
+struct SpeedChange
+{
+    int fromVertex;
+    int toVertex;
+    double milesPerHour;
+};
+
+
+struct RoadClosures
+{
+    std::vector<int> closedLocations;
+
+    // Each road segment is a pair of "from" and "to" vertex numbers.
+    std::vector<std::pair<int, int>> closedRoads;
+
+    // A speed of 0 closes the road segment.
+    std::vector<SpeedChange> speedChanges;
+};
+
+
+
+// readRoadClosures() reads closures in the format described above until
+// the input runs out.  If a line isn't well-formed, isn't one of the kinds
+// above, or mentions a location or road segment that the given RoadMap
+// doesn't have, a MapPatchException is thrown.
+RoadClosures readRoadClosures(std::istream& in, const RoadMap& roadMap);
+
+
+
+#endif // ROADCLOSURES_HPP
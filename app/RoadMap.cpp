@@ -0,0 +1,182 @@
+// RoadMap.cpp
+//
+// ICS 46 Winter 2019
+// Project #4: Rock and Roll Stops the Traffic
+
+#include <cstring>
+#include <unordered_set>
+#include "RoadMap.hpp"
+
+
+RoadMap::RoadMap()
+    : names{std::make_shared<StringPool>()}
+{
+}
+
+
+void RoadMap::addVertex(int vertex, std::string_view name)
+{
+    //a moved-from RoadMap has given its pool away
+    if (names == nullptr)
+    {
+        names = std::make_shared<StringPool>();
+    }
+
+    auto found = vertexByName.find(name);
+    std::string_view pooled = found != vertexByName.end() ? found->first : names->add(name);
+
+    Digraph::addVertex(vertex, pooled);
+
+    if (found == vertexByName.end())
+    {
+        vertexByName.emplace(pooled, vertex);
+    }
+    else if (vertex < found->second)
+    {
+        found->second = vertex;
+    }
+}
+
+
+void RoadMap::removeVertex(int vertex)
+{
+    std::string_view name = vertexInfo(vertex);
+    Digraph::removeVertex(vertex);
+
+    auto found = vertexByName.find(name);
+    if (found->second != vertex)
+    {
+        return;
+    }
+
+    //the name now belongs to the lowest-numbered other location that
+    //shares it, if there is one
+    vertexByName.erase(found);
+    for (int other : vertices())
+    {
+        if (vertexInfo(other) == name)
+        {
+            vertexByName.emplace(name, other);
+            break;
+        }
+    }
+}
+
+
+void RoadMap::removeVertices(const std::vector<int>& vertices)
+{
+    //the names that belong to the removed locations are found before
+    //they're gone (vertexInfo() throws if one of them doesn't exist,
+    //before anything has changed)
+    std::unordered_set<std::string_view> orphaned;
+    for (int vertex : vertices)
+    {
+        auto found = vertexByName.find(vertexInfo(vertex));
+        if (found->second == vertex)
+        {
+            orphaned.insert(found->first);
+        }
+    }
+
+    Digraph::removeVertices(vertices);
+
+    for (std::string_view name : orphaned)
+    {
+        vertexByName.erase(name);
+    }
+
+    //each name now belongs to the lowest-numbered remaining location that
+    //shares it, if there is one; one pass over the locations finds them all
+    if (!orphaned.empty())
+    {
+        for (int other : this->vertices())
+        {
+            std::string_view name = vertexInfo(other);
+            if (orphaned.count(name) != 0)
+            {
+                vertexByName.emplace(name, other);
+                orphaned.erase(name);
+            }
+        }
+    }
+}
+
+
+bool RoadMap::hasVertexNamed(std::string_view name) const
+{
+    return vertexByName.count(name) != 0;
+}
+
+
+int RoadMap::vertexNamed(std::string_view name) const
+{
+    auto found = vertexByName.find(name);
+    if (found == vertexByName.end())
+    {
+        throw DigraphException("Invalid Vertex Name");
+    }
+    return found->second;
+}
+
+
+MemoryUsage RoadMap::memoryUsage() const
+{
+    MemoryUsage usage = Digraph::memoryUsage();
+    usage.add("location names", names != nullptr ? names->allocatedBytes() : 0);
+    usage.add("name index", unorderedMapBytes(vertexByName));
+    return usage;
+}
+
+
+std::size_t RoadMap::estimateBytes(int locationCount, int roadSegmentCount, std::size_t nameBytes)
+{
+    //the name index holds a node per location, and about as many buckets
+    std::size_t locations = locationCount;
+    std::size_t nameIndexBytes =
+        locations * heapBytes(2 * sizeof(void*) + sizeof(std::pair<const std::string_view, int>)) +
+        heapBytes(locations * sizeof(void*));
+
+    return Digraph::estimateMemoryUsage(locationCount, roadSegmentCount).total() +
+           nameBytes + nameIndexBytes;
+}
+
+
+std::uint64_t RoadMap::checksum() const
+{
+    //FNV-1a, but a 64-bit word at a time rather than a byte at a time,
+    //followed by a final mix so that every bit of the input reaches every
+    //bit of the result
+    std::uint64_t hash = 14695981039346656037ull;
+    auto mix = [&](std::uint64_t value)
+    {
+        hash ^= value;
+        hash *= 1099511628211ull;
+        hash ^= hash >> 29;
+    };
+    auto mixDouble = [&](double value)
+    {
+        std::uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        mix(bits);
+    };
+
+    mix(vertexCount());
+    mix(edgeCount());
+    for (int vertex : vertices())
+    {
+        mix(static_cast<std::uint32_t>(vertex));
+        forEachOutgoingEdge(vertex,
+            [&](int toVertex, const RoadSegment& segment)
+            {
+                mix(static_cast<std::uint32_t>(toVertex));
+                mixDouble(segment.miles);
+                mixDouble(segment.milesPerHour);
+                mix(static_cast<std::uint32_t>(segment.speedProfile));
+            });
+    }
+
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdull;
+    hash ^= hash >> 33;
+    return hash;
+}
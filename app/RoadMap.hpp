@@ -3,22 +3,87 @@
 // ICS 46 Winter 2019
 // Project #4: Rock and Roll Stops the Traffic
 //
-// This header defines a type RoadMap, which is simply a typedef to a particular
-// instantiation of the Digraph template, where each vertex has a string for its
-// information and each edge has a RoadSegment for its information.
+// This header defines a type RoadMap, which is a particular instantiation
+// of the Digraph template, where each vertex has the name of a location
+// for its information and each edge has a RoadSegment for its information.
+//
+// Location names are kept in a StringPool rather than each in a
+// std::string of its own, so vertexInfo() hands back a std::string_view
+// into the pool; it stays valid for as long as the RoadMap (or any copy of
+// it, since copies share the pool).  A RoadMap also indexes its locations
+// by name, so that a location can be looked up by name as quickly as by
+// number.
 
 #ifndef ROADMAP_HPP
 #define ROADMAP_HPP
 
-#include <string>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
 #include "Digraph.hpp"
 #include "RoadSegment.hpp"
+#include "StringPool.hpp"
 
 
 
-typedef Digraph<std::string, RoadSegment> RoadMap;
+class RoadMap : public Digraph<std::string_view, RoadSegment>
+{
+public:
+    // Initializes an empty RoadMap.
+    RoadMap();
 
+    // addVertex() adds a location with the given number and name, which
+    // is copied into the map's StringPool (locations with the same name
+    // share one copy).  If there is already a location with the given
+    // number, a DigraphException is thrown instead.
+    void addVertex(int vertex, std::string_view name);
 
+    // removeVertex() removes the location with the given number, along
+    // with its road segments.  If it does not exist, a DigraphException
+    // is thrown instead.
+    void removeVertex(int vertex);
 
-#endif // ROADMAP_HPP
+    // removeVertices() removes the locations with the given numbers,
+    // along with their road segments, in one pass over the map.  If any
+    // of them does not exist, a DigraphException is thrown instead, and
+    // nothing is removed.
+    void removeVertices(const std::vector<int>& vertices);
+
+    // hasVertexNamed() returns true if some location has the given name.
+    bool hasVertexNamed(std::string_view name) const;
+
+    // vertexNamed() returns the number of the location with the given
+    // name (the lowest-numbered one, if several share it).  If there is
+    // none, a DigraphException is thrown instead.
+    int vertexNamed(std::string_view name) const;
+
+    // memoryUsage() returns the Digraph's breakdown (see Digraph.hpp),
+    // along with the memory used by the pool of location names and the
+    // index of locations by name.  Copies of a RoadMap share one pool, so
+    // each of them counts all of it.
+    MemoryUsage memoryUsage() const;
+
+    // estimateBytes() returns about how many bytes memoryUsage() would
+    // report in total for a RoadMap with the given numbers of locations
+    // and road segments, whose names add up to the given number of bytes.
+    static std::size_t estimateBytes(int locationCount, int roadSegmentCount, std::size_t nameBytes);
 
+    // checksum() returns a 64-bit checksum of the locations' numbers and
+    // every road segment (its endpoints, length, speed and speed profile),
+    // in the order they're stored, so that anything saved for one map can
+    // tell whether it's being loaded against the same one -- even in a
+    // later run of the program, unlike version().  Location names don't
+    // affect paths, so they're left out.
+    std::uint64_t checksum() const;
+
+
+private:
+    std::shared_ptr<StringPool> names;
+    std::unordered_map<std::string_view, int> vertexByName;
+};
+
+
+
+#endif // ROADMAP_HPP
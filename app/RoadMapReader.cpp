@@ -1,40 +1,432 @@
-// RoadMap.cpp
+// RoadMapReader.cpp
 //
 // ICS 46 Winter 2019
 // Project #4: Rock and Roll Stops the Traffic
 
 #include <algorithm>
-#include <sstream>
+#include <cctype>
+#include <charconv>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <system_error>
+#include <vector>
+#include "ParallelFor.hpp"
 #include "RoadMapReader.hpp"
 
 
+namespace
+{
+    // The road-segment section of a file is split into chunks of at
+    // least this many bytes, and about this many chunks per thread, so
+    // that a thread that finishes early can pick up another.
+    const std::size_t minimumChunkBytes = 1 << 20;
+    const unsigned int chunksPerThread = 4;
+
+    // Names aren't known until they're read, so they're estimated at this
+    // many bytes each.
+    const std::size_t estimatedNameBytes = 16;
+
+
+    struct ParsedSegment
+    {
+        int fromLocation;
+        int toLocation;
+        RoadSegment segment;
+    };
+
+
+    bool isSpace(char c)
+    {
+        return std::isspace(static_cast<unsigned char>(c));
+    }
+
+
+    //returns the end of [begin, end) with trailing whitespace removed
+    const char* trimRight(const char* begin, const char* end)
+    {
+        while (end != begin && isSpace(end[-1]))
+        {
+            --end;
+        }
+        return end;
+    }
+
+
+    //the same rule InputReader uses, applied to an already-trimmed line
+    bool isMeaningful(const char* begin, const char* end)
+    {
+        return begin != end && *begin != '#';
+    }
+
+
+    //reads one whitespace-separated number starting at p, moving p past it
+    template <typename Number>
+    bool parseField(const char*& p, const char* end, Number& value)
+    {
+        while (p != end && isSpace(*p))
+        {
+            ++p;
+        }
+
+        std::from_chars_result result = std::from_chars(p, end, value);
+        if (result.ec != std::errc{} || (result.ptr != end && !isSpace(*result.ptr)))
+        {
+            return false;
+        }
+
+        p = result.ptr;
+        return true;
+    }
+
+
+    //parses a trimmed line holding a count, throwing if it isn't one
+    int parseCount(const char* begin, const char* end, int lineNumber, const std::string& what)
+    {
+        int count;
+        if (!parseField(begin, end, count) || begin != end || count < 0)
+        {
+            throw RoadMapReaderException("expected the " + what, lineNumber);
+        }
+        return count;
+    }
+
+
+    //parses a trimmed road-segment line, returning a description of what's
+    //wrong with it, or an empty string if nothing is
+    std::string parseRoadSegment(
+        const char* begin, const char* end, int numberOfLocations, ParsedSegment& parsed)
+    {
+        if (!parseField(begin, end, parsed.fromLocation) ||
+            !parseField(begin, end, parsed.toLocation) ||
+            !parseField(begin, end, parsed.segment.miles) ||
+            !parseField(begin, end, parsed.segment.milesPerHour))
+        {
+            return "expected a road segment (from, to, miles, miles per hour)";
+        }
+
+        //a fifth field, if there is one, is the segment's speed profile
+        parsed.segment.speedProfile = noSpeedProfile;
+        while (begin != end && isSpace(*begin))
+        {
+            ++begin;
+        }
+        if (begin != end &&
+            (!parseField(begin, end, parsed.segment.speedProfile) || parsed.segment.speedProfile < 0))
+        {
+            return "expected a speed profile number after the speed";
+        }
+
+        for (int location : {parsed.fromLocation, parsed.toLocation})
+        {
+            if (location < 0 || location >= numberOfLocations)
+            {
+                return "no location numbered " + std::to_string(location);
+            }
+        }
+
+        return "";
+    }
+
+
+    //charges the budget, if there is one, an estimate of a map with the
+    //given numbers of locations and road segments, less what's already
+    //been charged for it, and returns the new estimate
+    std::size_t chargeEstimate(
+        MemoryBudget* budget, const std::string& what, int numberOfLocations,
+        int numberOfRoadSegments, std::size_t charged)
+    {
+        std::size_t estimate = RoadMap::estimateBytes(
+            numberOfLocations, numberOfRoadSegments, numberOfLocations * estimatedNameBytes);
+        if (budget != nullptr && estimate > charged)
+        {
+            budget->charge(what, estimate - charged);
+        }
+        return std::max(estimate, charged);
+    }
+
+
+    //reads a line from the InputReader, turning running out of input into
+    //a RoadMapReaderException
+    std::string readLine(InputReader& in)
+    {
+        try
+        {
+            return in.readLine();
+        }
+        catch (InputReaderException&)
+        {
+            throw RoadMapReaderException("unexpected end of input", in.lineNumber());
+        }
+    }
+
+
+    //Steps through the meaningful lines at the start of a file that's
+    //been read into memory, counting lines as it goes
+    class LineCursor
+    {
+    public:
+        LineCursor(const std::string& text)
+            : text_{text}, position_{0}, lineNumber_{0}
+        {
+        }
+
+        //finds the next meaningful line, storing its (trimmed) bounds
+        void next(const char*& begin, const char*& end)
+        {
+            while (true)
+            {
+                if (position_ >= text_.size())
+                {
+                    throw RoadMapReaderException("unexpected end of file", lineNumber_);
+                }
+
+                begin = text_.data() + position_;
+                const void* newline = std::memchr(begin, '\n', text_.size() - position_);
+                const char* lineEnd = newline != nullptr
+                    ? static_cast<const char*>(newline) : text_.data() + text_.size();
+
+                position_ = lineEnd - text_.data() + 1;
+                ++lineNumber_;
+
+                end = trimRight(begin, lineEnd);
+                if (isMeaningful(begin, end))
+                {
+                    return;
+                }
+            }
+        }
+
+        std::size_t position() const { return position_; }
+        int lineNumber() const { return lineNumber_; }
+
+    private:
+        const std::string& text_;
+        std::size_t position_;
+        int lineNumber_;
+    };
+
+
+    //What one thread found in one chunk of the road-segment section.  It
+    //can't know how many road segments came before its chunk, so it
+    //parses every meaningful line; whatever lies past the last road
+    //segment (and any error there) is thrown away afterward.
+    struct ParsedChunk
+    {
+        std::vector<ParsedSegment> segments;
+        int lineCount = 0;
+        int meaningfulLineCount = 0;
+
+        //the first line that couldn't be parsed, if there was one, as a
+        //line number within the chunk and an index among its meaningful
+        //lines
+        std::string error;
+        int errorLine = 0;
+        int errorIndex = 0;
+    };
+
+
+    void parseChunk(const char* begin, const char* end, int numberOfLocations, ParsedChunk& chunk)
+    {
+        chunk.segments.reserve((end - begin) / 16);
+
+        while (begin != end)
+        {
+            const void* newline = std::memchr(begin, '\n', end - begin);
+            const char* lineEnd = newline != nullptr ? static_cast<const char*>(newline) : end;
+            const char* trimmedEnd = trimRight(begin, lineEnd);
+            ++chunk.lineCount;
+
+            //after an error, lines are only counted, since the error may
+            //turn out to lie past the last road segment
+            if (isMeaningful(begin, trimmedEnd))
+            {
+                if (chunk.error.empty())
+                {
+                    ParsedSegment parsed;
+                    std::string error = parseRoadSegment(begin, trimmedEnd, numberOfLocations, parsed);
+
+                    if (error.empty())
+                    {
+                        chunk.segments.push_back(parsed);
+                    }
+                    else
+                    {
+                        chunk.error = error;
+                        chunk.errorLine = chunk.lineCount;
+                        chunk.errorIndex = chunk.meaningfulLineCount;
+                    }
+                }
+                ++chunk.meaningfulLineCount;
+            }
+
+            begin = lineEnd == end ? end : lineEnd + 1;
+        }
+    }
+}
+
+
+RoadMapReaderException::RoadMapReaderException(const std::string& reason, int lineNumber)
+    : std::runtime_error{lineNumber > 0 ? "line " + std::to_string(lineNumber) + ": " + reason : reason},
+      lineNumber_{lineNumber}
+{
+}
+
+
+int RoadMapReaderException::lineNumber() const noexcept
+{
+    return lineNumber_;
+}
+
+
+RoadMapReader::RoadMapReader(MemoryBudget* budget)
+    : budget{budget}
+{
+}
+
+
 RoadMap RoadMapReader::readRoadMap(InputReader& in)
 {
     RoadMap roadMap;
 
-    int numberOfLocations = in.readIntLine();
+    std::string line = readLine(in);
+    int numberOfLocations = parseCount(
+        line.data(), line.data() + line.size(), in.lineNumber(), "number of locations");
+    std::size_t charged = chargeEstimate(budget, "the map's locations", numberOfLocations, 0, 0);
 
     for (int i = 0; i < numberOfLocations; ++i)
     {
-        roadMap.addVertex(i, in.readLine());
+        roadMap.addVertex(i, readLine(in));
     }
 
-    int numberOfRoadSegments = in.readIntLine();
+    line = readLine(in);
+    int numberOfRoadSegments = parseCount(
+        line.data(), line.data() + line.size(), in.lineNumber(), "number of road segments");
+    chargeEstimate(budget, "the map's road segments", numberOfLocations, numberOfRoadSegments, charged);
 
     for (int i = 0; i < numberOfRoadSegments; ++i)
     {
-        std::istringstream roadSegmentLine{in.readLine()};
-
-        int fromLocation;
-        int toLocation;
-        double miles;
-        double milesPerHour;
+        line = readLine(in);
 
-        roadSegmentLine >> fromLocation >> toLocation >> miles >> milesPerHour;
+        ParsedSegment parsed;
+        std::string error = parseRoadSegment(
+            line.data(), line.data() + line.size(), numberOfLocations, parsed);
+        if (!error.empty())
+        {
+            throw RoadMapReaderException(error, in.lineNumber());
+        }
 
-        roadMap.addEdge(fromLocation, toLocation, RoadSegment{miles, milesPerHour});
+        roadMap.addEdge(parsed.fromLocation, parsed.toLocation, parsed.segment);
     }
 
     return roadMap;
 }
 
+
+RoadMap RoadMapReader::readRoadMapFile(const std::string& fileName, unsigned int threadCount)
+{
+    std::ifstream file{fileName, std::ios::binary | std::ios::ate};
+    if (!file)
+    {
+        throw RoadMapReaderException("could not open the file", 0);
+    }
+
+    //the whole file is held in memory while it's parsed
+    std::size_t fileBytes = static_cast<std::size_t>(file.tellg());
+    ScopedCharge textCharge{budget, "the text of " + fileName, fileBytes};
+
+    std::string text(fileBytes, '\0');
+    file.seekg(0);
+    if (!file.read(text.data(), fileBytes))
+    {
+        throw RoadMapReaderException("could not read the file", 0);
+    }
+
+    if (threadCount == 0)
+    {
+        threadCount = defaultThreadCount();
+    }
+
+    //the locations are read in order, just as readRoadMap() reads them
+    RoadMap roadMap;
+    LineCursor cursor{text};
+    const char* begin;
+    const char* end;
+
+    cursor.next(begin, end);
+    int numberOfLocations = parseCount(begin, end, cursor.lineNumber(), "number of locations");
+    std::size_t charged = chargeEstimate(budget, "the map's locations", numberOfLocations, 0, 0);
+
+    for (int i = 0; i < numberOfLocations; ++i)
+    {
+        cursor.next(begin, end);
+        roadMap.addVertex(i, std::string_view(begin, end - begin));
+    }
+
+    cursor.next(begin, end);
+    int numberOfRoadSegments = parseCount(begin, end, cursor.lineNumber(), "number of road segments");
+    chargeEstimate(budget, "the map's road segments", numberOfLocations, numberOfRoadSegments, charged);
+    if (numberOfRoadSegments == 0)
+    {
+        return roadMap;
+    }
+
+    //the rest of the file is split into chunks that each end just after a
+    //newline, so that no line is split between two of them
+    std::size_t sectionStart = std::min(cursor.position(), text.size());
+    std::size_t chunkBytes = std::max(
+        minimumChunkBytes, (text.size() - sectionStart) / (threadCount * chunksPerThread) + 1);
+
+    std::vector<std::size_t> boundaries{sectionStart};
+    while (boundaries.back() < text.size())
+    {
+        std::size_t next = boundaries.back() + chunkBytes;
+        const void* newline = next < text.size()
+            ? std::memchr(text.data() + next, '\n', text.size() - next) : nullptr;
+        boundaries.push_back(newline != nullptr
+            ? static_cast<const char*>(newline) - text.data() + 1 : text.size());
+    }
+
+    //each chunk sets aside room for a road segment per 16 bytes of it
+    std::size_t sectionBytes = text.size() - sectionStart;
+    ScopedCharge parsedCharge{budget, "the road segments parsed from " + fileName,
+                              (sectionBytes / 16 + boundaries.size()) * sizeof(ParsedSegment)};
+
+    std::vector<ParsedChunk> chunks(boundaries.size() - 1);
+    parallelFor(chunks.size(), threadCount,
+        [&](int chunk, unsigned int)
+        {
+            parseChunk(text.data() + boundaries[chunk], text.data() + boundaries[chunk + 1],
+                       numberOfLocations, chunks[chunk]);
+        });
+
+    //now that every chunk knows how many lines it holds, the chunks can
+    //be put back in order, stopping at the last road segment
+    int remaining = numberOfRoadSegments;
+    int lineNumber = cursor.lineNumber();
+
+    for (const ParsedChunk& chunk : chunks)
+    {
+        if (!chunk.error.empty() && chunk.errorIndex < remaining)
+        {
+            throw RoadMapReaderException(chunk.error, lineNumber + chunk.errorLine);
+        }
+
+        int taken = std::min(remaining, chunk.meaningfulLineCount);
+        for (int i = 0; i < taken; ++i)
+        {
+            const ParsedSegment& parsed = chunk.segments[i];
+            roadMap.addEdge(parsed.fromLocation, parsed.toLocation, parsed.segment);
+        }
+
+        remaining -= taken;
+        lineNumber += chunk.lineCount;
+        if (remaining == 0)
+        {
+            return roadMap;
+        }
+    }
+
+    throw RoadMapReaderException("unexpected end of file", lineNumber);
+}
+
@@ -6,22 +6,74 @@
 // The RoadMapReader class provides an object that knows how to read a
 // RoadMap from the standard input, using the format given in the
 // project write-up.
+//
+// A map that's stored in a file can also be read with readRoadMapFile(),
+// which parses its road segments -- by far the biggest part of a large
+// map -- on several threads at once.  Both produce the same RoadMap from
+// the same input.
+//
+// A road segment's line may end with a fifth field, the number of the
+// speed profile it follows (see SpeedProfiles.hpp).
+//
+// Input that isn't in the expected format causes a RoadMapReaderException
+// to be thrown, which says what was wrong and on which line.
+//
+// A RoadMapReader may be given a MemoryBudget (see MemoryBudget.hpp).  It
+// charges the budget an estimate of the map's size (see
+// RoadMap::estimateBytes()) as soon as it has read the number of locations
+// and then the number of road segments, before it builds them, along with
+// the buffers it needs only while reading; a map too big for the budget is
+// refused with a MemoryBudgetException before it's built.  The estimate
+// stays charged once the map has been read, for the caller to settle
+// against the map's actual memoryUsage().
 
 #ifndef ROADMAPREADER_HPP
 #define ROADMAPREADER_HPP
 
+#include <stdexcept>
+#include <string>
+#include "MemoryBudget.hpp"
 #include "RoadMap.hpp"
 #include "InputReader.hpp"
 
 
 
+class RoadMapReaderException : public std::runtime_error
+{
+public:
+    // lineNumber counts from 1; 0 means the problem isn't on any
+    // particular line (e.g., the file couldn't be opened).
+    RoadMapReaderException(const std::string& reason, int lineNumber);
+
+    int lineNumber() const noexcept;
+
+private:
+    int lineNumber_;
+};
+
+
+
 class RoadMapReader
 {
 public:
+    // Initializes a RoadMapReader that charges the given budget, if any,
+    // for the maps it reads.
+    explicit RoadMapReader(MemoryBudget* budget = nullptr);
+
     // readRoadMap() reads a RoadMap from the given InputReader.  The
     // RoadMap is expected to be described in the format given in the
     // project write-up.
     RoadMap readRoadMap(InputReader& in);
+
+    // readRoadMapFile() reads a RoadMap from the file with the given
+    // name, in the same format, using up to threadCount threads (0 means
+    // one per hardware thread) to parse its road segments.  Anything in
+    // the file after the last road segment is ignored.
+    RoadMap readRoadMapFile(const std::string& fileName, unsigned int threadCount = 0);
+
+
+private:
+    MemoryBudget* budget;
 };
 
 
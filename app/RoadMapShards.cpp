@@ -0,0 +1,326 @@
+// RoadMapShards.cpp
+//
+// ICS 46 Winter 2019
+// Project #4: Rock and Roll Stops the Traffic
+
+#include <algorithm>
+#include <charconv>
+#include <fstream>
+#include <limits>
+#include <vector>
+#include "MultilevelOverlay.hpp"
+#include "ParallelFor.hpp"
+#include "RoadMapShards.hpp"
+#include "RoadMapWeights.hpp"
+#include "SearchWorkspace.hpp"
+
+
+namespace
+{
+    // Each shard is made of about this many cells of the partition, so
+    // that the shards come out close to the same size.
+    const int cellsPerShard = 8;
+
+
+    //writes a number as briefly as it can be while still reading back as
+    //exactly the same number
+    std::ostream& writeNumber(std::ostream& out, double value)
+    {
+        char text[32];
+        std::to_chars_result result = std::to_chars(text, text + sizeof(text), value);
+        return out.write(text, result.ptr - text);
+    }
+
+
+    std::ofstream openFile(const std::string& fileName)
+    {
+        std::ofstream file{fileName};
+        if(!file)
+        {
+            throw ShardException("could not write " + fileName);
+        }
+        file<<"# written by writeRoadMapShards()\n";
+        return file;
+    }
+
+
+    void closeFile(std::ofstream& file, const std::string& fileName)
+    {
+        file.close();
+        if(!file)
+        {
+            throw ShardException("could not write " + fileName);
+        }
+    }
+
+
+    //writes a road segment's miles, speed and (if it has one) profile
+    void writeSegment(std::ostream& out, const RoadSegment& segment)
+    {
+        writeNumber(out, segment.miles)<<" ";
+        writeNumber(out, segment.milesPerHour);
+        if(segment.speedProfile != noSpeedProfile)
+        {
+            out<<" "<<segment.speedProfile;
+        }
+    }
+
+
+    //A shard's locations, renumbered from 0 in increasing order of their
+    //numbers in the whole map
+    struct Shard
+    {
+        std::vector<int> vertices;
+        std::vector<bool> boundary;
+        RoadMap roadMap;
+    };
+
+
+    struct CrossingSegment
+    {
+        int fromVertex;
+        int toVertex;
+        RoadSegment segment;
+    };
+
+
+    struct BoundaryCost
+    {
+        int to;
+        double miles;
+        double seconds;
+    };
+
+
+    //The shortest paths inside a shard from one boundary location to the
+    //others
+    struct BoundaryPaths
+    {
+        int shard;
+        int from;
+        std::vector<BoundaryCost> costs;
+    };
+}
+
+
+ShardException::ShardException(const std::string& reason)
+    : std::runtime_error{reason}
+{
+}
+
+
+std::string shardMapFile(const std::string& directory, int shard)
+{
+    return directory + "/shard-" + std::to_string(shard) + ".map";
+}
+
+
+std::string shardIdsFile(const std::string& directory, int shard)
+{
+    return directory + "/shard-" + std::to_string(shard) + ".ids";
+}
+
+
+std::string shardManifestFile(const std::string& directory)
+{
+    return directory + "/shards.txt";
+}
+
+
+void writeRoadMapShards(
+    const RoadMap& roadMap, int shardCount, const std::string& directory,
+    unsigned int threadCount)
+{
+    if(shardCount < 1)
+    {
+        throw ShardException("there must be at least one shard");
+    }
+
+    //the partition only cares about the shape of the map, so any weights
+    //will do
+    CompactDigraph<double> graph = compactRoadMap(roadMap, TripMetric::Distance);
+    int vertexCount = graph.vertexCount();
+    int cellSize = std::max(1, vertexCount / (shardCount * cellsPerShard));
+    CellPartition partition{graph, {cellSize}};
+
+    //cells are numbered in the order the partition split them off, so
+    //neighboring cells tend to have nearby numbers; they're handed out in
+    //that order, moving on to the next shard once one has its share
+    std::vector<int> cellVertexCounts(partition.cellCount(0), 0);
+    for(int index = 0; index < vertexCount; ++index)
+    {
+        ++cellVertexCounts[partition.cellOf(0, index)];
+    }
+
+    std::vector<int> shardOfCell(partition.cellCount(0));
+    int shard = 0;
+    long assigned = 0;
+    for(int cell = 0; cell < partition.cellCount(0); ++cell)
+    {
+        if(assigned >= static_cast<long>(shard + 1) * vertexCount / shardCount && shard < shardCount - 1)
+        {
+            ++shard;
+        }
+        shardOfCell[cell] = shard;
+        assigned += cellVertexCounts[cell];
+    }
+
+    std::vector<int> shardOf(vertexCount);
+    std::vector<int> localIndex(vertexCount);
+    std::vector<Shard> shards(shardCount);
+
+    for(int index = 0; index < vertexCount; ++index)
+    {
+        Shard& owner = shards[shardOf[index] = shardOfCell[partition.cellOf(0, index)]];
+        localIndex[index] = owner.vertices.size();
+        owner.vertices.push_back(graph.vertexNumber(index));
+        owner.boundary.push_back(false);
+        owner.roadMap.addVertex(localIndex[index], roadMap.vertexInfo(graph.vertexNumber(index)));
+    }
+
+    std::vector<CrossingSegment> crossings;
+
+    for(int index = 0; index < vertexCount; ++index)
+    {
+        roadMap.forEachOutgoingEdge(graph.vertexNumber(index),
+            [&](int toVertex, const RoadSegment& segment)
+            {
+                int to = graph.indexOf(toVertex);
+                if(shardOf[to] == shardOf[index])
+                {
+                    shards[shardOf[index]].roadMap.addEdge(localIndex[index], localIndex[to], segment);
+                }
+                else
+                {
+                    shards[shardOf[index]].boundary[localIndex[index]] = true;
+                    shards[shardOf[to]].boundary[localIndex[to]] = true;
+                    crossings.push_back(CrossingSegment{graph.vertexNumber(index), toVertex, segment});
+                }
+            });
+    }
+
+    //one search per boundary location and metric, spread across threads
+    std::vector<BoundaryPaths> paths;
+    for(int k = 0; k < shardCount; ++k)
+    {
+        for(unsigned int local = 0; local < shards[k].vertices.size(); ++local)
+        {
+            if(shards[k].boundary[local])
+            {
+                paths.push_back(BoundaryPaths{k, static_cast<int>(local), {}});
+            }
+        }
+    }
+
+    if(threadCount == 0)
+    {
+        threadCount = defaultThreadCount();
+    }
+    std::vector<SearchWorkspace<double>> workspaces(threadCount);
+    const double infinity = std::numeric_limits<double>::infinity();
+
+    parallelFor(paths.size(), threadCount,
+        [&](int i, unsigned int threadIndex)
+        {
+            BoundaryPaths& from = paths[i];
+            const Shard& current = shards[from.shard];
+
+            //both searches reach the same locations, in different orders,
+            //so the driving times are looked up by location
+            thread_local std::vector<double> seconds;
+            seconds.assign(current.vertices.size(), infinity);
+            for(const std::pair<int, double>& reached : findReachable(
+                    current.roadMap, from.from, TripMetric::Time, infinity, workspaces[threadIndex]))
+            {
+                seconds[reached.first] = reached.second;
+            }
+
+            for(const std::pair<int, double>& reached : findReachable(
+                    current.roadMap, from.from, TripMetric::Distance, infinity, workspaces[threadIndex]))
+            {
+                if(reached.first != from.from && current.boundary[reached.first])
+                {
+                    from.costs.push_back(BoundaryCost{reached.first, reached.second, seconds[reached.first]});
+                }
+            }
+        });
+
+    for(int k = 0; k < shardCount; ++k)
+    {
+        const Shard& current = shards[k];
+
+        std::string mapFile = shardMapFile(directory, k);
+        std::ofstream out = openFile(mapFile);
+        out<<current.vertices.size()<<"\n";
+        for(unsigned int local = 0; local < current.vertices.size(); ++local)
+        {
+            out<<current.roadMap.vertexInfo(local)<<"\n";
+        }
+        out<<current.roadMap.edgeCount()<<"\n";
+        for(unsigned int local = 0; local < current.vertices.size(); ++local)
+        {
+            current.roadMap.forEachOutgoingEdge(local,
+                [&](int toVertex, const RoadSegment& segment)
+                {
+                    out<<local<<" "<<toVertex<<" ";
+                    writeSegment(out, segment);
+                    out<<"\n";
+                });
+        }
+        closeFile(out, mapFile);
+
+        std::string idsFile = shardIdsFile(directory, k);
+        out = openFile(idsFile);
+        out<<current.vertices.size()<<"\n";
+        for(unsigned int local = 0; local < current.vertices.size(); ++local)
+        {
+            out<<current.vertices[local]<<" "<<current.boundary[local]<<"\n";
+        }
+        closeFile(out, idsFile);
+    }
+
+    std::string manifestFile = shardManifestFile(directory);
+    std::ofstream out = openFile(manifestFile);
+
+    out<<shardCount<<"\n";
+    out<<vertexCount<<"\n";
+    for(int index = 0; index < vertexCount; ++index)
+    {
+        out<<graph.vertexNumber(index)<<" "<<shardOf[index]<<"\n";
+    }
+
+    out<<paths.size()<<"\n";
+    for(const BoundaryPaths& from : paths)
+    {
+        out<<shards[from.shard].vertices[from.from]<<" "<<from.shard<<" "
+           <<shards[from.shard].roadMap.vertexInfo(from.from)<<"\n";
+    }
+
+    out<<crossings.size()<<"\n";
+    for(const CrossingSegment& crossing : crossings)
+    {
+        out<<crossing.fromVertex<<" "<<crossing.toVertex<<" ";
+        writeNumber(out, crossing.segment.miles)<<" ";
+        writeNumber(out, crossing.segment.milesPerHour)<<" "<<crossing.segment.speedProfile<<"\n";
+    }
+
+    long costCount = 0;
+    for(const BoundaryPaths& from : paths)
+    {
+        costCount += from.costs.size();
+    }
+
+    out<<costCount<<"\n";
+    for(const BoundaryPaths& from : paths)
+    {
+        const std::vector<int>& vertices = shards[from.shard].vertices;
+        for(const BoundaryCost& cost : from.costs)
+        {
+            out<<from.shard<<" "<<vertices[from.from]<<" "<<vertices[cost.to]<<" ";
+            writeNumber(out, cost.miles)<<" ";
+            writeNumber(out, cost.seconds)<<"\n";
+        }
+    }
+
+    closeFile(out, manifestFile);
+}
@@ -0,0 +1,75 @@
+// RoadMapShards.hpp
+//
+// ICS 46 Winter 2019
+// Project #4: Rock and Roll Stops the Traffic
+//
+// A map too big for one process can be split into shards, each small
+// enough for a process of its own (see ShardWorker.hpp), with a
+// coordinator (see ShardCoordinator.hpp) answering trips by combining
+// searches inside the shards.  writeRoadMapShards() does the splitting.
+//
+// Locations are divided among the shards with a CellPartition (see
+// MultilevelOverlay.hpp), whose small cells are grouped, in the order the
+// partition numbers them, into shards of about the same size, so that
+// each shard is a compact region with few road segments leaving it.  A
+// location with a road segment to or from another shard is a "boundary"
+// location.  For every pair of boundary locations in the same shard, the
+// length and driving time of the shortest path between them inside the
+// shard are worked out in advance, so the coordinator can cross a whole
+// shard in one step.
+//
+// writeRoadMapShards() writes these files into a directory:
+//
+//     shard-K.map   shard K's locations and the road segments between
+//                   them, in the format RoadMapReader reads, with the
+//                   locations numbered from 0 within the shard
+//     shard-K.ids   the number of shard K's locations, then one line for
+//                   each, in order: its number in the whole map, and 1 if
+//                   it's a boundary location (0 if not)
+//     shards.txt    for the coordinator: the number of shards; the number
+//                   of locations, then one line per location giving its
+//                   number and shard; the number of boundary locations,
+//                   then one line for each giving its number, shard and
+//                   name; the number of road segments between shards,
+//                   then one line for each (from, to, miles, miles per
+//                   hour, speed profile); and the number of paths between
+//                   boundary locations, then one line for each (shard,
+//                   from, to, miles, seconds)
+//
+// Blank lines and lines beginning with '#' are skipped in all of them.
+
+#ifndef ROADMAPSHARDS_HPP
+#define ROADMAPSHARDS_HPP
+
+#include <stdexcept>
+#include <string>
+#include "RoadMap.hpp"
+
+
+
+class ShardException : public std::runtime_error
+{
+public:
+    ShardException(const std::string& reason);
+};
+
+
+
+// The names of the files in a shard directory.
+std::string shardMapFile(const std::string& directory, int shard);
+std::string shardIdsFile(const std::string& directory, int shard);
+std::string shardManifestFile(const std::string& directory);
+
+
+// writeRoadMapShards() splits the given RoadMap into the given number of
+// shards and writes them into the given directory (which must already
+// exist), as described above, using up to threadCount threads (0 means
+// one per hardware thread) to find the paths between boundary locations.
+// If a file can't be written, a ShardException is thrown.
+void writeRoadMapShards(
+    const RoadMap& roadMap, int shardCount, const std::string& directory,
+    unsigned int threadCount = 0);
+
+
+
+#endif // ROADMAPSHARDS_HPP
@@ -0,0 +1,170 @@
+// RoadMapWeights.hpp
+//
+// ICS 46 Winter 2019
+// Project #4: Rock and Roll Stops the Traffic
+//
+// This header defines the edge weight policies used to route trips over a
+// RoadMap, one per TripMetric.  Each is a small function object taking a
+// RoadSegment, so it can be passed anywhere an edge weight function is
+// expected, but unlike a std::function its call can be inlined into the
+// search that uses it.
+//
+// MetricWeight<metric>::type names the policy for a TripMetric known at
+// compile time; withMetricWeight() chooses one for a TripMetric only known
+// at run time, making the choice once per call rather than once per edge.
+// findReachable() uses it to answer bounded searches for either metric.
+//
+// QuantizedWeight turns either policy into one that produces unsigned
+// integers in fixed-point units (hundredths of a mile, milliseconds), for
+// searches that use an integer priority queue.
+
+#ifndef ROADMAPWEIGHTS_HPP
+#define ROADMAPWEIGHTS_HPP
+
+#include <cmath>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "CompactDigraph.hpp"
+#include "RoadMap.hpp"
+#include "RoadSegment.hpp"
+#include "TripMetric.hpp"
+
+
+
+// DistanceWeight weighs a road segment by its length, in miles.
+struct DistanceWeight
+{
+    double operator()(const RoadSegment& segment) const
+    {
+        return segment.miles;
+    }
+};
+
+
+// TimeWeight weighs a road segment by the number of seconds it takes to
+// drive it at its current speed.
+struct TimeWeight
+{
+    double operator()(const RoadSegment& segment) const
+    {
+        return 3600 * segment.miles / segment.milesPerHour;
+    }
+};
+
+
+
+template <TripMetric metric>
+struct MetricWeight;
+
+template <>
+struct MetricWeight<TripMetric::Distance>
+{
+    typedef DistanceWeight type;
+};
+
+template <>
+struct MetricWeight<TripMetric::Time>
+{
+    typedef TimeWeight type;
+};
+
+
+
+// QuantizedWeight<Policy, scale> weighs a road segment by Policy's weight
+// multiplied by scale and rounded to the nearest integer.
+template <typename WeightPolicy, unsigned int scale>
+struct QuantizedWeight
+{
+    std::uint32_t operator()(const RoadSegment& segment) const
+    {
+        return static_cast<std::uint32_t>(std::lround(WeightPolicy{}(segment) * scale));
+    }
+};
+
+
+// Distances are quantized to hundredths of a mile and times to
+// milliseconds, which is finer than the two decimal places printed in
+// directions.
+constexpr unsigned int quantizedDistanceScale = 100;
+constexpr unsigned int quantizedTimeScale = 1000;
+
+typedef QuantizedWeight<DistanceWeight, quantizedDistanceScale> QuantizedDistanceWeight;
+typedef QuantizedWeight<TimeWeight, quantizedTimeScale> QuantizedTimeWeight;
+
+
+
+// withMetricWeight() calls func with the weight policy for the given
+// TripMetric, returning whatever func returns.  func is typically a
+// generic lambda, which is compiled once for each policy.
+template <typename Func>
+auto withMetricWeight(TripMetric metric, Func func)
+{
+    if(metric == TripMetric::Time)
+    {
+        return func(TimeWeight{});
+    }
+    return func(DistanceWeight{});
+}
+
+
+
+// findReachable() finds the locations within the given budget of the
+// start vertex -- in miles or seconds, depending on the TripMetric -- as
+// Digraph::findReachable() does.  The second form does the same for many
+// start vertices at once, using up to threadCount threads.
+inline std::vector<std::pair<int, double>> findReachable(
+    const RoadMap& roadMap, int startVertex, TripMetric metric, double budget,
+    SearchWorkspace<double>& workspace)
+{
+    return withMetricWeight(metric,
+        [&](auto weight)
+        {
+            return roadMap.findReachable(startVertex, weight, budget, workspace);
+        });
+}
+
+
+inline std::vector<std::vector<std::pair<int, double>>> findReachable(
+    const RoadMap& roadMap, const std::vector<int>& startVertices, TripMetric metric,
+    double budget, unsigned int threadCount = 0)
+{
+    return withMetricWeight(metric,
+        [&](auto weight)
+        {
+            return roadMap.findReachable(startVertices, weight, budget, threadCount);
+        });
+}
+
+
+
+// compactRoadMap() takes a CompactDigraph snapshot of the given RoadMap
+// weighted for the given TripMetric, so that the weight of each edge
+// (including the division needed to turn a speed into a driving time)
+// is worked out once, when the snapshot is taken, instead of during
+// every search.
+inline CompactDigraph<double> compactRoadMap(const RoadMap& roadMap, TripMetric metric)
+{
+    return withMetricWeight(metric,
+        [&](auto weight)
+        {
+            return CompactDigraph<double>(roadMap, weight);
+        });
+}
+
+
+// compactRoadMapQuantized() is like compactRoadMap(), but weighs each edge
+// with QuantizedDistanceWeight or QuantizedTimeWeight instead.
+inline CompactDigraph<std::uint32_t> compactRoadMapQuantized(
+    const RoadMap& roadMap, TripMetric metric)
+{
+    if(metric == TripMetric::Time)
+    {
+        return CompactDigraph<std::uint32_t>(roadMap, QuantizedTimeWeight{});
+    }
+    return CompactDigraph<std::uint32_t>(roadMap, QuantizedDistanceWeight{});
+}
+
+
+
+#endif // ROADMAPWEIGHTS_HPP
@@ -25,6 +25,11 @@ void RoadMapWriter::writeRoadMap(std::ostream& out, const RoadMap& roadMap)
         RoadSegment segment = roadMap.edgeInfo(edge.first, edge.second);
         out << segment.miles << "miles; " << segment.milesPerHour << "mph";
 
+        if (segment.speedProfile != noSpeedProfile)
+        {
+            out << "; profile " << segment.speedProfile;
+        }
+
         out << std::endl;
     }
 
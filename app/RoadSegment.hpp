@@ -7,19 +7,29 @@
 // about a segment of road, namely the distance (in miles) that the
 // segment spans and the speed (in miles per hour) that traffic is
 // currently travelling on that road.
+//
+// A segment whose speed changes through the day also names a speed
+// profile (see SpeedProfiles.hpp), which scales its speed up or down
+// depending on the time of day.  Many segments share each profile, so
+// a segment only stores the profile's number.
 
 #ifndef ROADSEGMENT_HPP
 #define ROADSEGMENT_HPP
 
 
 
+// noSpeedProfile is the speedProfile of a segment whose speed never
+// changes.
+constexpr int noSpeedProfile = -1;
+
+
 struct RoadSegment
 {
     double miles;
     double milesPerHour;
+    int speedProfile = noSpeedProfile;
 };
 
 
 
 #endif // ROADSEGMENT_HPP
-
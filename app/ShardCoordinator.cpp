@@ -0,0 +1,543 @@
+// ShardCoordinator.cpp
+//
+// ICS 46 Winter 2019
+// Project #4: Rock and Roll Stops the Traffic
+
+#include <algorithm>
+#include <csignal>
+#include <cstdlib>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "InputReader.hpp"
+#include "RoadMapShards.hpp"
+#include "RoadMapWeights.hpp"
+#include "SearchWorkspace.hpp"
+#include "ShardCoordinator.hpp"
+#include "TripWriter.hpp"
+
+
+namespace
+{
+    const double infinity = std::numeric_limits<double>::infinity();
+
+
+    //An edge of the overlay as it's read, before the edges are grouped
+    //by the location they leave
+    struct OverlayEdge
+    {
+        int from;
+        int to;
+        double miles;
+        double seconds;
+        int step;
+    };
+
+
+    //reads one line of the manifest into the given fields, throwing if
+    //they aren't all there
+    template <typename... Fields>
+    void readFields(InputReader& in, const std::string& what, Fields&... fields)
+    {
+        std::istringstream line{in.readLine()};
+        if(!(line >> ... >> fields))
+        {
+            throw ShardException(
+                "line " + std::to_string(in.lineNumber()) + ": expected " + what);
+        }
+    }
+
+
+    const char* metricName(TripMetric metric)
+    {
+        return metric == TripMetric::Distance ? "D" : "T";
+    }
+}
+
+
+ShardCoordinator::ShardCoordinator(const std::string& directory, const std::string& program)
+{
+    std::string manifestFile = shardManifestFile(directory);
+    std::ifstream manifestStream{manifestFile};
+    if(!manifestStream)
+    {
+        throw ShardException("could not open " + manifestFile);
+    }
+
+    std::vector<int> boundaryVertices;
+    std::vector<OverlayEdge> edges;
+    int shardCount;
+
+    try
+    {
+        InputReader manifest{manifestStream};
+        int count;
+
+        readFields(manifest, "the number of shards", shardCount);
+
+        readFields(manifest, "the number of locations", count);
+        for(int i = 0; i < count; ++i)
+        {
+            int vertex;
+            int shard;
+            readFields(manifest, "a location and its shard", vertex, shard);
+            shards.emplace(vertex, shard);
+        }
+
+        readFields(manifest, "the number of boundary locations", count);
+        for(int i = 0; i < count; ++i)
+        {
+            std::istringstream line{manifest.readLine()};
+            int vertex;
+            int shard;
+            std::string name;
+            if(!(line >> vertex >> shard) || !std::getline(line >> std::ws, name))
+            {
+                throw ShardException(
+                    "line " + std::to_string(manifest.lineNumber()) +
+                    ": expected a boundary location, its shard and its name");
+            }
+            boundaryVertices.push_back(vertex);
+            boundaryNames.emplace(vertex, name);
+        }
+
+        readFields(manifest, "the number of road segments between shards", count);
+        for(int i = 0; i < count; ++i)
+        {
+            int from;
+            int to;
+            RoadSegment segment;
+            readFields(manifest, "a road segment", from, to,
+                       segment.miles, segment.milesPerHour, segment.speedProfile);
+
+            edges.push_back(OverlayEdge{from, to, segment.miles, TimeWeight{}(segment),
+                                        static_cast<int>(steps.size())});
+            steps.push_back(OverlayStep{-1, segment});
+        }
+
+        readFields(manifest, "the number of paths across shards", count);
+        for(int i = 0; i < count; ++i)
+        {
+            int shard;
+            int from;
+            int to;
+            double miles;
+            double seconds;
+            readFields(manifest, "a path across a shard", shard, from, to, miles, seconds);
+
+            edges.push_back(OverlayEdge{from, to, miles, seconds, static_cast<int>(steps.size())});
+            steps.push_back(OverlayStep{shard, RoadSegment{0, 0}});
+        }
+    }
+    catch(InputReaderException& e)
+    {
+        throw ShardException(manifestFile + ": " + e.what());
+    }
+    catch(ShardException& e)
+    {
+        throw ShardException(manifestFile + ": " + e.what());
+    }
+
+    //the overlay's arrays are laid out as CompactDigraph expects them,
+    //with the steps put in the same order as the edges
+    std::sort(boundaryVertices.begin(), boundaryVertices.end());
+    auto indexOf = [&](int vertex)
+    {
+        auto found = std::lower_bound(boundaryVertices.begin(), boundaryVertices.end(), vertex);
+        if(found == boundaryVertices.end() || *found != vertex)
+        {
+            throw ShardException(manifestFile + ": " + std::to_string(vertex) +
+                                 " isn't listed as a boundary location");
+        }
+        return static_cast<int>(found - boundaryVertices.begin());
+    };
+
+    for(OverlayEdge& edge : edges)
+    {
+        edge.from = indexOf(edge.from);
+        edge.to = indexOf(edge.to);
+    }
+    std::stable_sort(edges.begin(), edges.end(),
+        [](const OverlayEdge& a, const OverlayEdge& b)
+        {
+            return a.from < b.from;
+        });
+
+    std::vector<int> offsets(boundaryVertices.size() + 1, 0);
+    std::vector<int> targets;
+    std::vector<double> miles;
+    std::vector<double> seconds;
+    std::vector<OverlayStep> orderedSteps;
+
+    for(const OverlayEdge& edge : edges)
+    {
+        ++offsets[edge.from + 1];
+        targets.push_back(edge.to);
+        miles.push_back(edge.miles);
+        seconds.push_back(edge.seconds);
+        orderedSteps.push_back(steps[edge.step]);
+        stepSources.push_back(edge.from);
+    }
+    for(unsigned int i = 1; i < offsets.size(); ++i)
+    {
+        offsets[i] += offsets[i - 1];
+    }
+
+    distanceOverlay = CompactDigraph<double>(boundaryVertices, offsets, targets, miles);
+    timeOverlay = CompactDigraph<double>(
+        std::move(boundaryVertices), std::move(offsets), std::move(targets), std::move(seconds));
+    steps = std::move(orderedSteps);
+
+    startWorkers(directory, program);
+
+    //each worker says when it has loaded its shard, so that a shard that
+    //can't be loaded is noticed now rather than in the middle of a trip
+    for(int shard = 0; shard < shardCount; ++shard)
+    {
+        if(receive(shard) != "READY")
+        {
+            throw ShardException("shard " + std::to_string(shard) + "'s worker didn't start");
+        }
+    }
+}
+
+
+ShardCoordinator::~ShardCoordinator() noexcept
+{
+    for(Worker& worker : workers)
+    {
+        close(worker.requests);
+        std::fclose(worker.replies);
+    }
+    for(Worker& worker : workers)
+    {
+        waitpid(worker.process, nullptr, 0);
+    }
+}
+
+
+void ShardCoordinator::startWorkers(const std::string& directory, const std::string& program)
+{
+    //a worker that dies should make send() fail, not end this process
+    std::signal(SIGPIPE, SIG_IGN);
+
+    int shardCount = 0;
+    for(const std::pair<const int, int>& owner : shards)
+    {
+        shardCount = std::max(shardCount, owner.second + 1);
+    }
+
+    for(int shard = 0; shard < shardCount; ++shard)
+    {
+        //every end is closed on exec, so a worker doesn't hold on to the
+        //pipes of the workers started before it
+        int requestPipe[2];
+        int replyPipe[2];
+        if(pipe2(requestPipe, O_CLOEXEC) < 0 || pipe2(replyPipe, O_CLOEXEC) < 0)
+        {
+            throw ShardException("could not create pipes for shard " + std::to_string(shard));
+        }
+
+        pid_t process = fork();
+        if(process < 0)
+        {
+            throw ShardException("could not start shard " + std::to_string(shard) + "'s worker");
+        }
+
+        if(process == 0)
+        {
+            dup2(requestPipe[0], STDIN_FILENO);
+            dup2(replyPipe[1], STDOUT_FILENO);
+
+            std::string shardText = std::to_string(shard);
+            execlp(program.c_str(), program.c_str(), "--shard-worker",
+                   directory.c_str(), shardText.c_str(), static_cast<char*>(nullptr));
+            _exit(127);
+        }
+
+        close(requestPipe[0]);
+        close(replyPipe[1]);
+        workers.push_back(Worker{process, requestPipe[1], fdopen(replyPipe[0], "r")});
+    }
+}
+
+
+void ShardCoordinator::send(int shard, const std::string& request)
+{
+    std::string line = request + "\n";
+    std::size_t sent = 0;
+
+    while(sent < line.size())
+    {
+        ssize_t count = write(workers[shard].requests, line.data() + sent, line.size() - sent);
+        if(count <= 0)
+        {
+            throw ShardException("shard " + std::to_string(shard) + "'s worker stopped answering");
+        }
+        sent += count;
+    }
+}
+
+
+std::string ShardCoordinator::receive(int shard)
+{
+    char* buffer = nullptr;
+    std::size_t capacity = 0;
+    ssize_t length = getline(&buffer, &capacity, workers[shard].replies);
+
+    std::string line = length > 0 ? std::string(buffer, length) : std::string{};
+    std::free(buffer);
+
+    if(length <= 0)
+    {
+        throw ShardException("shard " + std::to_string(shard) + "'s worker stopped answering");
+    }
+    if(line.back() == '\n')
+    {
+        line.pop_back();
+    }
+    if(line.compare(0, 5, "ERROR") == 0)
+    {
+        throw ShardException("shard " + std::to_string(shard) + ": " + line);
+    }
+    return line;
+}
+
+
+std::vector<std::pair<int, double>> ShardCoordinator::receiveCosts(int shard)
+{
+    std::istringstream reply{receive(shard)};
+    int count;
+    reply >> count;
+
+    std::vector<std::pair<int, double>> costs(std::max(count, 0));
+    for(std::pair<int, double>& cost : costs)
+    {
+        reply >> cost.first >> cost.second;
+    }
+    if(!reply)
+    {
+        throw ShardException("shard " + std::to_string(shard) + " sent malformed costs");
+    }
+    return costs;
+}
+
+
+void ShardCoordinator::addShardPath(
+    int shard, int from, int to, TripMetric metric, RoadMap& tripMap, std::vector<int>& path)
+{
+    send(shard, "P " + std::to_string(from) + " " + std::to_string(to) + " " + metricName(metric));
+    int count = std::stoi(receive(shard));
+    if(count == 0)
+    {
+        throw ShardException("shard " + std::to_string(shard) + " has no path it said it had");
+    }
+
+    for(int i = 0; i < count; ++i)
+    {
+        std::istringstream line{receive(shard)};
+        int vertex;
+        RoadSegment segment;
+        std::string name;
+        line >> vertex >> segment.miles >> segment.milesPerHour >> segment.speedProfile;
+        std::getline(line >> std::ws, name);
+
+        //each piece of the path starts where the last one ended
+        if(!path.empty() && path.back() == vertex)
+        {
+            continue;
+        }
+
+        if(!tripMap.hasVertex(vertex))
+        {
+            tripMap.addVertex(vertex, name);
+        }
+        if(!path.empty())
+        {
+            tripMap.addEdge(path.back(), vertex, segment);
+        }
+        path.push_back(vertex);
+    }
+}
+
+
+void ShardCoordinator::writeTrip(const Trip& trip, std::ostream& out)
+{
+    RoadMap tripMap;
+    std::vector<int> path;
+    routeTrip(trip, tripMap, path);
+
+    TripWriter writer;
+    writer.writeTrip(out, tripMap, trip, path);
+}
+
+
+void ShardCoordinator::findPath(const Trip& trip, std::vector<int>& path)
+{
+    RoadMap tripMap;
+    routeTrip(trip, tripMap, path);
+}
+
+
+void ShardCoordinator::routeTrip(const Trip& trip, RoadMap& tripMap, std::vector<int>& path)
+{
+    int startShard = shardOf(trip.startVertex);
+    int endShard = shardOf(trip.endVertex);
+    bool sameShard = startShard == endShard;
+    std::string metric = metricName(trip.metric);
+
+    //both shards are asked before either answer is waited for, so they
+    //search at the same time
+    send(startShard, "F " + std::to_string(trip.startVertex) + " " + metric +
+                     (sameShard ? " " + std::to_string(trip.endVertex) : ""));
+    send(endShard, "B " + std::to_string(trip.endVertex) + " " + metric);
+
+    std::vector<std::pair<int, double>> fromStart = receiveCosts(startShard);
+    std::vector<std::pair<int, double>> toEnd = receiveCosts(endShard);
+
+    const CompactDigraph<double>& overlay =
+        trip.metric == TripMetric::Distance ? distanceOverlay : timeOverlay;
+
+    //the path that stays inside the shard, if both ends are in one, is
+    //the one to beat
+    double best = infinity;
+    int bestExit = -1;
+    for(const std::pair<int, double>& cost : fromStart)
+    {
+        if(sameShard && cost.first == trip.endVertex)
+        {
+            best = cost.second;
+        }
+    }
+
+    //the predecessor of each overlay location is the edge it was reached
+    //by, or -1 for the boundary locations the search starts from
+    thread_local SearchWorkspace<double> workspace;
+    thread_local std::vector<double> exitCosts;
+    workspace.prepare(overlay.vertexCount());
+    exitCosts.assign(overlay.vertexCount(), infinity);
+
+    for(const std::pair<int, double>& cost : fromStart)
+    {
+        if(overlay.contains(cost.first) && shardOf(cost.first) == startShard)
+        {
+            int index = overlay.indexOf(cost.first);
+            workspace.reach(index, cost.second, -1);
+            workspace.push(cost.second, index);
+        }
+    }
+    for(const std::pair<int, double>& cost : toEnd)
+    {
+        if(overlay.contains(cost.first))
+        {
+            exitCosts[overlay.indexOf(cost.first)] = cost.second;
+        }
+    }
+
+    while(!workspace.heapEmpty())
+    {
+        std::pair<double, int> top = workspace.pop();
+
+        int current = top.second;
+        if(top.first > workspace.distance(current))
+        {
+            continue;
+        }
+        if(top.first >= best)
+        {
+            break;
+        }
+        if(top.first + exitCosts[current] < best)
+        {
+            best = top.first + exitCosts[current];
+            bestExit = current;
+        }
+
+        for(int edge = overlay.edgesBegin(current); edge < overlay.edgesEnd(current); ++edge)
+        {
+            int next = overlay.target(edge);
+            double candidate = top.first + overlay.weight(edge);
+
+            if(!workspace.reached(next) || candidate < workspace.distance(next))
+            {
+                workspace.reach(next, candidate, edge);
+                workspace.push(candidate, next);
+            }
+        }
+    }
+
+    path.clear();
+
+    if(best == infinity)
+    {
+        for(int vertex : {trip.startVertex, trip.endVertex})
+        {
+            if(!tripMap.hasVertex(vertex))
+            {
+                send(shardOf(vertex), "N " + std::to_string(vertex));
+                tripMap.addVertex(vertex, receive(shardOf(vertex)));
+            }
+        }
+    }
+    else if(bestExit == -1)
+    {
+        addShardPath(startShard, trip.startVertex, trip.endVertex, trip.metric, tripMap, path);
+    }
+    else
+    {
+        std::vector<int> route;
+        int entry = bestExit;
+        for(int edge = workspace.predecessor(entry); edge != -1; edge = workspace.predecessor(entry))
+        {
+            route.push_back(edge);
+            entry = stepSources[edge];
+        }
+        std::reverse(route.begin(), route.end());
+
+        addShardPath(startShard, trip.startVertex, overlay.vertexNumber(entry),
+                     trip.metric, tripMap, path);
+
+        for(int edge : route)
+        {
+            int from = overlay.vertexNumber(stepSources[edge]);
+            int to = overlay.vertexNumber(overlay.target(edge));
+
+            if(steps[edge].shard != -1)
+            {
+                addShardPath(steps[edge].shard, from, to, trip.metric, tripMap, path);
+            }
+            else
+            {
+                if(!tripMap.hasVertex(to))
+                {
+                    tripMap.addVertex(to, boundaryNames.at(to));
+                }
+                tripMap.addEdge(from, to, steps[edge].segment);
+                path.push_back(to);
+            }
+        }
+
+        addShardPath(endShard, overlay.vertexNumber(bestExit), trip.endVertex,
+                     trip.metric, tripMap, path);
+    }
+}
+
+
+int ShardCoordinator::shardCount() const noexcept
+{
+    return workers.size();
+}
+
+
+int ShardCoordinator::shardOf(int vertex) const
+{
+    auto found = shards.find(vertex);
+    if(found == shards.end())
+    {
+        throw DigraphException("Invalid Vertex");
+    }
+    return found->second;
+}
@@ -0,0 +1,126 @@
+// ShardCoordinator.hpp
+//
+// ICS 46 Winter 2019
+// Project #4: Rock and Roll Stops the Traffic
+//
+// A ShardCoordinator answers trips over a map that's been split into
+// shards by writeRoadMapShards() (see RoadMapShards.hpp), without ever
+// loading the whole map.  It starts one worker process per shard (each
+// running a ShardWorker; see ShardWorker.hpp), talks to each over a pair
+// of pipes, and keeps for itself only which shard each location is in and
+// the "overlay": the boundary locations, the road segments between
+// shards, and the precomputed paths across each shard between its
+// boundary locations.
+//
+// A trip is answered in three steps.  The shards holding its two ends are
+// asked (at the same time) for the costs from the start to their boundary
+// locations and from their boundary locations to the end; the overlay is
+// searched from the first set of boundary locations to the second, also
+// trying the path that stays inside the start's shard if both ends are in
+// it; and then each step of the winning route is turned into locations and
+// road segments by the shard it crosses.  Those are gathered into a small
+// RoadMap holding only the trip's path, which TripWriter writes out as it
+// would for a map loaded whole.
+//
+// Trips are routed by the segments' usual speeds, whether or not they say
+// when they leave.
+
+#ifndef SHARDCOORDINATOR_HPP
+#define SHARDCOORDINATOR_HPP
+
+#include <cstdio>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <sys/types.h>
+#include "CompactDigraph.hpp"
+#include "RoadMap.hpp"
+#include "RoadSegment.hpp"
+#include "Trip.hpp"
+
+
+
+class ShardCoordinator
+{
+public:
+    // Initializes a ShardCoordinator for the shards in the given
+    // directory, starting each worker by running the given program (which
+    // must accept "--shard-worker directory shard"; see main.cpp).  If the
+    // shards can't be read or the workers can't be started, a
+    // ShardException is thrown.
+    ShardCoordinator(const std::string& directory, const std::string& program);
+
+    // The destructor closes the pipes to the workers, which makes them
+    // exit, and waits for them to do so.
+    ~ShardCoordinator() noexcept;
+
+    ShardCoordinator(const ShardCoordinator&) = delete;
+    ShardCoordinator& operator=(const ShardCoordinator&) = delete;
+
+    // writeTrip() finds the path for the given trip and writes its
+    // directions to the given stream, as TripWriter does.  If either end
+    // of the trip does not exist, a DigraphException is thrown; if a
+    // worker stops answering, a ShardException is thrown.
+    void writeTrip(const Trip& trip, std::ostream& out);
+
+    // findPath() finds the same path writeTrip() would, storing the
+    // numbers of its locations into "path" (or leaving it empty if the
+    // end of the trip can't be reached) instead of writing directions.
+    // It throws the same exceptions writeTrip() does.
+    void findPath(const Trip& trip, std::vector<int>& path);
+
+    // shardCount() returns the number of shards (and workers).
+    int shardCount() const noexcept;
+
+
+private:
+    struct Worker
+    {
+        pid_t process;
+        int requests;
+        std::FILE* replies;
+    };
+
+    // A step of the overlay search: either a road segment between shards
+    // (shard is -1) or a path across a shard.
+    struct OverlayStep
+    {
+        int shard;
+        RoadSegment segment;
+    };
+
+    void startWorkers(const std::string& directory, const std::string& program);
+
+    void send(int shard, const std::string& request);
+    std::string receive(int shard);
+
+    //reads a reply to an F or B request, as pairs of location and cost
+    std::vector<std::pair<int, double>> receiveCosts(int shard);
+
+    //asks a shard for the path between two of its locations, adding its
+    //locations and road segments to the trip's RoadMap and path
+    void addShardPath(int shard, int from, int to, TripMetric metric,
+                      RoadMap& tripMap, std::vector<int>& path);
+
+    //finds the trip's path, gathering its locations and road segments
+    //into tripMap
+    void routeTrip(const Trip& trip, RoadMap& tripMap, std::vector<int>& path);
+
+    int shardOf(int vertex) const;
+
+    std::vector<Worker> workers;
+    std::unordered_map<int, int> shards;
+
+    //the overlay, one snapshot per metric; they share edge indexes, so
+    //steps[edge] describes edge "edge" in both
+    CompactDigraph<double> distanceOverlay;
+    CompactDigraph<double> timeOverlay;
+    std::vector<OverlayStep> steps;
+    std::vector<int> stepSources;
+    std::unordered_map<int, std::string> boundaryNames;
+};
+
+
+
+#endif // SHARDCOORDINATOR_HPP
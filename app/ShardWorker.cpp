@@ -0,0 +1,273 @@
+// ShardWorker.cpp
+//
+// ICS 46 Winter 2019
+// Project #4: Rock and Roll Stops the Traffic
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include "DeltaStepping.hpp"
+#include "InputReader.hpp"
+#include "ParallelFor.hpp"
+#include "RoadMapReader.hpp"
+#include "RoadMapShards.hpp"
+#include "RoadMapWeights.hpp"
+#include "SearchWorkspace.hpp"
+#include "ShardWorker.hpp"
+#include "ShortestPath.hpp"
+
+
+namespace
+{
+    std::ostream& writeNumber(std::ostream& out, double value)
+    {
+        char text[32];
+        std::to_chars_result result = std::to_chars(text, text + sizeof(text), value);
+        return out.write(text, result.ptr - text);
+    }
+
+
+    bool parseMetric(const std::string& text, TripMetric& metric)
+    {
+        if(text != "D" && text != "T")
+        {
+            return false;
+        }
+        metric = text == "D" ? TripMetric::Distance : TripMetric::Time;
+        return true;
+    }
+}
+
+
+ShardWorker::ShardWorker(const std::string& directory, int shard)
+{
+    try
+    {
+        RoadMapReader reader;
+        roadMap = reader.readRoadMapFile(shardMapFile(directory, shard), 1);
+
+        std::ifstream idsStream{shardIdsFile(directory, shard)};
+        if(!idsStream)
+        {
+            throw ShardException("could not open " + shardIdsFile(directory, shard));
+        }
+
+        InputReader ids{idsStream};
+        int count = ids.readIntLine();
+        for(int local = 0; local < count; ++local)
+        {
+            std::istringstream line{ids.readLine()};
+            int vertex;
+            int isBoundary;
+            if(!(line >> vertex >> isBoundary))
+            {
+                throw ShardException(
+                    shardIdsFile(directory, shard) + ": line " + std::to_string(ids.lineNumber()) +
+                    ": expected a location number and a boundary flag");
+            }
+
+            globalNumbers.push_back(vertex);
+            boundary.push_back(isBoundary != 0);
+            localIndexes.emplace(vertex, local);
+        }
+    }
+    catch(RoadMapReaderException& e)
+    {
+        throw ShardException(shardMapFile(directory, shard) + ": " + e.what());
+    }
+    catch(InputReaderException& e)
+    {
+        throw ShardException(shardIdsFile(directory, shard) + ": " + e.what());
+    }
+
+    if(static_cast<int>(globalNumbers.size()) != roadMap.vertexCount())
+    {
+        throw ShardException("shard " + std::to_string(shard) + "'s files don't match");
+    }
+
+    distanceGraph = compactRoadMap(roadMap, TripMetric::Distance);
+    timeGraph = compactRoadMap(roadMap, TripMetric::Time);
+    reversedDistanceGraph = distanceGraph.reversed();
+    reversedTimeGraph = timeGraph.reversed();
+
+    //a trip has the shards at both of its ends searching at once, so each
+    //gets half of the hardware threads
+    distanceDelta = averageEdgeWeight(distanceGraph);
+    timeDelta = averageEdgeWeight(timeGraph);
+    searchThreads = std::max(1u, defaultThreadCount() / 2);
+}
+
+
+void ShardWorker::serve(std::istream& in, std::ostream& out)
+{
+    out << "READY" << std::endl;
+
+    std::string request;
+    while(std::getline(in, request))
+    {
+        answer(request, out);
+        out.flush();
+    }
+}
+
+
+void ShardWorker::answer(const std::string& request, std::ostream& out)
+{
+    std::istringstream fields{request};
+    std::string kind;
+    std::string metricType;
+    std::string extra;
+    TripMetric metric;
+    int from;
+    int to;
+
+    fields >> kind;
+
+    if(kind == "F" && fields >> from >> metricType && parseMetric(metricType, metric))
+    {
+        int target = -1;
+        if(fields >> to)
+        {
+            target = localIndex(to);
+        }
+        else if(fields.clear(), fields >> extra)
+        {
+            out<<"ERROR malformed request: "<<request<<"\n";
+            return;
+        }
+
+        if(localIndex(from) == -1)
+        {
+            out<<"ERROR no such location in shard: "<<from<<"\n";
+            return;
+        }
+        bool byDistance = metric == TripMetric::Distance;
+        writeCosts(byDistance ? distanceGraph : timeGraph, byDistance ? distanceDelta : timeDelta,
+                   localIndex(from), target, out);
+    }
+    else if(kind == "B" && fields >> to >> metricType && parseMetric(metricType, metric) &&
+            !(fields >> extra))
+    {
+        if(localIndex(to) == -1)
+        {
+            out<<"ERROR no such location in shard: "<<to<<"\n";
+            return;
+        }
+        bool byDistance = metric == TripMetric::Distance;
+        writeCosts(byDistance ? reversedDistanceGraph : reversedTimeGraph,
+                   byDistance ? distanceDelta : timeDelta, localIndex(to), -1, out);
+    }
+    else if(kind == "P" && fields >> from >> to >> metricType && parseMetric(metricType, metric) &&
+            !(fields >> extra))
+    {
+        if(localIndex(from) == -1 || localIndex(to) == -1)
+        {
+            out<<"ERROR no such location in shard: "<<request<<"\n";
+            return;
+        }
+        writePath(localIndex(from), localIndex(to), metric, out);
+    }
+    else if(kind == "N" && fields >> from && !(fields >> extra))
+    {
+        if(localIndex(from) == -1)
+        {
+            out<<"ERROR no such location in shard: "<<from<<"\n";
+            return;
+        }
+        out<<roadMap.vertexInfo(localIndex(from))<<"\n";
+    }
+    else
+    {
+        out<<"ERROR malformed request: "<<request<<"\n";
+    }
+}
+
+
+void ShardWorker::writeCosts(
+    const CompactDigraph<double>& graph, double delta, int start, int target, std::ostream& out)
+{
+    thread_local SearchWorkspace<double> workspace;
+    thread_local std::vector<double> distances;
+
+    //only the costs are wanted, which delta-stepping finds exactly as
+    //Dijkstra's algorithm does; given only one thread, though, it's the
+    //slower of the two
+    if(searchThreads > 1)
+    {
+        distances = findShortestPathTreeParallel(graph, start, delta, searchThreads).distance;
+    }
+    else
+    {
+        findShortestPathTree(graph, start, workspace);
+        distances.resize(graph.vertexCount());
+        for(int local = 0; local < graph.vertexCount(); ++local)
+        {
+            distances[local] = workspace.distance(local);
+        }
+    }
+
+    std::ostringstream costs;
+    int count = 0;
+
+    for(int local = 0; local < graph.vertexCount(); ++local)
+    {
+        if(!std::isinf(distances[local]) && (boundary[local] || local == target))
+        {
+            costs<<" "<<globalNumbers[local]<<" ";
+            writeNumber(costs, distances[local]);
+            ++count;
+        }
+    }
+
+    out<<count<<costs.str()<<"\n";
+}
+
+
+void ShardWorker::writePath(int from, int to, TripMetric metric, std::ostream& out)
+{
+    thread_local SearchWorkspace<double> workspace;
+    thread_local std::vector<int> path;
+
+    const CompactDigraph<double>& graph = metric == TripMetric::Distance ? distanceGraph : timeGraph;
+    findShortestPath(graph, from, to, workspace, path);
+
+    out<<path.size()<<"\n";
+    for(unsigned int i = 0; i < path.size(); ++i)
+    {
+        RoadSegment segment{0, 0};
+
+        //of several road segments between the same two locations, the
+        //search took the cheapest
+        if(i > 0)
+        {
+            bool found = false;
+            roadMap.forEachOutgoingEdge(path[i - 1],
+                [&](int toVertex, const RoadSegment& candidate)
+                {
+                    if(toVertex == path[i] &&
+                       (!found || withMetricWeight(metric, [&](auto weight)
+                                  {
+                                      return weight(candidate) < weight(segment);
+                                  })))
+                    {
+                        segment = candidate;
+                        found = true;
+                    }
+                });
+        }
+
+        out<<globalNumbers[path[i]]<<" ";
+        writeNumber(out, segment.miles)<<" ";
+        writeNumber(out, segment.milesPerHour)<<" "<<segment.speedProfile<<" "
+            <<roadMap.vertexInfo(path[i])<<"\n";
+    }
+}
+
+
+int ShardWorker::localIndex(int vertex) const
+{
+    auto found = localIndexes.find(vertex);
+    return found == localIndexes.end() ? -1 : found->second;
+}
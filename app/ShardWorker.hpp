@@ -0,0 +1,85 @@
+// ShardWorker.hpp
+//
+// ICS 46 Winter 2019
+// Project #4: Rock and Roll Stops the Traffic
+//
+// A ShardWorker loads one shard written by writeRoadMapShards() (see
+// RoadMapShards.hpp) and answers the searches a ShardCoordinator asks of
+// it, one request per line, usually over a pipe from the coordinator's
+// process.  Locations are always given by their numbers in the whole map,
+// and metrics as D or T.
+//
+//     F from metric [to]  the cost of the shortest path inside the shard
+//                         from "from" to each boundary location (and to
+//                         "to", if it's given), answered on one line: the
+//                         number of locations reached, then each one's
+//                         number and cost
+//     B to metric         the same, but from each boundary location to "to"
+//     P from to metric    the shortest path inside the shard from "from" to
+//                         "to": a line with the number of locations along
+//                         it (0 if there is none), then one line for each,
+//                         giving its number, the miles, speed and speed
+//                         profile of the road segment leading to it (0 0 -1
+//                         for the first), and its name
+//     N location          the location's name
+//
+// A request that can't be answered is answered with a line beginning with
+// "ERROR".  Costs are written so that they read back exactly.
+
+#ifndef SHARDWORKER_HPP
+#define SHARDWORKER_HPP
+
+#include <istream>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "CompactDigraph.hpp"
+#include "RoadMap.hpp"
+#include "TripMetric.hpp"
+
+
+
+class ShardWorker
+{
+public:
+    // Initializes a ShardWorker by loading the given shard from the given
+    // directory.  If its files can't be read, a ShardException is thrown.
+    ShardWorker(const std::string& directory, int shard);
+
+    // serve() writes a line reading READY, then answers every request read
+    // from the given input stream until it runs out, flushing the output
+    // stream after each reply.
+    void serve(std::istream& in, std::ostream& out);
+
+    // answer() answers one request, writing the reply to the given stream.
+    void answer(const std::string& request, std::ostream& out);
+
+
+private:
+    void writeCosts(
+        const CompactDigraph<double>& graph, double delta, int start, int target, std::ostream& out);
+
+    void writePath(int from, int to, TripMetric metric, std::ostream& out);
+
+    int localIndex(int vertex) const;
+
+    RoadMap roadMap;
+    std::vector<int> globalNumbers;
+    std::vector<bool> boundary;
+    std::unordered_map<int, int> localIndexes;
+
+    CompactDigraph<double> distanceGraph;
+    CompactDigraph<double> timeGraph;
+    CompactDigraph<double> reversedDistanceGraph;
+    CompactDigraph<double> reversedTimeGraph;
+
+    //the bucket widths and number of threads writeCosts() searches with
+    double distanceDelta;
+    double timeDelta;
+    unsigned int searchThreads;
+};
+
+
+
+#endif // SHARDWORKER_HPP
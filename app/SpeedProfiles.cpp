@@ -0,0 +1,176 @@
+// SpeedProfiles.cpp
+//
+// ICS 46 Winter 2019
+// Project #4: Rock and Roll Stops the Traffic
+
+#include <cmath>
+#include <limits>
+#include <sstream>
+#include "MemoryUsage.hpp"
+#include "SpeedProfiles.hpp"
+
+
+SpeedProfilesException::SpeedProfilesException(const std::string& reason)
+    : std::runtime_error{reason}
+{
+}
+
+
+int SpeedProfiles::add(const Percentages& percentages)
+{
+    for(std::uint8_t percentage : percentages)
+    {
+        if(percentage == 0)
+        {
+            throw SpeedProfilesException("a speed profile can't stop traffic entirely");
+        }
+    }
+
+    //the index is built again if finishAdding() let go of it
+    if(shapeByPercentages.empty())
+    {
+        for(int shape = 0; shape < shapeCount(); ++shape)
+        {
+            const std::uint8_t* begin = shapes.data() + shape * bucketCount;
+            shapeByPercentages.emplace(std::string(begin, begin + bucketCount), shape);
+        }
+    }
+
+    std::string key(percentages.begin(), percentages.end());
+    auto found = shapeByPercentages.find(key);
+
+    if(found == shapeByPercentages.end())
+    {
+        found = shapeByPercentages.emplace(key, shapeCount()).first;
+        shapes.insert(shapes.end(), percentages.begin(), percentages.end());
+    }
+
+    shapeOfProfile.push_back(found->second);
+    return shapeOfProfile.size() - 1;
+}
+
+
+void SpeedProfiles::finishAdding()
+{
+    //swapped away rather than cleared, so that the buckets go too
+    std::unordered_map<std::string, int>{}.swap(shapeByPercentages);
+}
+
+
+int SpeedProfiles::profileCount() const noexcept
+{
+    return shapeOfProfile.size();
+}
+
+
+int SpeedProfiles::shapeCount() const noexcept
+{
+    return shapes.size() / bucketCount;
+}
+
+
+bool SpeedProfiles::contains(int profile) const noexcept
+{
+    return profile >= 0 && profile < profileCount();
+}
+
+
+int SpeedProfiles::percentage(int profile, double time) const
+{
+    long bucket = static_cast<long>(std::floor(time / bucketSeconds)) % bucketCount;
+    return shapes[shapeOfProfile[profile] * bucketCount + bucket];
+}
+
+
+double SpeedProfiles::travelSeconds(const RoadSegment& segment, double time) const
+{
+    if(segment.speedProfile == noSpeedProfile)
+    {
+        return 3600 * segment.miles / segment.milesPerHour;
+    }
+
+    //a segment nobody can move along would never run out, and there'd be
+    //no end to the loop below
+    if(segment.milesPerHour <= 0)
+    {
+        return std::numeric_limits<double>::infinity();
+    }
+
+    const std::uint8_t* shape = shapes.data() + shapeOfProfile[segment.speedProfile] * bucketCount;
+    double milesLeft = segment.miles;
+    double now = time;
+
+    //drive at each quarter hour's speed until either the segment or the
+    //quarter hour runs out
+    while(true)
+    {
+        double bucketStart = std::floor(now / bucketSeconds);
+        double milesPerSecond =
+            segment.milesPerHour * shape[static_cast<long>(bucketStart) % bucketCount] / 100 / 3600;
+        double secondsLeftInBucket = (bucketStart + 1) * bucketSeconds - now;
+
+        if(milesPerSecond * secondsLeftInBucket >= milesLeft)
+        {
+            return now + milesLeft / milesPerSecond - time;
+        }
+
+        milesLeft -= milesPerSecond * secondsLeftInBucket;
+        now = (bucketStart + 1) * bucketSeconds;
+    }
+}
+
+
+std::size_t SpeedProfiles::byteCount() const noexcept
+{
+    //each key is a string of bucketCount characters, too long to be
+    //stored inside the std::string itself
+    return shapes.size() + shapeOfProfile.size() * sizeof(int) +
+           unorderedMapBytes(shapeByPercentages) + shapeByPercentages.size() * heapBytes(bucketCount + 1);
+}
+
+
+SpeedProfiles readSpeedProfiles(InputReader& in)
+{
+    SpeedProfiles profiles;
+
+    try
+    {
+        int numberOfProfiles = in.readIntLine();
+
+        for(int i = 0; i < numberOfProfiles; ++i)
+        {
+            std::istringstream profileLine{in.readLine()};
+            SpeedProfiles::Percentages percentages;
+            int percentage;
+            std::string extra;
+
+            for(std::uint8_t& stored : percentages)
+            {
+                if(!(profileLine >> percentage) || percentage < 1 || percentage > 255)
+                {
+                    throw SpeedProfilesException(
+                        "line " + std::to_string(in.lineNumber()) +
+                        ": expected 96 percentages from 1 to 255");
+                }
+                stored = percentage;
+            }
+
+            if(profileLine >> extra)
+            {
+                throw SpeedProfilesException(
+                    "line " + std::to_string(in.lineNumber()) + ": more than 96 percentages");
+            }
+
+            profiles.add(percentages);
+        }
+
+        profiles.finishAdding();
+    }
+    catch(InputReaderException& e)
+    {
+        throw SpeedProfilesException(
+            "line " + std::to_string(in.lineNumber()) + ": " + e.what());
+    }
+
+    return profiles;
+}
@@ -0,0 +1,115 @@
+// SpeedProfiles.hpp
+//
+// ICS 46 Winter 2019
+// Project #4: Rock and Roll Stops the Traffic
+//
+// A SpeedProfiles object holds the speed profiles that road segments can
+// name (see RoadSegment.hpp) so that their speeds change through the day.
+// A profile divides the day into 96 quarter hours and gives, for each, the
+// speed of traffic as a percentage of the segment's usual speed: a road
+// that slows to a crawl at rush hour might say 100 most of the day but 30
+// from 7:30 to 9:00.
+//
+// Each percentage is stored in a single byte, and profiles with the same
+// percentages are stored only once, so a map with thousands of profiles
+// that mostly repeat a handful of shapes needs a few hundred bytes for
+// each shape and four for each profile.
+//
+// travelSeconds() works out how long it takes to drive a segment that's
+// entered at a given time, following the speed as it changes from one
+// quarter hour to the next.  Since a car that enters later is always
+// driving at the same speed as one that entered earlier, it never arrives
+// sooner, which is what findEarliestArrivalPath() relies on.
+//
+// Speed profiles are read from a file in this format, where blank lines
+// and lines beginning with '#' are skipped:
+//
+//     number of profiles
+//     one line per profile, numbered from 0: 96 percentages, each from
+//         1 to 255, the first for the quarter hour starting at midnight
+
+#ifndef SPEEDPROFILES_HPP
+#define SPEEDPROFILES_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "InputReader.hpp"
+#include "RoadSegment.hpp"
+#include "TimeOfDay.hpp"
+
+
+
+class SpeedProfilesException : public std::runtime_error
+{
+public:
+    SpeedProfilesException(const std::string& reason);
+};
+
+
+
+class SpeedProfiles
+{
+public:
+    static constexpr int bucketCount = 96;
+    static constexpr int bucketSeconds = secondsPerDay / bucketCount;
+
+    typedef std::array<std::uint8_t, bucketCount> Percentages;
+
+    // add() adds a profile with the given percentages, returning its
+    // number; profiles are numbered from 0 in the order they're added.
+    // If any percentage is 0, a SpeedProfilesException is thrown.
+    int add(const Percentages& percentages);
+
+    // finishAdding() lets go of the index add() uses to find repeated
+    // shapes, which is only needed while profiles are being added (if
+    // add() is called again, it builds the index again first).
+    // readSpeedProfiles() calls it once it has read every profile.
+    void finishAdding();
+
+    // profileCount() returns the number of profiles, and shapeCount()
+    // the number of distinct sets of percentages among them.
+    int profileCount() const noexcept;
+    int shapeCount() const noexcept;
+
+    // contains() returns true if there is a profile with the given number.
+    bool contains(int profile) const noexcept;
+
+    // percentage() returns the given profile's percentage at the given
+    // time, in seconds since midnight (times past midnight wrap around).
+    int percentage(int profile, double time) const;
+
+    // travelSeconds() returns the number of seconds it takes to drive the
+    // given segment if it's entered at the given time.  A segment with no
+    // speed profile takes the same time whenever it's entered; one with a
+    // profile but no speed (0 or less) can't be driven, and takes infinity.
+    double travelSeconds(const RoadSegment& segment, double time) const;
+
+    // byteCount() returns the number of bytes used to store the profiles,
+    // along with the index of shapes if add() is still keeping one.
+    std::size_t byteCount() const noexcept;
+
+
+private:
+    //the percentages of every distinct shape, one after another
+    std::vector<std::uint8_t> shapes;
+    std::vector<int> shapeOfProfile;
+
+    //finds repeats as profiles are added; empty once finishAdding() is
+    //called
+    std::unordered_map<std::string, int> shapeByPercentages;
+};
+
+
+
+// readSpeedProfiles() reads speed profiles in the format described above.
+// If the input isn't in that format, a SpeedProfilesException is thrown.
+SpeedProfiles readSpeedProfiles(InputReader& in);
+
+
+
+#endif // SPEEDPROFILES_HPP
@@ -0,0 +1,80 @@
+// TimeDependentTripRouter.cpp
+//
+// ICS 46 Winter 2019
+// Project #4: Rock and Roll Stops the Traffic
+
+#include <string>
+#include "RoadMapWeights.hpp"
+#include "SearchWorkspace.hpp"
+#include "ShortestPath.hpp"
+#include "TimeDependentTripRouter.hpp"
+
+
+TimeDependentTripRouter::TimeDependentTripRouter(
+    const RoadMap& roadMap, const SpeedProfiles& profiles, const TripRouter* otherTrips)
+    : graph{roadMap, [](const RoadSegment& segment) { return segment; }},
+      profiles{profiles}, otherTrips{otherTrips}
+{
+    for(int edge = 0; edge < graph.edgeCount(); ++edge)
+    {
+        int profile = graph.weight(edge).speedProfile;
+        if(profile != noSpeedProfile && !profiles.contains(profile))
+        {
+            throw SpeedProfilesException(
+                "a road segment follows speed profile " + std::to_string(profile) +
+                ", but there are only " + std::to_string(profiles.profileCount()));
+        }
+    }
+}
+
+
+void TimeDependentTripRouter::findPath(const Trip& trip, std::vector<int>& path) const
+{
+    bool timed = trip.metric == TripMetric::Time && trip.departureTime != noDepartureTime;
+    if(!timed && otherTrips != nullptr)
+    {
+        otherTrips->findPath(trip, path);
+        return;
+    }
+
+    thread_local SearchWorkspace<double> workspace;
+
+    int start = graph.indexOf(trip.startVertex);
+    int end = graph.indexOf(trip.endVertex);
+
+    if(timed)
+    {
+        findEarliestArrivalPath(graph, start, end, trip.departureTime,
+            [&](const RoadSegment& segment, double time)
+            {
+                return profiles.travelSeconds(segment, time);
+            },
+            workspace, path);
+    }
+    else
+    {
+        withMetricWeight(trip.metric,
+            [&](auto weight)
+            {
+                findEarliestArrivalPath(graph, start, end, 0.0,
+                    [&](const RoadSegment& segment, double)
+                    {
+                        return weight(segment);
+                    },
+                    workspace, path);
+            });
+    }
+
+    for(int& vertex : path)
+    {
+        vertex = graph.vertexNumber(vertex);
+    }
+}
+
+
+MemoryUsage TimeDependentTripRouter::memoryUsage() const
+{
+    MemoryUsage usage;
+    usage.add("segment snapshot", graph.byteCount());
+    return usage;
+}
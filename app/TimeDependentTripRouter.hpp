@@ -0,0 +1,54 @@
+// TimeDependentTripRouter.hpp
+//
+// ICS 46 Winter 2019
+// Project #4: Rock and Roll Stops the Traffic
+//
+// A TimeDependentTripRouter is a TripRouter for maps whose road segments
+// follow speed profiles (see SpeedProfiles.hpp).  A driving-time trip that
+// says when it leaves is routed by the speed on each segment at the time
+// the trip would reach it, using findEarliestArrivalPath(), so a trip that
+// leaves at rush hour may go a different way than one that leaves at
+// midnight.  Every other trip is handed to another TripRouter, if the
+// TimeDependentTripRouter was given one, or otherwise routed by the
+// segments' usual speeds, as DijkstraTripRouter would.
+//
+// It keeps a CompactDigraph whose weights are the RoadSegments themselves,
+// since a segment's travel time can't be worked out until it's known when
+// the segment is entered.
+
+#ifndef TIMEDEPENDENTTRIPROUTER_HPP
+#define TIMEDEPENDENTTRIPROUTER_HPP
+
+#include <vector>
+#include "CompactDigraph.hpp"
+#include "RoadMap.hpp"
+#include "SpeedProfiles.hpp"
+#include "TripRouter.hpp"
+
+
+
+class TimeDependentTripRouter : public TripRouter
+{
+public:
+    // Initializes a TimeDependentTripRouter for the given RoadMap and
+    // speed profiles, which must outlive it, as must otherTrips if it's
+    // given.  If a road segment follows a speed profile that doesn't
+    // exist, a SpeedProfilesException is thrown.
+    TimeDependentTripRouter(
+        const RoadMap& roadMap, const SpeedProfiles& profiles,
+        const TripRouter* otherTrips = nullptr);
+
+    using TripRouter::findPath;
+    void findPath(const Trip& trip, std::vector<int>& path) const override;
+    MemoryUsage memoryUsage() const override;
+
+
+private:
+    CompactDigraph<RoadSegment> graph;
+    const SpeedProfiles& profiles;
+    const TripRouter* otherTrips;
+};
+
+
+
+#endif // TIMEDEPENDENTTRIPROUTER_HPP
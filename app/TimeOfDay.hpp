@@ -0,0 +1,63 @@
+// TimeOfDay.hpp
+//
+// ICS 46 Winter 2019
+// Project #4: Rock and Roll Stops the Traffic
+//
+// Times of day are written as "HH:MM" or "HH:MM:SS" on a 24-hour clock
+// and stored as a number of seconds since midnight.  parseTimeOfDay()
+// converts from the former to the latter, returning false if the text
+// isn't a valid time; formatTimeOfDay() converts back (as "HH:MM:SS"
+// only if there are seconds to show), wrapping times past midnight
+// around to the next day.
+
+#ifndef TIMEOFDAY_HPP
+#define TIMEOFDAY_HPP
+
+#include <cstdio>
+#include <string>
+
+
+
+constexpr int secondsPerDay = 24 * 60 * 60;
+
+
+inline bool parseTimeOfDay(const std::string& text, int& seconds)
+{
+    int hours;
+    int minutes;
+    int secs = 0;
+    int length = 0;
+
+    if((std::sscanf(text.c_str(), "%2d:%2d:%2d%n", &hours, &minutes, &secs, &length) != 3 &&
+        std::sscanf(text.c_str(), "%2d:%2d%n", &hours, &minutes, &length) != 2) ||
+       length != static_cast<int>(text.size()) ||
+       hours < 0 || hours > 23 || minutes < 0 || minutes > 59 || secs < 0 || secs > 59)
+    {
+        return false;
+    }
+
+    seconds = hours * 3600 + minutes * 60 + secs;
+    return true;
+}
+
+
+inline std::string formatTimeOfDay(int seconds)
+{
+    seconds %= secondsPerDay;
+
+    char text[16];
+    if(seconds % 60 == 0)
+    {
+        std::snprintf(text, sizeof(text), "%02d:%02d", seconds / 3600, seconds / 60 % 60);
+    }
+    else
+    {
+        std::snprintf(text, sizeof(text), "%02d:%02d:%02d",
+                      seconds / 3600, seconds / 60 % 60, seconds % 60);
+    }
+    return text;
+}
+
+
+
+#endif // TIMEOFDAY_HPP
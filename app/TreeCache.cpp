@@ -0,0 +1,434 @@
+// TreeCache.cpp
+//
+// ICS 46 Winter 2019
+// Project #4: Rock and Roll Stops the Traffic
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "CompactDigraph.hpp"
+#include "ParallelFor.hpp"
+#include "RoadMapWeights.hpp"
+#include "SearchWorkspace.hpp"
+#include "ShortestPath.hpp"
+#include "TreeCache.hpp"
+
+
+namespace
+{
+    const char magic[8] = {'S', 'P', 'T', 'R', 'E', 'E', 'S', '1'};
+    const std::size_t headerBytes = sizeof(magic) + sizeof(std::uint64_t) + 2 * sizeof(std::int32_t);
+
+
+    std::size_t alignTo8(std::size_t bytes)
+    {
+        return (bytes + 7) & ~std::size_t{7};
+    }
+
+
+    //where the arrays of a file with the given numbers of locations and
+    //trees begin, and how big each tree is
+    struct Layout
+    {
+        Layout(std::size_t vertexCount, std::size_t treeCount)
+            : sourcesOffset{alignTo8(headerBytes + vertexCount * sizeof(std::int32_t))},
+              treesOffset{sourcesOffset + treeCount * 2 * sizeof(std::int32_t)},
+              distanceBytes{vertexCount * sizeof(double)},
+              treeBytes{distanceBytes + alignTo8(vertexCount * sizeof(std::int32_t))},
+              fileBytes{treesOffset + treeCount * treeBytes}
+        {
+        }
+
+        std::size_t sourcesOffset;
+        std::size_t treesOffset;
+        std::size_t distanceBytes;
+        std::size_t treeBytes;
+        std::size_t fileBytes;
+    };
+
+
+    //finds the shortest path tree from the given start index with the
+    //search findShortestPath() runs, and stores it into the given arrays
+    void buildTree(const CompactDigraph<double>& graph, int start, SearchWorkspace<double>& workspace,
+                   double* distance, std::int32_t* predecessor)
+    {
+        findShortestPathTree(graph, start, workspace);
+
+        for(int vertex = 0; vertex < graph.vertexCount(); ++vertex)
+        {
+            bool reached = workspace.reached(vertex);
+            distance[vertex] = reached ? workspace.distance(vertex)
+                                       : std::numeric_limits<double>::infinity();
+            predecessor[vertex] = reached ? workspace.predecessor(vertex) : -1;
+        }
+    }
+
+
+    template <typename T>
+    void writeValue(std::ostream& out, T value)
+    {
+        out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+
+    void writePadding(std::ostream& out, std::size_t bytes)
+    {
+        static const char zeros[8] = {};
+        out.write(zeros, alignTo8(bytes) - bytes);
+    }
+}
+
+
+TreeCacheException::TreeCacheException(const std::string& reason)
+    : std::runtime_error{reason}
+{
+}
+
+
+std::vector<std::pair<int, TripMetric>> readHotSources(InputReader& in)
+{
+    std::vector<std::pair<int, TripMetric>> sources;
+
+    try
+    {
+        int count = in.readIntLine();
+        for(int i = 0; i < count; ++i)
+        {
+            std::istringstream line{in.readLine()};
+            int vertex;
+            std::string metric;
+            std::string extra;
+            if(!(line >> vertex >> metric) || (metric != "D" && metric != "T") || line >> extra)
+            {
+                throw TreeCacheException(
+                    "line " + std::to_string(in.lineNumber()) +
+                    ": expected a location number and D or T");
+            }
+            sources.emplace_back(vertex, metric == "D" ? TripMetric::Distance : TripMetric::Time);
+        }
+    }
+    catch(InputReaderException& e)
+    {
+        throw TreeCacheException(
+            "line " + std::to_string(in.lineNumber()) + ": " + e.what());
+    }
+
+    return sources;
+}
+
+
+void writeTreeCache(
+    const std::string& fileName, const RoadMap& roadMap,
+    const std::vector<std::pair<int, TripMetric>>& sources,
+    unsigned int threadCount)
+{
+    if(threadCount == 0)
+    {
+        threadCount = defaultThreadCount();
+    }
+
+    //trees are stored in order of metric, then start, so they can be
+    //found by a binary search
+    std::vector<std::pair<int, int>> keys;
+    for(const std::pair<int, TripMetric>& source : sources)
+    {
+        if(!roadMap.hasVertex(source.first))
+        {
+            throw DigraphException("Invalid Vertex");
+        }
+        keys.emplace_back(static_cast<int>(source.second), source.first);
+    }
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+
+    CompactDigraph<double> graphs[2] = {
+        compactRoadMap(roadMap, TripMetric::Distance),
+        compactRoadMap(roadMap, TripMetric::Time)
+    };
+    int vertexCount = graphs[0].vertexCount();
+    Layout layout(vertexCount, keys.size());
+
+    //the file is written beside the old one and then renamed over it, so a
+    //program that has the old one mapped keeps seeing all of it
+    std::string partialName = fileName + ".partial";
+    std::ofstream out{partialName, std::ios::binary | std::ios::trunc};
+    if(!out)
+    {
+        throw TreeCacheException("could not create " + partialName);
+    }
+
+    out.write(magic, sizeof(magic));
+    writeValue(out, roadMap.checksum());
+    writeValue(out, static_cast<std::int32_t>(vertexCount));
+    writeValue(out, static_cast<std::int32_t>(keys.size()));
+
+    for(int index = 0; index < vertexCount; ++index)
+    {
+        writeValue(out, static_cast<std::int32_t>(graphs[0].vertexNumber(index)));
+    }
+    writePadding(out, headerBytes + vertexCount * sizeof(std::int32_t));
+
+    for(const std::pair<int, int>& key : keys)
+    {
+        writeValue(out, static_cast<std::int32_t>(key.second));
+        writeValue(out, static_cast<std::int32_t>(key.first));
+    }
+
+    //trees are built a batch at a time, one per thread, so that only a
+    //batch's worth of them is ever in memory at once
+    std::size_t batchLimit = std::max<std::size_t>(1, std::min<std::size_t>(threadCount, keys.size()));
+    std::vector<SearchWorkspace<double>> workspaces(batchLimit);
+    std::vector<std::vector<double>> distances(batchLimit, std::vector<double>(vertexCount));
+    std::vector<std::vector<std::int32_t>> predecessors(
+        batchLimit, std::vector<std::int32_t>(vertexCount));
+
+    for(std::size_t first = 0; first < keys.size(); first += batchLimit)
+    {
+        int batchSize = std::min(batchLimit, keys.size() - first);
+        parallelFor(batchSize, threadCount,
+            [&](int i, unsigned int)
+            {
+                const std::pair<int, int>& key = keys[first + i];
+                const CompactDigraph<double>& graph = graphs[key.first];
+                buildTree(graph, graph.indexOf(key.second), workspaces[i],
+                          distances[i].data(), predecessors[i].data());
+            });
+
+        for(int i = 0; i < batchSize; ++i)
+        {
+            out.write(reinterpret_cast<const char*>(distances[i].data()), layout.distanceBytes);
+            out.write(reinterpret_cast<const char*>(predecessors[i].data()),
+                      vertexCount * sizeof(std::int32_t));
+            writePadding(out, vertexCount * sizeof(std::int32_t));
+        }
+    }
+
+    out.close();
+    if(!out || std::rename(partialName.c_str(), fileName.c_str()) != 0)
+    {
+        std::remove(partialName.c_str());
+        throw TreeCacheException("could not write the file");
+    }
+}
+
+
+TreeCache::TreeCache()
+    : mapping{nullptr}, mappingSize{0}, vertexCount{0}, trees{0},
+      vertexNumbers{nullptr}, sources{nullptr}, treeData{nullptr}
+{
+}
+
+
+TreeCache::TreeCache(const std::string& fileName, const RoadMap& roadMap)
+    : TreeCache{}
+{
+    int file = open(fileName.c_str(), O_RDONLY | O_CLOEXEC);
+    if(file < 0)
+    {
+        throw TreeCacheException("could not open the file");
+    }
+
+    struct stat status;
+    if(fstat(file, &status) != 0 || static_cast<std::size_t>(status.st_size) < headerBytes)
+    {
+        close(file);
+        throw TreeCacheException("not a tree cache");
+    }
+
+    mappingSize = status.st_size;
+    mapping = mmap(nullptr, mappingSize, PROT_READ, MAP_SHARED, file, 0);
+    close(file);
+    if(mapping == MAP_FAILED)
+    {
+        mapping = nullptr;
+        throw TreeCacheException("could not map the file into memory");
+    }
+
+    //only the header is read here; the trees are left for the operating
+    //system to read in as they're used
+    const char* bytes = static_cast<const char*>(mapping);
+    std::uint64_t checksum;
+    std::int32_t savedVertexCount;
+    std::int32_t savedTreeCount;
+    std::memcpy(&checksum, bytes + sizeof(magic), sizeof(checksum));
+    std::memcpy(&savedVertexCount, bytes + sizeof(magic) + sizeof(checksum), sizeof(std::int32_t));
+    std::memcpy(&savedTreeCount, bytes + headerBytes - sizeof(std::int32_t), sizeof(std::int32_t));
+
+    if(!std::equal(magic, magic + sizeof(magic), bytes) || savedVertexCount < 0 || savedTreeCount < 0 ||
+       Layout(savedVertexCount, savedTreeCount).fileBytes != mappingSize)
+    {
+        munmap(mapping, mappingSize);
+        mapping = nullptr;
+        throw TreeCacheException("not a tree cache");
+    }
+    if(checksum != roadMap.checksum() || savedVertexCount != roadMap.vertexCount())
+    {
+        munmap(mapping, mappingSize);
+        mapping = nullptr;
+        throw TreeCacheException("built for a different map");
+    }
+
+    Layout layout(savedVertexCount, savedTreeCount);
+    vertexCount = savedVertexCount;
+    trees = savedTreeCount;
+    vertexNumbers = reinterpret_cast<const std::int32_t*>(bytes + headerBytes);
+    sources = reinterpret_cast<const std::int32_t*>(bytes + layout.sourcesOffset);
+    treeData = bytes + layout.treesOffset;
+}
+
+
+TreeCache::~TreeCache() noexcept
+{
+    if(mapping != nullptr)
+    {
+        munmap(mapping, mappingSize);
+    }
+}
+
+
+TreeCache::TreeCache(TreeCache&& other) noexcept
+    : TreeCache{}
+{
+    *this = std::move(other);
+}
+
+
+TreeCache& TreeCache::operator=(TreeCache&& other) noexcept
+{
+    std::swap(mapping, other.mapping);
+    std::swap(mappingSize, other.mappingSize);
+    std::swap(vertexCount, other.vertexCount);
+    std::swap(trees, other.trees);
+    std::swap(vertexNumbers, other.vertexNumbers);
+    std::swap(sources, other.sources);
+    std::swap(treeData, other.treeData);
+    return *this;
+}
+
+
+int TreeCache::treeCount() const noexcept
+{
+    return trees;
+}
+
+
+bool TreeCache::contains(int startVertex, TripMetric metric) const
+{
+    return findTree(startVertex, metric) != -1;
+}
+
+
+bool TreeCache::findPath(const Trip& trip, std::vector<int>& path) const
+{
+    int tree = findTree(trip.startVertex, trip.metric);
+    if(tree == -1)
+    {
+        return false;
+    }
+
+    const std::int32_t* predecessor = predecessors(tree);
+    int start = indexOf(trip.startVertex);
+    int current = indexOf(trip.endVertex);
+
+    path.clear();
+    if(predecessor[current] == -1)
+    {
+        return true;
+    }
+
+    //a tree has no cycles, so the walk can't take more steps than there
+    //are locations unless the file has been tampered with
+    while(current != start)
+    {
+        if(static_cast<int>(path.size()) == vertexCount || predecessor[current] < 0 ||
+           predecessor[current] >= vertexCount)
+        {
+            throw TreeCacheException("a cached tree is corrupt");
+        }
+        path.push_back(vertexNumbers[current]);
+        current = predecessor[current];
+    }
+    path.push_back(trip.startVertex);
+
+    std::reverse(path.begin(), path.end());
+    return true;
+}
+
+
+bool TreeCache::findDistance(const Trip& trip, double& distance) const
+{
+    int tree = findTree(trip.startVertex, trip.metric);
+    if(tree == -1)
+    {
+        return false;
+    }
+
+    distance = distances(tree)[indexOf(trip.endVertex)];
+    return true;
+}
+
+
+std::size_t TreeCache::byteCount() const noexcept
+{
+    return mappingSize;
+}
+
+
+int TreeCache::findTree(int startVertex, TripMetric metric) const
+{
+    int key[2] = {startVertex, static_cast<int>(metric)};
+
+    int low = 0;
+    int high = trees;
+    while(low < high)
+    {
+        int middle = (low + high) / 2;
+        const std::int32_t* source = sources + 2 * middle;
+        if(source[1] < key[1] || (source[1] == key[1] && source[0] < key[0]))
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+
+    if(low < trees && sources[2 * low] == key[0] && sources[2 * low + 1] == key[1])
+    {
+        return low;
+    }
+    return -1;
+}
+
+
+int TreeCache::indexOf(int vertex) const
+{
+    const std::int32_t* found = std::lower_bound(vertexNumbers, vertexNumbers + vertexCount, vertex);
+    if(found == vertexNumbers + vertexCount || *found != vertex)
+    {
+        throw DigraphException("Invalid Vertex");
+    }
+    return found - vertexNumbers;
+}
+
+
+const double* TreeCache::distances(int tree) const
+{
+    return reinterpret_cast<const double*>(treeData + tree * Layout(vertexCount, trees).treeBytes);
+}
+
+
+const std::int32_t* TreeCache::predecessors(int tree) const
+{
+    Layout layout(vertexCount, trees);
+    return reinterpret_cast<const std::int32_t*>(
+        treeData + tree * layout.treeBytes + layout.distanceBytes);
+}
@@ -0,0 +1,151 @@
+// TreeCache.hpp
+//
+// ICS 46 Winter 2019
+// Project #4: Rock and Roll Stops the Traffic
+//
+// A TreeCache is a file of precomputed shortest path trees -- for each of
+// a chosen set of "hot" start locations and metrics, the distance to and
+// predecessor of every location -- so that a program answering trips can
+// be restarted without searching from its most popular start locations all
+// over again.  A trip from one of them is answered by walking the tree's
+// predecessors back from the end location, with no search at all.
+//
+// writeTreeCache() builds the trees and writes the file.  A TreeCache maps
+// the file into memory rather than reading it, so opening one costs only
+// a check of its header and of the RoadMap's checksum (see
+// RoadMap::checksum()), which the file is stamped with; the operating
+// system reads each tree in as trips first touch it, and may drop it
+// again under memory pressure, since it can always be read back.
+//
+// The file holds, in the machine's own byte order, with every array
+// starting on an 8-byte boundary:
+//
+//     "SPTREES1"                          the magic number
+//     uint64 checksum                     RoadMap::checksum() of the map
+//     int32 locations, int32 trees
+//     int32 location numbers[locations]   in increasing order, so that
+//                                         index i stands for the i-th
+//     (int32 start, int32 metric)[trees]  in increasing order of metric
+//                                         (0 for D, 1 for T), then start
+//     then for each tree, in the same order:
+//         double distance[locations]      infinity if unreachable
+//         int32 predecessor[locations]    an index, the start's own index
+//                                         for the start, or -1 if
+//                                         unreachable
+//
+// Trees are built by findShortestPathTree() (see ShortestPath.hpp), which
+// runs the same search as the findShortestPath() DijkstraTripRouter calls,
+// so a cached path is the one that router would find.
+
+#ifndef TREECACHE_HPP
+#define TREECACHE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#include "InputReader.hpp"
+#include "RoadMap.hpp"
+#include "Trip.hpp"
+#include "TripMetric.hpp"
+
+
+
+class TreeCacheException : public std::runtime_error
+{
+public:
+    TreeCacheException(const std::string& reason);
+};
+
+
+
+// readHotSources() reads the start locations and metrics to build trees
+// for: the number of them on the first line, then one per line, as a
+// location number and D or T.  If the input isn't in that form, a
+// TreeCacheException is thrown.
+std::vector<std::pair<int, TripMetric>> readHotSources(InputReader& in);
+
+
+// writeTreeCache() builds a shortest path tree over the given RoadMap for
+// each of the given start locations and metrics (repeats are built once),
+// using up to threadCount threads (0 means one per hardware thread), and
+// writes them to the named file.  If a start location doesn't exist, a
+// DigraphException is thrown; if the file can't be written, a
+// TreeCacheException is thrown.
+void writeTreeCache(
+    const std::string& fileName, const RoadMap& roadMap,
+    const std::vector<std::pair<int, TripMetric>>& sources,
+    unsigned int threadCount = 0);
+
+
+
+class TreeCache
+{
+public:
+    // The default constructor initializes a TreeCache with no trees.
+    TreeCache();
+
+    // This constructor maps the named file, written by writeTreeCache(),
+    // into memory.  If it can't be opened, isn't a tree cache, or was
+    // built for a map other than the given one, a TreeCacheException is
+    // thrown.
+    TreeCache(const std::string& fileName, const RoadMap& roadMap);
+
+    // The destructor unmaps the file.
+    ~TreeCache() noexcept;
+
+    TreeCache(const TreeCache&) = delete;
+    TreeCache& operator=(const TreeCache&) = delete;
+
+    TreeCache(TreeCache&& other) noexcept;
+    TreeCache& operator=(TreeCache&& other) noexcept;
+
+    // treeCount() returns the number of trees in the cache.
+    int treeCount() const noexcept;
+
+    // contains() returns true if the cache has a tree for the given start
+    // location and metric, false otherwise.
+    bool contains(int startVertex, TripMetric metric) const;
+
+    // findPath() returns false if the cache has no tree for the given
+    // trip's start location and metric.  Otherwise, it stores the location
+    // numbers along the trip's path into "path" (or leaves it empty if the
+    // end location can't be reached) and returns true.  If the end
+    // location does not exist, a DigraphException is thrown.
+    bool findPath(const Trip& trip, std::vector<int>& path) const;
+
+    // findDistance() is like findPath(), but stores the length of the
+    // trip's path (infinity if there is none) into "distance" instead.
+    bool findDistance(const Trip& trip, double& distance) const;
+
+    // byteCount() returns the size of the mapped file.
+    std::size_t byteCount() const noexcept;
+
+
+private:
+    //returns the position of the tree for the given start and metric
+    //among the trees, or -1 if there isn't one
+    int findTree(int startVertex, TripMetric metric) const;
+
+    //returns the index of the given location number, throwing if there's
+    //no such location
+    int indexOf(int vertex) const;
+
+    const double* distances(int tree) const;
+    const std::int32_t* predecessors(int tree) const;
+
+    void* mapping;
+    std::size_t mappingSize;
+
+    int vertexCount;
+    int trees;
+    const std::int32_t* vertexNumbers;
+    const std::int32_t* sources;
+    const char* treeData;
+};
+
+
+
+#endif // TREECACHE_HPP
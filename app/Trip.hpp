@@ -6,6 +6,9 @@
 // Describes a type that carries information about one trip to be evaluated
 // by the program.  A trip is described by a start vertex number, an end
 // vertex number, and a TripMetric (i.e., distance or driving time).
+// A driving-time trip may also say when it leaves, in seconds since
+// midnight (see TimeOfDay.hpp), so that it can be routed around the
+// traffic at that time of day.
 
 #ifndef TRIP_HPP
 #define TRIP_HPP
@@ -14,11 +17,17 @@
 
 
 
+// noDepartureTime is the departureTime of a trip that doesn't say when
+// it leaves.
+constexpr int noDepartureTime = -1;
+
+
 struct Trip
 {
     int startVertex;
     int endVertex;
     TripMetric metric;
+    int departureTime = noDepartureTime;
 };
 
 
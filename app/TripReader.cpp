@@ -5,30 +5,99 @@
 
 #include <sstream>
 #include <string>
+#include "TimeOfDay.hpp"
 #include "TripReader.hpp"
 
 
-std::vector<Trip> TripReader::readTrips(InputReader& in)
+namespace
 {
-    std::vector<Trip> trips;
+    int readTripCount(InputReader& in)
+    {
+        try
+        {
+            return in.readIntLine();
+        }
+        catch (InputReaderException& e)
+        {
+            throw InputReaderException(
+                "line " + std::to_string(in.lineNumber()) + ": " + e.what());
+        }
+    }
 
-    int numberOfTrips = in.readIntLine();
 
-    for (int i = 0; i < numberOfTrips; ++i)
+    Trip readTrip(InputReader& in)
     {
         std::istringstream tripLine{in.readLine()};
 
         int fromVertex;
         int toVertex;
         std::string metricType;
+        std::string departure;
+        std::string extra;
+
+        if (!(tripLine >> fromVertex >> toVertex >> metricType) ||
+            (metricType != "D" && metricType != "T"))
+        {
+            throw InputReaderException(
+                "line " + std::to_string(in.lineNumber()) + ": expected a trip (from, to, D or T)");
+        }
+
+        Trip trip{fromVertex, toVertex,
+             metricType == "D" ? TripMetric::Distance : TripMetric::Time};
 
-        tripLine >> fromVertex >> toVertex >> metricType;
+        //a fourth field, if there is one, is when the trip leaves
+        if (tripLine >> departure && !parseTimeOfDay(departure, trip.departureTime))
+        {
+            throw InputReaderException(
+                "line " + std::to_string(in.lineNumber()) + ": invalid departure time " + departure);
+        }
+        if (tripLine >> extra)
+        {
+            throw InputReaderException(
+                "line " + std::to_string(in.lineNumber()) + ": unexpected " + extra + " after the trip");
+        }
 
-        trips.push_back(
-            {fromVertex, toVertex,
-             metricType == "D" ? TripMetric::Distance : TripMetric::Time});
+        return trip;
+    }
+}
+
+
+std::vector<Trip> TripReader::readTrips(InputReader& in)
+{
+    std::vector<Trip> trips;
+
+    int numberOfTrips = readTripCount(in);
+
+    for (int i = 0; i < numberOfTrips; ++i)
+    {
+        trips.push_back(readTrip(in));
     }
 
     return trips;
 }
 
+
+void TripReader::streamTrips(InputReader& in, BoundedQueue<Trip>& trips)
+{
+    try
+    {
+        int numberOfTrips = readTripCount(in);
+
+        //if the consumer closes the queue, it wants no more trips, so
+        //the rest are left unread
+        for (int i = 0; i < numberOfTrips; ++i)
+        {
+            if (!trips.push(readTrip(in)))
+            {
+                break;
+            }
+        }
+    }
+    catch (...)
+    {
+        trips.close();
+        throw;
+    }
+
+    trips.close();
+}
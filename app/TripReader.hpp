@@ -4,12 +4,16 @@
 // Project #4: Rock and Roll Stops the Traffic
 //
 // A TripReader reads a sequence of trips from the given input, assuming
-// they're written in the format described in the project write-up.
+// they're written in the format described in the project write-up.  A
+// trip's line may end with a fourth field, the time it leaves (e.g.,
+// "08:30").  A count or a trip that can't be understood causes an
+// InputReaderException that gives its line number.
 
 #ifndef TRIPREADER_HPP
 #define TRIPREADER_HPP
 
 #include <vector>
+#include "BoundedQueue.hpp"
 #include "Trip.hpp"
 #include "InputReader.hpp"
 
@@ -21,9 +25,16 @@ public:
     // readTrips() reads a sequence of trips from the given input,
     // returning them as a vector of Trip structs.
     std::vector<Trip> readTrips(InputReader& in);
+
+    // streamTrips() reads the same sequence of trips as readTrips(), but
+    // pushes each one onto the given queue as soon as it has been read,
+    // so that they can be processed (on another thread) while the rest
+    // are still being read.  The queue is closed once every trip has
+    // been pushed, or if reading fails; if the consumer closes it first,
+    // streamTrips() stops reading and returns.
+    void streamTrips(InputReader& in, BoundedQueue<Trip>& trips);
 };
 
 
 
 #endif // TRIPREADER_HPP
-
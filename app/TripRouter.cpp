@@ -0,0 +1,192 @@
+// TripRouter.cpp
+//
+// ICS 46 Winter 2019
+// Project #4: Rock and Roll Stops the Traffic
+
+#include <utility>
+#include "GraphOverlay.hpp"
+#include "RoadMapWeights.hpp"
+#include "SearchWorkspace.hpp"
+#include "ShortestPath.hpp"
+#include "TripRouter.hpp"
+
+
+namespace
+{
+    template <typename Weight, typename SearchFunc>
+    void searchSnapshot(
+        const CompactDigraph<Weight>& graph, const Trip& trip,
+        std::vector<int>& path, SearchFunc search)
+    {
+        search(graph, graph.indexOf(trip.startVertex), graph.indexOf(trip.endVertex), path);
+
+        for(int& vertex : path)
+        {
+            vertex = graph.vertexNumber(vertex);
+        }
+    }
+
+
+    //calls edgeFunc(edge) for every edge from one vertex to another,
+    //throwing if there isn't one
+    template <typename EdgeFunc>
+    void forEachRoadEdge(
+        const CompactDigraph<double>& graph, int fromVertex, int toVertex, EdgeFunc edgeFunc)
+    {
+        int from = graph.indexOf(fromVertex);
+        int to = graph.indexOf(toVertex);
+        bool found = false;
+
+        for(int edge = graph.edgesBegin(from); edge < graph.edgesEnd(from); ++edge)
+        {
+            if(graph.target(edge) == to)
+            {
+                edgeFunc(edge);
+                found = true;
+            }
+        }
+
+        if(!found)
+        {
+            throw DigraphException("Invalid Edge");
+        }
+    }
+}
+
+
+std::vector<int> TripRouter::findPath(const Trip& trip) const
+{
+    std::vector<int> path;
+    findPath(trip, path);
+    return path;
+}
+
+
+DijkstraTripRouter::DijkstraTripRouter(const RoadMap& roadMap)
+    : distanceGraph{compactRoadMap(roadMap, TripMetric::Distance)},
+      timeGraph{compactRoadMap(roadMap, TripMetric::Time)}
+{
+}
+
+
+void DijkstraTripRouter::findPath(const Trip& trip, std::vector<int>& path) const
+{
+    thread_local SearchWorkspace<double> workspace;
+
+    searchSnapshot(
+        trip.metric == TripMetric::Time ? timeGraph : distanceGraph, trip, path,
+        [](const CompactDigraph<double>& graph, int start, int end, std::vector<int>& path)
+        {
+            findShortestPath(graph, start, end, workspace, path);
+        });
+}
+
+
+void DijkstraTripRouter::findPath(
+    const Trip& trip, const RoadClosures& closures, std::vector<int>& path) const
+{
+    thread_local SearchWorkspace<double> workspace;
+    thread_local GraphOverlay<double> overlay;
+
+    //both snapshots were taken from the same RoadMap, so their vertices
+    //and edges have the same indexes
+    const CompactDigraph<double>& graph = trip.metric == TripMetric::Time ? timeGraph : distanceGraph;
+    overlay.prepare(graph.vertexCount(), graph.edgeCount());
+
+    for(int vertex : closures.closedLocations)
+    {
+        overlay.closeVertex(graph.indexOf(vertex));
+    }
+
+    for(const std::pair<int, int>& road : closures.closedRoads)
+    {
+        forEachRoadEdge(graph, road.first, road.second,
+            [&](int edge)
+            {
+                overlay.closeEdge(edge);
+            });
+    }
+
+    for(const SpeedChange& change : closures.speedChanges)
+    {
+        forEachRoadEdge(graph, change.fromVertex, change.toVertex,
+            [&](int edge)
+            {
+                if(change.milesPerHour <= 0.0)
+                {
+                    overlay.closeEdge(edge);
+                }
+                else if(trip.metric == TripMetric::Time)
+                {
+                    overlay.setWeight(edge,
+                        TimeWeight{}(RoadSegment{distanceGraph.weight(edge), change.milesPerHour}));
+                }
+            });
+    }
+
+    searchSnapshot(graph, trip, path,
+        [](const CompactDigraph<double>& graph, int start, int end, std::vector<int>& path)
+        {
+            findShortestPath(graph, overlay, start, end, workspace, path);
+        });
+}
+
+
+ClosureTripRouter::ClosureTripRouter(const DijkstraTripRouter& router, RoadClosures closures)
+    : router{router}, closures{std::move(closures)}
+{
+}
+
+
+void ClosureTripRouter::findPath(const Trip& trip, std::vector<int>& path) const
+{
+    router.findPath(trip, closures, path);
+}
+
+
+QuantizedTripRouter::QuantizedTripRouter(const RoadMap& roadMap)
+    : distanceGraph{compactRoadMapQuantized(roadMap, TripMetric::Distance)},
+      timeGraph{compactRoadMapQuantized(roadMap, TripMetric::Time)}
+{
+}
+
+
+void QuantizedTripRouter::findPath(const Trip& trip, std::vector<int>& path) const
+{
+    thread_local SearchWorkspace<std::uint64_t> workspace;
+
+    searchSnapshot(
+        trip.metric == TripMetric::Time ? timeGraph : distanceGraph, trip, path,
+        [](const CompactDigraph<std::uint32_t>& graph, int start, int end, std::vector<int>& path)
+        {
+            findShortestPathRadix(graph, start, end, workspace, path);
+        });
+}
+
+
+MemoryUsage DijkstraTripRouter::memoryUsage() const
+{
+    MemoryUsage usage;
+    usage.add("distance snapshot", distanceGraph.byteCount());
+    usage.add("time snapshot", timeGraph.byteCount());
+    return usage;
+}
+
+
+MemoryUsage QuantizedTripRouter::memoryUsage() const
+{
+    MemoryUsage usage;
+    usage.add("distance snapshot", distanceGraph.byteCount());
+    usage.add("time snapshot", timeGraph.byteCount());
+    return usage;
+}
+
+
+MemoryUsage ClosureTripRouter::memoryUsage() const
+{
+    MemoryUsage usage;
+    usage.add("closed locations", vectorBytes(closures.closedLocations));
+    usage.add("closed road segments", vectorBytes(closures.closedRoads));
+    usage.add("speed changes", vectorBytes(closures.speedChanges));
+    return usage;
+}
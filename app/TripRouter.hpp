@@ -0,0 +1,126 @@
+// TripRouter.hpp
+//
+// ICS 46 Winter 2019
+// Project #4: Rock and Roll Stops the Traffic
+//
+// A TripRouter finds the path for one trip at a time over a RoadMap.  There
+// are several kinds, which differ in how they search and what they store,
+// but any of them can be handed to the code that answers trips (e.g., a
+// QueryServer) so that the search engine can be chosen when the program
+// starts.  Every TripRouter may be used from several threads at once;
+// each thread searches in a SearchWorkspace of its own, which is kept
+// from one trip to the next, so routing a trip doesn't allocate anything
+// once the thread has warmed up.
+//
+// This header declares the TripRouter interface along with the two basic
+// kinds: one that runs Dijkstra's algorithm over double weights, and one
+// that runs it over quantized integer weights with a RadixHeap.  A
+// ClosureTripRouter routes every trip around the same RoadClosures.
+
+#ifndef TRIPROUTER_HPP
+#define TRIPROUTER_HPP
+
+#include <cstdint>
+#include <vector>
+#include "CompactDigraph.hpp"
+#include "MemoryUsage.hpp"
+#include "RoadClosures.hpp"
+#include "RoadMap.hpp"
+#include "Trip.hpp"
+
+
+
+class TripRouter
+{
+public:
+    virtual ~TripRouter() = default;
+
+    // findPath() stores the vertex numbers along the path chosen for the
+    // given trip into "path", from its start vertex to its end vertex, or
+    // leaves it empty if the end vertex can't be reached.  If either
+    // vertex does not exist, a DigraphException is thrown.
+    virtual void findPath(const Trip& trip, std::vector<int>& path) const = 0;
+
+    // This overload of findPath() returns the path instead.
+    std::vector<int> findPath(const Trip& trip) const;
+
+    // memoryUsage() returns a breakdown of the memory used by the router's
+    // own tables (its snapshots of the map, and whatever it precomputes
+    // from them), not counting the RoadMap it was built from or the
+    // workspaces its searches run in.
+    virtual MemoryUsage memoryUsage() const = 0;
+};
+
+
+
+// A DijkstraTripRouter searches a CompactDigraph<double> snapshot of the
+// RoadMap for each metric.
+class DijkstraTripRouter : public TripRouter
+{
+public:
+    explicit DijkstraTripRouter(const RoadMap& roadMap);
+
+    using TripRouter::findPath;
+    void findPath(const Trip& trip, std::vector<int>& path) const override;
+    MemoryUsage memoryUsage() const override;
+
+    // This overload of findPath() finds the path as though the given
+    // closures were in effect.  Applying them takes time proportional to
+    // how many there are, not to the size of the map, and the router
+    // itself is left unchanged, so any number of threads may ask about
+    // different closures at once.  If any location or road segment they
+    // mention does not exist, a DigraphException is thrown.
+    void findPath(const Trip& trip, const RoadClosures& closures, std::vector<int>& path) const;
+
+
+private:
+    CompactDigraph<double> distanceGraph;
+    CompactDigraph<double> timeGraph;
+};
+
+
+
+// A ClosureTripRouter hands every trip to a DijkstraTripRouter along with
+// the closures it was given, so that anything that takes a TripRouter can
+// route around them.  The DijkstraTripRouter has to outlive it.
+class ClosureTripRouter : public TripRouter
+{
+public:
+    ClosureTripRouter(const DijkstraTripRouter& router, RoadClosures closures);
+
+    using TripRouter::findPath;
+    void findPath(const Trip& trip, std::vector<int>& path) const override;
+
+    // Only the closures are counted, not the DijkstraTripRouter's tables.
+    MemoryUsage memoryUsage() const override;
+
+
+private:
+    const DijkstraTripRouter& router;
+    RoadClosures closures;
+};
+
+
+
+// A QuantizedTripRouter converts every RoadSegment into a scaled integer
+// weight when it's constructed (see QuantizedWeight in RoadMapWeights.hpp)
+// and searches with a RadixHeap.  Its paths have the same length as the
+// ones DijkstraTripRouter finds, to within the rounding of the weights.
+class QuantizedTripRouter : public TripRouter
+{
+public:
+    explicit QuantizedTripRouter(const RoadMap& roadMap);
+
+    using TripRouter::findPath;
+    void findPath(const Trip& trip, std::vector<int>& path) const override;
+    MemoryUsage memoryUsage() const override;
+
+
+private:
+    CompactDigraph<std::uint32_t> distanceGraph;
+    CompactDigraph<std::uint32_t> timeGraph;
+};
+
+
+
+#endif // TRIPROUTER_HPP
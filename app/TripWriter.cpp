@@ -0,0 +1,108 @@
+// TripWriter.cpp
+//
+// ICS 46 Winter 2019
+// Project #4: Rock and Roll Stops the Traffic
+
+#include <cmath>
+#include <iomanip>
+#include "TimeOfDay.hpp"
+#include "TripWriter.hpp"
+
+
+namespace
+{
+    void writeDuration(std::ostream& out, double seconds)
+    {
+        int hrs = (int)(seconds/3600);
+        int mins = (int)(std::fmod(seconds,3600)/60);
+        double secs = std::fmod(std::fmod(seconds,3600),60);
+
+        if(hrs!=0)
+        {
+            out<<hrs<<" hours ";
+        }
+        if(mins!=0)
+        {
+            out<<mins<<" minutes ";
+        }
+        out<<secs<<" seconds";
+    }
+}
+
+
+void TripWriter::writeTrip(
+    std::ostream& out, const RoadMap& roadMap,
+    const Trip& trip, const std::vector<int>& path,
+    const SpeedProfiles* profiles)
+{
+    out<<std::fixed<<std::setprecision(2);
+
+    double totalTime = 0;
+    double totalDist = 0;
+    bool timed = trip.departureTime != noDepartureTime && profiles != nullptr;
+
+    if(trip.metric == TripMetric::Time)
+    {
+        out<<"Shortest driving time from "<<
+        roadMap.vertexInfo(trip.startVertex)<<
+        " to "<<roadMap.vertexInfo(trip.endVertex);
+        if(timed)
+        {
+            out<<", leaving at "<<formatTimeOfDay(trip.departureTime);
+        }
+        out<<":\n";
+    }
+    else
+    {
+        out<<"Shortest distance from "<<
+        "\n\nTEST:"<<trip.startVertex<<
+        roadMap.vertexInfo(trip.startVertex)<<" to "<<
+        roadMap.vertexInfo(trip.endVertex)<<":\n";
+    }
+
+    out<<"\tBeging at "<<roadMap.vertexInfo(trip.startVertex)<<"\n";
+    if(path.empty())
+    {
+        out<<"\tNo route found\n";
+    }
+
+    for(unsigned int i = 1; i < path.size(); ++i)
+    {
+        RoadSegment segment = roadMap.edgeInfo(path[i - 1], path[i]);
+
+        out<<"\tContiue to "<< roadMap.vertexInfo(path[i])<<
+        " ("<<segment.miles<<" miles";
+
+        if(trip.metric == TripMetric::Time)
+        {
+            double time = 3600*segment.miles/segment.milesPerHour;
+            double milesPerHour = segment.milesPerHour;
+            if(timed)
+            {
+                time = profiles->travelSeconds(segment, trip.departureTime + totalTime);
+                milesPerHour = 3600*segment.miles/time;
+            }
+            totalTime += time;
+
+            out<<" & "<<milesPerHour<<"mph = ";
+            writeDuration(out, time);
+        }
+        else
+        {
+            totalDist += segment.miles;
+        }
+
+        out<<")\n";
+    }
+
+    if(trip.metric == TripMetric::Time)
+    {
+        out<<"Total time: ";
+        writeDuration(out, totalTime);
+        out<<")\n\n";
+    }
+    else
+    {
+        out<<"Total distance: "<<totalDist<<" miles\n";
+    }
+}
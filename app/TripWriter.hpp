@@ -0,0 +1,40 @@
+// TripWriter.hpp
+//
+// ICS 46 Winter 2019
+// Project #4: Rock and Roll Stops the Traffic
+//
+// The TripWriter class writes the turn-by-turn directions for one trip to
+// an output stream, given the path that was chosen for it.  It keeps no
+// state between trips, so any number of threads can use TripWriters at
+// once, each writing to its own stream.
+
+#ifndef TRIPWRITER_HPP
+#define TRIPWRITER_HPP
+
+#include <ostream>
+#include <vector>
+#include "RoadMap.hpp"
+#include "SpeedProfiles.hpp"
+#include "Trip.hpp"
+
+
+
+class TripWriter
+{
+public:
+    // writeTrip() writes the directions for the given trip to the given
+    // output stream.  The path lists the vertex numbers visited, from
+    // the trip's start vertex to its end vertex; an empty path means
+    // that the end vertex can't be reached.  If the trip says when it
+    // leaves and speed profiles are given, the time on each segment is
+    // the time it takes when the trip reaches it, and its speed is the
+    // average speed over that time.
+    void writeTrip(
+        std::ostream& out, const RoadMap& roadMap,
+        const Trip& trip, const std::vector<int>& path,
+        const SpeedProfiles* profiles = nullptr);
+};
+
+
+
+#endif // TRIPWRITER_HPP
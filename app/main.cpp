@@ -5,170 +5,1239 @@
 //
 // This is the program's main() function, which is the entry point for your
 // console user interface.
+//
+// With no arguments, the program reads a map and then a list of trips from
+// the standard input, writes directions for each trip, and exits.  Other
+// ways of running it:
+//
+//     --map FILE       read the map from FILE instead of the standard input
+//     --server         after loading the map, keep answering trip queries
+//                      (see QueryServer.hpp) read from the standard input
+//     --socket PATH    after loading the map, keep answering trip queries
+//                      sent to a Unix domain socket at PATH, until the
+//                      request QUIT, SIGINT or SIGTERM stops the server
+//     --threads N      answer up to N server queries at once, and read
+//                      the map given with --map on up to N threads
+//     --engine NAME    find paths with the named search engine:
+//                        batched    batched SIMD searches (the default for
+//                                   trips; the server uses dijkstra)
+//                        dijkstra   one search per trip
+//                        quantized  one search per trip over integer
+//                                   weights, using a radix heap
+//                        alt        one search per trip, steered toward
+//                                   its destination by landmarks
+//                        overlay    one search per trip, crossing whole
+//                                   cells of a partitioned map at once
+//                        compressed one search per trip over a map whose
+//                                   segments are compressed to a few
+//                                   bytes each
+//                        contracted one search per trip over a map whose
+//                                   chains of in-between locations are
+//                                   collapsed into single segments
+//     --patch FILE     apply the changes in FILE (see MapPatch.hpp) to the
+//                      map before answering trips; may be given more than
+//                      once, and the patches are applied in order
+//     --closures FILE  route every trip around the closed locations and
+//                      road segments, and at the changed speeds, in FILE
+//                      (see RoadClosures.hpp), without changing the map;
+//                      only the dijkstra engine can (batched becomes
+//                      dijkstra), no tree cache is used, and trips routed
+//                      by speed profiles ignore the closures
+//     --validate       after loading and patching the map, check that every
+//                      location can reach every other, on up to N threads
+//                      if --threads N is given; if some can't, write how
+//                      the map falls apart (its weakly connected pieces,
+//                      and the locations that reach the fewest others) to
+//                      the standard error and exit
+//     --profiles FILE  read speed profiles (see SpeedProfiles.hpp) from
+//                      FILE, and route driving-time trips that say when
+//                      they leave by the speeds at that time of day
+//     --landmarks N    use N landmarks per metric with --engine alt
+//                      (the default is 8)
+//     --landmark-file FILE
+//                      load the landmark tables from FILE if they were
+//                      built for this map, or build and save them there
+//     --write-shards DIR
+//                      split the map into shards (see RoadMapShards.hpp),
+//                      write them to DIR, and exit without reading trips
+//     --shards N       the number of shards --write-shards makes (the
+//                      default is 4)
+//     --shard-dir DIR  don't load a map; instead, read only trips from the
+//                      standard input and answer them over the shards in
+//                      DIR, with one worker process per shard (see
+//                      ShardCoordinator.hpp)
+//     --shard-worker DIR N
+//                      serve shard N in DIR over the standard input and
+//                      output; this is how --shard-dir starts its workers
+//     --write-tree-cache FILE
+//                      build shortest path trees from the start locations
+//                      and metrics listed in the file given with
+//                      --hot-sources (see TreeCache.hpp), write them to
+//                      FILE, and exit without reading trips
+//     --hot-sources FILE
+//                      the start locations and metrics for
+//                      --write-tree-cache
+//     --tree-cache FILE
+//                      answer trips from the start locations in FILE by
+//                      walking its cached trees, and the rest with the
+//                      chosen engine (batched becomes dijkstra); a cache
+//                      built for a different map is ignored
+//     --matrix         instead of writing directions for each trip, write
+//                      a table for each metric the trips use, of the
+//                      shortest distance (in miles) or driving time (in
+//                      seconds) from every start location of a trip by
+//                      that metric to every end location of one, using
+//                      up to N threads if --threads N is given; "-" means
+//                      there is no path
+//     --memory         after loading the map and building the engine,
+//                      write a breakdown of the memory they use (see
+//                      MemoryUsage.hpp) to the standard error
+//     --memory-budget SIZE
+//                      refuse to go on if the map, patches, engine tables,
+//                      tree cache and speed profiles would use more than
+//                      SIZE bytes between them (SIZE may end in K, M or
+//                      G); each is charged an estimate before it's built,
+//                      so that one too big is refused rather than loaded
 #include <iostream>
 #include "InputReader.hpp"
 #include "Digraph.hpp"
 #include "RoadMapReader.hpp"
 #include "TripReader.hpp"
 #include "TripMetric.hpp"
+#include "TripWriter.hpp"
 #include "RoadSegment.hpp"
 #include "RoadMapWriter.hpp"
+#include "RoadMapWeights.hpp"
+#include "CompactDigraph.hpp"
+#include "DigraphAnalytics.hpp"
+#include "DistanceMatrix.hpp"
+#include "BatchedSearch.hpp"
+#include "BoundedQueue.hpp"
+#include "QueryServer.hpp"
+#include "TripRouter.hpp"
+#include "AltTripRouter.hpp"
+#include "OverlayTripRouter.hpp"
+#include "CompressedTripRouter.hpp"
+#include "ContractedTripRouter.hpp"
+#include "MapPatch.hpp"
+#include "RoadClosures.hpp"
+#include "SpeedProfiles.hpp"
+#include "TimeDependentTripRouter.hpp"
+#include "RoadMapShards.hpp"
+#include "ShardWorker.hpp"
+#include "ShardCoordinator.hpp"
+#include "MemoryBudget.hpp"
+#include "MemoryUsage.hpp"
+#include "TreeCache.hpp"
+#include "CachedTripRouter.hpp"
 #include <vector>
-#include <math.h>
 #include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <csignal>
 #include <functional>
 #include <iomanip>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
 //#include <function>
 
 
-//set precision for doubles at 2
-//std::map<int,int> shortEdgeList ;
-//std::vector<Trip>;
-double totalTime=0, totalDist=0;
-RoadMap mainMap;
+//how far ahead in the trip list to look for other trips whose start
+//vertex can share a batched search with the current one
+const unsigned int batchLookahead = 256;
+
+//how many trips may be read but not yet routed at once
+const unsigned int tripQueueCapacity = 4096;
+
+
+//A TripBatch remembers which start vertices the most recent batched
+//search for one metric covered (one per lane), so that later trips from
+//any of those start vertices can reuse its results
+struct TripBatch
+{
+    std::vector<int> startVertices;
+    BatchedShortestPaths paths;
+};
+
+
+int findLane(const TripBatch& batch, int startVertex)
+{
+    for(unsigned int lane = 0; lane < batch.startVertices.size(); ++lane)
+    {
+        if(batch.startVertices[lane] == startVertex)
+        {
+            return lane;
+        }
+    }
+    return -1;
+}
+
+
+//searches from the given trip's start vertex, along with the start
+//vertices of the trips queued up behind it with the same metric, filling
+//up as many lanes as it can
+void runBatch(TripBatch& batch, const CompactDigraph<double>& graph,
+              const Trip& trip, const std::deque<Trip>& trips)
+{
+    //looked up first, so that a trip from a vertex that doesn't exist
+    //leaves the last batch as it was
+    std::vector<int> startIndexes{graph.indexOf(trip.startVertex)};
+    batch.startVertices = {trip.startVertex};
+
+    for(unsigned int j = 0;
+        j < trips.size() && batch.startVertices.size() < BatchedSearchLanes; ++j)
+    {
+        if(trips[j].metric == trip.metric &&
+           findLane(batch, trips[j].startVertex) == -1 &&
+           graph.contains(trips[j].startVertex))
+        {
+            batch.startVertices.push_back(trips[j].startVertex);
+            startIndexes.push_back(graph.indexOf(trips[j].startVertex));
+        }
+    }
+
+    batch.paths = findShortestPathsBatched(graph, startIndexes);
+}
+
+
+//walks the predecessors of one lane back from the end vertex, storing
+//the vertex numbers along the path from start to end into "path" (empty
+//if the end vertex was never reached)
+void tracePath(const CompactDigraph<double>& graph, const TripBatch& batch,
+               int lane, int startVertex, int endVertex, std::vector<int>& path)
+{
+    path.clear();
+    int start = graph.indexOf(startVertex);
+    int current = graph.indexOf(endVertex);
 
+    if(current != start && batch.paths.predecessor(lane, current) == current)
+    {
+        return;
+    }
 
-void printInfoDist(int currentVertIn, int nextVertIn, std::map<int,int> currentEdgeList, Trip currentTripIn)
+    while(current != start)
+    {
+        path.push_back(graph.vertexNumber(current));
+        current = batch.paths.predecessor(lane, current);
+    }
+    path.push_back(startVertex);
+
+    std::reverse(path.begin(), path.end());
+}
+
+
+//options that only some search engines use
+struct EngineOptions
+{
+    int landmarkCount = 8;
+    std::string landmarkFile;
+};
+
+
+//makes the TripRouter for the search engine with the given name, or
+//returns nullptr if there isn't one by that name
+std::unique_ptr<TripRouter> makeRouter(
+    const std::string& engine, const RoadMap& mainMap, const EngineOptions& options)
 {
-    if(nextVertIn!= currentTripIn.startVertex)
+    if(engine == "dijkstra")
+    {
+        return std::make_unique<DijkstraTripRouter>(mainMap);
+    }
+    else if(engine == "quantized")
+    {
+        return std::make_unique<QuantizedTripRouter>(mainMap);
+    }
+    else if(engine == "alt")
+    {
+        auto router = std::make_unique<AltTripRouter>(
+            mainMap, options.landmarkCount, options.landmarkFile);
+        if(!options.landmarkFile.empty() && !router->loadedFromFile() && !router->savedToFile())
+        {
+            std::cerr<<options.landmarkFile<<": could not save the landmark tables\n";
+        }
+        return router;
+    }
+    else if(engine == "overlay")
     {
-        printInfoDist(nextVertIn,currentEdgeList.at(nextVertIn), currentEdgeList, currentTripIn);
-            
+        return std::make_unique<OverlayTripRouter>(mainMap);
     }
-    //else
+    else if(engine == "compressed")
     {
-       //compute time 
+        return std::make_unique<CompressedTripRouter>(mainMap);
+    }
+    else if(engine == "contracted")
+    {
+        return std::make_unique<ContractedTripRouter>(mainMap);
+    }
+    return nullptr;
+}
+
+
+//closes the trip queue and waits for the thread reading trips into it,
+//however the routing loop is left: if routing throws, the reader may be
+//blocked on a full queue, and a thread that's never joined ends the
+//program when it's destroyed
+struct ReaderGuard
+{
+    BoundedQueue<Trip>& queue;
+    std::thread& thread;
+
+    ~ReaderGuard()
+    {
+        queue.close();
+        thread.join();
+    }
+};
+
+
+//the server that SIGINT and SIGTERM stop, while one is serving a socket
+std::atomic<QueryServer*> runningServer{nullptr};
+
+
+extern "C" void stopRunningServer(int)
+{
+    QueryServer* server = runningServer;
+    if(server != nullptr)
+    {
+        server->stop();
+    }
+}
+
+
+//reads the trips that follow the map and writes directions for each one,
+//using the given router to find paths, or batched searches if it's null;
+//trips that say when they leave go to timedRouter instead, if there is one
+void runTrips(InputReader& mainInputReader, const RoadMap& mainMap, const TripRouter* router,
+              const TripRouter* timedRouter, const SpeedProfiles* profiles)
+{
+    //array snapshots of the map, with the weight of every edge worked out
+    //once up front for each metric; only the batched searches use them,
+    //so they stay empty when there's a router
+    CompactDigraph<double> distanceGraph;
+    CompactDigraph<double> timeGraph;
+    if(router == nullptr)
+    {
+        distanceGraph = compactRoadMap(mainMap, TripMetric::Distance);
+        timeGraph = compactRoadMap(mainMap, TripMetric::Time);
+    }
     
-        double tempDist = (mainMap.edgeInfo(nextVertIn, currentVertIn)).miles;
-        totalDist +=tempDist;
+    
+    //TRIPs    
+    TripReader mainTripReader;
+    TripWriter mainTripWriter;
+    
+    //ar Trip has int start/endVertex and a TripMetric ("Time, Distance")
+    //trips are read on their own thread and routed as they arrive, so the
+    //first results come out before the last trips have even been read
+    BoundedQueue<Trip> tripQueue(tripQueueCapacity);
+    std::exception_ptr readFailure;
+    std::thread tripThread(
+        [&]()
+        {
+            try
+            {
+                mainTripReader.streamTrips(mainInputReader, tripQueue);
+            }
+            catch(...)
+            {
+                readFailure = std::current_exception();
+            }
+        });
+
+
+//EdgeInfo is of type RoadSegment
+
+    //trips with different start vertices share one batched search
+    TripBatch distanceBatch;
+    TripBatch timeBatch;
+
+    //trips taken off the queue but not yet routed; they're only there to
+    //fill up lanes in a batched search
+    std::deque<Trip> pending;
+    Trip nextTrip;
+
+    //reused for every trip, so that it stops allocating once it's as
+    //long as the longest path
+    std::vector<int> path;
+
+    {
+        ReaderGuard readerGuard{tripQueue, tripThread};
+
+        while(true)
+        {
+            if(pending.empty())
+            {
+                //about to wait for the reader, so let out what's ready
+                std::cout.flush();
+                if(!tripQueue.pop(nextTrip))
+                {
+                    break;
+                }
+                pending.push_back(nextTrip);
+            }
+            while(pending.size() < batchLookahead && tripQueue.tryPop(nextTrip))
+            {
+                pending.push_back(nextTrip);
+            }
+
+            Trip trip = pending.front();
+            pending.pop_front();
+
+            //a trip to or from a vertex that doesn't exist is reported and
+            //skipped, rather than ending the whole stream
+            try
+            {
+                if(timedRouter != nullptr && trip.departureTime != noDepartureTime)
+                {
+                    timedRouter->findPath(trip, path);
+                    mainTripWriter.writeTrip(std::cout, mainMap, trip, path, profiles);
+                    continue;
+                }
+
+                if(router != nullptr)
+                {
+                    router->findPath(trip, path);
+                    mainTripWriter.writeTrip(std::cout, mainMap, trip, path);
+                    continue;
+                }
+
+                bool byTime = trip.metric == TripMetric::Time;
+                const CompactDigraph<double>& graph = byTime ? timeGraph : distanceGraph;
+                TripBatch& batch = byTime ? timeBatch : distanceBatch;
+
+                int lane = findLane(batch, trip.startVertex);
+                if(lane == -1)
+                {
+                    runBatch(batch, graph, trip, pending);
+                    lane = 0;
+                }
+
+                tracePath(graph, batch, lane, trip.startVertex, trip.endVertex, path);
+
+                mainTripWriter.writeTrip(std::cout, mainMap, trip, path);
+            }
+            catch(DigraphException& e)
+            {
+                std::cerr<<"trip from "<<trip.startVertex<<" to "<<trip.endVertex
+                         <<": "<<e.what()<<"\n";
+            }
+        }
+    }
+
+    if(readFailure)
+    {
+        std::rethrow_exception(readFailure);
+    }
+}
+
+
+//parses a number of bytes, which may end in K, M or G (powers of 1024),
+//returning false if it isn't one
+bool parseByteCount(const std::string& text, std::size_t& bytes)
+{
+    std::size_t length = 0;
+    unsigned long long value;
+    try
+    {
+        value = std::stoull(text, &length);
+    }
+    catch(std::exception&)
+    {
+        return false;
+    }
 
-        std::cout<<"\tContiue to "<< mainMap.vertexInfo(currentVertIn)<<
-        " ("<<(mainMap.edgeInfo(nextVertIn, currentVertIn)).miles<<" miles)\n";
+    std::string suffix = text.substr(length);
+    int shift = suffix == "" ? 0 : suffix == "K" ? 10 : suffix == "M" ? 20 : suffix == "G" ? 30 : -1;
+    if(shift < 0 || text[0] == '-')
+    {
+        return false;
     }
+
+    bytes = static_cast<std::size_t>(value) << shift;
+    return true;
+}
+
+
+//charges the memory a structure uses to the budget, or writes why it
+//can't be to the standard error and returns false
+bool chargeBudget(MemoryBudget& budget, const std::string& what, std::size_t bytes)
+{
+    try
+    {
+        budget.charge(what, bytes);
+        return true;
+    }
+    catch(MemoryBudgetException& e)
+    {
+        std::cerr<<e.what()<<"\n";
+        return false;
+    }
+}
+
+
+//replaces an estimate charged to the budget before a structure was built
+//with what it turned out to use, or writes why that doesn't fit to the
+//standard error and returns false
+bool settleBudget(MemoryBudget& budget, const std::string& what, std::size_t estimated, std::size_t actual)
+{
+    budget.release(estimated);
+    return chargeBudget(budget, what, actual);
 }
 
-void printInfoTime(int currentVertIn, int nextVertIn, std::map<int,int> currentEdgeList, Trip currentTripIn)
+
+//estimates the memory the named engine's tables will use, before they're
+//built: its snapshots exactly, and the rest from how big it runs on road
+//maps.  Landmark tables hold a distance to and from each landmark for
+//every vertex; an overlay's partition is about the size of a snapshot,
+//and its cell costs about five times as big for each metric; chains and
+//contracted snapshots come to less than the snapshots they're made from,
+//and compressed segments to about half of one snapshot.  The batched
+//engine's snapshots and search results for each metric are counted too,
+//although runTrips() builds them; it builds nothing for the other
+//engines, whose tables are all in their routers' memoryUsage().
+std::size_t estimateEngineBytes(
+    const std::string& engine, const RoadMap& mainMap, const EngineOptions& options)
 {
-    if(nextVertIn!= currentTripIn.startVertex)
+    int vertices = mainMap.vertexCount();
+    int edges = mainMap.edgeCount();
+    std::size_t snapshot = CompactDigraph<double>::estimateByteCount(vertices, edges);
+
+    if(engine == "batched")
+    {
+        std::size_t lanes = static_cast<std::size_t>(vertices) * BatchedSearchLanes;
+        return 2 * snapshot + 2 * lanes * (sizeof(double) + sizeof(int));
+    }
+    else if(engine == "dijkstra")
+    {
+        return 2 * snapshot;
+    }
+    else if(engine == "quantized")
+    {
+        return 2 * CompactDigraph<std::uint32_t>::estimateByteCount(vertices, edges);
+    }
+    else if(engine == "alt")
+    {
+        std::size_t landmarks = std::max(options.landmarkCount, 0);
+        return 2 * snapshot + 2 * landmarks * (sizeof(int) + 2 * vertices * sizeof(double));
+    }
+    else if(engine == "overlay")
+    {
+        return 2 * snapshot + snapshot + 2 * 5 * snapshot;
+    }
+    else if(engine == "compressed")
     {
-        printInfoTime(nextVertIn,currentEdgeList.at(nextVertIn), currentEdgeList, currentTripIn);
-            
+        return snapshot / 2;
     }
-    //else
+    else if(engine == "contracted")
     {
-       //compute time 
+        return 4 * snapshot;
+    }
+    return 0;
+}
 
-        double tempTime = (3600*
-                (mainMap.edgeInfo(nextVertIn, currentVertIn)).miles/
-                ((mainMap.edgeInfo(nextVertIn, currentVertIn)).milesPerHour));
-        totalTime += tempTime;
-        int tempHrs = (int)(tempTime/3600);
-        int tempMins = (int)(fmod(tempTime,3600)/60);
-        double tempSecs = fmod(fmod(tempTime,3600),60);
 
-        std::cout<<"\tContiue to "<< mainMap.vertexInfo(currentVertIn)<<
-        " ("<<(mainMap.edgeInfo(nextVertIn, currentVertIn)).miles<<" miles & "<<
-        (mainMap.edgeInfo(nextVertIn, currentVertIn)).milesPerHour<<"mph = ";
+//checks that every location in the map can reach every other, and if
+//some can't, writes a report of how the map falls apart to the standard
+//error and returns false.  The searches run over a snapshot of the map,
+//which (along with its reversed copy) is charged to the budget while
+//they run.
+bool validateMap(const RoadMap& mainMap, MemoryBudget& budget, unsigned int threadCount)
+{
+    int vertices = mainMap.vertexCount();
+    ScopedCharge charge{&budget, "checking the map",
+        2 * CompactDigraph<double>::estimateByteCount(vertices, mainMap.edgeCount()) +
+        4 * static_cast<std::size_t>(vertices) * sizeof(int)};
 
-        if(tempHrs!=0)
+    CompactDigraph<double> graph = compactRoadMap(mainMap, TripMetric::Distance);
+    if(isStronglyConnectedParallel(graph, threadCount))
+    {
+        return true;
+    }
+
+    std::vector<int> pieces = weaklyConnectedComponents(graph, threadCount);
+    std::vector<int> counts = reachabilityCounts(graph, threadCount);
+
+    int pieceCount = 1 + *std::max_element(pieces.begin(), pieces.end());
+    int fewest = std::min_element(counts.begin(), counts.end()) - counts.begin();
+    int stranded = std::count_if(counts.begin(), counts.end(),
+        [&](int count)
         {
-            std::cout<<tempHrs<<" hours ";
+            return count < vertices;
+        });
+
+    std::cerr<<"The map is not strongly connected: "<<stranded<<" of its "<<vertices
+             <<" locations can't reach all of the others\n";
+    if(pieceCount > 1)
+    {
+        std::cerr<<"It falls into "<<pieceCount<<" pieces with no road segments between them\n";
+    }
+    std::cerr<<"Location "<<graph.vertexNumber(fewest)<<" ("<<mainMap.vertexInfo(graph.vertexNumber(fewest))
+             <<") reaches the fewest: "<<counts[fewest]<<", counting itself\n";
+    return false;
+}
+
+
+//reads the trips that follow the map and writes a table, for each metric
+//they use, of the shortest distance or driving time from each of their
+//distinct start locations to each of their distinct end locations, in
+//the order they first appear.  The snapshot and the table are charged
+//to the budget while they're built.
+void runMatrix(InputReader& mainInputReader, const RoadMap& mainMap,
+               MemoryBudget& budget, unsigned int threadCount)
+{
+    std::vector<Trip> trips = TripReader{}.readTrips(mainInputReader);
+
+    for(TripMetric metric : {TripMetric::Distance, TripMetric::Time})
+    {
+        std::vector<int> sources;
+        std::vector<int> targets;
+        for(const Trip& trip : trips)
+        {
+            if(trip.metric != metric)
+            {
+                continue;
+            }
+            if(std::find(sources.begin(), sources.end(), trip.startVertex) == sources.end())
+            {
+                sources.push_back(trip.startVertex);
+            }
+            if(std::find(targets.begin(), targets.end(), trip.endVertex) == targets.end())
+            {
+                targets.push_back(trip.endVertex);
+            }
+        }
+        if(sources.empty())
+        {
+            continue;
         }
-        if(tempMins!=0)
+
+        ScopedCharge charge{&budget, "the distance matrix",
+            2 * CompactDigraph<double>::estimateByteCount(mainMap.vertexCount(), mainMap.edgeCount()) +
+            sources.size() * targets.size() * sizeof(float)};
+
+        CompactDigraph<double> graph = compactRoadMap(mainMap, metric);
+        std::vector<float> matrix = computeDistanceMatrix(graph, sources, targets, threadCount);
+
+        std::cout<<(metric == TripMetric::Distance
+                    ? "Shortest distances (miles):\n" : "Shortest driving times (seconds):\n");
+        for(int target : targets)
         {
-            std::cout<<tempMins<<" minutes ";
+            std::cout<<"\t"<<target;
+        }
+        std::cout<<"\n";
+
+        for(unsigned int row = 0; row < sources.size(); ++row)
+        {
+            std::cout<<sources[row];
+            for(unsigned int column = 0; column < targets.size(); ++column)
+            {
+                float cost = matrix[row * targets.size() + column];
+                std::cout<<"\t";
+                if(std::isinf(cost))
+                {
+                    std::cout<<"-";
+                }
+                else
+                {
+                    std::cout<<cost;
+                }
+            }
+            std::cout<<"\n";
         }
-        std::cout<<tempSecs<<" seconds)\n";
     }
 }
 
-int main()
+
+//reads trips from the standard input and answers each one over the
+//shards in the given directory, starting workers by running "program"
+void runShardedTrips(const std::string& directory, const std::string& program)
 {
+    InputReader tripReader(std::cin);
+    std::vector<Trip> trips = TripReader{}.readTrips(tripReader);
+
+    ShardCoordinator coordinator(directory, program);
+    for(const Trip& trip : trips)
+    {
+        try
+        {
+            coordinator.writeTrip(trip, std::cout);
+        }
+        catch(DigraphException& e)
+        {
+            std::cerr<<"trip from "<<trip.startVertex<<" to "<<trip.endVertex
+                     <<": "<<e.what()<<"\n";
+        }
+    }
+}
+
+
+int main(int argc, char* argv[])
+{
+    std::string mapFile;
+    std::string socketPath;
+    std::string profileFile;
+    std::vector<std::string> patchFiles;
+    std::string closuresFile;
+    std::string shardOutputDirectory;
+    std::string shardDirectory;
+    int shardCount = 4;
+    bool reportMemory = false;
+    bool validate = false;
+    bool writeMatrix = false;
+    std::string treeCacheFile;
+    std::string treeCacheOutputFile;
+    std::string hotSourcesFile;
+    std::size_t budgetBytes = 0;
+    std::string engine = "batched";
+    EngineOptions engineOptions;
+    bool serve = false;
+    unsigned int threadCount = 0;
+
+    for(int i = 1; i < argc; ++i)
+    {
+        std::string option = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if(option == "--map" && hasValue)
+        {
+            mapFile = argv[++i];
+        }
+        else if(option == "--server")
+        {
+            serve = true;
+        }
+        else if(option == "--socket" && hasValue)
+        {
+            socketPath = argv[++i];
+        }
+        else if(option == "--engine" && hasValue)
+        {
+            engine = argv[++i];
+        }
+        else if(option == "--patch" && hasValue)
+        {
+            patchFiles.push_back(argv[++i]);
+        }
+        else if(option == "--closures" && hasValue)
+        {
+            closuresFile = argv[++i];
+        }
+        else if(option == "--profiles" && hasValue)
+        {
+            profileFile = argv[++i];
+        }
+        else if(option == "--landmarks" && hasValue)
+        {
+            engineOptions.landmarkCount = std::stoi(argv[++i]);
+        }
+        else if(option == "--landmark-file" && hasValue)
+        {
+            engineOptions.landmarkFile = argv[++i];
+        }
+        else if(option == "--threads" && hasValue)
+        {
+            threadCount = std::stoi(argv[++i]);
+        }
+        else if(option == "--write-shards" && hasValue)
+        {
+            shardOutputDirectory = argv[++i];
+        }
+        else if(option == "--shards" && hasValue)
+        {
+            shardCount = std::stoi(argv[++i]);
+        }
+        else if(option == "--tree-cache" && hasValue)
+        {
+            treeCacheFile = argv[++i];
+        }
+        else if(option == "--write-tree-cache" && hasValue)
+        {
+            treeCacheOutputFile = argv[++i];
+        }
+        else if(option == "--hot-sources" && hasValue)
+        {
+            hotSourcesFile = argv[++i];
+        }
+        else if(option == "--matrix")
+        {
+            writeMatrix = true;
+        }
+        else if(option == "--validate")
+        {
+            validate = true;
+        }
+        else if(option == "--memory")
+        {
+            reportMemory = true;
+        }
+        else if(option == "--memory-budget" && hasValue)
+        {
+            if(!parseByteCount(argv[++i], budgetBytes))
+            {
+                std::cerr<<"Invalid memory budget: "<<argv[i]<<"\n";
+                return 1;
+            }
+        }
+        else if(option == "--shard-dir" && hasValue)
+        {
+            shardDirectory = argv[++i];
+        }
+        else if(option == "--shard-worker" && i + 2 < argc)
+        {
+            std::string directory = argv[++i];
+            int shard = std::stoi(argv[++i]);
+            try
+            {
+                ShardWorker worker(directory, shard);
+                worker.serve(std::cin, std::cout);
+            }
+            catch(ShardException& e)
+            {
+                std::cerr<<"shard "<<shard<<": "<<e.what()<<"\n";
+                return 1;
+            }
+            return 0;
+        }
+        else
+        {
+            std::cerr<<"Unrecognized option: "<<option<<"\n";
+            return 1;
+        }
+    }
+
     std::cout<<std::fixed<<std::setprecision(2);
+
+    if(!shardDirectory.empty())
+    {
+        try
+        {
+            runShardedTrips(shardDirectory, argv[0]);
+        }
+        catch(InputReaderException& e)
+        {
+            std::cerr<<"trips: "<<e.what()<<"\n";
+            return 1;
+        }
+        catch(ShardException& e)
+        {
+            std::cerr<<shardDirectory<<": "<<e.what()<<"\n";
+            return 1;
+        }
+        return 0;
+    }
+
     InputReader mainInputReader(std::cin);
-    //Locations
+
+    //everything built from here on is charged to the budget before it's
+    //built, and the program stops at the first thing that doesn't fit
+    MemoryBudget budget{budgetBytes};
 
     //ROAD SEGMENTS
-    RoadMapReader mainRoadMapReader;
+    RoadMapReader mainRoadMapReader{&budget};
     //A roadMap is a Digraph<std::string, RoadSegment(edge)
-    mainMap = mainRoadMapReader.readRoadMap(mainInputReader);
-    
-    
-    
-    
-    //TRIPs    
-    TripReader mainTripReader;
-    
-    //ar Trip has int start/endVertex and a TripMetric ("Time, Distance")
-    std::vector<Trip> trips = mainTripReader.readTrips(mainInputReader);
+    RoadMap mainMap;
+    try
+    {
+        if(mapFile.empty())
+        {
+            mainMap = mainRoadMapReader.readRoadMap(mainInputReader);
+        }
+        else
+        {
+            mainMap = mainRoadMapReader.readRoadMapFile(mapFile, threadCount);
+        }
+    }
+    catch(RoadMapReaderException& e)
+    {
+        std::cerr<<(mapFile.empty() ? "map" : mapFile)<<": "<<e.what()<<"\n";
+        return 1;
+    }
+    catch(MemoryBudgetException& e)
+    {
+        std::cerr<<e.what()<<"\n";
+        return 1;
+    }
 
+    //the reader charged an estimate of the map's size before building it
+    std::size_t mapBytes = mainMap.memoryUsage().total();
+    if(!settleBudget(budget, "the map", budget.used(), mapBytes))
+    {
+        return 1;
+    }
 
-//EdgeInfo is of type RoadSegment
+    for(const std::string& patchFile : patchFiles)
+    {
+        try
+        {
+            std::ifstream patchStream{patchFile};
+            if(!patchStream)
+            {
+                throw MapPatchException("could not open the file", 0);
+            }
+            MapPatch patch = readMapPatch(patchStream);
+
+            //what the patch adds is checked against the budget before
+            //it's applied, and what it really adds charged afterward
+            int addedLocations = 0;
+            int addedRoadSegments = 0;
+            for(const MapPatchChange& change : patch.changes)
+            {
+                addedLocations += change.kind == MapPatchChange::Kind::AddLocation;
+                addedRoadSegments += change.kind == MapPatchChange::Kind::AddRoadSegment;
+            }
+            std::size_t growth =
+                RoadMap::estimateBytes(addedLocations, addedRoadSegments, 0) -
+                RoadMap::estimateBytes(0, 0, 0);
+            if(!chargeBudget(budget, "the map patched by " + patchFile, growth))
+            {
+                return 1;
+            }
+            budget.release(growth);
+
+            MapPatchSummary summary = applyMapPatch(mainMap, patch);
+
+            std::cerr<<patchFile<<": "<<summary.addedLocations<<" locations added, "
+                     <<summary.removedLocations<<" removed; "
+                     <<summary.addedRoadSegments<<" road segments added, "
+                     <<summary.removedRoadSegments<<" removed, "
+                     <<summary.changedRoadSegments<<" changed (map version "
+                     <<summary.newVersion<<")\n";
+
+            std::size_t patchedBytes = mainMap.memoryUsage().total();
+            if(patchedBytes < mapBytes)
+            {
+                budget.release(mapBytes - patchedBytes);
+            }
+            else if(!chargeBudget(budget, "the map patched by " + patchFile, patchedBytes - mapBytes))
+            {
+                return 1;
+            }
+            mapBytes = patchedBytes;
+        }
+        catch(MapPatchException& e)
+        {
+            std::cerr<<patchFile<<": "<<e.what()<<"\n";
+            return 1;
+        }
+    }
+
+    if(validate)
+    {
+        try
+        {
+            if(!validateMap(mainMap, budget, threadCount))
+            {
+                return 1;
+            }
+        }
+        catch(MemoryBudgetException& e)
+        {
+            std::cerr<<e.what()<<"\n";
+            return 1;
+        }
+    }
+
+    if(!shardOutputDirectory.empty())
+    {
+        try
+        {
+            writeRoadMapShards(mainMap, shardCount, shardOutputDirectory, threadCount);
+        }
+        catch(ShardException& e)
+        {
+            std::cerr<<shardOutputDirectory<<": "<<e.what()<<"\n";
+            return 1;
+        }
+        return 0;
+    }
+
+    if(!treeCacheOutputFile.empty())
+    {
+        try
+        {
+            std::ifstream hotSourcesStream{hotSourcesFile};
+            if(!hotSourcesStream)
+            {
+                throw TreeCacheException("could not open the hot sources " + hotSourcesFile);
+            }
+            InputReader hotSourcesReader{hotSourcesStream};
+            writeTreeCache(treeCacheOutputFile, mainMap, readHotSources(hotSourcesReader), threadCount);
+        }
+        catch(TreeCacheException& e)
+        {
+            std::cerr<<treeCacheOutputFile<<": "<<e.what()<<"\n";
+            return 1;
+        }
+        catch(DigraphException& e)
+        {
+            std::cerr<<hotSourcesFile<<": "<<e.what()<<"\n";
+            return 1;
+        }
+        return 0;
+    }
 
+    if(writeMatrix)
+    {
+        try
+        {
+            runMatrix(mainInputReader, mainMap, budget, threadCount);
+        }
+        catch(InputReaderException& e)
+        {
+            std::cerr<<"trips: "<<e.what()<<"\n";
+            return 1;
+        }
+        catch(MemoryBudgetException& e)
+        {
+            std::cerr<<e.what()<<"\n";
+            return 1;
+        }
+        catch(DigraphException& e)
+        {
+            std::cerr<<"trips: "<<e.what()<<"\n";
+            return 1;
+        }
+        return 0;
+    }
 
-    std::map<int,int> shortEdgeList;
-    //for each trip, display the 
-    for(int i=0; i<trips.size();i++)
+    //the closures are read before any engine is built, so that a bad
+    //file is reported without waiting for one
+    RoadClosures closures;
+    if(!closuresFile.empty())
     {
-        totalTime=0;
-        if(trips[i].metric == TripMetric::Time)
+        try
+        {
+            std::ifstream closuresStream{closuresFile};
+            if(!closuresStream)
+            {
+                throw MapPatchException("could not open the file", 0);
+            }
+            closures = readRoadClosures(closuresStream, mainMap);
+        }
+        catch(MapPatchException& e)
         {
-            //compute the number of second it will take
-            shortEdgeList = mainMap.findShortestPaths(
-                trips[i].startVertex,
-                [](RoadSegment edgeInfo)
-                {return (3600*edgeInfo.miles/edgeInfo.milesPerHour);});
-            //time compute
-            
-            //double totalTime =            int hrs
-            //out put
-            std::cout<<"Shortest driving time from "<<
-            mainMap.vertexInfo(trips[i].startVertex)<<
-            " to "<<mainMap.vertexInfo(trips[i].endVertex)<<":\n";
+            std::cerr<<closuresFile<<": "<<e.what()<<"\n";
+            return 1;
+        }
 
-            std::cout<<"\tBeging at "<<mainMap.vertexInfo(trips[i].startVertex)<<"\n";
-            int currentVert = trips[i].endVertex;
-            int nextVert = shortEdgeList.at(currentVert);
+        if(engine != "batched" && engine != "dijkstra")
+        {
+            std::cerr<<"--closures needs the dijkstra engine, not "<<engine<<"\n";
+            return 1;
+        }
+        if(!treeCacheFile.empty())
+        {
+            std::cerr<<treeCacheFile<<": its trees don't know about the closures; not using the cache\n";
+            treeCacheFile.clear();
+        }
+    }
+
+    bool serving = serve || !socketPath.empty();
+    if((serving || !treeCacheFile.empty() || !closuresFile.empty()) && engine == "batched")
+    {
+        engine = "dijkstra";
+    }
+
+    std::size_t engineEstimate = estimateEngineBytes(engine, mainMap, engineOptions);
+    if(!chargeBudget(budget, "the " + engine + " engine's tables", engineEstimate))
+    {
+        return 1;
+    }
 
-            printInfoTime(currentVert, nextVert, shortEdgeList, trips[i]);
-            //from the map you go from nextVertex to currentVert
-            std::cout<<"Total time: ";
-            int tempHrs = (int)(totalTime/3600);
-            int tempMins = (int)(fmod(totalTime,3600)/60);
-            double tempSecs = fmod(fmod(totalTime,3600),60);
+    //the batched engine's estimate stays charged, since its snapshots and
+    //search results are built as the trips are read; every other engine's
+    //is settled to what its router uses, and runTrips() adds nothing to it
+    std::unique_ptr<TripRouter> router = makeRouter(engine, mainMap, engineOptions);
+    if(router == nullptr && engine != "batched")
+    {
+        std::cerr<<"Unrecognized engine: "<<engine<<"\n";
+        return 1;
+    }
+    if(router != nullptr &&
+       !settleBudget(budget, "the " + engine + " engine's tables", engineEstimate,
+                     router->memoryUsage().total()))
+    {
+        return 1;
+    }
 
-            if(tempHrs!=0)
+    //trips from the cache's start locations are answered by walking its
+    //trees and the rest by the chosen engine; a cache built for a
+    //different map, or too big for the budget, is left out.  The trees
+    //are mapped from their file, and only read in as trips touch them, so
+    //the whole file is charged before any of it is in memory.
+    std::unique_ptr<TripRouter> cachedRouter;
+    if(!treeCacheFile.empty())
+    {
+        try
+        {
+            TreeCache cache{treeCacheFile, mainMap};
+            budget.charge("the tree cache", cache.byteCount());
+            cachedRouter = std::make_unique<CachedTripRouter>(std::move(cache), *router);
+        }
+        catch(TreeCacheException& e)
+        {
+            std::cerr<<treeCacheFile<<": "<<e.what()<<"; not using the cache\n";
+        }
+        catch(MemoryBudgetException& e)
+        {
+            std::cerr<<treeCacheFile<<": "<<e.what()<<"; not using the cache\n";
+        }
+    }
+    const TripRouter* tripRouter = cachedRouter != nullptr ? cachedRouter.get() : router.get();
+
+    //with closures, every trip goes through the dijkstra engine's
+    //findPath() that routes around them
+    std::unique_ptr<TripRouter> closureRouter;
+    if(!closuresFile.empty())
+    {
+        closureRouter = std::make_unique<ClosureTripRouter>(
+            static_cast<const DijkstraTripRouter&>(*router), std::move(closures));
+        if(!chargeBudget(budget, "the closures", closureRouter->memoryUsage().total()))
+        {
+            return 1;
+        }
+        tripRouter = closureRouter.get();
+    }
+
+    //the time-dependent router answers the trips that say when they leave
+    //and hands the rest to the chosen engine
+    SpeedProfiles profiles;
+    const SpeedProfiles* loadedProfiles = nullptr;
+    std::unique_ptr<TripRouter> timedRouter;
+    if(!profileFile.empty())
+    {
+        try
+        {
+            std::ifstream profileStream{profileFile};
+            if(!profileStream)
+            {
+                throw SpeedProfilesException("could not open the file");
+            }
+
+            //the profiles take fewer bytes than the text describing them
+            profileStream.seekg(0, std::ios::end);
+            std::size_t profileEstimate = static_cast<std::size_t>(profileStream.tellg());
+            profileStream.seekg(0);
+            if(!chargeBudget(budget, "the speed profiles", profileEstimate))
+            {
+                return 1;
+            }
+
+            InputReader profileReader{profileStream};
+            profiles = readSpeedProfiles(profileReader);
+            loadedProfiles = &profiles;
+            if(!settleBudget(budget, "the speed profiles", profileEstimate, profiles.byteCount()))
+            {
+                return 1;
+            }
+
+            std::size_t timedEstimate = CompactDigraph<RoadSegment>::estimateByteCount(
+                mainMap.vertexCount(), mainMap.edgeCount());
+            if(!chargeBudget(budget, "the time-dependent engine's tables", timedEstimate))
             {
-                std::cout<<tempHrs<<" hours ";
+                return 1;
             }
-            if(tempMins!=0)
+            timedRouter = std::make_unique<TimeDependentTripRouter>(mainMap, profiles, tripRouter);
+            if(!settleBudget(budget, "the time-dependent engine's tables", timedEstimate,
+                             timedRouter->memoryUsage().total()))
             {
-                std::cout<<tempMins<<" minutes ";
+                return 1;
             }
-            std::cout<<tempSecs<<" seconds)\n\n";
-        
         }
-        else//distance
+        catch(SpeedProfilesException& e)
         {
-            shortEdgeList = mainMap.findShortestPaths(
-                trips[i].startVertex,
-                [](RoadSegment edgeInfo){return edgeInfo.miles;});
-            std::cout<<"Shortest distance from "<<
-            "\n\nTEST:"<<trips[i].startVertex<<
-            mainMap.vertexInfo(trips[i].startVertex)<<" to "<<
-            mainMap.vertexInfo(trips[i].endVertex)<<":\n";
-            
-            std::cout<<"\tBeging at "<<mainMap.vertexInfo(trips[i].startVertex)<<"\n";
-            int currentVert = trips[i].endVertex;
-            int nextVert = shortEdgeList.at(currentVert);
+            std::cerr<<profileFile<<": "<<e.what()<<"\n";
+            return 1;
+        }
+    }
 
-            printInfoDist(currentVert, nextVert, shortEdgeList, trips[i]);
-            //from the map you go from nextVertex to currentVert
-            std::cout<<"Total distance: "<<totalDist<<" miles\n";
+    //the batched engine's snapshots are built as the trips are read, so
+    //the breakdown can only show its estimate
+    if(reportMemory)
+    {
+        MemoryUsage usage;
+        usage.add("map", mainMap.memoryUsage());
+        if(router != nullptr)
+        {
+            usage.add(engine, router->memoryUsage());
+        }
+        else
+        {
+            usage.add("batched (estimated)", engineEstimate);
+        }
+        if(cachedRouter != nullptr)
+        {
+            usage.add("tree cache", cachedRouter->memoryUsage());
+        }
+        if(closureRouter != nullptr)
+        {
+            usage.add("closures", closureRouter->memoryUsage());
+        }
+        if(loadedProfiles != nullptr)
+        {
+            usage.add("speed profiles", profiles.byteCount());
+            usage.add("time-dependent", timedRouter->memoryUsage());
+        }
 
+        std::cerr<<"Memory usage:\n";
+        writeMemoryUsage(std::cerr, usage);
+        if(budget.limit() != 0)
+        {
+            std::cerr<<"Memory budget: "<<budget.used()<<" of "<<budget.limit()<<" bytes used\n";
+        }
+    }
 
+    if(serving)
+    {
+        QueryServer server(mainMap, timedRouter != nullptr ? *timedRouter : *tripRouter, loadedProfiles);
+        if(!socketPath.empty())
+        {
+            //SIGINT and SIGTERM stop the server cleanly, so that the
+            //connections are finished, the statistics written and the
+            //socket removed
+            runningServer = &server;
+            struct sigaction stopping{};
+            stopping.sa_handler = stopRunningServer;
+            sigemptyset(&stopping.sa_mask);
+            sigaction(SIGINT, &stopping, nullptr);
+            sigaction(SIGTERM, &stopping, nullptr);
+
+            try
+            {
+                server.serveSocket(socketPath);
+            }
+            catch(QueryServerException& e)
+            {
+                std::cerr<<e.what()<<"\n";
+                return 1;
+            }
+
+            std::signal(SIGINT, SIG_DFL);
+            std::signal(SIGTERM, SIG_DFL);
+            runningServer = nullptr;
+        }
+        else
+        {
+            server.serveStream(std::cin, std::cout, threadCount);
+        }
+        server.writeStatistics(std::cerr);
+    }
+    else
+    {
+        try
+        {
+            runTrips(mainInputReader, mainMap, tripRouter, timedRouter.get(), loadedProfiles);
+        }
+        catch(InputReaderException& e)
+        {
+            std::cerr<<"trips: "<<e.what()<<"\n";
+            return 1;
         }
     }
+
     return 0;
 }
-
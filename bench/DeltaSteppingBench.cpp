@@ -0,0 +1,270 @@
+// DeltaSteppingBench.cpp
+//
+// ICS 46 Winter 2019
+// Project #4: Rock and Roll Stops the Traffic
+//
+// This is a separate program that measures how
+// findShortestPathTreeParallel() (see DeltaStepping.hpp) speeds up as it's
+// given more threads, compared with the single-threaded Dijkstra's
+// algorithm in findShortestPathTree() (see ShortestPath.hpp) over the same
+// snapshot.  It checks along the way that both find the same distances
+// and predecessors.
+//
+// By default it generates a road-like map: a grid of local streets, a few
+// of them missing, crossed every so often by faster arterial roads.  Its
+// options are:
+//
+//     --map FILE       benchmark the map in FILE (in the usual input
+//                      format) instead of a generated one
+//     --grid N         generate an N-by-N grid (the default is 1000)
+//     --metric M       weigh edges by "D" (distance) or "T" (time, the
+//                      default)
+//     --delta D        use buckets of width D (the default is the average
+//                      edge weight)
+//     --threads N      try 1, 2, 4, ... up to N threads (the default is
+//                      64)
+//     --sources N      time N searches from different start vertices for
+//                      each thread count (the default is 5)
+//     --memory         first write a breakdown of the memory used by the
+//                      map and by the snapshot the searches run over
+//
+// It writes one line per thread count, with the average time per search
+// and the speedup over one thread and over Dijkstra's algorithm.
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "CompactDigraph.hpp"
+#include "DeltaStepping.hpp"
+#include "MemoryUsage.hpp"
+#include "RoadMap.hpp"
+#include "RoadMapReader.hpp"
+#include "RoadMapWeights.hpp"
+#include "SearchWorkspace.hpp"
+#include "ShortestPath.hpp"
+
+
+namespace
+{
+    //every tenth row and column is an arterial road, and about one street
+    //segment in twenty is missing
+    RoadMap generateRoadMap(int gridSize)
+    {
+        std::mt19937 random{46};
+        std::uniform_real_distribution<double> blockLength{0.05, 0.25};
+        std::uniform_int_distribution<int> missing{0, 19};
+
+        RoadMap roadMap;
+        for(int vertex = 0; vertex < gridSize * gridSize; ++vertex)
+        {
+            roadMap.addVertex(vertex, "Intersection " + std::to_string(vertex));
+        }
+
+        auto addRoad = [&](int from, int to, bool arterial)
+        {
+            RoadSegment segment{blockLength(random), arterial ? 45.0 : 25.0};
+            roadMap.addEdge(from, to, segment);
+            roadMap.addEdge(to, from, segment);
+        };
+
+        for(int row = 0; row < gridSize; ++row)
+        {
+            for(int column = 0; column < gridSize; ++column)
+            {
+                int vertex = row * gridSize + column;
+                if(column + 1 < gridSize && (row % 10 == 0 || missing(random) != 0))
+                {
+                    addRoad(vertex, vertex + 1, row % 10 == 0);
+                }
+                if(row + 1 < gridSize && (column % 10 == 0 || missing(random) != 0))
+                {
+                    addRoad(vertex, vertex + gridSize, column % 10 == 0);
+                }
+            }
+        }
+
+        return roadMap;
+    }
+
+
+    double secondsSince(std::chrono::steady_clock::time_point started)
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    }
+}
+
+
+int main(int argc, char* argv[])
+{
+    std::string mapFile;
+    int gridSize = 1000;
+    TripMetric metric = TripMetric::Time;
+    double delta = 0.0;
+    unsigned int maxThreads = 64;
+    int sourceCount = 5;
+    bool reportMemory = false;
+
+    for(int i = 1; i < argc; ++i)
+    {
+        std::string option = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if(option == "--map" && hasValue)
+        {
+            mapFile = argv[++i];
+        }
+        else if(option == "--grid" && hasValue)
+        {
+            gridSize = std::stoi(argv[++i]);
+        }
+        else if(option == "--metric" && hasValue)
+        {
+            metric = std::string{argv[++i]} == "D" ? TripMetric::Distance : TripMetric::Time;
+        }
+        else if(option == "--delta" && hasValue)
+        {
+            delta = std::stod(argv[++i]);
+        }
+        else if(option == "--threads" && hasValue)
+        {
+            maxThreads = std::stoi(argv[++i]);
+        }
+        else if(option == "--sources" && hasValue)
+        {
+            sourceCount = std::stoi(argv[++i]);
+        }
+        else if(option == "--memory")
+        {
+            reportMemory = true;
+        }
+        else
+        {
+            std::cerr<<"Unrecognized option: "<<option<<"\n";
+            return 1;
+        }
+    }
+
+    RoadMap roadMap;
+    if(mapFile.empty())
+    {
+        roadMap = generateRoadMap(gridSize);
+    }
+    else
+    {
+        try
+        {
+            roadMap = RoadMapReader{}.readRoadMapFile(mapFile);
+        }
+        catch(RoadMapReaderException& e)
+        {
+            std::cerr<<mapFile<<": "<<e.what()<<"\n";
+            return 1;
+        }
+    }
+
+    CompactDigraph<double> graph = compactRoadMap(roadMap, metric);
+    if(graph.vertexCount() == 0)
+    {
+        std::cerr<<"The map is empty\n";
+        return 1;
+    }
+
+    if(reportMemory)
+    {
+        MemoryUsage usage;
+        usage.add("map", roadMap.memoryUsage());
+        usage.add("snapshot", graph.byteCount());
+        writeMemoryUsage(std::cout, usage);
+    }
+
+    if(delta <= 0.0)
+    {
+        delta = averageEdgeWeight(graph);
+    }
+
+    std::mt19937 random{1};
+    std::vector<int> sources;
+    for(int i = 0; i < sourceCount; ++i)
+    {
+        sources.push_back(random() % graph.vertexCount());
+    }
+
+    std::cout<<graph.vertexCount()<<" vertices, "<<graph.edgeCount()<<" edges, delta "
+             <<delta<<"\n";
+    std::cout<<std::fixed<<std::setprecision(4);
+
+    //the baseline, which is also what every run is checked against; it
+    //searches the same snapshot, so the speedups are down to the threads
+    //and not to the graph's layout
+    SearchWorkspace<double> workspace;
+    std::vector<std::vector<double>> expectedDistances;
+    std::vector<std::vector<int>> expectedPredecessors;
+    double dijkstraSeconds = 0.0;
+
+    for(int source : sources)
+    {
+        auto started = std::chrono::steady_clock::now();
+        findShortestPathTree(graph, source, workspace);
+        dijkstraSeconds += secondsSince(started);
+
+        std::vector<double> distances(graph.vertexCount());
+        std::vector<int> predecessors(graph.vertexCount());
+        for(int vertex = 0; vertex < graph.vertexCount(); ++vertex)
+        {
+            distances[vertex] = workspace.distance(vertex);
+            predecessors[vertex] = workspace.predecessor(vertex);
+        }
+        expectedDistances.push_back(distances);
+        expectedPredecessors.push_back(predecessors);
+    }
+    dijkstraSeconds /= sources.size();
+
+    std::cout<<"dijkstra    "<<dijkstraSeconds<<" s\n";
+
+    //predecessors can differ where shortest paths tie, but distances
+    //never should
+    double oneThreadSeconds = 0.0;
+    bool distancesDiffered = false;
+    for(unsigned int threads = 1; threads <= maxThreads; threads *= 2)
+    {
+        double seconds = 0.0;
+        int distanceMismatches = 0;
+        int predecessorMismatches = 0;
+
+        for(unsigned int i = 0; i < sources.size(); ++i)
+        {
+            auto started = std::chrono::steady_clock::now();
+            ShortestPathTree tree = findShortestPathTreeParallel(graph, sources[i], delta, threads);
+            seconds += secondsSince(started);
+
+            for(int vertex = 0; vertex < graph.vertexCount(); ++vertex)
+            {
+                distanceMismatches += tree.distance[vertex] != expectedDistances[i][vertex];
+                predecessorMismatches += tree.predecessor[vertex] != expectedPredecessors[i][vertex];
+            }
+        }
+        seconds /= sources.size();
+
+        if(threads == 1)
+        {
+            oneThreadSeconds = seconds;
+        }
+
+        std::cout<<std::setw(3)<<threads<<" threads "<<seconds<<" s  "
+                 <<std::setprecision(2)<<oneThreadSeconds / seconds<<"x over 1 thread  "
+                 <<dijkstraSeconds / seconds<<"x over dijkstra"<<std::setprecision(4);
+        distancesDiffered = distancesDiffered || distanceMismatches != 0;
+        if(distanceMismatches != 0 || predecessorMismatches != 0)
+        {
+            std::cout<<"  ("<<distanceMismatches<<" distances and "
+                     <<predecessorMismatches<<" predecessors differ)";
+        }
+        std::cout<<"\n";
+    }
+
+    return distancesDiffered ? 1 : 0;
+}
@@ -0,0 +1,1923 @@
+// EngineHarness.cpp
+//
+// ICS 46 Winter 2019
+// Project #4: Rock and Roll Stops the Traffic
+//
+// This is a separate program that checks every search engine against
+// Digraph::findShortestPaths() and measures how fast each of them is, so
+// that choosing between them is a matter of numbers rather than of faith.
+//
+// It generates random road maps -- grids of streets with some blocks
+// missing, some one-way, and a few fast highways cutting across them,
+// along with a couple of locations no road reaches -- and a random set of
+// trips over each, half of them from a few popular start locations.  Every
+// engine answers the same trips, and each path it finds is checked: it has
+// to start and end in the right places, follow road segments that are
+// really on the map, and cost (in miles or seconds) what the shortest path
+// found by Digraph::findShortestPaths() does, give or take the tolerance.
+// The engines are:
+//
+//     digraph         Digraph::findShortestPaths(), the reference itself
+//     dijkstra        DijkstraTripRouter
+//     quantized       QuantizedTripRouter
+//     alt             AltTripRouter, with 8 landmarks per metric
+//     overlay         OverlayTripRouter
+//     customized      OverlayTripRouter, built for the map with other
+//                     speeds and lengths and then customized for it
+//     compressed      CompressedTripRouter
+//     contracted      ContractedTripRouter
+//     batched         findShortestPathsBatched(), one trip per search
+//     time-dependent  TimeDependentTripRouter, with no speed profiles
+//     cached          CachedTripRouter, with trees for the popular start
+//                     locations (and DijkstraTripRouter for the rest)
+//     shards          ShardCoordinator, over the map split into four
+//                     shards in a scratch directory inside the --repro-dir
+//                     one, whose workers are this program run again with
+//                     --shard-worker
+//     closures        DijkstraTripRouter::findPath() with random closures
+//                     (see RoadClosures.hpp), checked against a copy of
+//                     the map with the closed locations and road segments
+//                     removed and the changed speeds changed
+//     profiles        TimeDependentTripRouter with speed profiles, over
+//                     the map as changed by a random patch (see
+//                     MapPatch.hpp and below)
+//
+// For the profiles check, a few speed profiles are made up, and a patch
+// gives about three in ten of the map's road segments one of them,
+// changes the speeds of others, and adds and removes a few locations.
+// applyMapPatch() applies it, and most of the driving-time trips are given
+// a time to leave (and moved off the removed locations onto the added
+// ones).  Each path is then checked against the map the patch should have
+// made, which is worked out without applyMapPatch(): a trip that says
+// when it leaves has to arrive as soon as a search that keeps improving
+// arrival times until none changes says it can, following the speeds at
+// the time it reaches each road segment, and any other trip costs what
+// Digraph says as usual.
+//
+// Along with the engines, the analyses in DigraphAnalytics.hpp are checked
+// over each map: whether the map is strongly connected (compared with
+// Digraph::isStronglyConnected(), both for the map and for the map with a
+// ring of two-way road segments through every location added, which always
+// is), and, for a sample of locations, how many locations each reaches and
+// which are in its weakly connected piece (compared with searches over the
+// map, and over the map with every road segment made two-way).  These are
+// left out if --engines doesn't include "connectivity".  Likewise,
+// computeDistanceMatrix() is checked against one findShortestPaths() per
+// source, for a few sources and many targets and the other way around
+// (so that it searches both forward and backward), unless --engines
+// doesn't include "matrix".
+//
+// When an engine gets a trip wrong, the map is cut down to as few road
+// segments as still show the problem (by deleting ever smaller groups of
+// them and building the engine again), and the cut-down map and the trip
+// are written, in the usual input format, to a file named
+// "repro-ENGINE-N.txt", which main can read from its standard input.
+// The closures aren't cut down; the whole map and the trip are written to
+// "repro-closures-N.txt", and the closures to "repro-closures-N.closures",
+// which main can read with --closures.  Nor is the profiles check: the
+// map and the trip go to "repro-profiles-N.txt", and the patch and the
+// profiles to "repro-profiles-N.patch" and "repro-profiles-N.profiles",
+// which main can read with --patch and --profiles.
+//
+// Its options are:
+//
+//     --maps N         generate N maps (the default is 5)
+//     --grid N         make each map an N-by-N grid (the default is 40)
+//     --trips N        answer N trips over each map (the default is 1000)
+//     --seed S         seed the random number generator with S (the
+//                      default is 46), so a run can be repeated exactly
+//     --map FILE       check the map in FILE (in the usual input format)
+//                      instead of generated ones
+//     --engines LIST   check only the engines in the comma-separated LIST,
+//                      which may also name closures, profiles,
+//                      connectivity and matrix
+//     --tolerance T    allow a path's cost to differ from the shortest by
+//                      T times the shortest (or T, if the shortest is less
+//                      than 1); the default is 0.0001, since the quantized
+//                      engine rounds segments to a hundredth of a mile and
+//                      a thousandth of a second
+//     --repro-dir DIR  write reproducers to DIR (the default is the
+//                      current directory)
+//     --repros N       write at most N reproducers per engine (the
+//                      default is 3)
+//     --shard-worker DIR N
+//                      serve shard N of the shards in DIR (see
+//                      ShardWorker.hpp) on the standard input and output
+//                      and exit; this is how the shards engine runs its
+//                      workers
+//
+// It writes a line for each wrong answer as it finds it, and finishes with
+// a report of how long each engine took to build, how much memory its
+// tables use (as its memoryUsage() reports, for the largest map), the 50th
+// and 99th percentiles of how long it took to answer a trip, how many
+// trips it answered per second, and how many it got wrong.  It exits with status 1
+// if any engine got any trip wrong.
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "BatchedSearch.hpp"
+#include "CompactDigraph.hpp"
+#include "DigraphAnalytics.hpp"
+#include "DistanceMatrix.hpp"
+#include "SearchWorkspace.hpp"
+#include "AltTripRouter.hpp"
+#include "CachedTripRouter.hpp"
+#include "CompressedTripRouter.hpp"
+#include "ContractedTripRouter.hpp"
+#include "MapPatch.hpp"
+#include "OverlayTripRouter.hpp"
+#include "RoadClosures.hpp"
+#include "RoadMap.hpp"
+#include "RoadMapReader.hpp"
+#include "RoadMapShards.hpp"
+#include "RoadMapWeights.hpp"
+#include "ShardCoordinator.hpp"
+#include "ShardWorker.hpp"
+#include "SpeedProfiles.hpp"
+#include "TimeDependentTripRouter.hpp"
+#include "TimeOfDay.hpp"
+#include "TreeCache.hpp"
+#include "Trip.hpp"
+#include "TripRouter.hpp"
+
+
+namespace
+{
+    // A map is kept as a list of road segments, rather than as a RoadMap,
+    // so that the minimizer can drop some of them and build it again.
+    struct MapEdge
+    {
+        int from;
+        int to;
+        RoadSegment segment;
+    };
+
+
+    struct MapSpec
+    {
+        std::vector<std::string> names;
+        std::vector<MapEdge> edges;
+    };
+
+
+    typedef std::vector<std::pair<int, TripMetric>> HotSources;
+
+
+    struct TripSet
+    {
+        std::vector<Trip> trips;
+        HotSources hotSources;
+    };
+
+
+    //every sixth row and column is an arterial road; of the other blocks,
+    //about one in twenty is missing and one in ten is one-way
+    MapSpec generateMap(std::mt19937& random, int gridSize)
+    {
+        std::uniform_int_distribution<int> percent{0, 99};
+        std::uniform_int_distribution<int> blockHundredths{5, 40};
+        std::uniform_int_distribution<int> anyVertex{0, gridSize * gridSize - 1};
+
+        MapSpec spec;
+        std::set<std::pair<int, int>> taken;
+
+        auto addEdge = [&](int from, int to, const RoadSegment& segment)
+        {
+            if(from != to && taken.emplace(from, to).second)
+            {
+                spec.edges.push_back(MapEdge{from, to, segment});
+            }
+        };
+
+        auto addRoad = [&](int from, int to, bool arterial)
+        {
+            int kind = percent(random);
+            double milesPerHour = arterial ? 45.0 : kind % 2 == 0 ? 25.0 : 35.0;
+            RoadSegment segment{blockHundredths(random) / 100.0, milesPerHour};
+
+            if(!arterial && kind < 5)
+            {
+                return;
+            }
+            else if(!arterial && kind < 15)
+            {
+                if(kind % 2 == 0)
+                {
+                    std::swap(from, to);
+                }
+                addEdge(from, to, segment);
+            }
+            else
+            {
+                addEdge(from, to, segment);
+                addEdge(to, from, segment);
+            }
+        };
+
+        for(int row = 0; row < gridSize; ++row)
+        {
+            for(int column = 0; column < gridSize; ++column)
+            {
+                int vertex = row * gridSize + column;
+                if(column + 1 < gridSize)
+                {
+                    addRoad(vertex, vertex + 1, row % 6 == 0);
+                }
+                if(row + 1 < gridSize)
+                {
+                    addRoad(vertex, vertex + gridSize, column % 6 == 0);
+                }
+            }
+        }
+
+        //highways are a little shorter than the streets they bypass, and
+        //much faster, so shortest paths take them whenever they can
+        std::uniform_int_distribution<int> shortening{70, 95};
+        for(int highway = 0; highway < gridSize / 2; ++highway)
+        {
+            int from = anyVertex(random);
+            int to = anyVertex(random);
+            int blocks = std::abs(from / gridSize - to / gridSize) + std::abs(from % gridSize - to % gridSize);
+            RoadSegment segment{std::max(1, blocks * 22 * shortening(random) / 100) / 100.0, 65.0};
+            addEdge(from, to, segment);
+            addEdge(to, from, segment);
+        }
+
+        //and a couple of locations can't be reached at all
+        for(int vertex = 0; vertex < gridSize * gridSize + 2; ++vertex)
+        {
+            spec.names.push_back("Location " + std::to_string(vertex));
+        }
+
+        return spec;
+    }
+
+
+    //lists a RoadMap's road segments, numbering its locations from 0 in
+    //increasing order of their vertex numbers; speed profiles are dropped,
+    //since only the time-dependent engine knows about them
+    MapSpec specOf(const RoadMap& roadMap)
+    {
+        std::vector<int> vertices = roadMap.vertices();
+
+        MapSpec spec;
+        for(int vertex : vertices)
+        {
+            spec.names.emplace_back(roadMap.vertexInfo(vertex));
+        }
+
+        auto indexOf = [&](int vertex)
+        {
+            return static_cast<int>(std::lower_bound(vertices.begin(), vertices.end(), vertex) - vertices.begin());
+        };
+
+        for(int vertex : vertices)
+        {
+            roadMap.forEachOutgoingEdge(vertex,
+                [&](int to, const RoadSegment& segment)
+                {
+                    RoadSegment unprofiled{segment.miles, segment.milesPerHour};
+                    spec.edges.push_back(MapEdge{indexOf(vertex), indexOf(to), unprofiled});
+                });
+        }
+
+        return spec;
+    }
+
+
+    RoadMap buildRoadMap(const MapSpec& spec)
+    {
+        RoadMap roadMap;
+        for(unsigned int vertex = 0; vertex < spec.names.size(); ++vertex)
+        {
+            roadMap.addVertex(vertex, spec.names[vertex]);
+        }
+        for(const MapEdge& edge : spec.edges)
+        {
+            roadMap.addEdge(edge.from, edge.to, edge.segment);
+        }
+        return roadMap;
+    }
+
+
+    //half of the trips start from one of a few popular locations, and
+    //about one in fifty ends where it starts
+    TripSet generateTrips(std::mt19937& random, int locationCount, int tripCount)
+    {
+        std::uniform_int_distribution<int> percent{0, 99};
+        std::uniform_int_distribution<int> anyVertex{0, locationCount - 1};
+        std::vector<int> popular;
+        for(int i = 0; i < 4; ++i)
+        {
+            popular.push_back(anyVertex(random));
+        }
+
+        TripSet tripSet;
+        for(int start : popular)
+        {
+            tripSet.hotSources.emplace_back(start, TripMetric::Distance);
+            tripSet.hotSources.emplace_back(start, TripMetric::Time);
+        }
+
+        for(int i = 0; i < tripCount; ++i)
+        {
+            Trip trip;
+            trip.startVertex = percent(random) < 50 ? popular[random() % popular.size()] : anyVertex(random);
+            trip.endVertex = percent(random) < 2 ? trip.startVertex : anyVertex(random);
+            trip.metric = percent(random) < 50 ? TripMetric::Distance : TripMetric::Time;
+            tripSet.trips.push_back(trip);
+        }
+
+        return tripSet;
+    }
+
+
+    // The reference: one Digraph::findShortestPaths() per trip, over the
+    // RoadMap itself rather than a snapshot of it.
+    class DigraphTripRouter : public TripRouter
+    {
+    public:
+        explicit DigraphTripRouter(const RoadMap& roadMap)
+            : roadMap{roadMap}
+        {
+        }
+
+        using TripRouter::findPath;
+
+        void findPath(const Trip& trip, std::vector<int>& path) const override
+        {
+            search(trip);
+
+            path.clear();
+            if(!workspace.reached(roadMap.slotOf(trip.endVertex)))
+            {
+                return;
+            }
+            for(int vertex = trip.endVertex; ; vertex = workspace.predecessor(roadMap.slotOf(vertex)))
+            {
+                path.push_back(vertex);
+                if(vertex == trip.startVertex)
+                {
+                    break;
+                }
+            }
+            std::reverse(path.begin(), path.end());
+        }
+
+        MemoryUsage memoryUsage() const override
+        {
+            return MemoryUsage{};
+        }
+
+        //returns the cost of the trip's shortest path, or infinity if the
+        //end location can't be reached
+        double findCost(const Trip& trip) const
+        {
+            search(trip);
+            int slot = roadMap.slotOf(trip.endVertex);
+            return workspace.reached(slot) ? workspace.distance(slot) : INFINITY;
+        }
+
+
+    private:
+        void search(const Trip& trip) const
+        {
+            withMetricWeight(trip.metric,
+                [&](auto weight)
+                {
+                    roadMap.findShortestPaths(trip.startVertex, weight, workspace);
+                });
+        }
+
+        const RoadMap& roadMap;
+        mutable SearchWorkspace<double> workspace;
+    };
+
+
+    // What main's default engine does, but with one trip per search, so
+    // that each trip's time can be told apart from the others'.
+    class BatchedTripRouter : public TripRouter
+    {
+    public:
+        explicit BatchedTripRouter(const RoadMap& roadMap)
+            : distanceGraph{compactRoadMap(roadMap, TripMetric::Distance)},
+              timeGraph{compactRoadMap(roadMap, TripMetric::Time)}
+        {
+        }
+
+        using TripRouter::findPath;
+
+        void findPath(const Trip& trip, std::vector<int>& path) const override
+        {
+            const CompactDigraph<double>& graph = trip.metric == TripMetric::Time ? timeGraph : distanceGraph;
+            int start = graph.indexOf(trip.startVertex);
+            int end = graph.indexOf(trip.endVertex);
+
+            BatchedShortestPaths paths = findShortestPathsBatched(graph, {start});
+
+            path.clear();
+            if(std::isinf(paths.distance(0, end)))
+            {
+                return;
+            }
+            for(int vertex = end; ; vertex = paths.predecessor(0, vertex))
+            {
+                path.push_back(graph.vertexNumber(vertex));
+                if(vertex == start)
+                {
+                    break;
+                }
+            }
+            std::reverse(path.begin(), path.end());
+        }
+
+        MemoryUsage memoryUsage() const override
+        {
+            MemoryUsage usage;
+            usage.add("distance snapshot", distanceGraph.byteCount());
+            usage.add("time snapshot", timeGraph.byteCount());
+            return usage;
+        }
+
+
+    private:
+        CompactDigraph<double> distanceGraph;
+        CompactDigraph<double> timeGraph;
+    };
+
+
+    // TimeDependentTripRouter routes every trip itself, since none of
+    // them say when they leave and it isn't given another router.
+    class UnprofiledTripRouter : public TripRouter
+    {
+    public:
+        explicit UnprofiledTripRouter(const RoadMap& roadMap)
+            : router{roadMap, profiles}
+        {
+        }
+
+        using TripRouter::findPath;
+
+        void findPath(const Trip& trip, std::vector<int>& path) const override
+        {
+            router.findPath(trip, path);
+        }
+
+        MemoryUsage memoryUsage() const override
+        {
+            return router.memoryUsage();
+        }
+
+
+    private:
+        SpeedProfiles profiles;
+        TimeDependentTripRouter router;
+    };
+
+
+    // A CachedTripRouter along with the router it hands uncached trips to.
+    class CacheEngine : public TripRouter
+    {
+    public:
+        CacheEngine(const RoadMap& roadMap, TreeCache cache)
+            : otherTrips{roadMap}, router{std::move(cache), otherTrips}
+        {
+        }
+
+        using TripRouter::findPath;
+
+        void findPath(const Trip& trip, std::vector<int>& path) const override
+        {
+            router.findPath(trip, path);
+        }
+
+        MemoryUsage memoryUsage() const override
+        {
+            MemoryUsage usage = router.memoryUsage();
+            usage.add("dijkstra", otherTrips.memoryUsage());
+            return usage;
+        }
+
+
+    private:
+        DijkstraTripRouter otherTrips;
+        CachedTripRouter router;
+    };
+
+
+    struct Engine
+    {
+        std::string name;
+        std::function<std::unique_ptr<TripRouter>(const RoadMap&, const HotSources&)> build;
+    };
+
+
+    //builds the tree cache in a scratch file, which is removed as soon as
+    //it's mapped into memory
+    std::unique_ptr<TripRouter> makeCacheEngine(
+        const RoadMap& roadMap, const HotSources& hotSources, const std::string& directory)
+    {
+        std::string fileName = directory + "/engine-harness-" + std::to_string(getpid()) + ".trees";
+        writeTreeCache(fileName, roadMap, hotSources, 1);
+        TreeCache cache{fileName, roadMap};
+        std::remove(fileName.c_str());
+        return std::make_unique<CacheEngine>(roadMap, std::move(cache));
+    }
+
+
+    //builds an overlay for the map with a third of its speeds and a
+    //seventh of its lengths changed, then customizes it twice: for the
+    //map's own lengths (but the other speeds), which has to customize
+    //both metrics again, and for the map itself, which has to customize
+    //only the time metric and keeps the distance costs from the first.
+    //On the way, it checks that a map with a road segment missing is
+    //turned away.
+    std::unique_ptr<TripRouter> makeCustomizedEngine(const RoadMap& roadMap)
+    {
+        RoadMap otherSpeeds = roadMap;
+        int segment = 0;
+        for(int vertex : roadMap.vertices())
+        {
+            roadMap.forEachOutgoingEdge(vertex,
+                [&](int to, const RoadSegment&)
+                {
+                    if(segment++ % 3 == 0)
+                    {
+                        otherSpeeds.updateEdges(vertex, to,
+                            [](RoadSegment& changed)
+                            {
+                                changed.milesPerHour = changed.milesPerHour > 40.0 ? 25.0 : 65.0;
+                            });
+                    }
+                });
+        }
+
+        RoadMap otherLengths = otherSpeeds;
+        std::pair<int, int> missing{-1, -1};
+        segment = 0;
+        for(int vertex : roadMap.vertices())
+        {
+            roadMap.forEachOutgoingEdge(vertex,
+                [&](int to, const RoadSegment&)
+                {
+                    if(segment++ % 7 == 0)
+                    {
+                        otherLengths.updateEdges(vertex, to,
+                            [](RoadSegment& changed)
+                            {
+                                changed.miles *= 3.0;
+                            });
+                    }
+                    missing = {vertex, to};
+                });
+        }
+
+        std::unique_ptr<OverlayTripRouter> router = std::make_unique<OverlayTripRouter>(otherLengths);
+        router->customize(otherSpeeds);
+
+        if(missing.first != -1)
+        {
+            RoadMap fewerSegments = roadMap;
+            fewerSegments.removeEdge(missing.first, missing.second);
+            try
+            {
+                router->customize(fewerSegments);
+                throw std::runtime_error{"customize() took a map with a road segment missing"};
+            }
+            catch(OverlayTripRouterException&)
+            {
+            }
+        }
+
+        router->customize(roadMap);
+        return router;
+    }
+
+
+    // A ShardCoordinator, whose workers are this program run again with
+    // --shard-worker.  It isn't safe to use from several threads at once,
+    // which the harness never does, and its memoryUsage() is empty, since
+    // the shards are held by the workers.
+    class ShardEngine : public TripRouter
+    {
+    public:
+        explicit ShardEngine(std::unique_ptr<ShardCoordinator> coordinator)
+            : coordinator{std::move(coordinator)}
+        {
+        }
+
+        using TripRouter::findPath;
+
+        void findPath(const Trip& trip, std::vector<int>& path) const override
+        {
+            coordinator->findPath(trip, path);
+        }
+
+        MemoryUsage memoryUsage() const override
+        {
+            return MemoryUsage{};
+        }
+
+
+    private:
+        std::unique_ptr<ShardCoordinator> coordinator;
+    };
+
+
+    //writes the map's shards into a scratch directory, which is removed
+    //as soon as the workers have loaded them
+    std::unique_ptr<TripRouter> makeShardEngine(
+        const RoadMap& roadMap, const std::string& directory, const std::string& program)
+    {
+        const int shardCount = 4;
+        std::string shardDirectory = directory + "/engine-harness-" + std::to_string(getpid()) + ".shards";
+        if(mkdir(shardDirectory.c_str(), 0777) != 0 && errno != EEXIST)
+        {
+            throw std::runtime_error{"could not create " + shardDirectory};
+        }
+
+        auto removeShards = [&]()
+        {
+            for(int shard = 0; shard < shardCount; ++shard)
+            {
+                std::remove(shardMapFile(shardDirectory, shard).c_str());
+                std::remove(shardIdsFile(shardDirectory, shard).c_str());
+            }
+            std::remove(shardManifestFile(shardDirectory).c_str());
+            rmdir(shardDirectory.c_str());
+        };
+
+        try
+        {
+            writeRoadMapShards(roadMap, shardCount, shardDirectory, 1);
+            auto coordinator = std::make_unique<ShardCoordinator>(shardDirectory, program);
+            removeShards();
+            return std::make_unique<ShardEngine>(std::move(coordinator));
+        }
+        catch(...)
+        {
+            removeShards();
+            throw;
+        }
+    }
+
+
+    //program is how to run this program again, for the shards' workers
+    std::vector<Engine> allEngines(const std::string& scratchDirectory, const std::string& program)
+    {
+        return {
+            {"digraph", [](const RoadMap& m, const HotSources&) { return std::make_unique<DigraphTripRouter>(m); }},
+            {"dijkstra", [](const RoadMap& m, const HotSources&) { return std::make_unique<DijkstraTripRouter>(m); }},
+            {"quantized", [](const RoadMap& m, const HotSources&) { return std::make_unique<QuantizedTripRouter>(m); }},
+            {"alt", [](const RoadMap& m, const HotSources&) { return std::make_unique<AltTripRouter>(m, 8, ""); }},
+            {"overlay", [](const RoadMap& m, const HotSources&) { return std::make_unique<OverlayTripRouter>(m); }},
+            {"customized", [](const RoadMap& m, const HotSources&) { return makeCustomizedEngine(m); }},
+            {"compressed", [](const RoadMap& m, const HotSources&) { return std::make_unique<CompressedTripRouter>(m); }},
+            {"contracted", [](const RoadMap& m, const HotSources&) { return std::make_unique<ContractedTripRouter>(m); }},
+            {"batched", [](const RoadMap& m, const HotSources&) { return std::make_unique<BatchedTripRouter>(m); }},
+            {"time-dependent", [](const RoadMap& m, const HotSources&) { return std::make_unique<UnprofiledTripRouter>(m); }},
+            {"cached",
+                [scratchDirectory](const RoadMap& m, const HotSources& hotSources)
+                {
+                    return makeCacheEngine(m, hotSources, scratchDirectory);
+                }},
+            {"shards",
+                [scratchDirectory, program](const RoadMap& m, const HotSources&)
+                {
+                    return makeShardEngine(m, scratchDirectory, program);
+                }}
+        };
+    }
+
+
+    std::string formatCost(double cost, TripMetric metric)
+    {
+        std::ostringstream out;
+        out<<std::setprecision(10)<<cost<<(metric == TripMetric::Distance ? " miles" : " seconds");
+        return out.str();
+    }
+
+
+    //returns what's wrong with the path found for the trip, given the
+    //cost of its shortest path, or an empty string if nothing is; if
+    //profiles are given, a trip that says when it leaves is costed by how
+    //long it takes to arrive
+    std::string checkPath(
+        const RoadMap& roadMap, const Trip& trip, const std::vector<int>& path,
+        double expectedCost, double tolerance, const SpeedProfiles* profiles = nullptr)
+    {
+        bool timed = profiles != nullptr && trip.departureTime != noDepartureTime;
+
+        if(path.empty())
+        {
+            return std::isinf(expectedCost)
+                ? "" : "found no path, but there is one of " + formatCost(expectedCost, trip.metric);
+        }
+        if(path.front() != trip.startVertex || path.back() != trip.endVertex)
+        {
+            return "found a path from " + std::to_string(path.front()) + " to " + std::to_string(path.back());
+        }
+
+        double cost = 0.0;
+        for(unsigned int i = 1; i < path.size(); ++i)
+        {
+            RoadSegment segment;
+            try
+            {
+                segment = roadMap.edgeInfo(path[i - 1], path[i]);
+            }
+            catch(DigraphException&)
+            {
+                return "found a path along a road segment from " + std::to_string(path[i - 1]) +
+                       " to " + std::to_string(path[i]) + " that isn't on the map";
+            }
+            cost += timed
+                ? profiles->travelSeconds(segment, trip.departureTime + cost)
+                : withMetricWeight(trip.metric, [&](auto weight) { return weight(segment); });
+        }
+
+        if(std::isinf(expectedCost))
+        {
+            return "found a path of " + formatCost(cost, trip.metric) + ", but there is none";
+        }
+        if(std::abs(cost - expectedCost) > tolerance * std::max(1.0, expectedCost))
+        {
+            return "found a path of " + formatCost(cost, trip.metric) +
+                   ", but the shortest is " + formatCost(expectedCost, trip.metric) +
+                   " (off by " + formatCost(cost - expectedCost, trip.metric) + ")";
+        }
+        return "";
+    }
+
+
+    double secondsSince(std::chrono::steady_clock::time_point started)
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    }
+
+
+    //has the router answer the trip, returning what's wrong with its
+    //answer (which includes throwing an exception) or an empty string
+    std::string runTrip(
+        const TripRouter& router, const RoadMap& roadMap, const Trip& trip, double expectedCost,
+        double tolerance, std::vector<int>& path, double& seconds,
+        const SpeedProfiles* profiles = nullptr)
+    {
+        auto started = std::chrono::steady_clock::now();
+        try
+        {
+            router.findPath(trip, path);
+        }
+        catch(std::exception& e)
+        {
+            seconds = secondsSince(started);
+            return std::string{"threw an exception: "} + e.what();
+        }
+        seconds = secondsSince(started);
+        return checkPath(roadMap, trip, path, expectedCost, tolerance, profiles);
+    }
+
+
+    //keeps only the given road segments' locations, and the trip's, and
+    //renumbers them from 0 in the order they were in
+    MapSpec cutDown(const MapSpec& spec, const std::vector<MapEdge>& edges, Trip& trip)
+    {
+        std::vector<int> kept{trip.startVertex, trip.endVertex};
+        for(const MapEdge& edge : edges)
+        {
+            kept.push_back(edge.from);
+            kept.push_back(edge.to);
+        }
+        std::sort(kept.begin(), kept.end());
+        kept.erase(std::unique(kept.begin(), kept.end()), kept.end());
+
+        auto indexOf = [&](int vertex)
+        {
+            return static_cast<int>(std::lower_bound(kept.begin(), kept.end(), vertex) - kept.begin());
+        };
+
+        MapSpec cut;
+        for(int vertex : kept)
+        {
+            cut.names.push_back(spec.names[vertex]);
+        }
+        for(const MapEdge& edge : edges)
+        {
+            cut.edges.push_back(MapEdge{indexOf(edge.from), indexOf(edge.to), edge.segment});
+        }
+        trip.startVertex = indexOf(trip.startVertex);
+        trip.endVertex = indexOf(trip.endVertex);
+        return cut;
+    }
+
+
+    //returns what the engine gets wrong about the trip over the map made
+    //of only the given road segments, or an empty string if nothing is
+    std::string problemWith(
+        const Engine& engine, const MapSpec& spec, const std::vector<MapEdge>& edges,
+        Trip trip, double tolerance)
+    {
+        MapSpec cut = cutDown(spec, edges, trip);
+        RoadMap roadMap = buildRoadMap(cut);
+        double expectedCost = DigraphTripRouter{roadMap}.findCost(trip);
+
+        std::unique_ptr<TripRouter> router;
+        try
+        {
+            router = engine.build(roadMap, {{trip.startVertex, trip.metric}});
+        }
+        catch(std::exception&)
+        {
+            //a different problem than the one being looked for
+            return "";
+        }
+
+        std::vector<int> path;
+        double seconds;
+        return runTrip(*router, roadMap, trip, expectedCost, tolerance, path, seconds);
+    }
+
+
+    //finds a small set of the map's road segments over which the engine
+    //still gets the trip wrong, by trying to remove halves of them, then
+    //quarters, and so on down to one at a time; the search gives up
+    //trying to make it smaller after testLimit attempts
+    std::vector<MapEdge> minimize(
+        const Engine& engine, const MapSpec& spec, const Trip& trip, double tolerance,
+        int testLimit)
+    {
+        std::vector<MapEdge> edges = spec.edges;
+        int tests = 0;
+
+        for(std::size_t chunk = edges.size() / 2; chunk >= 1 && tests < testLimit; chunk /= 2)
+        {
+            std::size_t begin = 0;
+            while(begin < edges.size() && tests < testLimit)
+            {
+                std::vector<MapEdge> candidate{edges.begin(), edges.begin() + begin};
+                candidate.insert(candidate.end(), edges.begin() + std::min(edges.size(), begin + chunk), edges.end());
+
+                ++tests;
+                if(!problemWith(engine, spec, candidate, trip, tolerance).empty())
+                {
+                    edges = std::move(candidate);
+                }
+                else
+                {
+                    begin += chunk;
+                }
+            }
+        }
+
+        return edges;
+    }
+
+
+    //writes a number as briefly as it can be while still reading back as
+    //exactly the same number
+    std::ostream& writeNumber(std::ostream& out, double value)
+    {
+        char text[32];
+        std::to_chars_result result = std::to_chars(text, text + sizeof(text), value);
+        return out.write(text, result.ptr - text);
+    }
+
+
+    //writes the map and the trip in the format main reads them in
+    bool writeReproducer(
+        const std::string& fileName, const std::string& engineName, const MapSpec& spec,
+        const Trip& trip, const std::string& problem)
+    {
+        std::ofstream out{fileName};
+        out<<"# written by EngineHarness: the "<<engineName<<" engine "<<problem<<"\n";
+        out<<spec.names.size()<<"\n";
+        for(const std::string& name : spec.names)
+        {
+            out<<name<<"\n";
+        }
+        out<<spec.edges.size()<<"\n";
+        for(const MapEdge& edge : spec.edges)
+        {
+            out<<edge.from<<" "<<edge.to<<" ";
+            writeNumber(out, edge.segment.miles)<<" ";
+            writeNumber(out, edge.segment.milesPerHour);
+            if(edge.segment.speedProfile != noSpeedProfile)
+            {
+                out<<" "<<edge.segment.speedProfile;
+            }
+            out<<"\n";
+        }
+        out<<"1\n"<<trip.startVertex<<" "<<trip.endVertex<<" "
+           <<(trip.metric == TripMetric::Distance ? "D" : "T");
+        if(trip.departureTime != noDepartureTime)
+        {
+            out<<" "<<formatTimeOfDay(trip.departureTime);
+        }
+        out<<"\n";
+        out.close();
+        return static_cast<bool>(out);
+    }
+
+
+    //closes about one location in fifty and one pair of locations' road
+    //segments in twenty, and changes the speed of one in twenty; it has a
+    //random number generator of its own, so that checking closures or not
+    //doesn't change the maps and trips the engines are given
+    RoadClosures generateClosures(std::mt19937& random, const MapSpec& spec)
+    {
+        std::uniform_int_distribution<int> percent{0, 99};
+        std::uniform_int_distribution<int> speed{10, 70};
+
+        RoadClosures closures;
+        for(unsigned int vertex = 0; vertex < spec.names.size(); ++vertex)
+        {
+            if(percent(random) < 2)
+            {
+                closures.closedLocations.push_back(vertex);
+            }
+        }
+
+        std::set<std::pair<int, int>> roads;
+        for(const MapEdge& edge : spec.edges)
+        {
+            roads.emplace(edge.from, edge.to);
+        }
+        for(const std::pair<int, int>& road : roads)
+        {
+            int kind = percent(random);
+            if(kind < 5)
+            {
+                closures.closedRoads.push_back(road);
+            }
+            else if(kind < 10)
+            {
+                closures.speedChanges.push_back(SpeedChange{road.first, road.second, double(speed(random))});
+            }
+        }
+
+        return closures;
+    }
+
+
+    //copies the map and makes the closures to the copy: the closed
+    //locations are removed, every road segment closed is removed, and every
+    //one whose speed changes is removed and added back at the new speed
+    RoadMap closeRoads(const RoadMap& roadMap, const RoadClosures& closures)
+    {
+        RoadMap closed = roadMap;
+        closed.removeVertices(closures.closedLocations);
+
+        //removes the road segments between two locations, returning them
+        auto removeRoad = [&](int from, int to)
+        {
+            std::vector<RoadSegment> removed;
+            if(!closed.hasVertex(from) || !closed.hasVertex(to))
+            {
+                return removed;
+            }
+            closed.forEachOutgoingEdge(from,
+                [&](int target, const RoadSegment& segment)
+                {
+                    if(target == to)
+                    {
+                        removed.push_back(segment);
+                    }
+                });
+            for(unsigned int i = 0; i < removed.size(); ++i)
+            {
+                closed.removeEdge(from, to);
+            }
+            return removed;
+        };
+
+        for(const std::pair<int, int>& road : closures.closedRoads)
+        {
+            removeRoad(road.first, road.second);
+        }
+        for(const SpeedChange& change : closures.speedChanges)
+        {
+            for(RoadSegment segment : removeRoad(change.fromVertex, change.toVertex))
+            {
+                if(change.milesPerHour > 0.0)
+                {
+                    segment.milesPerHour = change.milesPerHour;
+                    closed.addEdge(change.fromVertex, change.toVertex, segment);
+                }
+            }
+        }
+
+        return closed;
+    }
+
+
+    //writes the closures in the format readRoadClosures() reads
+    bool writeClosures(const std::string& fileName, const RoadClosures& closures)
+    {
+        std::ofstream out{fileName};
+        for(int vertex : closures.closedLocations)
+        {
+            out<<"-V "<<vertex<<"\n";
+        }
+        for(const std::pair<int, int>& road : closures.closedRoads)
+        {
+            out<<"-E "<<road.first<<" "<<road.second<<"\n";
+        }
+        for(const SpeedChange& change : closures.speedChanges)
+        {
+            out<<"~E "<<change.fromVertex<<" "<<change.toVertex<<" ";
+            writeNumber(out, change.milesPerHour)<<"\n";
+        }
+        out.close();
+        return static_cast<bool>(out);
+    }
+
+
+    //writes the speed profiles the profiles check uses, in the format
+    //readSpeedProfiles() reads: one that never changes, a morning and an
+    //evening rush hour, one that's faster than usual overnight, one with a
+    //speed picked at random (from 1% to 200%) for every quarter hour, and
+    //the morning rush hour again, which should be stored only once
+    std::string generateProfiles(std::mt19937& random)
+    {
+        std::uniform_int_distribution<int> anyPercentage{1, 200};
+        const int hour = 3600 / SpeedProfiles::bucketSeconds;
+
+        std::vector<std::vector<int>> profiles(5, std::vector<int>(SpeedProfiles::bucketCount, 100));
+        for(int bucket = 7 * hour; bucket < 9 * hour; ++bucket)
+        {
+            profiles[1][bucket] = 30;
+        }
+        for(int bucket = 16 * hour; bucket < 19 * hour; ++bucket)
+        {
+            profiles[2][bucket] = 45;
+        }
+        for(int bucket = 0; bucket < SpeedProfiles::bucketCount; ++bucket)
+        {
+            if(bucket < 5 * hour || bucket >= 22 * hour)
+            {
+                profiles[3][bucket] = 140;
+            }
+            profiles[4][bucket] = anyPercentage(random);
+        }
+        profiles.push_back(profiles[1]);
+
+        std::ostringstream out;
+        out<<profiles.size()<<"\n";
+        for(const std::vector<int>& percentages : profiles)
+        {
+            for(unsigned int bucket = 0; bucket < percentages.size(); ++bucket)
+            {
+                out<<(bucket == 0 ? "" : " ")<<percentages[bucket];
+            }
+            out<<"\n";
+        }
+        return out.str();
+    }
+
+
+    // What the profiles check makes of a map: speed profiles, and a patch
+    // (see MapPatch.hpp) that makes some of the map's road segments follow
+    // them, changes the speeds of others, and adds and removes a few
+    // locations.  The map the patch should make is worked out here too,
+    // without applyMapPatch(): "expected" is the map with every change but
+    // the removals, which are in removedLocations.
+    struct ProfiledVariant
+    {
+        std::string profileText;
+        std::string patchText;
+        MapSpec expected;
+        std::vector<int> addedLocations;
+        std::vector<int> removedLocations;
+    };
+
+
+    //about three in ten road segments are given a profile (by removing
+    //them and adding them back with one) and one in twenty a new speed;
+    //three locations are added, each with a road segment from one location
+    //on the map and to another, and three are removed.  Only a pair of
+    //locations with a single road segment between them is changed, so
+    //there's no question which segment a line of the patch means.  Like
+    //generateClosures(), it has a random number generator of its own.
+    ProfiledVariant generateProfiledVariant(std::mt19937& random, const MapSpec& spec)
+    {
+        std::uniform_int_distribution<int> percent{0, 99};
+        std::uniform_int_distribution<int> speed{10, 70};
+        std::uniform_int_distribution<int> anyProfile{0, 5};
+        std::uniform_int_distribution<int> anyVertex{0, static_cast<int>(spec.names.size()) - 1};
+
+        ProfiledVariant variant;
+        variant.profileText = generateProfiles(random);
+        variant.expected = spec;
+        std::ostringstream patch;
+
+        auto addSegment = [&](int from, int to, const RoadSegment& segment)
+        {
+            patch<<"+E "<<from<<" "<<to<<" ";
+            writeNumber(patch, segment.miles)<<" ";
+            writeNumber(patch, segment.milesPerHour);
+            if(segment.speedProfile != noSpeedProfile)
+            {
+                patch<<" "<<segment.speedProfile;
+            }
+            patch<<"\n";
+        };
+
+        std::map<std::pair<int, int>, int> segmentCounts;
+        for(const MapEdge& edge : spec.edges)
+        {
+            ++segmentCounts[{edge.from, edge.to}];
+        }
+
+        for(MapEdge& edge : variant.expected.edges)
+        {
+            if(segmentCounts[{edge.from, edge.to}] != 1 || edge.segment.milesPerHour <= 0.0)
+            {
+                continue;
+            }
+
+            int kind = percent(random);
+            if(kind < 30)
+            {
+                edge.segment.speedProfile = anyProfile(random);
+                patch<<"-E "<<edge.from<<" "<<edge.to<<"\n";
+                addSegment(edge.from, edge.to, edge.segment);
+            }
+            else if(kind < 35)
+            {
+                edge.segment.milesPerHour = speed(random);
+                patch<<"~E "<<edge.from<<" "<<edge.to<<" "<<edge.segment.milesPerHour<<"\n";
+            }
+        }
+
+        for(int i = 1; i <= 3; ++i)
+        {
+            int location = variant.expected.names.size();
+            std::string name = "Patched Location " + std::to_string(i);
+            patch<<"+V "<<location<<" "<<name<<"\n";
+            variant.expected.names.push_back(name);
+            variant.addedLocations.push_back(location);
+
+            MapEdge in{anyVertex(random), location, RoadSegment{0.5, 25.0, anyProfile(random)}};
+            MapEdge out{location, anyVertex(random), RoadSegment{0.5, 25.0}};
+            for(const MapEdge& edge : {in, out})
+            {
+                addSegment(edge.from, edge.to, edge.segment);
+                variant.expected.edges.push_back(edge);
+            }
+        }
+
+        std::set<int> removed;
+        for(int i = 0; i < 3; ++i)
+        {
+            removed.insert(anyVertex(random));
+        }
+        for(int location : removed)
+        {
+            patch<<"-V "<<location<<"\n";
+            variant.removedLocations.push_back(location);
+        }
+
+        variant.patchText = patch.str();
+        return variant;
+    }
+
+
+    //returns how many seconds a trip that says when it leaves takes to
+    //arrive at the soonest, or infinity if it can't.  Rather than running
+    //Dijkstra's algorithm, it keeps improving the arrival times until none
+    //changes (which finds the soonest whenever leaving later never means
+    //arriving sooner), so it shares nothing with findEarliestArrivalPath().
+    double findEarliestArrival(const RoadMap& roadMap, const SpeedProfiles& profiles, const Trip& trip)
+    {
+        std::vector<double> arrivals(roadMap.vertices().back() + 1, INFINITY);
+        std::vector<bool> queued(arrivals.size(), false);
+        std::deque<int> queue;
+
+        arrivals[trip.startVertex] = trip.departureTime;
+        queue.push_back(trip.startVertex);
+
+        while(!queue.empty())
+        {
+            int vertex = queue.front();
+            queue.pop_front();
+            queued[vertex] = false;
+
+            roadMap.forEachOutgoingEdge(vertex,
+                [&](int to, const RoadSegment& segment)
+                {
+                    double arrival = arrivals[vertex] + profiles.travelSeconds(segment, arrivals[vertex]);
+                    if(arrival < arrivals[to])
+                    {
+                        arrivals[to] = arrival;
+                        if(!queued[to])
+                        {
+                            queued[to] = true;
+                            queue.push_back(to);
+                        }
+                    }
+                });
+        }
+
+        return arrivals[trip.endVertex] - trip.departureTime;
+    }
+
+
+    //writes the text to a file, returning false if it couldn't
+    bool writeText(const std::string& fileName, const std::string& text)
+    {
+        std::ofstream out{fileName};
+        out<<text;
+        out.close();
+        return static_cast<bool>(out);
+    }
+
+
+    //what's measured about the connectivity analyses over all of the maps
+    struct ConnectivityResults
+    {
+        double parallelSeconds = 0.0;
+        double digraphSeconds = 0.0;
+        long checks = 0;
+        long wrong = 0;
+    };
+
+
+    //returns the number of locations the start location reaches
+    int countReachable(const RoadMap& roadMap, int startVertex, SearchWorkspace<double>& workspace)
+    {
+        roadMap.findShortestPaths(startVertex, DistanceWeight{}, workspace);
+        int count = 0;
+        for(int vertex : roadMap.vertices())
+        {
+            count += workspace.reached(roadMap.slotOf(vertex));
+        }
+        return count;
+    }
+
+
+    //checks the analyses in DigraphAnalytics.hpp over the map against
+    //what Digraph finds, writing a line for each disagreement
+    void compareConnectivity(std::mt19937& random, const MapSpec& spec, ConnectivityResults& results)
+    {
+        auto fail = [&](const std::string& problem)
+        {
+            ++results.wrong;
+            std::cout<<"  connectivity: "<<problem<<"\n";
+        };
+
+        MapSpec ring = spec;
+        MapSpec twoWay = spec;
+        for(unsigned int vertex = 1; vertex < spec.names.size(); ++vertex)
+        {
+            ring.edges.push_back(MapEdge{int(vertex) - 1, int(vertex), RoadSegment{1.0, 25.0}});
+            ring.edges.push_back(MapEdge{int(vertex), int(vertex) - 1, RoadSegment{1.0, 25.0}});
+        }
+        for(const MapEdge& edge : spec.edges)
+        {
+            twoWay.edges.push_back(MapEdge{edge.to, edge.from, edge.segment});
+        }
+
+        const MapSpec* checkedMaps[] = {&spec, &ring};
+        for(const MapSpec* checked : checkedMaps)
+        {
+            RoadMap roadMap = buildRoadMap(*checked);
+            CompactDigraph<double> graph = compactRoadMap(roadMap, TripMetric::Distance);
+
+            auto started = std::chrono::steady_clock::now();
+            bool parallel = isStronglyConnectedParallel(graph);
+            results.parallelSeconds += secondsSince(started);
+
+            started = std::chrono::steady_clock::now();
+            bool digraph = roadMap.isStronglyConnected();
+            results.digraphSeconds += secondsSince(started);
+
+            ++results.checks;
+            if(parallel != digraph)
+            {
+                fail(std::string{"isStronglyConnectedParallel() says the map "} +
+                     (checked == &ring ? "with a ring added " : "") + "is " +
+                     (parallel ? "" : "not ") + "strongly connected, but Digraph says it is" +
+                     (digraph ? "" : " not"));
+            }
+        }
+
+        RoadMap roadMap = buildRoadMap(spec);
+        RoadMap twoWayMap = buildRoadMap(twoWay);
+        CompactDigraph<double> graph = compactRoadMap(roadMap, TripMetric::Distance);
+        std::vector<int> counts = reachabilityCounts(graph);
+        std::vector<int> pieces = weaklyConnectedComponents(graph);
+
+        SearchWorkspace<double> workspace;
+        std::uniform_int_distribution<int> anyVertex{0, int(spec.names.size()) - 1};
+        for(int sample = 0; sample < 20; ++sample)
+        {
+            int vertex = anyVertex(random);
+            int index = graph.indexOf(vertex);
+
+            ++results.checks;
+            int reachable = countReachable(roadMap, vertex, workspace);
+            if(counts[index] != reachable)
+            {
+                fail("reachabilityCounts() says location " + std::to_string(vertex) + " reaches " +
+                     std::to_string(counts[index]) + " locations, but it reaches " + std::to_string(reachable));
+            }
+
+            //the search over the two-way map reaches exactly the locations
+            //in the same weakly connected piece
+            ++results.checks;
+            countReachable(twoWayMap, vertex, workspace);
+            for(int other = 0; other < graph.vertexCount(); ++other)
+            {
+                bool samePiece = pieces[other] == pieces[index];
+                if(samePiece != workspace.reached(twoWayMap.slotOf(graph.vertexNumber(other))))
+                {
+                    fail("weaklyConnectedComponents() says locations " + std::to_string(vertex) + " and " +
+                         std::to_string(graph.vertexNumber(other)) + " are " + (samePiece ? "" : "not ") +
+                         "in the same piece, but they are" + (samePiece ? " not" : ""));
+                    break;
+                }
+            }
+        }
+    }
+
+
+    //what's measured about the distance matrices over all of the maps
+    struct MatrixResults
+    {
+        double matrixSeconds = 0.0;
+        double digraphSeconds = 0.0;
+        long entries = 0;
+        long wrong = 0;
+    };
+
+
+    //checks computeDistanceMatrix() over the map, for 8 random sources by
+    //64 random targets and 64 by 8, against one findShortestPaths() per
+    //source, writing a line for each wrong entry (up to a few per map)
+    void compareMatrices(
+        std::mt19937& random, const RoadMap& roadMap, double tolerance, MatrixResults& results)
+    {
+        std::uniform_int_distribution<int> anyVertex{0, roadMap.vertexCount() - 1};
+        auto pick = [&](int count)
+        {
+            std::vector<int> vertices;
+            for(int i = 0; i < count; ++i)
+            {
+                vertices.push_back(anyVertex(random));
+            }
+            return vertices;
+        };
+
+        SearchWorkspace<double> workspace;
+        int reported = 0;
+
+        for(int shape = 0; shape < 2; ++shape)
+        {
+            std::vector<int> sources = pick(shape == 0 ? 8 : 64);
+            std::vector<int> targets = pick(shape == 0 ? 64 : 8);
+
+            for(TripMetric metric : {TripMetric::Distance, TripMetric::Time})
+            {
+                CompactDigraph<double> graph = compactRoadMap(roadMap, metric);
+
+                auto started = std::chrono::steady_clock::now();
+                std::vector<float> matrix = computeDistanceMatrix(graph, sources, targets);
+                results.matrixSeconds += secondsSince(started);
+
+                for(unsigned int row = 0; row < sources.size(); ++row)
+                {
+                    started = std::chrono::steady_clock::now();
+                    withMetricWeight(metric,
+                        [&](auto weight)
+                        {
+                            roadMap.findShortestPaths(sources[row], weight, workspace);
+                        });
+                    results.digraphSeconds += secondsSince(started);
+
+                    for(unsigned int column = 0; column < targets.size(); ++column)
+                    {
+                        int slot = roadMap.slotOf(targets[column]);
+                        double expected = workspace.reached(slot) ? workspace.distance(slot) : INFINITY;
+                        double found = matrix[row * targets.size() + column];
+
+                        ++results.entries;
+                        bool right = std::isinf(expected)
+                            ? std::isinf(found)
+                            : std::abs(found - expected) <= tolerance * std::max(1.0, expected);
+                        if(right)
+                        {
+                            continue;
+                        }
+
+                        ++results.wrong;
+                        if(++reported <= 5)
+                        {
+                            std::cout<<"  matrix, from "<<sources[row]<<" to "<<targets[column]<<": "
+                                     <<formatCost(found, metric)<<", but the shortest is "
+                                     <<formatCost(expected, metric)<<"\n";
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+
+    //what's measured about one engine over all of the maps
+    struct EngineResults
+    {
+        double buildSeconds = 0.0;
+        std::size_t tableBytes = 0;
+        std::vector<double> tripSeconds;
+        long wrongTrips = 0;
+        int reproducers = 0;
+    };
+
+
+    double percentile(std::vector<double> values, double fraction)
+    {
+        if(values.empty())
+        {
+            return 0.0;
+        }
+        std::size_t rank = std::min(values.size() - 1, static_cast<std::size_t>(fraction * values.size()));
+        std::nth_element(values.begin(), values.begin() + rank, values.end());
+        return values[rank];
+    }
+}
+
+
+int main(int argc, char* argv[])
+{
+    int mapCount = 5;
+    int gridSize = 40;
+    int tripCount = 1000;
+    unsigned int seed = 46;
+    std::string mapFile;
+    std::string engineList;
+    double tolerance = 0.0001;
+    std::string reproDirectory = ".";
+    int reproLimit = 3;
+
+    for(int i = 1; i < argc; ++i)
+    {
+        std::string option = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if(option == "--maps" && hasValue)
+        {
+            mapCount = std::stoi(argv[++i]);
+        }
+        else if(option == "--grid" && hasValue)
+        {
+            gridSize = std::stoi(argv[++i]);
+        }
+        else if(option == "--trips" && hasValue)
+        {
+            tripCount = std::stoi(argv[++i]);
+        }
+        else if(option == "--seed" && hasValue)
+        {
+            seed = std::stoul(argv[++i]);
+        }
+        else if(option == "--map" && hasValue)
+        {
+            mapFile = argv[++i];
+        }
+        else if(option == "--engines" && hasValue)
+        {
+            engineList = argv[++i];
+        }
+        else if(option == "--tolerance" && hasValue)
+        {
+            tolerance = std::stod(argv[++i]);
+        }
+        else if(option == "--repro-dir" && hasValue)
+        {
+            reproDirectory = argv[++i];
+        }
+        else if(option == "--repros" && hasValue)
+        {
+            reproLimit = std::stoi(argv[++i]);
+        }
+        else if(option == "--shard-worker" && i + 2 < argc)
+        {
+            std::string directory = argv[++i];
+            int shard = std::stoi(argv[++i]);
+            try
+            {
+                ShardWorker worker(directory, shard);
+                worker.serve(std::cin, std::cout);
+            }
+            catch(ShardException& e)
+            {
+                std::cerr<<"shard "<<shard<<": "<<e.what()<<"\n";
+                return 1;
+            }
+            return 0;
+        }
+        else
+        {
+            std::cerr<<"Unrecognized option: "<<option<<"\n";
+            return 1;
+        }
+    }
+
+    std::vector<Engine> engines = allEngines(reproDirectory, argv[0]);
+    bool checkClosures = true;
+    bool checkProfiles = true;
+    bool checkConnectivity = true;
+    bool checkMatrices = true;
+    if(!engineList.empty())
+    {
+        std::vector<Engine> chosen;
+        checkClosures = false;
+        checkProfiles = false;
+        checkConnectivity = false;
+        checkMatrices = false;
+        std::istringstream names{engineList};
+        std::string name;
+        while(std::getline(names, name, ','))
+        {
+            if(name == "closures")
+            {
+                checkClosures = true;
+                continue;
+            }
+            if(name == "profiles")
+            {
+                checkProfiles = true;
+                continue;
+            }
+            if(name == "connectivity")
+            {
+                checkConnectivity = true;
+                continue;
+            }
+            if(name == "matrix")
+            {
+                checkMatrices = true;
+                continue;
+            }
+            auto found = std::find_if(engines.begin(), engines.end(),
+                [&](const Engine& engine) { return engine.name == name; });
+            if(found == engines.end())
+            {
+                std::cerr<<"Unrecognized engine: "<<name<<"\n";
+                return 1;
+            }
+            chosen.push_back(*found);
+        }
+        engines = chosen;
+    }
+
+    MapSpec fileSpec;
+    if(!mapFile.empty())
+    {
+        try
+        {
+            fileSpec = specOf(RoadMapReader{}.readRoadMapFile(mapFile));
+        }
+        catch(RoadMapReaderException& e)
+        {
+            std::cerr<<mapFile<<": "<<e.what()<<"\n";
+            return 1;
+        }
+        if(fileSpec.names.empty())
+        {
+            std::cerr<<"The map is empty\n";
+            return 1;
+        }
+        mapCount = 1;
+    }
+
+    std::mt19937 random{seed};
+    std::vector<EngineResults> results(engines.size());
+    EngineResults closureResults;
+    EngineResults profileResults;
+    ConnectivityResults connectivityResults;
+    MatrixResults matrixResults;
+    std::vector<double> expectedCosts;
+    std::vector<int> path;
+
+    for(int mapNumber = 1; mapNumber <= mapCount; ++mapNumber)
+    {
+        MapSpec spec = mapFile.empty() ? generateMap(random, gridSize) : fileSpec;
+        TripSet tripSet = generateTrips(random, spec.names.size(), tripCount);
+        RoadMap roadMap = buildRoadMap(spec);
+
+        DigraphTripRouter reference{roadMap};
+        expectedCosts.clear();
+        for(const Trip& trip : tripSet.trips)
+        {
+            expectedCosts.push_back(reference.findCost(trip));
+        }
+
+        std::cout<<"map "<<mapNumber<<": "<<roadMap.vertexCount()<<" locations, "
+                 <<roadMap.edgeCount()<<" road segments, "<<tripSet.trips.size()<<" trips\n";
+
+        for(unsigned int e = 0; e < engines.size(); ++e)
+        {
+            const Engine& engine = engines[e];
+            EngineResults& engineResults = results[e];
+
+            auto started = std::chrono::steady_clock::now();
+            std::unique_ptr<TripRouter> router;
+            try
+            {
+                router = engine.build(roadMap, tripSet.hotSources);
+            }
+            catch(std::exception& ex)
+            {
+                std::cout<<"  "<<engine.name<<" could not be built: "<<ex.what()<<"\n";
+                engineResults.wrongTrips += tripSet.trips.size();
+                continue;
+            }
+            engineResults.buildSeconds += secondsSince(started);
+            engineResults.tableBytes = std::max(engineResults.tableBytes, router->memoryUsage().total());
+
+            for(unsigned int t = 0; t < tripSet.trips.size(); ++t)
+            {
+                const Trip& trip = tripSet.trips[t];
+                double seconds;
+                std::string problem = runTrip(
+                    *router, roadMap, trip, expectedCosts[t], tolerance, path, seconds);
+                engineResults.tripSeconds.push_back(seconds);
+
+                if(problem.empty())
+                {
+                    continue;
+                }
+
+                ++engineResults.wrongTrips;
+                std::cout<<"  "<<engine.name<<", trip from "<<trip.startVertex<<" to "
+                         <<trip.endVertex<<" by "<<(trip.metric == TripMetric::Distance ? "distance" : "time")
+                         <<": "<<problem<<"\n";
+
+                if(engineResults.reproducers < reproLimit)
+                {
+                    std::vector<MapEdge> edges = minimize(engine, spec, trip, tolerance, 2000);
+                    Trip cutTrip = trip;
+                    MapSpec cut = cutDown(spec, edges, cutTrip);
+                    std::string cutProblem = problemWith(engine, spec, edges, trip, tolerance);
+
+                    std::string fileName = reproDirectory + "/repro-" + engine.name + "-" +
+                                           std::to_string(++engineResults.reproducers) + ".txt";
+                    if(writeReproducer(fileName, engine.name, cut, cutTrip, cutProblem))
+                    {
+                        std::cout<<"    reproduced with "<<cut.names.size()<<" locations and "
+                                 <<cut.edges.size()<<" road segments in "<<fileName<<"\n";
+                    }
+                    else
+                    {
+                        std::cout<<"    could not write "<<fileName<<"\n";
+                    }
+                }
+            }
+        }
+
+        if(checkConnectivity)
+        {
+            std::mt19937 sampleRandom{seed + mapNumber};
+            compareConnectivity(sampleRandom, spec, connectivityResults);
+        }
+
+        if(checkMatrices)
+        {
+            std::mt19937 matrixRandom{seed + mapNumber};
+            compareMatrices(matrixRandom, roadMap, tolerance, matrixResults);
+        }
+
+        if(checkClosures)
+        {
+            std::mt19937 closureRandom{seed + mapNumber};
+            RoadClosures closures = generateClosures(closureRandom, spec);
+            RoadMap closedMap = closeRoads(roadMap, closures);
+            DigraphTripRouter closedReference{closedMap};
+
+            auto started = std::chrono::steady_clock::now();
+            DijkstraTripRouter dijkstra{roadMap};
+            ClosureTripRouter router{dijkstra, closures};
+            closureResults.buildSeconds += secondsSince(started);
+            closureResults.tableBytes = std::max(
+                closureResults.tableBytes, dijkstra.memoryUsage().total() + router.memoryUsage().total());
+
+            for(const Trip& trip : tripSet.trips)
+            {
+                //a trip to or from a closed location has no path at all
+                double expectedCost =
+                    closedMap.hasVertex(trip.startVertex) && closedMap.hasVertex(trip.endVertex)
+                    ? closedReference.findCost(trip) : INFINITY;
+
+                double seconds;
+                std::string problem = runTrip(router, closedMap, trip, expectedCost, tolerance, path, seconds);
+                closureResults.tripSeconds.push_back(seconds);
+
+                if(problem.empty())
+                {
+                    continue;
+                }
+
+                ++closureResults.wrongTrips;
+                std::cout<<"  closures, trip from "<<trip.startVertex<<" to "
+                         <<trip.endVertex<<" by "<<(trip.metric == TripMetric::Distance ? "distance" : "time")
+                         <<": "<<problem<<"\n";
+
+                if(closureResults.reproducers < reproLimit)
+                {
+                    std::string fileName = reproDirectory + "/repro-closures-" +
+                                           std::to_string(++closureResults.reproducers);
+                    if(writeReproducer(fileName + ".txt", "closures", spec, trip, problem) &&
+                       writeClosures(fileName + ".closures", closures))
+                    {
+                        std::cout<<"    reproduced in "<<fileName<<".txt with --closures "
+                                 <<fileName<<".closures\n";
+                    }
+                    else
+                    {
+                        std::cout<<"    could not write "<<fileName<<"\n";
+                    }
+                }
+            }
+        }
+
+        if(checkProfiles)
+        {
+            std::mt19937 profileRandom{seed + mapNumber};
+            ProfiledVariant variant = generateProfiledVariant(profileRandom, spec);
+            RoadMap expectedMap = buildRoadMap(variant.expected);
+            expectedMap.removeVertices(variant.removedLocations);
+            DigraphTripRouter expectedReference{expectedMap};
+
+            //the trips are the map's, with about nine in ten of the
+            //driving-time ones given a time to leave, and moved off the
+            //locations the patch removes onto the ones it adds
+            std::uniform_int_distribution<int> percent{0, 99};
+            std::uniform_int_distribution<int> anyTime{0, secondsPerDay - 1};
+            std::vector<Trip> trips = tripSet.trips;
+            for(unsigned int t = 0; t < trips.size(); ++t)
+            {
+                Trip& trip = trips[t];
+                if(trip.metric == TripMetric::Time && percent(profileRandom) < 90)
+                {
+                    trip.departureTime = anyTime(profileRandom);
+                }
+                for(int* end : {&trip.startVertex, &trip.endVertex})
+                {
+                    if(!expectedMap.hasVertex(*end))
+                    {
+                        *end = variant.addedLocations[t % variant.addedLocations.size()];
+                    }
+                }
+            }
+
+            auto started = std::chrono::steady_clock::now();
+            RoadMap patchedMap = roadMap;
+            SpeedProfiles profiles;
+            std::unique_ptr<TimeDependentTripRouter> router;
+            try
+            {
+                std::istringstream profileStream{variant.profileText};
+                InputReader profileReader{profileStream};
+                profiles = readSpeedProfiles(profileReader);
+
+                std::istringstream patchStream{variant.patchText};
+                applyMapPatch(patchedMap, readMapPatch(patchStream));
+
+                router = std::make_unique<TimeDependentTripRouter>(patchedMap, profiles);
+            }
+            catch(std::exception& ex)
+            {
+                std::cout<<"  profiles could not be built: "<<ex.what()<<"\n";
+                profileResults.wrongTrips += trips.size();
+                continue;
+            }
+            profileResults.buildSeconds += secondsSince(started);
+            profileResults.tableBytes = std::max(
+                profileResults.tableBytes, router->memoryUsage().total() + profiles.byteCount());
+
+            for(const Trip& trip : trips)
+            {
+                double expectedCost = trip.departureTime != noDepartureTime
+                    ? findEarliestArrival(expectedMap, profiles, trip)
+                    : expectedReference.findCost(trip);
+
+                //the path is checked against the map as it should have
+                //been patched, which also catches a patch applied wrongly
+                double seconds;
+                std::string problem = runTrip(
+                    *router, expectedMap, trip, expectedCost, tolerance, path, seconds, &profiles);
+                profileResults.tripSeconds.push_back(seconds);
+
+                if(problem.empty())
+                {
+                    continue;
+                }
+
+                ++profileResults.wrongTrips;
+                std::cout<<"  profiles, trip from "<<trip.startVertex<<" to "
+                         <<trip.endVertex<<" by "<<(trip.metric == TripMetric::Distance ? "distance" : "time");
+                if(trip.departureTime != noDepartureTime)
+                {
+                    std::cout<<" at "<<formatTimeOfDay(trip.departureTime);
+                }
+                std::cout<<": "<<problem<<"\n";
+
+                if(profileResults.reproducers < reproLimit)
+                {
+                    std::string fileName = reproDirectory + "/repro-profiles-" +
+                                           std::to_string(++profileResults.reproducers);
+                    if(writeReproducer(fileName + ".txt", "profiles", spec, trip, problem) &&
+                       writeText(fileName + ".patch", variant.patchText) &&
+                       writeText(fileName + ".profiles", variant.profileText))
+                    {
+                        std::cout<<"    reproduced in "<<fileName<<".txt with --patch "
+                                 <<fileName<<".patch --profiles "<<fileName<<".profiles\n";
+                    }
+                    else
+                    {
+                        std::cout<<"    could not write "<<fileName<<"\n";
+                    }
+                }
+            }
+        }
+    }
+
+    std::cout<<"\n"<<std::left<<std::setw(16)<<"engine"<<std::right
+             <<std::setw(12)<<"build ms"<<std::setw(12)<<"tables MiB"<<std::setw(12)<<"p50 us"<<std::setw(12)<<"p99 us"
+             <<std::setw(14)<<"trips/s"<<std::setw(10)<<"wrong"<<"\n";
+    std::cout<<std::fixed;
+
+    bool anyWrong = false;
+    auto writeResults = [&](const std::string& name, const EngineResults& engineResults)
+    {
+        double totalSeconds = 0.0;
+        for(double seconds : engineResults.tripSeconds)
+        {
+            totalSeconds += seconds;
+        }
+
+        std::cout<<std::left<<std::setw(16)<<name<<std::right<<std::setprecision(1)
+                 <<std::setw(12)<<engineResults.buildSeconds * 1e3
+                 <<std::setw(12)<<engineResults.tableBytes / (1024.0 * 1024.0)
+                 <<std::setw(12)<<percentile(engineResults.tripSeconds, 0.50) * 1e6
+                 <<std::setw(12)<<percentile(engineResults.tripSeconds, 0.99) * 1e6
+                 <<std::setprecision(0)
+                 <<std::setw(14)<<(totalSeconds > 0.0 ? engineResults.tripSeconds.size() / totalSeconds : 0.0)
+                 <<std::setw(10)<<engineResults.wrongTrips<<"\n";
+        anyWrong = anyWrong || engineResults.wrongTrips != 0;
+    };
+
+    for(unsigned int e = 0; e < engines.size(); ++e)
+    {
+        writeResults(engines[e].name, results[e]);
+    }
+    if(checkClosures)
+    {
+        writeResults("closures", closureResults);
+    }
+    if(checkProfiles)
+    {
+        writeResults("profiles", profileResults);
+    }
+
+    if(checkConnectivity)
+    {
+        std::cout<<"\nconnectivity: "<<connectivityResults.checks<<" checks, "
+                 <<connectivityResults.wrong<<" wrong; strong connectivity took "<<std::setprecision(1)
+                 <<connectivityResults.parallelSeconds * 1e3<<" ms in parallel and "
+                 <<connectivityResults.digraphSeconds * 1e3<<" ms with Digraph\n";
+        anyWrong = anyWrong || connectivityResults.wrong != 0;
+    }
+
+    if(checkMatrices)
+    {
+        std::cout<<(checkConnectivity ? "" : "\n")<<"matrix: "<<matrixResults.entries<<" entries, "
+                 <<matrixResults.wrong<<" wrong; the matrices took "<<std::setprecision(1)
+                 <<matrixResults.matrixSeconds * 1e3<<" ms and one search per source "
+                 <<matrixResults.digraphSeconds * 1e3<<" ms\n";
+        anyWrong = anyWrong || matrixResults.wrong != 0;
+    }
+
+    return anyWrong ? 1 : 0;
+}
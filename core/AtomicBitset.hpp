@@ -0,0 +1,94 @@
+// AtomicBitset.hpp
+//
+// ICS 46 Winter 2019
+// Project #4: Rock and Roll Stops the Traffic
+//
+// An AtomicBitset is a fixed-size set of bits that many threads can set at
+// the same time without locking.  It's meant for "visited" marks in
+// parallel graph traversals: testAndSet() tells exactly one of the threads
+// racing to mark a vertex that it got there first.
+
+#ifndef ATOMICBITSET_HPP
+#define ATOMICBITSET_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+
+
+class AtomicBitset
+{
+public:
+    // Initializes an AtomicBitset holding the given number of bits, all
+    // of which are initially clear.
+    explicit AtomicBitset(int size);
+
+    // size() returns the number of bits in the set.
+    int size() const noexcept;
+
+    // test() returns true if the given bit is set.
+    bool test(int bit) const;
+
+    // testAndSet() sets the given bit, returning true if this call is the
+    // one that changed it from clear to set.
+    bool testAndSet(int bit);
+
+    // clear() clears every bit.  It is not safe to call while other
+    // threads are using the set.
+    void clear();
+
+
+private:
+    int bitCount;
+    int wordCount;
+    std::unique_ptr<std::atomic<std::uint64_t>[]> words;
+};
+
+
+
+inline AtomicBitset::AtomicBitset(int size)
+    : bitCount{size},
+      wordCount{(size + 63) / 64},
+      words{new std::atomic<std::uint64_t>[(size + 63) / 64]}
+{
+    clear();
+}
+
+
+inline int AtomicBitset::size() const noexcept
+{
+    return bitCount;
+}
+
+
+inline bool AtomicBitset::test(int bit) const
+{
+    return (words[bit / 64].load(std::memory_order_relaxed) >> (bit % 64)) & 1;
+}
+
+
+inline bool AtomicBitset::testAndSet(int bit)
+{
+    std::uint64_t mask = std::uint64_t{1} << (bit % 64);
+
+    //checking first avoids a locked instruction when the bit is already set
+    if(words[bit / 64].load(std::memory_order_relaxed) & mask)
+    {
+        return false;
+    }
+    return (words[bit / 64].fetch_or(mask, std::memory_order_relaxed) & mask) == 0;
+}
+
+
+inline void AtomicBitset::clear()
+{
+    for(int i = 0; i < wordCount; ++i)
+    {
+        words[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+
+
+#endif // ATOMICBITSET_HPP
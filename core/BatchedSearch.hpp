@@ -0,0 +1,287 @@
+// BatchedSearch.hpp
+//
+// ICS 46 Winter 2019
+// Project #4: Rock and Roll Stops the Traffic
+//
+// findShortestPathsBatched() runs up to BatchedSearchLanes single-source
+// shortest path searches over a CompactDigraph<double> at the same time.
+// Each search is a "lane"; every vertex stores one tentative distance and
+// one predecessor per lane, interleaved so that all of a vertex's lanes
+// sit next to each other in memory.  Relaxing an edge then updates every
+// lane with a handful of vector instructions, and the adjacency lists are
+// walked once for the whole batch instead of once per search.
+//
+// The search is label-correcting: a vertex is scanned again whenever any
+// of its lanes improves, and vertices are scanned in order of their
+// smallest improved distance so that, in practice, most vertices are
+// scanned only once or twice.  Because edge weights are never negative,
+// each lane ends with exactly the distances Dijkstra's algorithm finds.
+//
+// On x86 processors that support AVX2 (checked at run time), the
+// relaxation uses 256-bit vector min/compare operations; everywhere else,
+// an equivalent scalar loop is used instead.
+
+#ifndef BATCHEDSEARCH_HPP
+#define BATCHEDSEARCH_HPP
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <utility>
+#include <vector>
+#include "CompactDigraph.hpp"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BATCHEDSEARCH_HAVE_AVX2 1
+#include <immintrin.h>
+#endif
+
+
+
+// The number of searches run together by findShortestPathsBatched().
+constexpr int BatchedSearchLanes = 8;
+
+
+
+// BatchedShortestPaths holds the results of one batched search.  For a
+// vertex with index v and a lane l, distance(l, v) is the length of the
+// shortest path from that lane's start vertex to v (positive infinity if
+// v was never reached) and predecessor(l, v) is the index of the vertex
+// before v on that path (v itself if v is the start vertex or was never
+// reached).
+
+struct BatchedShortestPaths
+{
+    int laneCount = 0;
+    std::vector<double> distances;
+    std::vector<int> predecessors;
+
+    double distance(int lane, int vertex) const
+    {
+        return distances[vertex * BatchedSearchLanes + lane];
+    }
+
+    int predecessor(int lane, int vertex) const
+    {
+        return predecessors[vertex * BatchedSearchLanes + lane];
+    }
+};
+
+
+// findShortestPathsBatched() searches from each of the given vertex
+// indexes (at most BatchedSearchLanes of them), one per lane, in the
+// order given.  The same vertex may be given more than once.
+inline BatchedShortestPaths findShortestPathsBatched(
+    const CompactDigraph<double>& graph,
+    const std::vector<int>& startIndexes);
+
+
+// batchedSearchUsesAvx2() returns true if findShortestPathsBatched()
+// will use the AVX2 kernel on this machine.
+inline bool batchedSearchUsesAvx2();
+
+
+
+namespace BatchedSearchDetail
+{
+    // A relaxation kernel scans every outgoing edge of vertex "from",
+    // updating the distances and predecessors of the vertices they point
+    // to.  For each vertex that improves in at least one lane, it appends
+    // (smallest improved distance, vertex) to "improved".
+    typedef void (*RelaxFunc)(
+        const CompactDigraph<double>& graph, int from,
+        double* distances, int* predecessors,
+        std::vector<std::pair<double, int>>& improved);
+
+
+    inline void relaxScalar(
+        const CompactDigraph<double>& graph, int from,
+        double* distances, int* predecessors,
+        std::vector<std::pair<double, int>>& improved)
+    {
+        const double* fromDistances = distances + from * BatchedSearchLanes;
+
+        for(int edge = graph.edgesBegin(from); edge < graph.edgesEnd(from); ++edge)
+        {
+            int to = graph.target(edge);
+            double weight = graph.weight(edge);
+            double* toDistances = distances + to * BatchedSearchLanes;
+            int* toPredecessors = predecessors + to * BatchedSearchLanes;
+
+            double smallest = std::numeric_limits<double>::infinity();
+            for(int lane = 0; lane < BatchedSearchLanes; ++lane)
+            {
+                double candidate = fromDistances[lane] + weight;
+                if(candidate < toDistances[lane])
+                {
+                    toDistances[lane] = candidate;
+                    toPredecessors[lane] = from;
+                    smallest = std::min(smallest, candidate);
+                }
+            }
+
+            if(smallest != std::numeric_limits<double>::infinity())
+            {
+                improved.push_back({smallest, to});
+            }
+        }
+    }
+
+
+#ifdef BATCHEDSEARCH_HAVE_AVX2
+    __attribute__((target("avx2")))
+    inline void relaxAvx2(
+        const CompactDigraph<double>& graph, int from,
+        double* distances, int* predecessors,
+        std::vector<std::pair<double, int>>& improved)
+    {
+        //eight doubles are two 256-bit registers
+        const double* fromDistances = distances + from * BatchedSearchLanes;
+        __m256d fromLow = _mm256_loadu_pd(fromDistances);
+        __m256d fromHigh = _mm256_loadu_pd(fromDistances + 4);
+
+        for(int edge = graph.edgesBegin(from); edge < graph.edgesEnd(from); ++edge)
+        {
+            int to = graph.target(edge);
+            __m256d weight = _mm256_set1_pd(graph.weight(edge));
+            double* toDistances = distances + to * BatchedSearchLanes;
+
+            __m256d candidateLow = _mm256_add_pd(fromLow, weight);
+            __m256d candidateHigh = _mm256_add_pd(fromHigh, weight);
+            __m256d currentLow = _mm256_loadu_pd(toDistances);
+            __m256d currentHigh = _mm256_loadu_pd(toDistances + 4);
+
+            int mask =
+                _mm256_movemask_pd(_mm256_cmp_pd(candidateLow, currentLow, _CMP_LT_OQ)) |
+                (_mm256_movemask_pd(_mm256_cmp_pd(candidateHigh, currentHigh, _CMP_LT_OQ)) << 4);
+
+            if(mask == 0)
+            {
+                continue;
+            }
+
+            _mm256_storeu_pd(toDistances, _mm256_min_pd(candidateLow, currentLow));
+            _mm256_storeu_pd(toDistances + 4, _mm256_min_pd(candidateHigh, currentHigh));
+
+            //improvements are rare compared to relaxations, so the
+            //predecessors and the heap key are fixed up one lane at a time
+            int* toPredecessors = predecessors + to * BatchedSearchLanes;
+            double smallest = std::numeric_limits<double>::infinity();
+            for(int lane = 0; lane < BatchedSearchLanes; ++lane)
+            {
+                if(mask & (1 << lane))
+                {
+                    toPredecessors[lane] = from;
+                    smallest = std::min(smallest, toDistances[lane]);
+                }
+            }
+
+            improved.push_back({smallest, to});
+        }
+    }
+#endif
+
+
+    inline RelaxFunc chooseRelaxFunc()
+    {
+#ifdef BATCHEDSEARCH_HAVE_AVX2
+        if(__builtin_cpu_supports("avx2"))
+        {
+            return relaxAvx2;
+        }
+#endif
+        return relaxScalar;
+    }
+}
+
+
+
+inline bool batchedSearchUsesAvx2()
+{
+#ifdef BATCHEDSEARCH_HAVE_AVX2
+    return BatchedSearchDetail::chooseRelaxFunc() != BatchedSearchDetail::relaxScalar;
+#else
+    return false;
+#endif
+}
+
+
+inline BatchedShortestPaths findShortestPathsBatched(
+    const CompactDigraph<double>& graph,
+    const std::vector<int>& startIndexes)
+{
+    static const BatchedSearchDetail::RelaxFunc relax = BatchedSearchDetail::chooseRelaxFunc();
+
+    if(startIndexes.size() > static_cast<unsigned int>(BatchedSearchLanes))
+    {
+        throw DigraphException("Too many start vertices for one batch");
+    }
+
+    const int vertexCount = graph.vertexCount();
+
+    BatchedShortestPaths result;
+    result.laneCount = startIndexes.size();
+    result.distances.assign(
+        static_cast<std::size_t>(vertexCount) * BatchedSearchLanes,
+        std::numeric_limits<double>::infinity());
+    result.predecessors.resize(static_cast<std::size_t>(vertexCount) * BatchedSearchLanes);
+
+    for(int vertex = 0; vertex < vertexCount; ++vertex)
+    {
+        std::fill_n(result.predecessors.begin() + vertex * BatchedSearchLanes,
+                    BatchedSearchLanes, vertex);
+    }
+
+    //heap of (smallest improved distance, vertex); a vertex may be in the
+    //heap more than once, but it's only scanned while it's marked dirty
+    std::vector<std::pair<double, int>> heap;
+    std::vector<char> dirty(vertexCount, 0);
+    std::greater<std::pair<double, int>> heapOrder;
+
+    for(int lane = 0; lane < result.laneCount; ++lane)
+    {
+        int start = startIndexes[lane];
+        if(start < 0 || start >= vertexCount)
+        {
+            throw DigraphException("Invalid Vertex");
+        }
+
+        result.distances[start * BatchedSearchLanes + lane] = 0.0;
+        if(!dirty[start])
+        {
+            dirty[start] = 1;
+            heap.push_back({0.0, start});
+        }
+    }
+
+    std::vector<std::pair<double, int>> improved;
+
+    while(!heap.empty())
+    {
+        std::pop_heap(heap.begin(), heap.end(), heapOrder);
+        int current = heap.back().second;
+        heap.pop_back();
+
+        if(!dirty[current])
+        {
+            continue;
+        }
+        dirty[current] = 0;
+
+        relax(graph, current, result.distances.data(), result.predecessors.data(), improved);
+
+        for(const std::pair<double, int>& entry : improved)
+        {
+            dirty[entry.second] = 1;
+            heap.push_back(entry);
+            std::push_heap(heap.begin(), heap.end(), heapOrder);
+        }
+        improved.clear();
+    }
+
+    return result;
+}
+
+
+
+#endif // BATCHEDSEARCH_HPP
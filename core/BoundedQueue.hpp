@@ -0,0 +1,134 @@
+// BoundedQueue.hpp
+//
+// ICS 46 Winter 2019
+// Project #4: Rock and Roll Stops the Traffic
+//
+// A BoundedQueue is a first-in, first-out queue with a fixed capacity that
+// connects a thread producing values to a thread consuming them.  A
+// producer that gets too far ahead waits for room, so the amount of
+// memory in use stays constant no matter how many values pass through.
+// When the producer is finished, it closes the queue; the consumer then
+// drains whatever is left and is told there's nothing more coming.
+
+#ifndef BOUNDEDQUEUE_HPP
+#define BOUNDEDQUEUE_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <utility>
+
+
+
+template <typename T>
+class BoundedQueue
+{
+public:
+    // Initializes an empty BoundedQueue that holds at most the given
+    // number of values at once.
+    explicit BoundedQueue(std::size_t capacity);
+
+    // push() adds a value to the back of the queue, first waiting until
+    // there is room for it, and returns true.  Values pushed after close()
+    // are discarded, and push() returns false, so that a producer can stop
+    // once the consumer has given up.
+    bool push(T value);
+
+    // pop() waits until the queue is non-empty or closed.  If there is a
+    // value, it's removed from the front of the queue and stored into
+    // "value", and pop() returns true; if the queue is closed and empty,
+    // pop() returns false.
+    bool pop(T& value);
+
+    // tryPop() is like pop(), except that it never waits: it returns
+    // false right away if the queue is empty.
+    bool tryPop(T& value);
+
+    // close() tells the consumer that no more values are coming, or the
+    // producer that no more values are wanted.
+    void close();
+
+
+private:
+    std::size_t capacity;
+    std::deque<T> values;
+    bool closed = false;
+    std::mutex mutex;
+    std::condition_variable notEmpty;
+    std::condition_variable notFull;
+};
+
+
+
+template <typename T>
+BoundedQueue<T>::BoundedQueue(std::size_t capacity)
+    : capacity{capacity == 0 ? 1 : capacity}
+{
+}
+
+
+template <typename T>
+bool BoundedQueue<T>::push(T value)
+{
+    std::unique_lock<std::mutex> lock{mutex};
+    notFull.wait(lock, [this]{ return closed || values.size() < capacity; });
+
+    if(closed)
+    {
+        return false;
+    }
+
+    values.push_back(std::move(value));
+    notEmpty.notify_one();
+    return true;
+}
+
+
+template <typename T>
+bool BoundedQueue<T>::pop(T& value)
+{
+    std::unique_lock<std::mutex> lock{mutex};
+    notEmpty.wait(lock, [this]{ return closed || !values.empty(); });
+
+    if(values.empty())
+    {
+        return false;
+    }
+
+    value = std::move(values.front());
+    values.pop_front();
+    notFull.notify_one();
+    return true;
+}
+
+
+template <typename T>
+bool BoundedQueue<T>::tryPop(T& value)
+{
+    std::lock_guard<std::mutex> lock{mutex};
+
+    if(values.empty())
+    {
+        return false;
+    }
+
+    value = std::move(values.front());
+    values.pop_front();
+    notFull.notify_one();
+    return true;
+}
+
+
+template <typename T>
+void BoundedQueue<T>::close()
+{
+    std::lock_guard<std::mutex> lock{mutex};
+    closed = true;
+    notEmpty.notify_all();
+    notFull.notify_all();
+}
+
+
+
+#endif // BOUNDEDQUEUE_HPP
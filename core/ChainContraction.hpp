@@ -0,0 +1,630 @@
+// ChainContraction.hpp
+//
+// ICS 46 Winter 2019
+// Project #4: Rock and Roll Stops the Traffic
+//
+// Road maps are full of vertices that aren't really intersections: a bend
+// in the road, a town line, a mile marker.  Such a vertex connects exactly
+// two others, and a search gains nothing by stopping there.  A
+// ChainContraction finds the runs of them ("chains") in a CompactDigraph
+// and replaces each run by a single composite edge from one end to the
+// other (one in each direction, for a two-way road), so that searches
+// over the contracted graph have far fewer vertices to settle.
+//
+// A vertex is contracted if it is
+//
+//   * on a one-way road: one edge in, from u, and one edge out, to w; or
+//   * on a two-way road: edges to and from u and w, and no others;
+//
+// where u and w are two different vertices other than itself.  Every
+// other vertex is "kept".  (A loop made only of such vertices keeps one of
+// them.)
+//
+// The ChainContraction itself only records which vertices were kept and
+// which edges each composite edge stands for, so one of them serves any
+// number of weightings of the same graph: contract() builds the contracted
+// CompactDigraph for a given weighting, with each composite edge weighing
+// the sum of the edges it stands for.  findShortestPath() then answers a
+// query between any two vertices -- kept or not -- over the contracted
+// graph, and expands the result back into a path over the original one.
+
+#ifndef CHAINCONTRACTION_HPP
+#define CHAINCONTRACTION_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+#include "CompactDigraph.hpp"
+#include "SearchWorkspace.hpp"
+
+
+
+class ChainContraction
+{
+public:
+    // The default constructor initializes a ChainContraction of an empty
+    // graph.
+    ChainContraction();
+
+    // This constructor finds the chains in the given graph.  Only its
+    // edges, not its weights, are looked at.
+    template <typename Weight>
+    explicit ChainContraction(const CompactDigraph<Weight>& graph);
+
+    // vertexCount() returns the number of vertices in the original graph,
+    // and keptVertexCount() the number of them that were kept.
+    int vertexCount() const noexcept;
+    int keptVertexCount() const noexcept;
+
+    // kept() returns true if the vertex with the given index in the
+    // original graph was kept.
+    bool kept(int index) const;
+
+    // byteCount() returns the number of bytes used to store the chains and
+    // the contracted graph's edges (but not the contracted graphs made by
+    // contract(), which belong to the caller).
+    std::size_t byteCount() const noexcept;
+
+    // contract() builds the contracted graph for the given weighting of
+    // the original graph (which must have the same edges as the one this
+    // ChainContraction was built from).  Its vertex numbers are the same
+    // as the original's.
+    template <typename Weight>
+    CompactDigraph<Weight> contract(const CompactDigraph<Weight>& graph) const;
+
+    // findShortestPath() stores the vertex indexes (in the original graph)
+    // along a shortest path from startIndex to endIndex into "path", or
+    // leaves it empty if the end vertex can't be reached.  "contracted"
+    // must be contract(graph), and the workspace is used for the search
+    // over it.
+    template <typename Weight>
+    void findShortestPath(
+        const CompactDigraph<Weight>& graph, const CompactDigraph<Weight>& contracted,
+        int startIndex, int endIndex,
+        SearchWorkspace<Weight>& workspace, std::vector<int>& path) const;
+
+
+private:
+    template <typename Weight>
+    void addChain(const CompactDigraph<Weight>& graph, int start, int firstEdge);
+
+    bool twoWay(int chain) const;
+    int chainLength(int chain) const;
+    int chainVertex(int chain, int position) const;
+
+    // forwardLength() sums the weights along a chain from one position to
+    // a later one; backwardLength() from one position to an earlier one,
+    // against the direction of the chain.
+    template <typename Weight>
+    Weight forwardLength(const CompactDigraph<Weight>& graph, int chain, int from, int to) const;
+
+    template <typename Weight>
+    Weight backwardLength(const CompactDigraph<Weight>& graph, int chain, int from, int to) const;
+
+    // appendWalk() adds the vertices along a chain after position "from"
+    // up to and including position "to", in either direction.
+    void appendWalk(int chain, int from, int to, std::vector<int>& path) const;
+
+    // For each vertex of the original graph: its index in the contracted
+    // graph if it was kept (-1 if not), and, if it wasn't, the chain it
+    // belongs to and its position along it.
+    std::vector<int> contractedIndexes;
+    std::vector<int> chainOf;
+    std::vector<int> positionOf;
+
+    std::vector<int> keptVertices;
+
+    // The contracted graph's edges, laid out as in a CompactDigraph; each
+    // stands for the original edges pieceEdges[pieceBegin[e]] through
+    // pieceEdges[pieceBegin[e + 1] - 1], in order.
+    std::vector<int> offsets;
+    std::vector<int> targets;
+    std::vector<int> pieceBegin;
+    std::vector<int> pieceEdges;
+
+    // The vertices of chain c, from one kept end to the other, are at
+    // positions chainBegin[c] through chainBegin[c + 1] - 1 of
+    // chainVertices.  At the same position, chainForward holds the edge
+    // to the next vertex, and chainBackward the edge from the next vertex
+    // back (or -1 on a one-way road).
+    std::vector<int> chainBegin;
+    std::vector<int> chainVertices;
+    std::vector<int> chainForward;
+    std::vector<int> chainBackward;
+};
+
+
+
+inline ChainContraction::ChainContraction()
+    : offsets{0}, pieceBegin{0}, chainBegin{0}
+{
+}
+
+
+template <typename Weight>
+ChainContraction::ChainContraction(const CompactDigraph<Weight>& graph)
+    : ChainContraction()
+{
+    int vertexCount = graph.vertexCount();
+    CompactDigraph<Weight> reverse = graph.reversed();
+
+    std::vector<bool> keep(vertexCount);
+    for(int vertex = 0; vertex < vertexCount; ++vertex)
+    {
+        int outBegin = graph.edgesBegin(vertex);
+        int inBegin = reverse.edgesBegin(vertex);
+        int outCount = graph.edgesEnd(vertex) - outBegin;
+        int inCount = reverse.edgesEnd(vertex) - inBegin;
+        bool contractible = false;
+
+        if(outCount == 1 && inCount == 1)
+        {
+            int from = reverse.target(inBegin);
+            int to = graph.target(outBegin);
+            contractible = from != to && from != vertex && to != vertex;
+        }
+        else if(outCount == 2 && inCount == 2)
+        {
+            int out1 = graph.target(outBegin);
+            int out2 = graph.target(outBegin + 1);
+            int in1 = reverse.target(inBegin);
+            int in2 = reverse.target(inBegin + 1);
+            contractible = out1 != out2 && out1 != vertex && out2 != vertex &&
+                ((out1 == in1 && out2 == in2) || (out1 == in2 && out2 == in1));
+        }
+
+        keep[vertex] = !contractible;
+    }
+
+    chainOf.assign(vertexCount, -1);
+    positionOf.assign(vertexCount, -1);
+    contractedIndexes.assign(vertexCount, -1);
+
+    //contractedIndexes marks the kept vertices while the chains are found
+    auto walkFrom = [&](int start)
+    {
+        for(int edge = graph.edgesBegin(start); edge < graph.edgesEnd(start); ++edge)
+        {
+            int next = graph.target(edge);
+            if(contractedIndexes[next] == -1 && chainOf[next] == -1)
+            {
+                addChain(graph, start, edge);
+            }
+        }
+    };
+
+    for(int vertex = 0; vertex < vertexCount; ++vertex)
+    {
+        if(keep[vertex])
+        {
+            contractedIndexes[vertex] = 0;
+        }
+    }
+    for(int vertex = 0; vertex < vertexCount; ++vertex)
+    {
+        if(keep[vertex])
+        {
+            walkFrom(vertex);
+        }
+    }
+
+    //whatever's left is on loops with nothing kept, so one vertex of each
+    //is kept after all
+    for(int vertex = 0; vertex < vertexCount; ++vertex)
+    {
+        if(contractedIndexes[vertex] == -1 && chainOf[vertex] == -1)
+        {
+            contractedIndexes[vertex] = 0;
+            walkFrom(vertex);
+        }
+    }
+
+    for(int vertex = 0; vertex < vertexCount; ++vertex)
+    {
+        if(contractedIndexes[vertex] != -1)
+        {
+            contractedIndexes[vertex] = keptVertices.size();
+            keptVertices.push_back(vertex);
+        }
+    }
+
+    //each edge out of a kept vertex is either an edge of the contracted
+    //graph as it is, or the first edge of a chain (in one direction or
+    //the other)
+    for(int vertex : keptVertices)
+    {
+        for(int edge = graph.edgesBegin(vertex); edge < graph.edgesEnd(vertex); ++edge)
+        {
+            int next = graph.target(edge);
+            int chain = chainOf[next];
+
+            if(chain == -1)
+            {
+                targets.push_back(contractedIndexes[next]);
+                pieceEdges.push_back(edge);
+            }
+            else if(chainForward[chainBegin[chain]] == edge)
+            {
+                int length = chainLength(chain);
+                targets.push_back(contractedIndexes[chainVertex(chain, length)]);
+                for(int position = 0; position < length; ++position)
+                {
+                    pieceEdges.push_back(chainForward[chainBegin[chain] + position]);
+                }
+            }
+            else
+            {
+                targets.push_back(contractedIndexes[chainVertex(chain, 0)]);
+                for(int position = chainLength(chain) - 1; position >= 0; --position)
+                {
+                    pieceEdges.push_back(chainBackward[chainBegin[chain] + position]);
+                }
+            }
+
+            pieceBegin.push_back(pieceEdges.size());
+        }
+
+        offsets.push_back(targets.size());
+    }
+}
+
+
+template <typename Weight>
+void ChainContraction::addChain(const CompactDigraph<Weight>& graph, int start, int firstEdge)
+{
+    int chain = chainBegin.size() - 1;
+    int begin = chainVertices.size();
+
+    chainVertices.push_back(start);
+    chainForward.push_back(firstEdge);
+
+    int previous = start;
+    int current = graph.target(firstEdge);
+
+    //a contracted vertex has only one way out that doesn't lead back
+    while(contractedIndexes[current] == -1)
+    {
+        chainOf[current] = chain;
+        positionOf[current] = chainVertices.size() - begin;
+        chainVertices.push_back(current);
+
+        int edge = graph.edgesBegin(current);
+        if(graph.target(edge) == previous)
+        {
+            ++edge;
+        }
+        chainForward.push_back(edge);
+
+        previous = current;
+        current = graph.target(edge);
+    }
+
+    chainVertices.push_back(current);
+    chainForward.push_back(-1);
+
+    //a two-way chain's first contracted vertex has two edges out
+    int first = chainVertices[begin + 1];
+    bool bothWays = graph.edgesEnd(first) - graph.edgesBegin(first) == 2;
+    for(unsigned int position = begin; position + 1 < chainVertices.size(); ++position)
+    {
+        chainBackward.push_back(
+            bothWays ? graph.findEdge(chainVertices[position + 1], chainVertices[position]) : -1);
+    }
+    chainBackward.push_back(-1);
+
+    chainBegin.push_back(chainVertices.size());
+}
+
+
+inline int ChainContraction::vertexCount() const noexcept
+{
+    return contractedIndexes.size();
+}
+
+
+inline int ChainContraction::keptVertexCount() const noexcept
+{
+    return keptVertices.size();
+}
+
+
+inline bool ChainContraction::kept(int index) const
+{
+    return contractedIndexes[index] != -1;
+}
+
+
+inline std::size_t ChainContraction::byteCount() const noexcept
+{
+    std::size_t ints = contractedIndexes.size() + chainOf.size() + positionOf.size()
+        + keptVertices.size() + offsets.size() + targets.size()
+        + pieceBegin.size() + pieceEdges.size()
+        + chainBegin.size() + chainVertices.size() + chainForward.size() + chainBackward.size();
+    return ints * sizeof(int);
+}
+
+
+inline bool ChainContraction::twoWay(int chain) const
+{
+    return chainBackward[chainBegin[chain]] != -1;
+}
+
+
+inline int ChainContraction::chainLength(int chain) const
+{
+    return chainBegin[chain + 1] - chainBegin[chain] - 1;
+}
+
+
+inline int ChainContraction::chainVertex(int chain, int position) const
+{
+    return chainVertices[chainBegin[chain] + position];
+}
+
+
+template <typename Weight>
+Weight ChainContraction::forwardLength(
+    const CompactDigraph<Weight>& graph, int chain, int from, int to) const
+{
+    Weight length{};
+    for(int position = from; position < to; ++position)
+    {
+        length += graph.weight(chainForward[chainBegin[chain] + position]);
+    }
+    return length;
+}
+
+
+template <typename Weight>
+Weight ChainContraction::backwardLength(
+    const CompactDigraph<Weight>& graph, int chain, int from, int to) const
+{
+    Weight length{};
+    for(int position = from - 1; position >= to; --position)
+    {
+        length += graph.weight(chainBackward[chainBegin[chain] + position]);
+    }
+    return length;
+}
+
+
+inline void ChainContraction::appendWalk(int chain, int from, int to, std::vector<int>& path) const
+{
+    if(from < to)
+    {
+        for(int position = from + 1; position <= to; ++position)
+        {
+            path.push_back(chainVertex(chain, position));
+        }
+    }
+    else
+    {
+        for(int position = from - 1; position >= to; --position)
+        {
+            path.push_back(chainVertex(chain, position));
+        }
+    }
+}
+
+
+template <typename Weight>
+CompactDigraph<Weight> ChainContraction::contract(const CompactDigraph<Weight>& graph) const
+{
+    std::vector<int> vertexNumbers;
+    vertexNumbers.reserve(keptVertices.size());
+    for(int vertex : keptVertices)
+    {
+        vertexNumbers.push_back(graph.vertexNumber(vertex));
+    }
+
+    std::vector<Weight> weights;
+    weights.reserve(targets.size());
+    for(unsigned int edge = 0; edge < targets.size(); ++edge)
+    {
+        Weight weight{};
+        for(int piece = pieceBegin[edge]; piece < pieceBegin[edge + 1]; ++piece)
+        {
+            weight += graph.weight(pieceEdges[piece]);
+        }
+        weights.push_back(weight);
+    }
+
+    return CompactDigraph<Weight>{std::move(vertexNumbers), offsets, targets, std::move(weights)};
+}
+
+
+template <typename Weight>
+void ChainContraction::findShortestPath(
+    const CompactDigraph<Weight>& graph, const CompactDigraph<Weight>& contracted,
+    int startIndex, int endIndex,
+    SearchWorkspace<Weight>& workspace, std::vector<int>& path) const
+{
+    path.clear();
+    if(startIndex == endIndex)
+    {
+        path.push_back(startIndex);
+        return;
+    }
+
+    //the kept vertices the search starts from, with the distance to each
+    //from the start vertex along its chain: the end of the chain, then the
+    //beginning if the chain is two-way
+    std::pair<int, Weight> sources[2];
+    int sourceCount = 0;
+    int startChain = chainOf[startIndex];
+    int startPosition = positionOf[startIndex];
+
+    if(startChain == -1)
+    {
+        sources[sourceCount++] = {contractedIndexes[startIndex], Weight{}};
+    }
+    else
+    {
+        int length = chainLength(startChain);
+        sources[sourceCount++] = {contractedIndexes[chainVertex(startChain, length)],
+                                  forwardLength(graph, startChain, startPosition, length)};
+        if(twoWay(startChain))
+        {
+            sources[sourceCount++] = {contractedIndexes[chainVertex(startChain, 0)],
+                                      backwardLength(graph, startChain, startPosition, 0)};
+        }
+    }
+
+    //likewise, the kept vertices from which the end vertex is reached,
+    //with the distance left to go: from the beginning of its chain, then
+    //from the end if the chain is two-way
+    std::pair<int, Weight> goals[2];
+    int goalCount = 0;
+    int endChain = chainOf[endIndex];
+    int endPosition = positionOf[endIndex];
+
+    if(endChain == -1)
+    {
+        goals[goalCount++] = {contractedIndexes[endIndex], Weight{}};
+    }
+    else
+    {
+        int length = chainLength(endChain);
+        goals[goalCount++] = {contractedIndexes[chainVertex(endChain, 0)],
+                              forwardLength(graph, endChain, 0, endPosition)};
+        if(twoWay(endChain))
+        {
+            goals[goalCount++] = {contractedIndexes[chainVertex(endChain, length)],
+                                  backwardLength(graph, endChain, length, endPosition)};
+        }
+    }
+
+    //both ends on the same chain can be joined without leaving it
+    bool found = false;
+    Weight best{};
+    int bestGoal = -1;
+
+    if(startChain != -1 && startChain == endChain)
+    {
+        if(startPosition < endPosition)
+        {
+            best = forwardLength(graph, startChain, startPosition, endPosition);
+            found = true;
+        }
+        else if(twoWay(startChain))
+        {
+            best = backwardLength(graph, startChain, startPosition, endPosition);
+            found = true;
+        }
+    }
+
+    workspace.prepare(contracted.vertexCount());
+    for(int i = 0; i < sourceCount; ++i)
+    {
+        int source = sources[i].first;
+        if(!workspace.reached(source) || sources[i].second < workspace.distance(source))
+        {
+            workspace.reach(source, sources[i].second, source);
+            workspace.push(sources[i].second, source);
+        }
+    }
+
+    while(!workspace.heapEmpty())
+    {
+        std::pair<Weight, int> top = workspace.pop();
+
+        int current = top.second;
+        if(top.first > workspace.distance(current))
+        {
+            continue;
+        }
+        if(found && !(top.first < best))
+        {
+            break;
+        }
+
+        for(int i = 0; i < goalCount; ++i)
+        {
+            if(goals[i].first == current && (!found || top.first + goals[i].second < best))
+            {
+                best = top.first + goals[i].second;
+                bestGoal = i;
+                found = true;
+            }
+        }
+
+        for(int edge = contracted.edgesBegin(current); edge < contracted.edgesEnd(current); ++edge)
+        {
+            int next = contracted.target(edge);
+            Weight candidate = top.first + contracted.weight(edge);
+
+            if(!workspace.reached(next) || candidate < workspace.distance(next))
+            {
+                workspace.reach(next, candidate, current);
+                workspace.push(candidate, next);
+            }
+        }
+    }
+
+    if(!found)
+    {
+        return;
+    }
+
+    path.push_back(startIndex);
+    if(bestGoal == -1)
+    {
+        appendWalk(startChain, startPosition, endPosition, path);
+        return;
+    }
+
+    //the kept vertices the path passes through, found backward from the
+    //goal it reached
+    thread_local std::vector<int> hops;
+    hops.clear();
+    for(int current = goals[bestGoal].first; ; current = workspace.predecessor(current))
+    {
+        hops.push_back(current);
+        if(workspace.predecessor(current) == current)
+        {
+            break;
+        }
+    }
+    std::reverse(hops.begin(), hops.end());
+
+    //out along the start vertex's chain to the source the path left from
+    if(startChain != -1)
+    {
+        bool forward = sources[0].first == hops.front() &&
+            sources[0].second == workspace.distance(hops.front());
+        appendWalk(startChain, startPosition, forward ? chainLength(startChain) : 0, path);
+    }
+
+    //across the contracted graph, expanding each edge taken; where there
+    //are several between the same two vertices, the search took the
+    //lightest
+    for(unsigned int i = 1; i < hops.size(); ++i)
+    {
+        int taken = -1;
+        for(int edge = contracted.edgesBegin(hops[i - 1]); edge < contracted.edgesEnd(hops[i - 1]); ++edge)
+        {
+            if(contracted.target(edge) == hops[i] &&
+               (taken == -1 || contracted.weight(edge) < contracted.weight(taken)))
+            {
+                taken = edge;
+            }
+        }
+
+        for(int piece = pieceBegin[taken]; piece < pieceBegin[taken + 1]; ++piece)
+        {
+            path.push_back(graph.target(pieceEdges[piece]));
+        }
+    }
+
+    //and in along the end vertex's chain
+    if(endChain != -1)
+    {
+        appendWalk(endChain, bestGoal == 0 ? 0 : chainLength(endChain), endPosition, path);
+    }
+}
+
+
+
+#endif // CHAINCONTRACTION_HPP
+
@@ -0,0 +1,296 @@
+// CompactDigraph.hpp
+//
+// ICS 46 Winter 2019
+// Project #4: Rock and Roll Stops the Traffic
+//
+// This header file declares a class template called CompactDigraph, which
+// is a read-only snapshot of a Digraph laid out in arrays (sometimes called
+// "compressed sparse row" form).  Every vertex is given a dense index from
+// 0 to vertexCount() - 1, and the outgoing edges of vertex i are stored
+// contiguously, so a search can walk an adjacency list without following
+// any pointers.
+//
+// Rather than keeping EdgeInfo objects around, a CompactDigraph stores a
+// precomputed weight for each edge, determined once (when the snapshot is
+// taken) by a function that takes an EdgeInfo object and returns a weight.
+// The type of those weights is the type parameter to the class template.
+
+#ifndef COMPACTDIGRAPH_HPP
+#define COMPACTDIGRAPH_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+#include "Digraph.hpp"
+
+
+
+template <typename Weight>
+class CompactDigraph
+{
+public:
+    // The default constructor initializes an empty CompactDigraph with
+    // no vertices and no edges.
+    CompactDigraph();
+
+    // This constructor takes a snapshot of the given Digraph, using the
+    // given function to turn each EdgeInfo object into a Weight.  Vertex
+    // indexes are assigned in increasing order of vertex number.  Edges
+    // pointing to vertices that are not in the Digraph are ignored.
+    template <typename VertexInfo, typename EdgeInfo, typename WeightFunc>
+    CompactDigraph(const Digraph<VertexInfo, EdgeInfo>& d, WeightFunc edgeWeightFunc);
+
+    // This constructor assembles a snapshot from its arrays: the vertex
+    // numbers of the vertices, in increasing order, and offsets, targets
+    // and weights laid out as described above (so offsets has one more
+    // element than vertexNumbers, and the outgoing edges of vertex i are
+    // at positions offsets[i] through offsets[i + 1] - 1 of the others).
+    CompactDigraph(std::vector<int> vertexNumbers, std::vector<int> offsets,
+                   std::vector<int> targets, std::vector<Weight> weights);
+
+    // vertexCount() returns the number of vertices in the snapshot.
+    int vertexCount() const noexcept;
+
+    // edgeCount() returns the number of edges in the snapshot.
+    int edgeCount() const noexcept;
+
+    // vertexNumber() returns the Digraph vertex number of the vertex with
+    // the given index.
+    int vertexNumber(int index) const;
+
+    // indexOf() returns the index of the vertex with the given Digraph
+    // vertex number.  If that vertex does not exist, a DigraphException
+    // is thrown instead.
+    int indexOf(int vertex) const;
+
+    // contains() returns true if the given Digraph vertex number is a
+    // vertex in the snapshot, false otherwise.
+    bool contains(int vertex) const;
+
+    // The outgoing edges of the vertex with index i are the edges whose
+    // edge indexes are in the range [edgesBegin(i), edgesEnd(i)).
+    int edgesBegin(int index) const;
+    int edgesEnd(int index) const;
+
+    // target() returns the index of the vertex that the edge with the
+    // given edge index points to.
+    int target(int edge) const;
+
+    // weight() returns the weight of the edge with the given edge index.
+    Weight weight(int edge) const;
+
+    // findEdge() returns the edge index of the edge pointing from the
+    // vertex with index "from" to the vertex with index "to", or -1 if
+    // there is no such edge.
+    int findEdge(int from, int to) const;
+
+    // reversed() returns a CompactDigraph with the same vertex indexes
+    // in which every edge points the other way.  Searching the reversed
+    // snapshot from a vertex finds shortest paths *to* that vertex.
+    CompactDigraph reversed() const;
+
+    // byteCount() returns the number of bytes used to store the snapshot.
+    std::size_t byteCount() const noexcept;
+
+    // estimateByteCount() returns the byteCount() of a snapshot of a
+    // Digraph with the given numbers of vertices and edges, so that the
+    // memory a snapshot will need can be known before it's taken.
+    static std::size_t estimateByteCount(int vertexCount, int edgeCount) noexcept;
+
+
+private:
+    std::vector<int> vertexNumbers;
+    std::vector<int> offsets;
+    std::vector<int> targets;
+    std::vector<Weight> weights;
+};
+
+
+
+template <typename Weight>
+CompactDigraph<Weight>::CompactDigraph()
+    : offsets{0}
+{
+}
+
+
+template <typename Weight>
+template <typename VertexInfo, typename EdgeInfo, typename WeightFunc>
+CompactDigraph<Weight>::CompactDigraph(
+    const Digraph<VertexInfo, EdgeInfo>& d, WeightFunc edgeWeightFunc)
+    : vertexNumbers{d.vertices()}
+{
+    //vertices() hands them back in increasing order, so indexOf() can
+    //binary search them
+    offsets.reserve(vertexNumbers.size() + 1);
+    targets.reserve(d.edgeCount());
+    weights.reserve(d.edgeCount());
+
+    offsets.push_back(0);
+
+    for(int vertex : vertexNumbers)
+    {
+        d.forEachOutgoingEdge(vertex,
+            [&](int toVertex, const EdgeInfo& einfo)
+            {
+                if(contains(toVertex))
+                {
+                    targets.push_back(indexOf(toVertex));
+                    weights.push_back(edgeWeightFunc(einfo));
+                }
+            });
+
+        offsets.push_back(targets.size());
+    }
+}
+
+
+template <typename Weight>
+CompactDigraph<Weight>::CompactDigraph(
+    std::vector<int> vertexNumbers, std::vector<int> offsets,
+    std::vector<int> targets, std::vector<Weight> weights)
+    : vertexNumbers{std::move(vertexNumbers)}, offsets{std::move(offsets)},
+      targets{std::move(targets)}, weights{std::move(weights)}
+{
+}
+
+
+template <typename Weight>
+int CompactDigraph<Weight>::vertexCount() const noexcept
+{
+    return vertexNumbers.size();
+}
+
+
+template <typename Weight>
+int CompactDigraph<Weight>::edgeCount() const noexcept
+{
+    return targets.size();
+}
+
+
+template <typename Weight>
+int CompactDigraph<Weight>::vertexNumber(int index) const
+{
+    return vertexNumbers[index];
+}
+
+
+template <typename Weight>
+int CompactDigraph<Weight>::indexOf(int vertex) const
+{
+    auto it = std::lower_bound(vertexNumbers.begin(), vertexNumbers.end(), vertex);
+    if(it==vertexNumbers.end() || *it!=vertex)
+    {
+        throw DigraphException("Invalid Vertex");
+    }
+
+    return it - vertexNumbers.begin();
+}
+
+
+template <typename Weight>
+bool CompactDigraph<Weight>::contains(int vertex) const
+{
+    return std::binary_search(vertexNumbers.begin(), vertexNumbers.end(), vertex);
+}
+
+
+template <typename Weight>
+int CompactDigraph<Weight>::edgesBegin(int index) const
+{
+    return offsets[index];
+}
+
+
+template <typename Weight>
+int CompactDigraph<Weight>::edgesEnd(int index) const
+{
+    return offsets[index + 1];
+}
+
+
+template <typename Weight>
+int CompactDigraph<Weight>::target(int edge) const
+{
+    return targets[edge];
+}
+
+
+template <typename Weight>
+Weight CompactDigraph<Weight>::weight(int edge) const
+{
+    return weights[edge];
+}
+
+
+template <typename Weight>
+int CompactDigraph<Weight>::findEdge(int from, int to) const
+{
+    for(int edge = offsets[from]; edge < offsets[from + 1]; ++edge)
+    {
+        if(targets[edge]==to)
+        {
+            return edge;
+        }
+    }
+
+    return -1;
+}
+
+
+template <typename Weight>
+std::size_t CompactDigraph<Weight>::byteCount() const noexcept
+{
+    return (vertexNumbers.size() + offsets.size() + targets.size()) * sizeof(int)
+        + weights.size() * sizeof(Weight);
+}
+
+
+template <typename Weight>
+std::size_t CompactDigraph<Weight>::estimateByteCount(int vertexCount, int edgeCount) noexcept
+{
+    std::size_t vertices = vertexCount;
+    std::size_t edges = edgeCount;
+    return (2 * vertices + 1 + edges) * sizeof(int) + edges * sizeof(Weight);
+}
+
+
+template <typename Weight>
+CompactDigraph<Weight> CompactDigraph<Weight>::reversed() const
+{
+    CompactDigraph<Weight> result;
+    result.vertexNumbers = vertexNumbers;
+    result.offsets.assign(vertexNumbers.size() + 1, 0);
+    result.targets.resize(targets.size());
+    result.weights.resize(weights.size());
+
+    //count the incoming edges of each vertex, then turn the counts
+    //into starting positions
+    for(int to : targets)
+    {
+        result.offsets[to + 1]++;
+    }
+    for(unsigned int i = 1; i < result.offsets.size(); ++i)
+    {
+        result.offsets[i] += result.offsets[i - 1];
+    }
+
+    std::vector<int> next(result.offsets.begin(), result.offsets.end() - 1);
+    for(int from = 0; from < vertexCount(); ++from)
+    {
+        for(int edge = offsets[from]; edge < offsets[from + 1]; ++edge)
+        {
+            int position = next[targets[edge]]++;
+            result.targets[position] = from;
+            result.weights[position] = weights[edge];
+        }
+    }
+
+    return result;
+}
+
+
+
+#endif // COMPACTDIGRAPH_HPP
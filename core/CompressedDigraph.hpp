@@ -0,0 +1,374 @@
+// CompressedDigraph.hpp
+//
+// ICS 46 Winter 2019
+// Project #4: Rock and Roll Stops the Traffic
+//
+// This header file declares a class template called CompressedDigraph,
+// which, like a CompactDigraph, is a read-only snapshot of a Digraph with
+// dense vertex indexes, but which squeezes its edges into as few bytes as
+// it can so that very large maps fit in memory.  Instead of a weight,
+// each edge keeps ValueCount unsigned integers, chosen when the snapshot
+// is taken by a function of its EdgeInfo object (e.g., a length and a
+// speed in fixed-point units), from which a search works out weights as
+// it goes.
+//
+// The outgoing edges of each vertex are stored as one block of bytes,
+// sorted by target.  Each target is stored as the difference from the
+// one before it (the first as the difference from the vertex itself), so
+// that on a map whose nearby locations have nearby numbers most of them
+// are small, and every number is written as a "varint": seven bits per
+// byte, with the high bit set on every byte but the last.  A typical road
+// segment fits in about six bytes, rather than the fifty or so a Digraph
+// spends on one.  Decoding happens on the fly in forEachEdge().
+//
+// findShortestPath() answers a point-to-point query over a
+// CompressedDigraph, the same way as its namesake in ShortestPath.hpp.
+
+#ifndef COMPRESSEDDIGRAPH_HPP
+#define COMPRESSEDDIGRAPH_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "Digraph.hpp"
+#include "SearchWorkspace.hpp"
+#include "ShortestPath.hpp"
+
+
+
+template <unsigned int ValueCount>
+class CompressedDigraph
+{
+public:
+    typedef std::array<std::uint32_t, ValueCount> EdgeValues;
+
+    // The default constructor initializes an empty CompressedDigraph with
+    // no vertices and no edges.
+    CompressedDigraph();
+
+    // This constructor takes a snapshot of the given Digraph, using the
+    // given function to turn each EdgeInfo object into an EdgeValues
+    // array.  Vertex indexes are assigned in increasing order of vertex
+    // number.  Edges pointing to vertices that are not in the Digraph are
+    // ignored.
+    template <typename VertexInfo, typename EdgeInfo, typename EncodeFunc>
+    CompressedDigraph(const Digraph<VertexInfo, EdgeInfo>& d, EncodeFunc encodeFunc);
+
+    // vertexCount() returns the number of vertices in the snapshot.
+    int vertexCount() const noexcept;
+
+    // edgeCount() returns the number of edges in the snapshot.
+    int edgeCount() const noexcept;
+
+    // vertexNumber() returns the Digraph vertex number of the vertex with
+    // the given index.
+    int vertexNumber(int index) const;
+
+    // indexOf() returns the index of the vertex with the given Digraph
+    // vertex number.  If that vertex does not exist, a DigraphException
+    // is thrown instead.
+    int indexOf(int vertex) const;
+
+    // contains() returns true if the given Digraph vertex number is a
+    // vertex in the snapshot, false otherwise.
+    bool contains(int vertex) const;
+
+    // forEachEdge() calls edgeFunc(target, values) for every edge
+    // outgoing from the vertex with the given index, in increasing order
+    // of target index.
+    template <typename EdgeFunc>
+    void forEachEdge(int index, EdgeFunc edgeFunc) const;
+
+    // byteCount() returns the number of bytes used to store the edges.
+    std::size_t byteCount() const noexcept;
+
+
+private:
+    // Vertex numbers are only stored if they aren't simply 0, 1, 2, ...,
+    // which is how RoadMapReader numbers them.
+    std::vector<int> vertexNumbers;
+    int vertices;
+    int edges;
+
+    std::vector<std::size_t> offsets;
+    std::vector<std::uint8_t> bytes;
+};
+
+
+
+// This overload of findShortestPath() searches a CompressedDigraph,
+// using the given function to turn each edge's EdgeValues into a double
+// weight.  It stores the vertex indexes along the shortest path from
+// startIndex to endIndex into "path", or leaves it empty if the end
+// vertex can't be reached.
+template <unsigned int ValueCount, typename WeightFunc>
+void findShortestPath(
+    const CompressedDigraph<ValueCount>& graph, WeightFunc weightFunc,
+    int startIndex, int endIndex,
+    SearchWorkspace<double>& workspace, std::vector<int>& path);
+
+
+
+namespace CompressedDigraphDetail
+{
+    inline void writeVarint(std::vector<std::uint8_t>& bytes, std::uint64_t value)
+    {
+        while(value >= 0x80)
+        {
+            bytes.push_back(static_cast<std::uint8_t>(value) | 0x80);
+            value >>= 7;
+        }
+        bytes.push_back(static_cast<std::uint8_t>(value));
+    }
+
+
+    inline std::uint64_t readVarint(const std::uint8_t*& p)
+    {
+        std::uint64_t value = 0;
+        int shift = 0;
+        while(*p & 0x80)
+        {
+            value |= static_cast<std::uint64_t>(*p++ & 0x7f) << shift;
+            shift += 7;
+        }
+        value |= static_cast<std::uint64_t>(*p++) << shift;
+        return value;
+    }
+
+
+    // The first target in a block can be below the vertex itself, so its
+    // difference is "zigzag" encoded: 0, -1, 1, -2, 2, ... become 0, 1, 2,
+    // 3, 4, ..., which keeps small negative differences small.
+    inline std::uint64_t zigzag(std::int64_t value)
+    {
+        return value < 0 ? (static_cast<std::uint64_t>(-(value + 1)) << 1) | 1
+                         : static_cast<std::uint64_t>(value) << 1;
+    }
+
+
+    inline std::int64_t unzigzag(std::uint64_t value)
+    {
+        return value & 1 ? -static_cast<std::int64_t>(value >> 1) - 1
+                         : static_cast<std::int64_t>(value >> 1);
+    }
+}
+
+
+
+template <unsigned int ValueCount>
+CompressedDigraph<ValueCount>::CompressedDigraph()
+    : vertices{0}, edges{0}, offsets{0}
+{
+}
+
+
+template <unsigned int ValueCount>
+template <typename VertexInfo, typename EdgeInfo, typename EncodeFunc>
+CompressedDigraph<ValueCount>::CompressedDigraph(
+    const Digraph<VertexInfo, EdgeInfo>& d, EncodeFunc encodeFunc)
+    : vertexNumbers{d.vertices()}, vertices{0}, edges{0}
+{
+    using namespace CompressedDigraphDetail;
+
+    vertices = vertexNumbers.size();
+
+    //the numbers are in increasing order, so they're 0, 1, 2, ... if and
+    //only if the last one is one less than the count
+    bool sequential = vertexNumbers.empty() ||
+        (vertexNumbers.front() == 0 && vertexNumbers.back() == vertices - 1);
+
+    offsets.reserve(vertices + 1);
+    offsets.push_back(0);
+
+    std::vector<std::pair<int, EdgeValues>> block;
+
+    for(int index = 0; index < vertices; ++index)
+    {
+        block.clear();
+        d.forEachOutgoingEdge(vertexNumbers[index],
+            [&](int toVertex, const EdgeInfo& einfo)
+            {
+                if(contains(toVertex))
+                {
+                    block.emplace_back(indexOf(toVertex), encodeFunc(einfo));
+                }
+            });
+
+        //only the targets need to be in order; ties keep their order
+        std::stable_sort(block.begin(), block.end(),
+            [](const std::pair<int, EdgeValues>& a, const std::pair<int, EdgeValues>& b)
+            {
+                return a.first < b.first;
+            });
+
+        writeVarint(bytes, block.size());
+        int previous = index;
+        for(unsigned int i = 0; i < block.size(); ++i)
+        {
+            if(i == 0)
+            {
+                writeVarint(bytes, zigzag(static_cast<std::int64_t>(block[i].first) - previous));
+            }
+            else
+            {
+                writeVarint(bytes, block[i].first - previous);
+            }
+            previous = block[i].first;
+
+            for(std::uint32_t value : block[i].second)
+            {
+                writeVarint(bytes, value);
+            }
+        }
+
+        edges += block.size();
+        offsets.push_back(bytes.size());
+    }
+
+    if(sequential)
+    {
+        vertexNumbers.clear();
+        vertexNumbers.shrink_to_fit();
+    }
+    bytes.shrink_to_fit();
+}
+
+
+template <unsigned int ValueCount>
+int CompressedDigraph<ValueCount>::vertexCount() const noexcept
+{
+    return vertices;
+}
+
+
+template <unsigned int ValueCount>
+int CompressedDigraph<ValueCount>::edgeCount() const noexcept
+{
+    return edges;
+}
+
+
+template <unsigned int ValueCount>
+int CompressedDigraph<ValueCount>::vertexNumber(int index) const
+{
+    return vertexNumbers.empty() ? index : vertexNumbers[index];
+}
+
+
+template <unsigned int ValueCount>
+int CompressedDigraph<ValueCount>::indexOf(int vertex) const
+{
+    if(!contains(vertex))
+    {
+        throw DigraphException("Invalid Vertex");
+    }
+
+    if(vertexNumbers.empty())
+    {
+        return vertex;
+    }
+    return std::lower_bound(vertexNumbers.begin(), vertexNumbers.end(), vertex)
+        - vertexNumbers.begin();
+}
+
+
+template <unsigned int ValueCount>
+bool CompressedDigraph<ValueCount>::contains(int vertex) const
+{
+    if(vertexNumbers.empty())
+    {
+        return vertex >= 0 && vertex < vertices;
+    }
+    return std::binary_search(vertexNumbers.begin(), vertexNumbers.end(), vertex);
+}
+
+
+template <unsigned int ValueCount>
+template <typename EdgeFunc>
+void CompressedDigraph<ValueCount>::forEachEdge(int index, EdgeFunc edgeFunc) const
+{
+    using namespace CompressedDigraphDetail;
+
+    const std::uint8_t* p = bytes.data() + offsets[index];
+    std::uint64_t count = readVarint(p);
+
+    int target = index;
+    EdgeValues values;
+
+    for(std::uint64_t i = 0; i < count; ++i)
+    {
+        if(i == 0)
+        {
+            target = static_cast<int>(index + unzigzag(readVarint(p)));
+        }
+        else
+        {
+            target += static_cast<int>(readVarint(p));
+        }
+
+        for(std::uint32_t& value : values)
+        {
+            value = static_cast<std::uint32_t>(readVarint(p));
+        }
+
+        edgeFunc(target, static_cast<const EdgeValues&>(values));
+    }
+}
+
+
+template <unsigned int ValueCount>
+std::size_t CompressedDigraph<ValueCount>::byteCount() const noexcept
+{
+    return bytes.size() + offsets.size() * sizeof(std::size_t)
+        + vertexNumbers.size() * sizeof(int);
+}
+
+
+
+template <unsigned int ValueCount, typename WeightFunc>
+void findShortestPath(
+    const CompressedDigraph<ValueCount>& graph, WeightFunc weightFunc,
+    int startIndex, int endIndex,
+    SearchWorkspace<double>& workspace, std::vector<int>& path)
+{
+    workspace.prepare(graph.vertexCount());
+    workspace.reach(startIndex, 0.0, startIndex);
+    workspace.push(0.0, startIndex);
+
+    while(!workspace.heapEmpty())
+    {
+        std::pair<double, int> top = workspace.pop();
+
+        int current = top.second;
+        if(top.first > workspace.distance(current))
+        {
+            continue;
+        }
+        if(current == endIndex)
+        {
+            break;
+        }
+
+        graph.forEachEdge(current,
+            [&](int next, const typename CompressedDigraph<ValueCount>::EdgeValues& values)
+            {
+                double candidate = top.first + weightFunc(values);
+
+                if(!workspace.reached(next) || candidate < workspace.distance(next))
+                {
+                    workspace.reach(next, candidate, current);
+                    workspace.push(candidate, next);
+                }
+            });
+    }
+
+    ShortestPathDetail::tracePath(workspace, startIndex, endIndex, path);
+}
+
+
+
+#endif // COMPRESSEDDIGRAPH_HPP
+
@@ -0,0 +1,349 @@
+// DeltaStepping.hpp
+//
+// ICS 46 Winter 2019
+// Project #4: Rock and Roll Stops the Traffic
+//
+// findShortestPathTreeParallel() computes a whole single-source shortest
+// path tree over a CompactDigraph with the "delta-stepping" algorithm,
+// which spreads the work of one search across several threads.  (The
+// findShortestPathTree() in ShortestPath.hpp is the one-thread Dijkstra's
+// algorithm, whose predecessors always match findShortestPath()'s.)
+// Where Dijkstra's algorithm settles one vertex at a time in order of
+// distance, delta-stepping groups vertices into buckets of width delta --
+// bucket i holds
+// the vertices whose tentative distance is in [i * delta, (i+1) * delta)
+// -- and settles a whole bucket at once, relaxing the edges of all of its
+// vertices in parallel:
+//
+//   * "Light" edges (weight <= delta) can lead back into the same bucket,
+//     so they're relaxed repeatedly until the bucket stops changing.
+//   * "Heavy" edges (weight > delta) can only lead to later buckets, so
+//     they're relaxed once, after the bucket is finished.
+//
+// A small delta behaves like Dijkstra's algorithm (little wasted work but
+// little parallelism); a large one behaves like Bellman-Ford (lots of
+// both).  Something near the typical edge weight, which averageEdgeWeight()
+// works out, is a good start.
+//
+// Distances come out exactly as Dijkstra's algorithm finds them.  Since
+// the order in which threads improve a vertex isn't fixed, predecessors
+// are chosen afterward from the final distances, so that they don't depend
+// on timing either: the predecessor of a vertex is the lowest-numbered
+// vertex index that is strictly closer to the start and along whose edge
+// its distance is achieved.  (Where that's only possible along edges of
+// weight 0, any vertex that keeps the predecessors a tree will do.)  So
+// the predecessors match Dijkstra's wherever shortest paths are unique.
+
+#ifndef DELTASTEPPING_HPP
+#define DELTASTEPPING_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <memory>
+#include <utility>
+#include <vector>
+#include "CompactDigraph.hpp"
+#include "ParallelFor.hpp"
+
+
+
+// A ShortestPathTree holds the results of a single-source search over a
+// CompactDigraph, indexed by vertex index: the length of the shortest path
+// to each vertex (infinity if it can't be reached), and its predecessor
+// on that path (the start vertex is its own predecessor; an unreachable
+// vertex's predecessor is -1).
+struct ShortestPathTree
+{
+    std::vector<double> distance;
+    std::vector<int> predecessor;
+};
+
+
+// findShortestPathTreeParallel() searches from the vertex with index
+// startIndex using delta-stepping with the given bucket width (which must
+// be positive), using up to threadCount threads (0 means one per hardware
+// thread).
+inline ShortestPathTree findShortestPathTreeParallel(
+    const CompactDigraph<double>& graph, int startIndex,
+    double delta, unsigned int threadCount = 0);
+
+
+// averageEdgeWeight() returns the average weight of the graph's edges, or
+// 1 if it has none (or they all weigh 0), for use as a delta.
+inline double averageEdgeWeight(const CompactDigraph<double>& graph);
+
+
+
+namespace DeltaSteppingDetail
+{
+    // Frontiers are handed out to threads in chunks of this many vertices,
+    // and a frontier smaller than this is processed on one thread rather
+    // than paying to start others.
+    const int chunkSize = 256;
+
+
+    // lowerTo() lowers an atomic distance to candidate if candidate is
+    // smaller, returning true if it did.
+    inline bool lowerTo(std::atomic<double>& distance, double candidate)
+    {
+        double current = distance.load(std::memory_order_relaxed);
+        while(candidate < current)
+        {
+            if(distance.compare_exchange_weak(current, candidate, std::memory_order_relaxed))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+
+    // forEachChunk() calls chunkFunc(begin, end, threadIndex) for chunks
+    // of [0, count), in parallel if there are enough of them.
+    template <typename ChunkFunc>
+    void forEachChunk(int count, unsigned int threadCount, ChunkFunc chunkFunc)
+    {
+        int chunks = (count + chunkSize - 1) / chunkSize;
+        parallelFor(chunks, chunks > 1 ? threadCount : 1,
+            [&](int chunk, unsigned int threadIndex)
+            {
+                int begin = chunk * chunkSize;
+                chunkFunc(begin, std::min(count, begin + chunkSize), threadIndex);
+            });
+    }
+}
+
+
+
+inline ShortestPathTree findShortestPathTreeParallel(
+    const CompactDigraph<double>& graph, int startIndex,
+    double delta, unsigned int threadCount)
+{
+    using DeltaSteppingDetail::forEachChunk;
+    using DeltaSteppingDetail::lowerTo;
+
+    const double infinity = std::numeric_limits<double>::infinity();
+    int vertexCount = graph.vertexCount();
+
+    if(threadCount == 0)
+    {
+        threadCount = defaultThreadCount();
+    }
+
+    std::unique_ptr<std::atomic<double>[]> distance{new std::atomic<double>[vertexCount]};
+    for(int vertex = 0; vertex < vertexCount; ++vertex)
+    {
+        distance[vertex].store(infinity, std::memory_order_relaxed);
+    }
+
+    //the last phase in which each vertex was put in a frontier, so that
+    //no frontier lists a vertex twice
+    std::unique_ptr<std::atomic<std::int64_t>[]> queuedIn{new std::atomic<std::int64_t>[vertexCount]};
+    for(int vertex = 0; vertex < vertexCount; ++vertex)
+    {
+        queuedIn[vertex].store(-1, std::memory_order_relaxed);
+    }
+    std::int64_t phase = 0;
+
+    auto bucketOf = [&](double value)
+    {
+        return static_cast<std::int64_t>(value / delta);
+    };
+
+    //buckets that aren't empty, by number; a vertex can be listed in a
+    //bucket it has since left, and is skipped when that bucket comes up
+    std::map<std::int64_t, std::vector<int>> buckets;
+
+    //each thread collects the vertices whose distances it lowered
+    std::vector<std::vector<int>> lowered(threadCount);
+
+    distance[startIndex].store(0.0, std::memory_order_relaxed);
+    buckets[0].push_back(startIndex);
+
+    std::vector<int> frontier;
+    std::vector<int> settledInBucket;
+
+    //relaxes the edges leaving the given vertices whose weights are on
+    //the chosen side of delta
+    auto relax = [&](const std::vector<int>& vertices, bool light)
+    {
+        forEachChunk(vertices.size(), threadCount,
+            [&](int begin, int end, unsigned int threadIndex)
+            {
+                for(int i = begin; i < end; ++i)
+                {
+                    int vertex = vertices[i];
+                    double base = distance[vertex].load(std::memory_order_relaxed);
+
+                    for(int edge = graph.edgesBegin(vertex); edge < graph.edgesEnd(vertex); ++edge)
+                    {
+                        double weight = graph.weight(edge);
+                        if((weight <= delta) == light &&
+                           lowerTo(distance[graph.target(edge)], base + weight))
+                        {
+                            lowered[threadIndex].push_back(graph.target(edge));
+                        }
+                    }
+                }
+            });
+    };
+
+    //moves what the threads lowered into the buckets, or into the next
+    //frontier if it landed back in the current bucket
+    auto collect = [&](std::int64_t current)
+    {
+        ++phase;
+        frontier.clear();
+        for(std::vector<int>& list : lowered)
+        {
+            for(int vertex : list)
+            {
+                std::int64_t bucket = bucketOf(distance[vertex].load(std::memory_order_relaxed));
+                if(bucket != current)
+                {
+                    buckets[bucket].push_back(vertex);
+                }
+                else if(queuedIn[vertex].exchange(phase, std::memory_order_relaxed) != phase)
+                {
+                    frontier.push_back(vertex);
+                }
+            }
+            list.clear();
+        }
+    };
+
+    while(!buckets.empty())
+    {
+        std::int64_t current = buckets.begin()->first;
+        std::vector<int> listed = std::move(buckets.begin()->second);
+        buckets.erase(buckets.begin());
+
+        //vertices that have since moved to an earlier bucket were already
+        //settled there
+        ++phase;
+        frontier.clear();
+        for(int vertex : listed)
+        {
+            if(bucketOf(distance[vertex].load(std::memory_order_relaxed)) == current &&
+               queuedIn[vertex].exchange(phase, std::memory_order_relaxed) != phase)
+            {
+                frontier.push_back(vertex);
+            }
+        }
+
+        settledInBucket.clear();
+        while(!frontier.empty())
+        {
+            settledInBucket.insert(settledInBucket.end(), frontier.begin(), frontier.end());
+            relax(frontier, true);
+            collect(current);
+        }
+
+        //a vertex may have gone through the frontier more than once, but
+        //its heavy edges only need relaxing from its final distance
+        std::sort(settledInBucket.begin(), settledInBucket.end());
+        settledInBucket.erase(
+            std::unique(settledInBucket.begin(), settledInBucket.end()), settledInBucket.end());
+
+        relax(settledInBucket, false);
+        collect(current);
+    }
+
+    ShortestPathTree tree;
+    tree.distance.resize(vertexCount);
+    for(int vertex = 0; vertex < vertexCount; ++vertex)
+    {
+        tree.distance[vertex] = distance[vertex].load(std::memory_order_relaxed);
+    }
+
+    //the lowest-numbered closer vertex along whose edge each distance is
+    //achieved; atomic because many vertices can offer themselves at once
+    std::unique_ptr<std::atomic<int>[]> chosen{new std::atomic<int>[vertexCount]};
+    for(int vertex = 0; vertex < vertexCount; ++vertex)
+    {
+        chosen[vertex].store(std::numeric_limits<int>::max(), std::memory_order_relaxed);
+    }
+
+    forEachChunk(vertexCount, threadCount,
+        [&](int begin, int end, unsigned int)
+        {
+            for(int vertex = begin; vertex < end; ++vertex)
+            {
+                for(int edge = graph.edgesBegin(vertex); edge < graph.edgesEnd(vertex); ++edge)
+                {
+                    int next = graph.target(edge);
+                    if(tree.distance[vertex] < tree.distance[next] &&
+                       tree.distance[vertex] + graph.weight(edge) == tree.distance[next])
+                    {
+                        int previous = chosen[next].load(std::memory_order_relaxed);
+                        while(vertex < previous &&
+                              !chosen[next].compare_exchange_weak(
+                                  previous, vertex, std::memory_order_relaxed))
+                        {
+                        }
+                    }
+                }
+            }
+        });
+
+    tree.predecessor.resize(vertexCount);
+    bool missing = false;
+    for(int vertex = 0; vertex < vertexCount; ++vertex)
+    {
+        int previous = chosen[vertex].load(std::memory_order_relaxed);
+        tree.predecessor[vertex] = previous == std::numeric_limits<int>::max() ? -1 : previous;
+        missing = missing ||
+            (tree.predecessor[vertex] == -1 && vertex != startIndex && tree.distance[vertex] != infinity);
+    }
+    tree.predecessor[startIndex] = startIndex;
+
+    //vertices reached only along edges of weight 0 are given predecessors
+    //by a breadth-first search out from the ones that already have them
+    if(missing)
+    {
+        std::vector<int> queue;
+        for(int vertex = 0; vertex < vertexCount; ++vertex)
+        {
+            if(tree.predecessor[vertex] != -1)
+            {
+                queue.push_back(vertex);
+            }
+        }
+
+        for(std::size_t head = 0; head < queue.size(); ++head)
+        {
+            int vertex = queue[head];
+            for(int edge = graph.edgesBegin(vertex); edge < graph.edgesEnd(vertex); ++edge)
+            {
+                int next = graph.target(edge);
+                if(tree.predecessor[next] == -1 &&
+                   tree.distance[vertex] + graph.weight(edge) == tree.distance[next])
+                {
+                    tree.predecessor[next] = vertex;
+                    queue.push_back(next);
+                }
+            }
+        }
+    }
+
+    return tree;
+}
+
+
+inline double averageEdgeWeight(const CompactDigraph<double>& graph)
+{
+    double total = 0.0;
+    for(int edge = 0; edge < graph.edgeCount(); ++edge)
+    {
+        total += graph.weight(edge);
+    }
+    return total > 0.0 ? total / graph.edgeCount() : 1.0;
+}
+
+
+
+#endif // DELTASTEPPING_HPP
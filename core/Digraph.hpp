@@ -20,14 +20,20 @@
 #ifndef DIGRAPH_HPP
 #define DIGRAPH_HPP
 
+#include <algorithm>
 #include <exception>
 #include <functional>
 #include <list>
 #include <map>
+#include <stdexcept>
+#include <string>
 #include <utility>
 #include <vector>
 #include <utility>
 #include <limits>
+#include "MemoryUsage.hpp"
+#include "ParallelFor.hpp"
+#include "SearchWorkspace.hpp"
 //#include <iostream>
 // DigraphExceptions are thrown from some of the member functions in the
 // Digraph class template, so that exception is declared here, so it
@@ -58,6 +64,7 @@ struct DigraphEdge
     int fromVertex;
     int toVertex;
     EdgeInfo einfo;
+    int toSlot;
 };
 
 
@@ -65,12 +72,14 @@ struct DigraphEdge
 // A DigraphVertex includes two things: a VertexInfo object and a list of
 // its outgoing edges.  Because different kinds of Digraphs store different
 // kinds of vertex and edge information, DigraphVertex is a struct template.
+// It also remembers its slot (see Digraph::slotOf()).
 
 template <typename VertexInfo, typename EdgeInfo>
 struct DigraphVertex
 {
     VertexInfo vinfo;
     std::list<DigraphEdge<EdgeInfo>> edges;
+    int slot;
 };
 
 
@@ -172,6 +181,51 @@ public:
     // thrown instead.
     void removeEdge(int fromVertex, int toVertex);
 
+    // updateEdge() replaces the EdgeInfo object belonging to the edge
+    // pointing from the given "from" vertex number to the given "to"
+    // vertex number.  If either of these vertices does not exist *or* if
+    // the edge is not present in the graph, a DigraphException is thrown
+    // instead.
+    void updateEdge(int fromVertex, int toVertex, const EdgeInfo& einfo);
+
+    // updateEdges() calls the given function on the EdgeInfo object of
+    // every edge pointing from the given "from" vertex number to the
+    // given "to" vertex number (there may be several), letting it change
+    // them in place, and returns how many there were.  If either vertex
+    // does not exist *or* there is no such edge, a DigraphException is
+    // thrown instead, and nothing is changed.
+    template <typename UpdateFunc>
+    int updateEdges(int fromVertex, int toVertex, UpdateFunc update);
+
+    // removeVertices() removes every vertex with one of the given vertex
+    // numbers, along with their incoming and outgoing edges, in a single
+    // pass over the graph rather than one pass per vertex.  If any of
+    // them does not exist, a DigraphException is thrown instead, and
+    // nothing is removed.
+    void removeVertices(const std::vector<int>& vertices);
+
+    // version() returns a number that changes whenever the Digraph does
+    // (i.e., whenever a vertex or edge is added, removed or updated), so
+    // that anything built from the Digraph can tell whether it's still
+    // up to date by remembering the version it was built from.
+    unsigned long version() const noexcept;
+
+    // memoryUsage() returns a breakdown of the memory the Digraph uses:
+    // the index from vertex numbers to vertices, the vertices and edges
+    // themselves (their allocations and links), the VertexInfo and
+    // EdgeInfo objects stored in them, and the slot table.  Memory that
+    // the VertexInfo and EdgeInfo objects own in turn isn't included.
+    MemoryUsage memoryUsage() const;
+
+    // estimateMemoryUsage() returns the breakdown memoryUsage() would
+    // report for a Digraph with the given numbers of vertices and edges,
+    // so that the memory a graph will need can be known before it's built.
+    static MemoryUsage estimateMemoryUsage(int vertexCount, int edgeCount);
+
+    // hasVertex() returns true if there is a vertex with the given vertex
+    // number, false otherwise.
+    bool hasVertex(int vertex) const;
+
     // vertexCount() returns the number of vertices in the graph.
     int vertexCount() const noexcept;
 
@@ -190,6 +244,13 @@ public:
     // false otherwise.
     bool isStronglyConnected() const;
 
+    // This overload of isStronglyConnected() does its work in the given
+    // workspace, so that a caller checking the graph again and again (as
+    // it changes, say) allocates nothing once the workspace is big enough.
+    // It follows each edge forward only, so it needs no list of incoming
+    // edges either.  The workspace's contents afterward are unspecified.
+    bool isStronglyConnected(SearchWorkspace<double>& workspace) const;
+
     // findShortestPaths() takes a start vertex number and a function
     // that takes an EdgeInfo object and determines an edge weight.
     // It uses Dijkstra's Shortest Path Algorithm to determine the
@@ -204,6 +265,74 @@ public:
         int startVertex,
         std::function<double(const EdgeInfo&)> edgeWeightFunc) const;
 
+    // This overload of findShortestPaths() does the same thing, but takes
+    // the edge weight function as a template parameter instead, so that
+    // a lambda or a weight policy object (such as the ones declared in
+    // RoadMapWeights.hpp) can be inlined into the search rather than
+    // being called through a std::function on every edge.
+    template <typename EdgeWeightFunc>
+    std::map<int, int> findShortestPaths(
+        int startVertex,
+        EdgeWeightFunc edgeWeightFunc) const;
+
+    // This overload of findShortestPaths() leaves its results in the
+    // given workspace instead of building a std::map, so that a caller
+    // running many searches allocates nothing once the workspace is big
+    // enough.  Afterward, for any vertex v with slot s = slotOf(v),
+    // workspace.reached(s) says whether v was reached,
+    // workspace.distance(s) is the length of the shortest path to it, and
+    // workspace.predecessor(s) is the vertex number of its predecessor
+    // (the start vertex is its own predecessor).
+    template <typename EdgeWeightFunc>
+    void findShortestPaths(
+        int startVertex,
+        EdgeWeightFunc edgeWeightFunc,
+        SearchWorkspace<double>& workspace) const;
+
+    // findReachable() finds every vertex whose shortest path from the
+    // start vertex is no longer than the given budget, returning pairs of
+    // its vertex number and the length of that path, in increasing order
+    // of length (so the start vertex comes first, at 0).  The search stops
+    // at the budget, so it only ever touches the vertices within it and
+    // the edges leaving them, and it does its work in the given workspace.
+    // If the start vertex does not exist, a DigraphException is thrown.
+    template <typename EdgeWeightFunc>
+    std::vector<std::pair<int, double>> findReachable(
+        int startVertex,
+        EdgeWeightFunc edgeWeightFunc,
+        double budget,
+        SearchWorkspace<double>& workspace) const;
+
+    // This overload of findReachable() does the same for each of the
+    // given start vertices, using up to threadCount threads (0 means one
+    // per hardware thread); element i of the result is for startVertices[i].
+    template <typename EdgeWeightFunc>
+    std::vector<std::vector<std::pair<int, double>>> findReachable(
+        const std::vector<int>& startVertices,
+        EdgeWeightFunc edgeWeightFunc,
+        double budget,
+        unsigned int threadCount = 0) const;
+
+    // slotOf() returns the slot of the given vertex: a number from 0 to
+    // slotCount() - 1 that no other vertex has, suitable for indexing
+    // arrays (such as a SearchWorkspace's).  Slots of removed vertices are
+    // reused by vertices added later.  If the given vertex does not
+    // exist, a DigraphException is thrown instead.
+    int slotOf(int vertex) const;
+
+    // slotCount() returns one more than the largest slot that any vertex
+    // has ever had, which is at least vertexCount().
+    int slotCount() const noexcept;
+
+    // forEachOutgoingEdge() calls the given function once for every edge
+    // outgoing from the given vertex number, passing it the "to" vertex
+    // number and the EdgeInfo object of that edge.  Unlike edges() and
+    // edgeInfo(), nothing is copied or searched for along the way, which
+    // makes this the cheap way to walk an adjacency list.  If the given
+    // vertex does not exist, a DigraphException is thrown instead.
+    template <typename EdgeFunc>
+    void forEachOutgoingEdge(int vertex, EdgeFunc edgeFunc) const;
+
 
 private:
     // Add whatever member variables you think you need here.  One
@@ -213,6 +342,12 @@ private:
     std::map<int,DigraphVertex<VertexInfo, EdgeInfo>*> mainMap;
     unsigned int vertexNum =0;
     unsigned int edgeNum =0;
+    unsigned long versionNum =0;
+
+    //the vertex in each slot (nullptr if the slot is free), and the slots
+    //that are free to be reused
+    std::vector<DigraphVertex<VertexInfo, EdgeInfo>*> slotVertices;
+    std::vector<int> freeSlots;
     // You can also feel free to add any additional member functions
     // you'd like (public or private), so long as you don't remove or
     // change the signatures of the ones that already exist.
@@ -241,13 +376,20 @@ template <typename VertexInfo, typename EdgeInfo>
 Digraph<VertexInfo, EdgeInfo>::Digraph(const Digraph& d)
 {
     
+    //every vertex keeps its slot, so the copied edges' slots stay right
+    slotVertices.assign(d.slotVertices.size(), nullptr);
+    freeSlots = d.freeSlots;
+
     for(auto it = d.mainMap.begin(); it!= d.mainMap.end(); ++it)
     {
-        
-        addVertex(it->first, it->second->vinfo);
-        mainMap.at(it->first)->edges = it->second->edges;
+        DigraphVertex<VertexInfo, EdgeInfo>* copy =
+            new DigraphVertex<VertexInfo, EdgeInfo>{*it->second};
+        mainMap.emplace_hint(mainMap.end(), it->first, copy);
+        slotVertices[copy->slot] = copy;
     }
+    vertexNum = d.vertexNum;
     edgeNum = d.edgeNum;
+    versionNum = d.versionNum;
 }
 
 
@@ -262,6 +404,9 @@ Digraph<VertexInfo, EdgeInfo>::Digraph(Digraph&& d) noexcept
     d.mainMap = emptyMap;
     vertexNum = d.vertexNum;
     edgeNum = d.edgeNum;
+    versionNum = d.versionNum;
+    slotVertices = std::move(d.slotVertices);
+    freeSlots = std::move(d.freeSlots);
 }
 
 
@@ -278,16 +423,32 @@ Digraph<VertexInfo, EdgeInfo>::~Digraph() noexcept
 template <typename VertexInfo, typename EdgeInfo>
 Digraph<VertexInfo, EdgeInfo>& Digraph<VertexInfo, EdgeInfo>::operator=(const Digraph& d)
 {
-    Digraph{d};
-    //Digraph(d);<-doesnt work
-return *this;
+    //make the deep copy first, then trade contents with it so the copy's
+    //destructor cleans up what "this" used to hold
+    if(this != &d)
+    {
+        Digraph copy{d};
+        std::swap(mainMap, copy.mainMap);
+        std::swap(vertexNum, copy.vertexNum);
+        std::swap(edgeNum, copy.edgeNum);
+        std::swap(versionNum, copy.versionNum);
+        std::swap(slotVertices, copy.slotVertices);
+        std::swap(freeSlots, copy.freeSlots);
+    }
+    return *this;
 }
 
 
 template <typename VertexInfo, typename EdgeInfo>
 Digraph<VertexInfo, EdgeInfo>& Digraph<VertexInfo, EdgeInfo>::operator=(Digraph&& d) noexcept
 {
-    Digraph{d};
+    //d is expiring, so it can take "this" Digraph's old vertices with it
+    std::swap(mainMap, d.mainMap);
+    std::swap(vertexNum, d.vertexNum);
+    std::swap(edgeNum, d.edgeNum);
+    std::swap(versionNum, d.versionNum);
+    std::swap(slotVertices, d.slotVertices);
+    std::swap(freeSlots, d.freeSlots);
     return *this;
 }
 
@@ -385,8 +546,28 @@ EdgeInfo Digraph<VertexInfo, EdgeInfo>::edgeInfo(int fromVertex, int toVertex) c
 template <typename VertexInfo, typename EdgeInfo>
 void Digraph<VertexInfo, EdgeInfo>::addVertex(int vertexIn, const VertexInfo& vinfoIn)
 {
-    mainMap.insert(std::pair(vertexIn, new DigraphVertex<VertexInfo, EdgeInfo>{.vinfo = vinfoIn}));
+    if(mainMap.count(vertexIn))
+    {
+        throw DigraphException("Vertex Already Exists");
+    }
+
+    int slot = slotVertices.size();
+    if(!freeSlots.empty())
+    {
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+    }
+    else
+    {
+        slotVertices.push_back(nullptr);
+    }
+
+    DigraphVertex<VertexInfo, EdgeInfo>* newVertex =
+        new DigraphVertex<VertexInfo, EdgeInfo>{.vinfo = vinfoIn, .edges = {}, .slot = slot};
+    mainMap.insert(std::pair(vertexIn, newVertex));
+    slotVertices[slot] = newVertex;
     vertexNum++;
+    versionNum++;
 }
 
 
@@ -406,9 +587,11 @@ void Digraph<VertexInfo, EdgeInfo>::addEdge(int fromVertexIn, int toVertexIn, co
     
    
     DigraphEdge<EdgeInfo> newEdge{.fromVertex = 
-            fromVertexIn, .toVertex = toVertexIn, .einfo = einfoIn};
+            fromVertexIn, .toVertex = toVertexIn, .einfo = einfoIn,
+            .toSlot = it->second->slot};
     mainMap.at(fromVertexIn)->edges.push_front(newEdge);
     edgeNum++;
+    versionNum++;
 
 }
 
@@ -426,20 +609,29 @@ void Digraph<VertexInfo, EdgeInfo>::removeVertex(int vertex)
         if(!currentVertex->second->edges.empty())
         {
             for(typename std::list<DigraphEdge<EdgeInfo>>::iterator currentEdge=currentVertex->second->edges.begin();
-            currentEdge!=currentVertex->second->edges.end(); ++currentEdge)
+            currentEdge!=currentVertex->second->edges.end(); )
             {
                 if(currentEdge->toVertex == vertex)
                 {
+                    //erase() hands back the next edge, so nothing is skipped
                     currentEdge = currentVertex->second->edges.erase(currentEdge);
-                    --currentEdge;//go back one so no edge is skipped
                     edgeNum--;
                 }
+                else
+                {
+                    ++currentEdge;
+                }
             }
         }
 
    }
-   delete mainMap.at(vertex);
-   mainMap.erase(vertex);
+   edgeNum -= it->second->edges.size();
+   slotVertices[it->second->slot] = nullptr;
+   freeSlots.push_back(it->second->slot);
+   delete it->second;
+   mainMap.erase(it);
+   vertexNum--;
+   versionNum++;
 }
 
 
@@ -464,12 +656,177 @@ void Digraph<VertexInfo, EdgeInfo>::removeEdge(int fromVertex, int toVertex)
         {
             mainMap.at(fromVertex)->edges.erase(it);
             edgeNum--;
+            versionNum++;
             break;
         }
     }
 }
 
 
+template <typename VertexInfo, typename EdgeInfo>
+void Digraph<VertexInfo, EdgeInfo>::updateEdge(int fromVertex, int toVertex, const EdgeInfo& einfo)
+{
+    auto from = mainMap.find(fromVertex);
+    if(from==mainMap.end() || mainMap.count(toVertex)==0)
+    {
+        throw DigraphException("Invalid Vertex");
+    }
+
+    for(DigraphEdge<EdgeInfo>& edge : from->second->edges)
+    {
+        if(edge.toVertex == toVertex)
+        {
+            edge.einfo = einfo;
+            versionNum++;
+            return;
+        }
+    }
+    throw DigraphException("Invalid Edge");
+}
+
+
+template <typename VertexInfo, typename EdgeInfo>
+template <typename UpdateFunc>
+int Digraph<VertexInfo, EdgeInfo>::updateEdges(int fromVertex, int toVertex, UpdateFunc update)
+{
+    auto from = mainMap.find(fromVertex);
+    if(from==mainMap.end() || mainMap.count(toVertex)==0)
+    {
+        throw DigraphException("Invalid Vertex");
+    }
+
+    int updated = 0;
+    for(DigraphEdge<EdgeInfo>& edge : from->second->edges)
+    {
+        if(edge.toVertex == toVertex)
+        {
+            update(edge.einfo);
+            ++updated;
+        }
+    }
+
+    if(updated == 0)
+    {
+        throw DigraphException("Invalid Edge");
+    }
+    versionNum++;
+    return updated;
+}
+
+
+template <typename VertexInfo, typename EdgeInfo>
+void Digraph<VertexInfo, EdgeInfo>::removeVertices(const std::vector<int>& vertices)
+{
+    //every vertex is checked before anything is removed, and marked by
+    //its slot, so each edge can be checked in constant time
+    std::vector<bool> removing(slotVertices.size(), false);
+    for(int vertex : vertices)
+    {
+        auto it = mainMap.find(vertex);
+        if(it==mainMap.end())
+        {
+            throw DigraphException("Invalid Vertex");
+        }
+        removing[it->second->slot] = true;
+    }
+    if(vertices.empty())
+    {
+        return;
+    }
+
+    for(auto currentVertex = mainMap.begin(); currentVertex!=mainMap.end(); ++currentVertex)
+    {
+        if(removing[currentVertex->second->slot])
+        {
+            continue;
+        }
+
+        std::list<DigraphEdge<EdgeInfo>>& edges = currentVertex->second->edges;
+        for(auto currentEdge = edges.begin(); currentEdge != edges.end(); )
+        {
+            if(removing[currentEdge->toSlot])
+            {
+                currentEdge = edges.erase(currentEdge);
+                edgeNum--;
+            }
+            else
+            {
+                ++currentEdge;
+            }
+        }
+    }
+
+    for(int vertex : vertices)
+    {
+        //the same vertex may be listed more than once
+        auto it = mainMap.find(vertex);
+        if(it==mainMap.end())
+        {
+            continue;
+        }
+
+        edgeNum -= it->second->edges.size();
+        slotVertices[it->second->slot] = nullptr;
+        freeSlots.push_back(it->second->slot);
+        delete it->second;
+        mainMap.erase(it);
+        vertexNum--;
+    }
+    versionNum++;
+}
+
+
+template <typename VertexInfo, typename EdgeInfo>
+unsigned long Digraph<VertexInfo, EdgeInfo>::version() const noexcept
+{
+    return versionNum;
+}
+
+
+template <typename VertexInfo, typename EdgeInfo>
+bool Digraph<VertexInfo, EdgeInfo>::hasVertex(int vertex) const
+{
+    return mainMap.count(vertex) != 0;
+}
+
+
+template <typename VertexInfo, typename EdgeInfo>
+MemoryUsage Digraph<VertexInfo, EdgeInfo>::memoryUsage() const
+{
+    std::size_t vertexBytes = heapBytes(sizeof(DigraphVertex<VertexInfo, EdgeInfo>));
+    std::size_t edgeBytes = listNodeBytes<DigraphEdge<EdgeInfo>>();
+
+    MemoryUsage usage;
+    usage.add("vertex index",
+              mainMap.size() * mapNodeBytes<int, DigraphVertex<VertexInfo, EdgeInfo>*>());
+    usage.add("vertices", vertexNum * (vertexBytes - sizeof(VertexInfo)));
+    usage.add("vertex payloads", vertexNum * sizeof(VertexInfo));
+    usage.add("edges", edgeNum * (edgeBytes - sizeof(EdgeInfo)));
+    usage.add("edge payloads", edgeNum * sizeof(EdgeInfo));
+    usage.add("slots", vectorBytes(slotVertices) + vectorBytes(freeSlots));
+    return usage;
+}
+
+
+template <typename VertexInfo, typename EdgeInfo>
+MemoryUsage Digraph<VertexInfo, EdgeInfo>::estimateMemoryUsage(int vertexCount, int edgeCount)
+{
+    std::size_t vertexBytes = heapBytes(sizeof(DigraphVertex<VertexInfo, EdgeInfo>));
+    std::size_t edgeBytes = listNodeBytes<DigraphEdge<EdgeInfo>>();
+    std::size_t vertices = vertexCount;
+    std::size_t edges = edgeCount;
+
+    MemoryUsage usage;
+    usage.add("vertex index", vertices * mapNodeBytes<int, DigraphVertex<VertexInfo, EdgeInfo>*>());
+    usage.add("vertices", vertices * (vertexBytes - sizeof(VertexInfo)));
+    usage.add("vertex payloads", vertices * sizeof(VertexInfo));
+    usage.add("edges", edges * (edgeBytes - sizeof(EdgeInfo)));
+    usage.add("edge payloads", edges * sizeof(EdgeInfo));
+    usage.add("slots", heapBytes(vertices * sizeof(DigraphVertex<VertexInfo, EdgeInfo>*)));
+    return usage;
+}
+
+
 template <typename VertexInfo, typename EdgeInfo>
 int Digraph<VertexInfo, EdgeInfo>::vertexCount() const noexcept
 {
@@ -498,66 +855,76 @@ int Digraph<VertexInfo, EdgeInfo>::edgeCount(int vertex) const
 
 template <typename VertexInfo, typename EdgeInfo>
 bool Digraph<VertexInfo, EdgeInfo>::isStronglyConnected() const
+{
+    SearchWorkspace<double> workspace;
+    return isStronglyConnected(workspace);
+}
+
+
+template <typename VertexInfo, typename EdgeInfo>
+bool Digraph<VertexInfo, EdgeInfo>::isStronglyConnected(SearchWorkspace<double>& workspace) const
 {
     if(vertexNum==0 || vertexNum==1)
     {
         return true;
     }
-    std::list<int> visted={};
-    std::list<int> reachable ={};
-    
-    auto it = mainMap.begin();
-    reachable.push_back(it->first);
-    int currentVertex =0;
-    int nextVertex=0;
-    while(reachable.empty()==false)
-    {
-        currentVertex = reachable.front();
-        reachable.pop_front();
-        //add all adjacent vertex to reachable
-        for(typename std::list<DigraphEdge<EdgeInfo>>::iterator currentEdge=
-            mainMap.at(currentVertex)->edges.begin();
-            currentEdge!=mainMap.at(currentVertex)->edges.end(); ++currentEdge)
+
+    //a depth-first search from the first vertex, in the manner of
+    //Tarjan's algorithm: each slot's distance is the order in which it
+    //was first visited and its predecessor the lowest order it's known to
+    //reach.  The graph is strongly connected exactly when the search
+    //reaches every vertex and the first vertex is the only one that can't
+    //reach anything visited before it.  The heap is the search's stack:
+    //each entry's priority is lower than the last one's, so the newest
+    //comes out first.  An entry for slot s means "visit s"; one for ~s
+    //means "every vertex s leads to has been visited".
+    workspace.prepare(slotVertices.size());
+    int root = mainMap.begin()->second->slot;
+    double pushes = 0;
+    int order = 0;
+    workspace.push(pushes--, root);
+
+    while(!workspace.heapEmpty())
+    {
+        int entry = workspace.pop().second;
+
+        if(entry >= 0)
         {
-            nextVertex = currentEdge->toVertex;
-            bool found =false;
-            //check if it's been visted
-            for(std::list<int>::iterator vistedIt = visted.begin();
-            vistedIt!=visted.end(); ++vistedIt)
+            if(workspace.reached(entry))
             {
-                if(*vistedIt==nextVertex)
-                {
-                    found=true;
-                }
+                continue;
             }
-            if(found==false)
+            workspace.reach(entry, order, order);
+            ++order;
+
+            workspace.push(pushes--, ~entry);
+            for(const DigraphEdge<EdgeInfo>& edge : slotVertices[entry]->edges)
             {
-                //check if it's been seen
-                for(std::list<int>::iterator reachIt = reachable.begin(); 
-                reachIt!=reachable.end(); ++reachIt)
-                {
-                    if(*reachIt==nextVertex)
-                    {
-                        found=true;
-                    }
-                }
-                //if it has not been seen add it to reachable
-                if(found==false && nextVertex!=currentVertex)
+                if(!workspace.reached(edge.toSlot))
                 {
-                    reachable.push_back(currentEdge->toVertex);
+                    workspace.push(pushes--, edge.toSlot);
                 }
             }
+            continue;
         }
 
-        visted.push_back(currentVertex);
-    }
-    //if all vertexs were reachable
-    if(visted.size()==vertexNum)
-    {
-        return true;
+        int slot = ~entry;
+        int lowest = workspace.predecessor(slot);
+        for(const DigraphEdge<EdgeInfo>& edge : slotVertices[slot]->edges)
+        {
+            //nothing has been set aside as a separate component yet, so
+            //everything visited still counts
+            lowest = std::min(lowest, workspace.predecessor(edge.toSlot));
+        }
+        workspace.reach(slot, workspace.distance(slot), lowest);
+
+        if(slot != root && lowest == workspace.distance(slot))
+        {
+            return false;
+        }
     }
 
-    return false;
+    return order == static_cast<int>(vertexNum);
 }
 
 
@@ -565,87 +932,192 @@ template <typename VertexInfo, typename EdgeInfo>
 std::map<int, int> Digraph<VertexInfo, EdgeInfo>::findShortestPaths(
     int startVertex,
     std::function<double(const EdgeInfo&)> edgeWeightFunc) const
+{
+    //naming the template argument picks the template overload, rather
+    //than this one again
+    return findShortestPaths<std::function<double(const EdgeInfo&)>&>(
+        startVertex, edgeWeightFunc);
+}
+
+
+template <typename VertexInfo, typename EdgeInfo>
+template <typename EdgeWeightFunc>
+std::map<int, int> Digraph<VertexInfo, EdgeInfo>::findShortestPaths(
+    int startVertex,
+    EdgeWeightFunc edgeWeightFunc) const
+{
+    SearchWorkspace<double> workspace{slotCount()};
+    findShortestPaths(startVertex, edgeWeightFunc, workspace);
+
+    //every vertex that was never reached is its own predecessor
+    std::map<int,int> output;
+    for(auto mapIt = mainMap.begin(); mapIt != mainMap.end(); ++mapIt)
+    {
+        int slot = mapIt->second->slot;
+        output.emplace_hint(output.end(), mapIt->first,
+            workspace.reached(slot) ? workspace.predecessor(slot) : mapIt->first);
+    }
+
+    return output;
+}
+
+
+template <typename VertexInfo, typename EdgeInfo>
+template <typename EdgeWeightFunc>
+void Digraph<VertexInfo, EdgeInfo>::findShortestPaths(
+    int startVertex,
+    EdgeWeightFunc edgeWeightFunc,
+    SearchWorkspace<double>& workspace) const
 {
     auto it = mainMap.find(startVertex);
     if(it==mainMap.end())
     {
         throw DigraphException("Invalid Vertex");
     }
-    //vertex,(fromVertex, weight)
-    std::map<int,std::pair<int,double>> returnMap;
-    std::vector<int> computed;
-    std::vector<int> toBeComputed = vertices();
-    
-    for(std::vector<int>::iterator it = toBeComputed.begin(); it != toBeComputed.end(); ++it)
+
+    //the heap holds (weight so far, slot); stale entries are skipped
+    workspace.prepare(slotCount());
+    workspace.reach(it->second->slot, 0.0, startVertex);
+    workspace.push(0.0, it->second->slot);
+
+    while(workspace.heapEmpty()==false)
     {
-        //set the default values to point from itself and with a max weight
-        returnMap.insert(std::pair<int,std::pair<int,double>>
-        (*it,std::pair<int,double>(*it,std::numeric_limits<double>::max())));
-        
-        //remove the starting vertex from the tobeComputed and put it in the computed vector
-        if(*it==startVertex)
+        std::pair<double,int> current = workspace.pop();
+
+        if(current.first > workspace.distance(current.second))
         {
-            computed.push_back(*it);
-            toBeComputed.erase(it);
-            --it;
+            continue;
         }
-    }
-    std::vector<std::pair<int,int>> outGoingEdges = edges(startVertex);
-    for(auto temp = outGoingEdges.begin(); temp!= outGoingEdges.end(); ++temp)
-    {
-        //std::cout<<"\n\nSetting default value to:"<<(temp->second);
-        returnMap.at(temp->second)=std::pair<int,double>(startVertex, edgeWeightFunc(edgeInfo(temp->first,temp->second)));
-    }
-    int currentVertex=0;
-    while(toBeComputed.empty()==false)
-    {
-        double lowestWeight= std::numeric_limits<double>::max();
-        currentVertex =-1;
-        for(auto it = toBeComputed.begin(); it!=toBeComputed.end(); ++it)
+
+        //update all outgoing edges
+        for(const DigraphEdge<EdgeInfo>& edge : slotVertices[current.second]->edges)
         {
-            //find the vertex with the lowest weight
-            if(returnMap.at(*it).second<lowestWeight)
+            //add weight of current vertex to the weight of going to next
+            double currentWeight = current.first + edgeWeightFunc(edge.einfo);
+
+            if(!workspace.reached(edge.toSlot) || currentWeight < workspace.distance(edge.toSlot))
             {
-                currentVertex = *it;
-                toBeComputed.erase(it);
-                --it;
+                workspace.reach(edge.toSlot, currentWeight, edge.fromVertex);
+                workspace.push(currentWeight, edge.toSlot);
             }
         }
-        //std::cout<<"\n\n-----TEST----\nCurretnVertex:"<<currentVertex;
-        //if not updated, then the rest are unreachable
-        if(currentVertex==-1)
+    }
+}
+
+
+template <typename VertexInfo, typename EdgeInfo>
+template <typename EdgeWeightFunc>
+std::vector<std::pair<int, double>> Digraph<VertexInfo, EdgeInfo>::findReachable(
+    int startVertex,
+    EdgeWeightFunc edgeWeightFunc,
+    double budget,
+    SearchWorkspace<double>& workspace) const
+{
+    auto it = mainMap.find(startVertex);
+    if(it==mainMap.end())
+    {
+        throw DigraphException("Invalid Vertex");
+    }
+
+    std::vector<std::pair<int, double>> reachable;
+
+    //a slot doesn't know its vertex number, so the search keeps it in the
+    //slot's mark
+    workspace.prepare(slotCount());
+    workspace.reach(it->second->slot, 0.0, startVertex);
+    workspace.setMark(it->second->slot, startVertex);
+    workspace.push(0.0, it->second->slot);
+
+    while(workspace.heapEmpty()==false)
+    {
+        std::pair<double,int> current = workspace.pop();
+
+        if(current.first > workspace.distance(current.second))
         {
-            break;
+            continue;
         }
+        reachable.emplace_back(workspace.mark(current.second), current.first);
 
-        //update all outgoing edges
-        std::vector<std::pair<int,int>> outGoingEdges = edges(currentVertex);
-        double currentWeight=0;
-        for(auto nextEdge = outGoingEdges.begin(); nextEdge!= outGoingEdges.end(); ++nextEdge)
+        for(const DigraphEdge<EdgeInfo>& edge : slotVertices[current.second]->edges)
         {
-            //add weight of current vertex to the weight of going to next
-            currentWeight = edgeWeightFunc(edgeInfo(nextEdge->first,nextEdge->second))+
-                            returnMap.at(nextEdge->first).second;
-            //if less than the next vertex weight
-            if(currentWeight<returnMap.at(nextEdge->second).second)
+            double currentWeight = current.first + edgeWeightFunc(edge.einfo);
+
+            //anything over the budget is never even recorded
+            if(currentWeight <= budget &&
+               (!workspace.reached(edge.toSlot) || currentWeight < workspace.distance(edge.toSlot)))
             {
-                //std::cout<<"\nUpdating weight of"<<(nextEdge->second)<<" from:"<<nextEdge->first; 
-                returnMap.at(nextEdge->second)=
-                                    std::pair<int,double>(currentVertex,
-                                    edgeWeightFunc(edgeInfo(nextEdge->first,nextEdge->second)));
+                workspace.reach(edge.toSlot, currentWeight, edge.fromVertex);
+                workspace.setMark(edge.toSlot, edge.toVertex);
+                workspace.push(currentWeight, edge.toSlot);
             }
         }
-        computed.push_back(currentVertex);
+    }
 
+    return reachable;
+}
+
+
+template <typename VertexInfo, typename EdgeInfo>
+template <typename EdgeWeightFunc>
+std::vector<std::vector<std::pair<int, double>>> Digraph<VertexInfo, EdgeInfo>::findReachable(
+    const std::vector<int>& startVertices,
+    EdgeWeightFunc edgeWeightFunc,
+    double budget,
+    unsigned int threadCount) const
+{
+    if(threadCount == 0)
+    {
+        threadCount = defaultThreadCount();
     }
-    std::map<int,int> output;
-    for(auto mapIt = returnMap.begin(); mapIt != returnMap.end(); ++mapIt)
+
+    std::vector<std::vector<std::pair<int, double>>> reachable(startVertices.size());
+    std::vector<SearchWorkspace<double>> workspaces(threadCount);
+
+    parallelFor(startVertices.size(), threadCount,
+        [&](int i, unsigned int threadIndex)
+        {
+            reachable[i] = findReachable(
+                startVertices[i], edgeWeightFunc, budget, workspaces[threadIndex]);
+        });
+
+    return reachable;
+}
+
+
+template <typename VertexInfo, typename EdgeInfo>
+int Digraph<VertexInfo, EdgeInfo>::slotOf(int vertex) const
+{
+    auto it = mainMap.find(vertex);
+    if(it==mainMap.end())
     {
-        output.insert(std::pair<int,int>(mapIt->first,(mapIt->second).first));
+        throw DigraphException("Invalid Vertex");
     }
 
+    return it->second->slot;
+}
 
-    return output;
+
+template <typename VertexInfo, typename EdgeInfo>
+int Digraph<VertexInfo, EdgeInfo>::slotCount() const noexcept
+{
+    return slotVertices.size();
+}
+
+
+template <typename VertexInfo, typename EdgeInfo>
+template <typename EdgeFunc>
+void Digraph<VertexInfo, EdgeInfo>::forEachOutgoingEdge(int vertex, EdgeFunc edgeFunc) const
+{
+    auto it = mainMap.find(vertex);
+    if(it==mainMap.end())
+    {
+        throw DigraphException("Invalid Vertex");
+    }
+
+    for(const DigraphEdge<EdgeInfo>& edge : it->second->edges)
+    {
+        edgeFunc(edge.toVertex, edge.einfo);
+    }
 }
 
 
@@ -0,0 +1,495 @@
+// DigraphAnalytics.hpp
+//
+// ICS 46 Winter 2019
+// Project #4: Rock and Roll Stops the Traffic
+//
+// This header declares parallel connectivity and reachability analyses
+// over a CompactDigraph, for validating a freshly loaded map and for
+// reporting on its quality.  All of them treat the snapshot as read-only,
+// so any number of them can run over the same one at once; edge weights
+// are ignored throughout.
+//
+// The traversals underneath are level-synchronous breadth-first searches:
+// each level's frontier is split into blocks handed out by parallelFor(),
+// and vertices are claimed with an AtomicBitset so that each one joins
+// exactly one next frontier.  Small frontiers are expanded on the calling
+// thread, since road maps have long, thin stretches where starting threads
+// would cost more than the work they'd do.
+
+#ifndef DIGRAPHANALYTICS_HPP
+#define DIGRAPHANALYTICS_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <utility>
+#include <vector>
+#include "AtomicBitset.hpp"
+#include "CompactDigraph.hpp"
+#include "ParallelFor.hpp"
+
+
+
+// parallelReachable() returns a vector with one entry per vertex index,
+// which is nonzero if that vertex can be reached from the vertex with
+// the given index.
+template <typename Weight>
+std::vector<char> parallelReachable(
+    const CompactDigraph<Weight>& graph, int startIndex, unsigned int threadCount = 0);
+
+
+// isStronglyConnectedParallel() returns true if every vertex can be
+// reached from every other, which is the case exactly when everything is
+// reachable from one vertex both forward and backward.  An empty snapshot
+// is considered to be strongly connected.
+template <typename Weight>
+bool isStronglyConnectedParallel(
+    const CompactDigraph<Weight>& graph, unsigned int threadCount = 0);
+
+
+// stronglyConnectedComponents() returns a vector with one entry per vertex
+// index, giving the strongly connected component it belongs to.  The
+// components are numbered from 0 with no gaps.
+template <typename Weight>
+std::vector<int> stronglyConnectedComponents(
+    const CompactDigraph<Weight>& graph, unsigned int threadCount = 0);
+
+
+// weaklyConnectedComponents() returns a vector with one entry per vertex
+// index, giving the component it belongs to when edge directions are
+// ignored.  The components are numbered from 0 with no gaps, in order of
+// their lowest vertex index.
+template <typename Weight>
+std::vector<int> weaklyConnectedComponents(
+    const CompactDigraph<Weight>& graph, unsigned int threadCount = 0);
+
+
+// reachabilityCounts() returns a vector with one entry per vertex index,
+// giving the number of vertices (including itself) reachable from it.
+// Every vertex in a strongly connected component reaches the same set of
+// vertices, so only one search is run per component.
+template <typename Weight>
+std::vector<int> reachabilityCounts(
+    const CompactDigraph<Weight>& graph, unsigned int threadCount = 0);
+
+
+
+namespace DigraphAnalyticsDetail
+{
+    // Frontiers smaller than this are expanded on the calling thread.
+    constexpr int parallelFrontierSize = 4096;
+
+    // Each parallelFor() index expands a block of this many vertices.
+    constexpr int frontierBlockSize = 1024;
+
+
+    // parallelBfs() marks in "visited" every vertex reachable from the
+    // vertex with index "start" through vertices for which allowed(v) is
+    // true (start itself is always visited).
+    template <typename Weight, typename AllowedFunc>
+    void parallelBfs(
+        const CompactDigraph<Weight>& graph, int start, AtomicBitset& visited,
+        AllowedFunc allowed, unsigned int threadCount)
+    {
+        if(threadCount == 0)
+        {
+            threadCount = defaultThreadCount();
+        }
+
+        std::vector<int> frontier{start};
+        std::vector<int> nextFrontier;
+        std::vector<std::vector<int>> found(threadCount);
+        visited.testAndSet(start);
+
+        auto expand = [&](int vertex, std::vector<int>& out)
+        {
+            for(int edge = graph.edgesBegin(vertex); edge < graph.edgesEnd(vertex); ++edge)
+            {
+                int next = graph.target(edge);
+                if(allowed(next) && visited.testAndSet(next))
+                {
+                    out.push_back(next);
+                }
+            }
+        };
+
+        while(!frontier.empty())
+        {
+            nextFrontier.clear();
+
+            if(threadCount == 1 || frontier.size() < parallelFrontierSize)
+            {
+                for(int vertex : frontier)
+                {
+                    expand(vertex, nextFrontier);
+                }
+            }
+            else
+            {
+                int blocks = (frontier.size() + frontierBlockSize - 1) / frontierBlockSize;
+                parallelFor(blocks, threadCount,
+                    [&](int block, unsigned int threadIndex)
+                    {
+                        int end = std::min<int>(frontier.size(), (block + 1) * frontierBlockSize);
+                        for(int i = block * frontierBlockSize; i < end; ++i)
+                        {
+                            expand(frontier[i], found[threadIndex]);
+                        }
+                    });
+
+                for(std::vector<int>& part : found)
+                {
+                    nextFrontier.insert(nextFrontier.end(), part.begin(), part.end());
+                    part.clear();
+                }
+            }
+
+            std::swap(frontier, nextFrontier);
+        }
+    }
+
+
+    // tarjanRemaining() finds the strongly connected components among the
+    // vertices whose component is still -1, numbering them from
+    // nextComponent on, and returns the next unused component number.
+    // It's an iterative version of Tarjan's algorithm, so it's safe on
+    // long chains of vertices.
+    template <typename Weight>
+    int tarjanRemaining(
+        const CompactDigraph<Weight>& graph, std::vector<int>& component, int nextComponent)
+    {
+        const int vertexCount = graph.vertexCount();
+        std::vector<int> order(vertexCount, -1);
+        std::vector<int> lowLink(vertexCount, 0);
+        std::vector<char> onStack(vertexCount, 0);
+        std::vector<int> stack;
+
+        //(vertex, next edge to look at) for each call in progress
+        std::vector<std::pair<int, int>> calls;
+        int counter = 0;
+
+        for(int root = 0; root < vertexCount; ++root)
+        {
+            if(component[root] != -1 || order[root] != -1)
+            {
+                continue;
+            }
+
+            calls.push_back({root, graph.edgesBegin(root)});
+            order[root] = lowLink[root] = counter++;
+            stack.push_back(root);
+            onStack[root] = 1;
+
+            while(!calls.empty())
+            {
+                int vertex = calls.back().first;
+                int& edge = calls.back().second;
+
+                if(edge < graph.edgesEnd(vertex))
+                {
+                    int next = graph.target(edge++);
+                    if(component[next] != -1)
+                    {
+                        continue;
+                    }
+                    if(order[next] == -1)
+                    {
+                        order[next] = lowLink[next] = counter++;
+                        stack.push_back(next);
+                        onStack[next] = 1;
+                        calls.push_back({next, graph.edgesBegin(next)});
+                    }
+                    else if(onStack[next])
+                    {
+                        lowLink[vertex] = std::min(lowLink[vertex], order[next]);
+                    }
+                    continue;
+                }
+
+                calls.pop_back();
+                if(!calls.empty())
+                {
+                    int parent = calls.back().first;
+                    lowLink[parent] = std::min(lowLink[parent], lowLink[vertex]);
+                }
+
+                if(lowLink[vertex] == order[vertex])
+                {
+                    int member;
+                    do
+                    {
+                        member = stack.back();
+                        stack.pop_back();
+                        onStack[member] = 0;
+                        component[member] = nextComponent;
+                    }
+                    while(member != vertex);
+                    ++nextComponent;
+                }
+            }
+        }
+
+        return nextComponent;
+    }
+
+
+    // findRoot() follows parent links to the root of a union-find tree,
+    // halving the path as it goes.
+    inline int findRoot(std::vector<std::atomic<int>>& parent, int vertex)
+    {
+        while(true)
+        {
+            int up = parent[vertex].load(std::memory_order_relaxed);
+            if(up == vertex)
+            {
+                return vertex;
+            }
+            int upUp = parent[up].load(std::memory_order_relaxed);
+            if(upUp != up)
+            {
+                //losing this race is harmless; it only skips a shortcut
+                parent[vertex].compare_exchange_weak(up, upUp, std::memory_order_relaxed);
+            }
+            vertex = upUp;
+        }
+    }
+}
+
+
+
+template <typename Weight>
+std::vector<char> parallelReachable(
+    const CompactDigraph<Weight>& graph, int startIndex, unsigned int threadCount)
+{
+    AtomicBitset visited{graph.vertexCount()};
+    DigraphAnalyticsDetail::parallelBfs(
+        graph, startIndex, visited, [](int) { return true; }, threadCount);
+
+    std::vector<char> reached(graph.vertexCount());
+    for(int vertex = 0; vertex < graph.vertexCount(); ++vertex)
+    {
+        reached[vertex] = visited.test(vertex);
+    }
+    return reached;
+}
+
+
+template <typename Weight>
+bool isStronglyConnectedParallel(
+    const CompactDigraph<Weight>& graph, unsigned int threadCount)
+{
+    if(graph.vertexCount() <= 1)
+    {
+        return true;
+    }
+
+    const CompactDigraph<Weight> reversedGraph = graph.reversed();
+
+    for(const CompactDigraph<Weight>* direction : {&graph, &reversedGraph})
+    {
+        AtomicBitset visited{graph.vertexCount()};
+        DigraphAnalyticsDetail::parallelBfs(
+            *direction, 0, visited, [](int) { return true; }, threadCount);
+
+        for(int vertex = 0; vertex < graph.vertexCount(); ++vertex)
+        {
+            if(!visited.test(vertex))
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+
+template <typename Weight>
+std::vector<int> stronglyConnectedComponents(
+    const CompactDigraph<Weight>& graph, unsigned int threadCount)
+{
+    const int vertexCount = graph.vertexCount();
+    std::vector<int> component(vertexCount, -1);
+    if(vertexCount == 0)
+    {
+        return component;
+    }
+
+    CompactDigraph<Weight> reversedGraph = graph.reversed();
+
+    //road maps are mostly one giant component, which forward/backward
+    //search finds in parallel: starting from a well-connected pivot,
+    //everything reachable both ways is in the pivot's component
+    int pivot = 0;
+    long bestDegree = -1;
+    for(int vertex = 0; vertex < vertexCount; ++vertex)
+    {
+        long degree =
+            static_cast<long>(graph.edgesEnd(vertex) - graph.edgesBegin(vertex)) *
+            (reversedGraph.edgesEnd(vertex) - reversedGraph.edgesBegin(vertex));
+        if(degree > bestDegree)
+        {
+            bestDegree = degree;
+            pivot = vertex;
+        }
+    }
+
+    AtomicBitset forward{vertexCount};
+    AtomicBitset backward{vertexCount};
+    DigraphAnalyticsDetail::parallelBfs(
+        graph, pivot, forward, [](int) { return true; }, threadCount);
+    DigraphAnalyticsDetail::parallelBfs(
+        reversedGraph, pivot, backward, [&](int v) { return forward.test(v); }, threadCount);
+
+    parallelFor((vertexCount + 4095) / 4096, threadCount,
+        [&](int block, unsigned int)
+        {
+            int end = std::min(vertexCount, (block + 1) * 4096);
+            for(int vertex = block * 4096; vertex < end; ++vertex)
+            {
+                if(backward.test(vertex))
+                {
+                    component[vertex] = 0;
+                }
+            }
+        });
+
+    //whatever is left is small pieces hanging off the giant component,
+    //which a sequential pass handles quickly
+    DigraphAnalyticsDetail::tarjanRemaining(graph, component, 1);
+    return component;
+}
+
+
+template <typename Weight>
+std::vector<int> weaklyConnectedComponents(
+    const CompactDigraph<Weight>& graph, unsigned int threadCount)
+{
+    const int vertexCount = graph.vertexCount();
+    std::vector<std::atomic<int>> parent(vertexCount);
+    for(int vertex = 0; vertex < vertexCount; ++vertex)
+    {
+        parent[vertex].store(vertex, std::memory_order_relaxed);
+    }
+
+    //union every edge's endpoints, always hanging the higher-numbered
+    //root under the lower one so that concurrent unions can't form cycles
+    parallelFor((vertexCount + 1023) / 1024, threadCount,
+        [&](int block, unsigned int)
+        {
+            int end = std::min(vertexCount, (block + 1) * 1024);
+            for(int vertex = block * 1024; vertex < end; ++vertex)
+            {
+                for(int edge = graph.edgesBegin(vertex); edge < graph.edgesEnd(vertex); ++edge)
+                {
+                    int a = vertex;
+                    int b = graph.target(edge);
+                    while(true)
+                    {
+                        a = DigraphAnalyticsDetail::findRoot(parent, a);
+                        b = DigraphAnalyticsDetail::findRoot(parent, b);
+                        if(a == b)
+                        {
+                            break;
+                        }
+                        if(a < b)
+                        {
+                            std::swap(a, b);
+                        }
+                        int expected = a;
+                        if(parent[a].compare_exchange_strong(expected, b))
+                        {
+                            break;
+                        }
+                    }
+                }
+            }
+        });
+
+    //roots are the lowest index in their component, so numbering them in
+    //index order numbers the components in order of lowest vertex index
+    std::vector<int> component(vertexCount);
+    int components = 0;
+    for(int vertex = 0; vertex < vertexCount; ++vertex)
+    {
+        int root = DigraphAnalyticsDetail::findRoot(parent, vertex);
+        component[vertex] = root == vertex ? components++ : component[root];
+    }
+    return component;
+}
+
+
+template <typename Weight>
+std::vector<int> reachabilityCounts(
+    const CompactDigraph<Weight>& graph, unsigned int threadCount)
+{
+    const int vertexCount = graph.vertexCount();
+    std::vector<int> component = stronglyConnectedComponents(graph, threadCount);
+
+    int componentCount = 0;
+    for(int c : component)
+    {
+        componentCount = std::max(componentCount, c + 1);
+    }
+
+    std::vector<int> representative(componentCount, -1);
+    for(int vertex = 0; vertex < vertexCount; ++vertex)
+    {
+        if(representative[component[vertex]] == -1)
+        {
+            representative[component[vertex]] = vertex;
+        }
+    }
+
+    if(threadCount == 0)
+    {
+        threadCount = defaultThreadCount();
+    }
+
+    //one search per component, each on its own thread with its own
+    //visited stamps, so these searches run sequentially inside
+    std::vector<std::vector<int>> stamps(threadCount, std::vector<int>());
+    std::vector<std::vector<int>> queues(threadCount);
+    std::vector<int> componentCounts(componentCount);
+
+    parallelFor(componentCount, threadCount,
+        [&](int c, unsigned int threadIndex)
+        {
+            std::vector<int>& stamp = stamps[threadIndex];
+            std::vector<int>& queue = queues[threadIndex];
+            if(stamp.empty())
+            {
+                stamp.assign(vertexCount, -1);
+            }
+
+            queue.clear();
+            queue.push_back(representative[c]);
+            stamp[representative[c]] = c;
+
+            for(unsigned int i = 0; i < queue.size(); ++i)
+            {
+                int vertex = queue[i];
+                for(int edge = graph.edgesBegin(vertex); edge < graph.edgesEnd(vertex); ++edge)
+                {
+                    int next = graph.target(edge);
+                    if(stamp[next] != c)
+                    {
+                        stamp[next] = c;
+                        queue.push_back(next);
+                    }
+                }
+            }
+
+            componentCounts[c] = queue.size();
+        });
+
+    std::vector<int> counts(vertexCount);
+    for(int vertex = 0; vertex < vertexCount; ++vertex)
+    {
+        counts[vertex] = componentCounts[component[vertex]];
+    }
+    return counts;
+}
+
+
+
+#endif // DIGRAPHANALYTICS_HPP
@@ -0,0 +1,281 @@
+// DistanceMatrix.hpp
+//
+// ICS 46 Winter 2019
+// Project #4: Rock and Roll Stops the Traffic
+//
+// computeDistanceMatrix() finds the shortest path distance from each of a
+// set of source vertices to each of a set of target vertices in a
+// CompactDigraph (a "many-to-many" query), writing the results into a
+// dense, row-major array of floats with one row per source and one column
+// per target.
+//
+// The work shared across the whole matrix is done once: the target lookup
+// table is built a single time, and the searches are run from whichever
+// side of the matrix is smaller (forward from the sources, or backward
+// from the targets over the reversed graph), so an N-by-M matrix costs
+// min(N, M) searches.  Each search stops as soon as every vertex on the
+// other side has been settled, and the searches are spread across threads
+// with parallelFor().
+
+#ifndef DISTANCEMATRIX_HPP
+#define DISTANCEMATRIX_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <utility>
+#include <vector>
+#include "CompactDigraph.hpp"
+#include "ParallelFor.hpp"
+
+
+
+// computeDistanceMatrix() fills result[s * targets.size() + t] with the
+// shortest path distance from sources[s] to targets[t], where both are
+// Digraph vertex numbers.  Unreachable pairs are set to positive infinity.
+// result must have room for sources.size() * targets.size() floats.
+// threadCount is the number of threads to use (0 means one per hardware
+// thread).  If any source or target is not a vertex in the graph, a
+// DigraphException is thrown.
+template <typename Weight>
+void computeDistanceMatrix(
+    const CompactDigraph<Weight>& graph,
+    const std::vector<int>& sources,
+    const std::vector<int>& targets,
+    float* result,
+    unsigned int threadCount = 0);
+
+
+// This overload allocates and returns the row-major matrix instead.
+template <typename Weight>
+std::vector<float> computeDistanceMatrix(
+    const CompactDigraph<Weight>& graph,
+    const std::vector<int>& sources,
+    const std::vector<int>& targets,
+    unsigned int threadCount = 0);
+
+
+
+namespace DistanceMatrixDetail
+{
+    // Scratch space for one thread's searches.  Only the entries listed
+    // in "touched" are ever different from their initial values, so
+    // resetting between searches costs as much as the search did.
+    template <typename Weight>
+    struct SearchScratch
+    {
+        std::vector<Weight> distance;
+        std::vector<char> settled;
+        std::vector<int> touched;
+        std::vector<std::pair<Weight, int>> heap;
+    };
+
+
+    // searchOneSide() runs Dijkstra's algorithm on graph from the vertex
+    // with index "origin" until every vertex with at least one column in
+    // [columnOffsets[v], columnOffsets[v + 1]) has been settled, calling
+    // record(column, distance) for each of those columns as it goes.
+    template <typename Weight, typename RecordFunc>
+    void searchOneSide(
+        const CompactDigraph<Weight>& graph,
+        int origin,
+        const std::vector<int>& columnOffsets,
+        const std::vector<int>& columns,
+        int distinctColumnVertices,
+        SearchScratch<Weight>& scratch,
+        RecordFunc record)
+    {
+        const Weight infinity = std::numeric_limits<Weight>::max();
+        std::greater<std::pair<Weight, int>> heapOrder;
+
+        if(scratch.distance.empty())
+        {
+            scratch.distance.assign(graph.vertexCount(), infinity);
+            scratch.settled.assign(graph.vertexCount(), 0);
+        }
+
+        scratch.distance[origin] = Weight{};
+        scratch.touched.push_back(origin);
+        scratch.heap.push_back({Weight{}, origin});
+
+        int remaining = distinctColumnVertices;
+
+        while(!scratch.heap.empty() && remaining > 0)
+        {
+            std::pop_heap(scratch.heap.begin(), scratch.heap.end(), heapOrder);
+            std::pair<Weight, int> top = scratch.heap.back();
+            scratch.heap.pop_back();
+
+            int current = top.second;
+            if(scratch.settled[current])
+            {
+                continue;
+            }
+            scratch.settled[current] = 1;
+
+            if(columnOffsets[current] != columnOffsets[current + 1])
+            {
+                for(int i = columnOffsets[current]; i < columnOffsets[current + 1]; ++i)
+                {
+                    record(columns[i], top.first);
+                }
+                --remaining;
+            }
+
+            for(int edge = graph.edgesBegin(current); edge < graph.edgesEnd(current); ++edge)
+            {
+                int next = graph.target(edge);
+                Weight candidate = top.first + graph.weight(edge);
+
+                if(candidate < scratch.distance[next])
+                {
+                    if(scratch.distance[next] == infinity)
+                    {
+                        scratch.touched.push_back(next);
+                    }
+                    scratch.distance[next] = candidate;
+                    scratch.heap.push_back({candidate, next});
+                    std::push_heap(scratch.heap.begin(), scratch.heap.end(), heapOrder);
+                }
+            }
+        }
+
+        for(int vertex : scratch.touched)
+        {
+            scratch.distance[vertex] = infinity;
+            scratch.settled[vertex] = 0;
+        }
+        scratch.touched.clear();
+        scratch.heap.clear();
+    }
+
+
+    // buildColumnIndex() turns a list of vertex numbers into a table that
+    // maps each vertex index to the positions it occupies in that list
+    // (a vertex may be listed more than once), returning the number of
+    // distinct vertices listed.
+    template <typename Weight>
+    int buildColumnIndex(
+        const CompactDigraph<Weight>& graph,
+        const std::vector<int>& vertexNumbers,
+        std::vector<int>& columnOffsets,
+        std::vector<int>& columns)
+    {
+        std::vector<int> indexes;
+        indexes.reserve(vertexNumbers.size());
+        for(int vertex : vertexNumbers)
+        {
+            indexes.push_back(graph.indexOf(vertex));
+        }
+
+        columnOffsets.assign(graph.vertexCount() + 1, 0);
+        for(int index : indexes)
+        {
+            columnOffsets[index + 1]++;
+        }
+
+        int distinct = 0;
+        for(int i = 1; i <= graph.vertexCount(); ++i)
+        {
+            if(columnOffsets[i] != 0)
+            {
+                ++distinct;
+            }
+            columnOffsets[i] += columnOffsets[i - 1];
+        }
+
+        columns.resize(indexes.size());
+        std::vector<int> next(columnOffsets.begin(), columnOffsets.end() - 1);
+        for(unsigned int column = 0; column < indexes.size(); ++column)
+        {
+            columns[next[indexes[column]]++] = column;
+        }
+
+        return distinct;
+    }
+}
+
+
+
+template <typename Weight>
+void computeDistanceMatrix(
+    const CompactDigraph<Weight>& graph,
+    const std::vector<int>& sources,
+    const std::vector<int>& targets,
+    float* result,
+    unsigned int threadCount)
+{
+    const int rows = sources.size();
+    const int columns = targets.size();
+
+    std::fill(result, result + static_cast<std::size_t>(rows) * columns,
+              std::numeric_limits<float>::infinity());
+
+    //search from whichever side has fewer vertices
+    bool forward = rows <= columns;
+
+    const std::vector<int>& origins = forward ? sources : targets;
+    const std::vector<int>& destinations = forward ? targets : sources;
+
+    CompactDigraph<Weight> reversedGraph;
+    if(!forward)
+    {
+        reversedGraph = graph.reversed();
+    }
+    const CompactDigraph<Weight>& searchGraph = forward ? graph : reversedGraph;
+
+    std::vector<int> originIndexes;
+    originIndexes.reserve(origins.size());
+    for(int vertex : origins)
+    {
+        originIndexes.push_back(graph.indexOf(vertex));
+    }
+
+    std::vector<int> columnOffsets;
+    std::vector<int> columnList;
+    int distinct = DistanceMatrixDetail::buildColumnIndex(
+        graph, destinations, columnOffsets, columnList);
+
+    if(threadCount == 0)
+    {
+        threadCount = defaultThreadCount();
+    }
+    std::vector<DistanceMatrixDetail::SearchScratch<Weight>> scratch(threadCount);
+
+    parallelFor(origins.size(), threadCount,
+        [&](int origin, unsigned int threadIndex)
+        {
+            DistanceMatrixDetail::searchOneSide(
+                searchGraph, originIndexes[origin], columnOffsets, columnList,
+                distinct, scratch[threadIndex],
+                [&](int destination, Weight distance)
+                {
+                    if(forward)
+                    {
+                        result[static_cast<std::size_t>(origin) * columns + destination] = distance;
+                    }
+                    else
+                    {
+                        result[static_cast<std::size_t>(destination) * columns + origin] = distance;
+                    }
+                });
+        });
+}
+
+
+template <typename Weight>
+std::vector<float> computeDistanceMatrix(
+    const CompactDigraph<Weight>& graph,
+    const std::vector<int>& sources,
+    const std::vector<int>& targets,
+    unsigned int threadCount)
+{
+    std::vector<float> result(sources.size() * targets.size());
+    computeDistanceMatrix(graph, sources, targets, result.data(), threadCount);
+    return result;
+}
+
+
+
+#endif // DISTANCEMATRIX_HPP
@@ -0,0 +1,230 @@
+// GraphOverlay.hpp
+//
+// ICS 46 Winter 2019
+// Project #4: Rock and Roll Stops the Traffic
+//
+// A GraphOverlay describes temporary changes to a CompactDigraph -- vertices
+// and edges that are closed, and edges whose weights are different -- that
+// a search can honor as it goes (see the findShortestPath() overload in
+// ShortestPath.hpp that takes one) without the graph itself being copied
+// or changed.  So any number of searches can share one graph while each
+// asks its own "what if these roads were closed?" question.
+//
+// Vertices and edges are identified by their indexes in the graph.  Closed
+// vertices and edges are kept in bitsets, so a search can check an edge in
+// constant time; the overlay also remembers which ones it has changed, so
+// that prepare() can undo them in time proportional to how many there
+// were rather than to the size of the graph.  Like a SearchWorkspace, a
+// GraphOverlay is meant to be kept by one thread and reused.
+
+#ifndef GRAPHOVERLAY_HPP
+#define GRAPHOVERLAY_HPP
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "CompactDigraph.hpp"
+
+
+
+template <typename Weight>
+class GraphOverlay
+{
+public:
+    // Initializes a GraphOverlay with room for the given numbers of
+    // vertices and edges, and no changes.
+    explicit GraphOverlay(int vertexCount = 0, int edgeCount = 0);
+
+    // prepare() undoes every change and makes room for the given numbers
+    // of vertices and edges, so that the overlay can be reused for a
+    // graph of that size.
+    void prepare(int vertexCount, int edgeCount);
+
+    // closeVertex() closes the vertex with the given index, which closes
+    // every edge leading to it.
+    void closeVertex(int index);
+
+    // closeEdge() closes the given edge.
+    void closeEdge(int edge);
+
+    // setWeight() gives the given edge a different weight.
+    void setWeight(int edge, Weight weight);
+
+    // vertexClosed() and edgeClosed() return true if the given vertex or
+    // edge has been closed.
+    bool vertexClosed(int index) const;
+    bool edgeClosed(int edge) const;
+
+    // edgeWeight() returns false if the given edge, or the vertex it leads
+    // to, is closed; otherwise it stores the edge's weight -- the one given
+    // to setWeight(), if any, or else the graph's -- into "weight".
+    bool edgeWeight(const CompactDigraph<Weight>& graph, int edge, Weight& weight) const;
+
+    // changeCount() returns the number of vertices and edges changed since
+    // the last call to prepare().
+    int changeCount() const noexcept;
+
+
+private:
+    static bool test(const std::vector<std::uint64_t>& bits, int bit);
+    static bool testAndSet(std::vector<std::uint64_t>& bits, int bit);
+    static void reset(std::vector<std::uint64_t>& bits, int bit);
+
+    std::vector<std::uint64_t> closedVertices;
+
+    //an edge's bit is set here if it's closed or has a new weight, so the
+    //search only has to look further for the few edges that do
+    std::vector<std::uint64_t> changedEdges;
+    std::vector<std::uint64_t> closedEdges;
+    std::unordered_map<int, Weight> weights;
+
+    std::vector<int> changedVertexList;
+    std::vector<int> changedEdgeList;
+};
+
+
+
+template <typename Weight>
+GraphOverlay<Weight>::GraphOverlay(int vertexCount, int edgeCount)
+{
+    prepare(vertexCount, edgeCount);
+}
+
+
+template <typename Weight>
+void GraphOverlay<Weight>::prepare(int vertexCount, int edgeCount)
+{
+    for(int index : changedVertexList)
+    {
+        reset(closedVertices, index);
+    }
+    for(int edge : changedEdgeList)
+    {
+        reset(changedEdges, edge);
+        reset(closedEdges, edge);
+    }
+    changedVertexList.clear();
+    changedEdgeList.clear();
+    weights.clear();
+
+    if(static_cast<int>(closedVertices.size()) * 64 < vertexCount)
+    {
+        closedVertices.resize((vertexCount + 63) / 64, 0);
+    }
+    if(static_cast<int>(changedEdges.size()) * 64 < edgeCount)
+    {
+        changedEdges.resize((edgeCount + 63) / 64, 0);
+        closedEdges.resize((edgeCount + 63) / 64, 0);
+    }
+}
+
+
+template <typename Weight>
+void GraphOverlay<Weight>::closeVertex(int index)
+{
+    if(testAndSet(closedVertices, index))
+    {
+        changedVertexList.push_back(index);
+    }
+}
+
+
+template <typename Weight>
+void GraphOverlay<Weight>::closeEdge(int edge)
+{
+    if(testAndSet(changedEdges, edge))
+    {
+        changedEdgeList.push_back(edge);
+    }
+    testAndSet(closedEdges, edge);
+}
+
+
+template <typename Weight>
+void GraphOverlay<Weight>::setWeight(int edge, Weight weight)
+{
+    if(testAndSet(changedEdges, edge))
+    {
+        changedEdgeList.push_back(edge);
+    }
+    weights[edge] = weight;
+}
+
+
+template <typename Weight>
+bool GraphOverlay<Weight>::vertexClosed(int index) const
+{
+    return test(closedVertices, index);
+}
+
+
+template <typename Weight>
+bool GraphOverlay<Weight>::edgeClosed(int edge) const
+{
+    return test(closedEdges, edge);
+}
+
+
+template <typename Weight>
+bool GraphOverlay<Weight>::edgeWeight(
+    const CompactDigraph<Weight>& graph, int edge, Weight& weight) const
+{
+    if(test(closedVertices, graph.target(edge)))
+    {
+        return false;
+    }
+
+    if(test(changedEdges, edge))
+    {
+        if(test(closedEdges, edge))
+        {
+            return false;
+        }
+
+        auto found = weights.find(edge);
+        if(found != weights.end())
+        {
+            weight = found->second;
+            return true;
+        }
+    }
+
+    weight = graph.weight(edge);
+    return true;
+}
+
+
+template <typename Weight>
+int GraphOverlay<Weight>::changeCount() const noexcept
+{
+    return changedVertexList.size() + changedEdgeList.size();
+}
+
+
+template <typename Weight>
+bool GraphOverlay<Weight>::test(const std::vector<std::uint64_t>& bits, int bit)
+{
+    return (bits[bit / 64] >> (bit % 64)) & 1;
+}
+
+
+template <typename Weight>
+bool GraphOverlay<Weight>::testAndSet(std::vector<std::uint64_t>& bits, int bit)
+{
+    std::uint64_t mask = std::uint64_t{1} << (bit % 64);
+    bool wasSet = bits[bit / 64] & mask;
+    bits[bit / 64] |= mask;
+    return !wasSet;
+}
+
+
+template <typename Weight>
+void GraphOverlay<Weight>::reset(std::vector<std::uint64_t>& bits, int bit)
+{
+    bits[bit / 64] &= ~(std::uint64_t{1} << (bit % 64));
+}
+
+
+
+#endif // GRAPHOVERLAY_HPP
+
@@ -0,0 +1,474 @@
+// LandmarkTable.hpp
+//
+// ICS 46 Winter 2019
+// Project #4: Rock and Roll Stops the Traffic
+//
+// A LandmarkTable supports "ALT" searches (A*, Landmarks, and the Triangle
+// inequality), which aim a shortest path search at its destination without
+// needing to know where any vertex actually is.  A handful of vertices are
+// chosen as landmarks, and the shortest path distance from every landmark
+// to every vertex, and from every vertex to every landmark, is worked out
+// ahead of time.  By the triangle inequality, for any landmark L,
+//
+//     dist(v, t) >= dist(L, t) - dist(L, v)
+//     dist(v, t) >= dist(v, L) - dist(t, L)
+//
+// so the largest of these over all landmarks is a lower bound on the rest
+// of the trip from v to t, which findShortestPathAlt() uses to explore
+// toward t first.
+//
+// Landmarks are chosen by "farthest" selection: each new landmark is the
+// vertex farthest from all of the landmarks chosen so far (vertices that
+// can't be reached at all count as farthest), which tends to put them out
+// at the edges of the map where their bounds are sharpest.
+//
+// Building a table costs two full searches per landmark, so a table can
+// be saved to a stream and loaded again later instead.  A saved table
+// records a fingerprint of the vertices, edges and weights of the graph it
+// was built for, and won't load against a different one.
+
+#ifndef LANDMARKTABLE_HPP
+#define LANDMARKTABLE_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <istream>
+#include <limits>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#include "CompactDigraph.hpp"
+#include "ParallelFor.hpp"
+#include "SearchWorkspace.hpp"
+#include "ShortestPath.hpp"
+
+
+
+class LandmarkTableException : public std::runtime_error
+{
+public:
+    LandmarkTableException(const std::string& reason);
+};
+
+
+inline LandmarkTableException::LandmarkTableException(const std::string& reason)
+    : std::runtime_error{reason}
+{
+}
+
+
+
+class LandmarkTable
+{
+public:
+    // The default constructor initializes a table with no landmarks,
+    // whose lower bounds are always 0.
+    LandmarkTable();
+
+    // This constructor chooses the given number of landmarks in the given
+    // graph (fewer if the graph has fewer vertices) and computes their
+    // distances, using up to threadCount threads (0 means one per
+    // hardware thread).
+    LandmarkTable(const CompactDigraph<double>& graph, int landmarkCount,
+                  unsigned int threadCount = 0);
+
+    // landmarkCount() returns the number of landmarks in the table.
+    int landmarkCount() const noexcept;
+
+    // landmark() returns the vertex index of the landmark with the
+    // given number.
+    int landmark(int number) const;
+
+    // lowerBound() returns a lower bound on the shortest path distance
+    // from the vertex with index "from" to the vertex with index "to".
+    double lowerBound(int from, int to) const;
+
+    // byteCount() returns the number of bytes used to store the table.
+    std::size_t byteCount() const noexcept;
+
+    // save() writes the table to the given (binary) output stream.
+    void save(std::ostream& out) const;
+
+    // load() reads a table previously written by save(), replacing this
+    // table's contents.  If the stream doesn't contain a table, or the
+    // table was built for a graph other than the given one, a
+    // LandmarkTableException is thrown and this table is left unchanged.
+    void load(std::istream& in, const CompactDigraph<double>& graph);
+
+
+private:
+    static std::uint64_t fingerprint(const CompactDigraph<double>& graph);
+
+    int count;
+    int vertexCount;
+    std::uint64_t graphFingerprint;
+    std::vector<int> landmarks;
+
+    //fromLandmark[v * count + i] is the distance from landmark i to v;
+    //toLandmark[v * count + i] is the distance from v to landmark i
+    std::vector<double> fromLandmark;
+    std::vector<double> toLandmark;
+};
+
+
+// findShortestPathAlt() returns the vertex indexes along a shortest path
+// from startIndex to endIndex (empty if there is none), like
+// findShortestPath() in ShortestPath.hpp, but uses the given table's
+// lower bounds to steer the search toward endIndex.  The table must have
+// been built for the same graph.
+inline std::vector<int> findShortestPathAlt(
+    const CompactDigraph<double>& graph, const LandmarkTable& table,
+    int startIndex, int endIndex);
+
+// This overload of findShortestPathAlt() works in the given workspace and
+// fills in "path", like the similar overload of findShortestPath().
+inline void findShortestPathAlt(
+    const CompactDigraph<double>& graph, const LandmarkTable& table,
+    int startIndex, int endIndex, SearchWorkspace<double>& workspace,
+    std::vector<int>& path);
+
+
+
+namespace LandmarkTableDetail
+{
+    const char magic[8] = {'A', 'L', 'T', 'T', 'A', 'B', 'L', '1'};
+
+    // allDistances() runs Dijkstra's algorithm from every one of the
+    // given vertex indexes at once (a multi-source search), returning the
+    // distance from the nearest of them to every vertex.
+    inline std::vector<double> allDistances(
+        const CompactDigraph<double>& graph, const std::vector<int>& starts)
+    {
+        const double infinity = std::numeric_limits<double>::infinity();
+        std::vector<double> distance(graph.vertexCount(), infinity);
+        std::vector<std::pair<double, int>> heap;
+        std::greater<std::pair<double, int>> heapOrder;
+
+        for(int start : starts)
+        {
+            distance[start] = 0.0;
+            heap.push_back({0.0, start});
+        }
+        std::make_heap(heap.begin(), heap.end(), heapOrder);
+
+        while(!heap.empty())
+        {
+            std::pop_heap(heap.begin(), heap.end(), heapOrder);
+            std::pair<double, int> top = heap.back();
+            heap.pop_back();
+
+            if(top.first > distance[top.second])
+            {
+                continue;
+            }
+
+            for(int edge = graph.edgesBegin(top.second); edge < graph.edgesEnd(top.second); ++edge)
+            {
+                int next = graph.target(edge);
+                double candidate = top.first + graph.weight(edge);
+                if(candidate < distance[next])
+                {
+                    distance[next] = candidate;
+                    heap.push_back({candidate, next});
+                    std::push_heap(heap.begin(), heap.end(), heapOrder);
+                }
+            }
+        }
+
+        return distance;
+    }
+
+
+    template <typename T>
+    void write(std::ostream& out, const T& value)
+    {
+        out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+
+    template <typename T>
+    void read(std::istream& in, T& value)
+    {
+        in.read(reinterpret_cast<char*>(&value), sizeof(T));
+    }
+}
+
+
+
+inline LandmarkTable::LandmarkTable()
+    : count{0}, vertexCount{0}, graphFingerprint{0}
+{
+}
+
+
+inline LandmarkTable::LandmarkTable(
+    const CompactDigraph<double>& graph, int landmarkCount, unsigned int threadCount)
+    : count{std::max(0, std::min(landmarkCount, graph.vertexCount()))},
+      vertexCount{graph.vertexCount()},
+      graphFingerprint{fingerprint(graph)}
+{
+    const double infinity = std::numeric_limits<double>::infinity();
+
+    //farthest selection, starting from whichever vertex is farthest from
+    //vertex 0; choosing needs one multi-source search per landmark
+    std::vector<double> nearest;
+    if(count > 0)
+    {
+        nearest = LandmarkTableDetail::allDistances(graph, {0});
+    }
+
+    std::vector<char> chosen(vertexCount, 0);
+    while(static_cast<int>(landmarks.size()) < count)
+    {
+        int farthest = 0;
+        double farthestDistance = -1.0;
+        for(int vertex = 0; vertex < vertexCount; ++vertex)
+        {
+            if(chosen[vertex])
+            {
+                continue;
+            }
+            double distance = nearest[vertex] == infinity
+                ? std::numeric_limits<double>::max() : nearest[vertex];
+            if(distance > farthestDistance)
+            {
+                farthestDistance = distance;
+                farthest = vertex;
+            }
+        }
+
+        landmarks.push_back(farthest);
+        chosen[farthest] = 1;
+        nearest = LandmarkTableDetail::allDistances(graph, landmarks);
+    }
+
+    //with the landmarks chosen, their distances are independent searches
+    CompactDigraph<double> reversedGraph = graph.reversed();
+    fromLandmark.resize(static_cast<std::size_t>(vertexCount) * count);
+    toLandmark.resize(static_cast<std::size_t>(vertexCount) * count);
+
+    parallelFor(count * 2, threadCount,
+        [&](int job, unsigned int)
+        {
+            int number = job / 2;
+            bool forward = job % 2 == 0;
+
+            std::vector<double> distance = LandmarkTableDetail::allDistances(
+                forward ? graph : reversedGraph, {landmarks[number]});
+
+            std::vector<double>& table = forward ? fromLandmark : toLandmark;
+            for(int vertex = 0; vertex < vertexCount; ++vertex)
+            {
+                table[static_cast<std::size_t>(vertex) * count + number] = distance[vertex];
+            }
+        });
+}
+
+
+inline int LandmarkTable::landmarkCount() const noexcept
+{
+    return count;
+}
+
+
+inline int LandmarkTable::landmark(int number) const
+{
+    return landmarks[number];
+}
+
+
+inline std::size_t LandmarkTable::byteCount() const noexcept
+{
+    return landmarks.size() * sizeof(int)
+        + (fromLandmark.size() + toLandmark.size()) * sizeof(double);
+}
+
+
+inline double LandmarkTable::lowerBound(int from, int to) const
+{
+    const double infinity = std::numeric_limits<double>::infinity();
+    const double* fromFrom = fromLandmark.data() + static_cast<std::size_t>(from) * count;
+    const double* fromTo = fromLandmark.data() + static_cast<std::size_t>(to) * count;
+    const double* toFrom = toLandmark.data() + static_cast<std::size_t>(from) * count;
+    const double* toTo = toLandmark.data() + static_cast<std::size_t>(to) * count;
+
+    double bound = 0.0;
+    for(int i = 0; i < count; ++i)
+    {
+        //an infinite distance says nothing useful about the other side
+        if(fromFrom[i] != infinity && fromTo[i] != infinity)
+        {
+            bound = std::max(bound, fromTo[i] - fromFrom[i]);
+        }
+        if(toFrom[i] != infinity && toTo[i] != infinity)
+        {
+            bound = std::max(bound, toFrom[i] - toTo[i]);
+        }
+    }
+    return bound;
+}
+
+
+inline std::uint64_t LandmarkTable::fingerprint(const CompactDigraph<double>& graph)
+{
+    //FNV-1a over every edge's endpoints and weight
+    std::uint64_t hash = 14695981039346656037ull;
+    auto mix = [&](std::uint64_t value)
+    {
+        for(int byte = 0; byte < 8; ++byte)
+        {
+            hash ^= (value >> (byte * 8)) & 0xff;
+            hash *= 1099511628211ull;
+        }
+    };
+
+    mix(graph.vertexCount());
+    for(int vertex = 0; vertex < graph.vertexCount(); ++vertex)
+    {
+        mix(graph.vertexNumber(vertex));
+        for(int edge = graph.edgesBegin(vertex); edge < graph.edgesEnd(vertex); ++edge)
+        {
+            double weight = graph.weight(edge);
+            std::uint64_t weightBits;
+            std::memcpy(&weightBits, &weight, sizeof(weightBits));
+            mix(graph.target(edge));
+            mix(weightBits);
+        }
+    }
+    return hash;
+}
+
+
+inline void LandmarkTable::save(std::ostream& out) const
+{
+    out.write(LandmarkTableDetail::magic, sizeof(LandmarkTableDetail::magic));
+    LandmarkTableDetail::write(out, static_cast<std::int32_t>(count));
+    LandmarkTableDetail::write(out, static_cast<std::int32_t>(vertexCount));
+    LandmarkTableDetail::write(out, graphFingerprint);
+
+    for(int landmark : landmarks)
+    {
+        LandmarkTableDetail::write(out, static_cast<std::int32_t>(landmark));
+    }
+    out.write(reinterpret_cast<const char*>(fromLandmark.data()),
+              fromLandmark.size() * sizeof(double));
+    out.write(reinterpret_cast<const char*>(toLandmark.data()),
+              toLandmark.size() * sizeof(double));
+}
+
+
+inline void LandmarkTable::load(std::istream& in, const CompactDigraph<double>& graph)
+{
+    char magic[sizeof(LandmarkTableDetail::magic)];
+    in.read(magic, sizeof(magic));
+    if(!in || !std::equal(magic, magic + sizeof(magic), LandmarkTableDetail::magic))
+    {
+        throw LandmarkTableException("Not a landmark table");
+    }
+
+    std::int32_t savedCount;
+    std::int32_t savedVertexCount;
+    std::uint64_t savedFingerprint;
+    LandmarkTableDetail::read(in, savedCount);
+    LandmarkTableDetail::read(in, savedVertexCount);
+    LandmarkTableDetail::read(in, savedFingerprint);
+
+    if(!in || savedCount < 0 || savedCount > savedVertexCount ||
+       savedVertexCount != graph.vertexCount() || savedFingerprint != fingerprint(graph))
+    {
+        throw LandmarkTableException("Landmark table was built for a different graph");
+    }
+
+    std::vector<int> savedLandmarks(savedCount);
+    for(int& landmark : savedLandmarks)
+    {
+        std::int32_t value;
+        LandmarkTableDetail::read(in, value);
+        landmark = value;
+    }
+
+    std::size_t entries = static_cast<std::size_t>(savedVertexCount) * savedCount;
+    std::vector<double> savedFrom(entries);
+    std::vector<double> savedTo(entries);
+    in.read(reinterpret_cast<char*>(savedFrom.data()), entries * sizeof(double));
+    in.read(reinterpret_cast<char*>(savedTo.data()), entries * sizeof(double));
+
+    if(!in)
+    {
+        throw LandmarkTableException("Landmark table is truncated");
+    }
+
+    count = savedCount;
+    vertexCount = savedVertexCount;
+    graphFingerprint = savedFingerprint;
+    landmarks = std::move(savedLandmarks);
+    fromLandmark = std::move(savedFrom);
+    toLandmark = std::move(savedTo);
+}
+
+
+inline std::vector<int> findShortestPathAlt(
+    const CompactDigraph<double>& graph, const LandmarkTable& table,
+    int startIndex, int endIndex)
+{
+    SearchWorkspace<double> workspace{graph.vertexCount()};
+    std::vector<int> path;
+    findShortestPathAlt(graph, table, startIndex, endIndex, workspace, path);
+    return path;
+}
+
+
+inline void findShortestPathAlt(
+    const CompactDigraph<double>& graph, const LandmarkTable& table,
+    int startIndex, int endIndex, SearchWorkspace<double>& workspace,
+    std::vector<int>& path)
+{
+    //the lower bounds are consistent (they never drop by more than an
+    //edge's weight along that edge), so as in Dijkstra's algorithm each
+    //vertex is final the first time it comes off the heap, after which
+    //it's marked as settled; the heap holds (distance so far + lower
+    //bound on the rest, vertex)
+    const int settled = 1;
+
+    workspace.prepare(graph.vertexCount());
+    workspace.reach(startIndex, 0.0, startIndex);
+    workspace.push(table.lowerBound(startIndex, endIndex), startIndex);
+
+    while(!workspace.heapEmpty())
+    {
+        int current = workspace.pop().second;
+
+        if(current == endIndex)
+        {
+            break;
+        }
+        if(workspace.mark(current) == settled)
+        {
+            continue;
+        }
+        workspace.setMark(current, settled);
+
+        for(int edge = graph.edgesBegin(current); edge < graph.edgesEnd(current); ++edge)
+        {
+            int next = graph.target(edge);
+            double candidate = workspace.distance(current) + graph.weight(edge);
+
+            if(candidate < workspace.distance(next))
+            {
+                workspace.reach(next, candidate, current);
+                workspace.push(candidate + table.lowerBound(next, endIndex), next);
+            }
+        }
+    }
+
+    ShortestPathDetail::tracePath(workspace, startIndex, endIndex, path);
+}
+
+
+
+#endif // LANDMARKTABLE_HPP
@@ -0,0 +1,151 @@
+// MemoryBudget.hpp
+//
+// ICS 46 Winter 2019
+// Project #4: Rock and Roll Stops the Traffic
+//
+// A MemoryBudget puts a hard limit on how many bytes the structures a
+// program builds may use between them.  Each structure is charged to the
+// budget as it's loaded or grown (by the size its memoryUsage() or
+// byteCount() reports); a charge that would take the total past the limit
+// is refused with a MemoryBudgetException, and nothing is charged, so the
+// caller can refuse the load or drop the structure rather than letting the
+// process grow without bound.  Charges may be made from several threads
+// at once.
+
+#ifndef MEMORYBUDGET_HPP
+#define MEMORYBUDGET_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+
+
+
+class MemoryBudgetException : public std::runtime_error
+{
+public:
+    MemoryBudgetException(const std::string& reason);
+};
+
+
+
+class MemoryBudget
+{
+public:
+    // Initializes a MemoryBudget with the given limit, in bytes, with
+    // nothing charged to it yet.  A limit of 0 means there is no limit.
+    explicit MemoryBudget(std::size_t limit = 0);
+
+    // charge() adds the given number of bytes, used by the named
+    // structure, to the total.  If that would take the total past the
+    // limit, a MemoryBudgetException naming the structure is thrown
+    // instead, and the total is left as it was.
+    void charge(const std::string& what, std::size_t bytes);
+
+    // release() subtracts the given number of bytes from the total, when
+    // a structure that was charged is shrunk or destroyed.
+    void release(std::size_t bytes) noexcept;
+
+    // used() returns the number of bytes charged so far.
+    std::size_t used() const noexcept;
+
+    // limit() returns the limit, or 0 if there is none.
+    std::size_t limit() const noexcept;
+
+
+private:
+    std::size_t limitBytes;
+    std::atomic<std::size_t> usedBytes;
+};
+
+
+
+// A ScopedCharge charges a MemoryBudget for memory that's only needed for
+// a while (a buffer used while loading, say), and releases the charge when
+// it's destroyed.  Given no budget (a null pointer), it does nothing.
+class ScopedCharge
+{
+public:
+    ScopedCharge(MemoryBudget* budget, const std::string& what, std::size_t bytes);
+    ~ScopedCharge() noexcept;
+
+    ScopedCharge(const ScopedCharge&) = delete;
+    ScopedCharge& operator=(const ScopedCharge&) = delete;
+
+
+private:
+    MemoryBudget* budget;
+    std::size_t bytes;
+};
+
+
+
+inline MemoryBudgetException::MemoryBudgetException(const std::string& reason)
+    : std::runtime_error{reason}
+{
+}
+
+
+inline MemoryBudget::MemoryBudget(std::size_t limit)
+    : limitBytes{limit}, usedBytes{0}
+{
+}
+
+
+inline void MemoryBudget::charge(const std::string& what, std::size_t bytes)
+{
+    std::size_t current = usedBytes.load(std::memory_order_relaxed);
+    do
+    {
+        if(limitBytes != 0 && (bytes > limitBytes || current > limitBytes - bytes))
+        {
+            throw MemoryBudgetException(
+                what + " needs " + std::to_string(bytes) + " bytes, but only " +
+                std::to_string(current < limitBytes ? limitBytes - current : 0) +
+                " of the " + std::to_string(limitBytes) + "-byte memory budget are left");
+        }
+    }
+    while(!usedBytes.compare_exchange_weak(current, current + bytes, std::memory_order_relaxed));
+}
+
+
+inline void MemoryBudget::release(std::size_t bytes) noexcept
+{
+    usedBytes.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+
+inline std::size_t MemoryBudget::used() const noexcept
+{
+    return usedBytes.load(std::memory_order_relaxed);
+}
+
+
+inline std::size_t MemoryBudget::limit() const noexcept
+{
+    return limitBytes;
+}
+
+
+inline ScopedCharge::ScopedCharge(MemoryBudget* budget, const std::string& what, std::size_t bytes)
+    : budget{budget}, bytes{bytes}
+{
+    if(budget != nullptr)
+    {
+        budget->charge(what, bytes);
+    }
+}
+
+
+inline ScopedCharge::~ScopedCharge() noexcept
+{
+    if(budget != nullptr)
+    {
+        budget->release(bytes);
+    }
+}
+
+
+
+#endif // MEMORYBUDGET_HPP
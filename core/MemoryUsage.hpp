@@ -0,0 +1,203 @@
+// MemoryUsage.hpp
+//
+// ICS 46 Winter 2019
+// Project #4: Rock and Roll Stops the Traffic
+//
+// A MemoryUsage is a breakdown of the memory a data structure uses, as a
+// list of named components (e.g., "vertices", "edges", "name index") and
+// the number of bytes in each, so that different ways of storing the same
+// map can be compared component by component rather than by guesswork.
+//
+// Node-based containers (std::map, std::list, std::unordered_map) make one
+// heap allocation per element, and each allocation costs more than the
+// element itself: the container's own links, and the allocator's header
+// and rounding.  The functions below estimate those costs the way the GNU
+// C++ library and glibc's malloc lay them out; the numbers are close, not
+// exact, on other platforms.  They count what a structure holds directly,
+// not memory that its elements own in turn (such as a std::string's
+// characters), which the structure has to add for itself if it knows.
+
+#ifndef MEMORYUSAGE_HPP
+#define MEMORYUSAGE_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <iomanip>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+
+
+class MemoryUsage
+{
+public:
+    // add() adds the given number of bytes to the named component, which
+    // is added to the end of the list if it isn't already in it.
+    void add(const std::string& component, std::size_t bytes);
+
+    // This overload of add() adds every component of another MemoryUsage,
+    // with its name prefixed by the given one (e.g., "map: edges").
+    void add(const std::string& prefix, const MemoryUsage& other);
+
+    // bytes() returns the number of bytes in the named component, or 0 if
+    // there is no such component.
+    std::size_t bytes(const std::string& component) const;
+
+    // total() returns the number of bytes in all of the components.
+    std::size_t total() const noexcept;
+
+    // components() returns every component's name and number of bytes, in
+    // the order they were first added.
+    const std::vector<std::pair<std::string, std::size_t>>& components() const noexcept;
+
+
+private:
+    std::vector<std::pair<std::string, std::size_t>> parts;
+};
+
+
+
+// heapBytes() returns the number of bytes the allocator sets aside to
+// satisfy a request for the given number of bytes.
+inline std::size_t heapBytes(std::size_t requested)
+{
+    //glibc adds an 8-byte header, rounds up to 16, and never hands out a
+    //chunk smaller than 32 bytes
+    return requested == 0 ? 0 : std::max<std::size_t>(32, (requested + 8 + 15) & ~std::size_t{15});
+}
+
+
+// vectorBytes() returns the number of bytes on the heap held by the given
+// std::vector, counting its capacity rather than its size.
+template <typename T>
+std::size_t vectorBytes(const std::vector<T>& v)
+{
+    return heapBytes(v.capacity() * sizeof(T));
+}
+
+
+// mapNodeBytes() returns the number of bytes one element of a std::map
+// with the given key and value types uses: a red-black tree node holding
+// its color and three links as well as the element.
+template <typename Key, typename Value>
+std::size_t mapNodeBytes()
+{
+    return heapBytes(4 * sizeof(void*) + sizeof(std::pair<const Key, Value>));
+}
+
+
+// listNodeBytes() returns the number of bytes one element of a std::list
+// uses: a node holding two links as well as the element.
+template <typename T>
+std::size_t listNodeBytes()
+{
+    return heapBytes(2 * sizeof(void*) + sizeof(T));
+}
+
+
+// unorderedMapBytes() returns the number of bytes the given
+// std::unordered_map uses for its nodes (each holding a link and, for all
+// but the simplest keys, the key's hash as well as the element) and its
+// array of buckets.
+template <typename Key, typename Value, typename Hash, typename Equal>
+std::size_t unorderedMapBytes(const std::unordered_map<Key, Value, Hash, Equal>& m)
+{
+    std::size_t node = heapBytes(2 * sizeof(void*) + sizeof(std::pair<const Key, Value>));
+    return m.size() * node + heapBytes(m.bucket_count() * sizeof(void*));
+}
+
+
+// writeMemoryUsage() writes one line per component of the given
+// MemoryUsage, then a line with the total, to the given stream.
+void writeMemoryUsage(std::ostream& out, const MemoryUsage& usage);
+
+
+
+inline void MemoryUsage::add(const std::string& component, std::size_t bytes)
+{
+    for(std::pair<std::string, std::size_t>& part : parts)
+    {
+        if(part.first == component)
+        {
+            part.second += bytes;
+            return;
+        }
+    }
+    parts.emplace_back(component, bytes);
+}
+
+
+inline void MemoryUsage::add(const std::string& prefix, const MemoryUsage& other)
+{
+    for(const std::pair<std::string, std::size_t>& part : other.parts)
+    {
+        add(prefix + ": " + part.first, part.second);
+    }
+}
+
+
+inline std::size_t MemoryUsage::bytes(const std::string& component) const
+{
+    for(const std::pair<std::string, std::size_t>& part : parts)
+    {
+        if(part.first == component)
+        {
+            return part.second;
+        }
+    }
+    return 0;
+}
+
+
+inline std::size_t MemoryUsage::total() const noexcept
+{
+    std::size_t sum = 0;
+    for(const std::pair<std::string, std::size_t>& part : parts)
+    {
+        sum += part.second;
+    }
+    return sum;
+}
+
+
+inline const std::vector<std::pair<std::string, std::size_t>>& MemoryUsage::components() const noexcept
+{
+    return parts;
+}
+
+
+inline void writeMemoryUsage(std::ostream& out, const MemoryUsage& usage)
+{
+    std::size_t width = 5;
+    for(const std::pair<std::string, std::size_t>& part : usage.components())
+    {
+        width = std::max(width, part.first.size());
+    }
+
+    std::ios_base::fmtflags flags = out.flags();
+    std::streamsize precision = out.precision();
+    out<<std::fixed<<std::setprecision(1);
+
+    auto writeLine = [&](const std::string& name, std::size_t bytes)
+    {
+        out<<"    "<<std::left<<std::setw(width)<<name<<"  "
+           <<std::right<<std::setw(14)<<bytes<<" bytes  ("
+           <<std::setw(8)<<bytes / (1024.0 * 1024.0)<<" MiB)\n";
+    };
+
+    for(const std::pair<std::string, std::size_t>& part : usage.components())
+    {
+        writeLine(part.first, part.second);
+    }
+    writeLine("Total", usage.total());
+
+    out.flags(flags);
+    out.precision(precision);
+}
+
+
+
+#endif // MEMORYUSAGE_HPP
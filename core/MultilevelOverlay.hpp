@@ -0,0 +1,700 @@
+// MultilevelOverlay.hpp
+//
+// ICS 46 Winter 2019
+// Project #4: Rock and Roll Stops the Traffic
+//
+// This header supports multilevel overlay routing, which splits the work
+// of speeding up searches into a part that depends only on the shape of
+// the graph and a part that depends on its weights, so that when speeds
+// change only the cheap second part has to be redone.
+//
+// A CellPartition (the metric-independent part) divides the vertices into
+// cells of at most a given size, then divides each of those cells into
+// smaller ones, and so on, one level per size.  Level 0 holds the smallest
+// cells, and every cell is nested inside exactly one cell of each coarser
+// level.  A vertex with an edge to or from a vertex in another cell of
+// some level is a "boundary" vertex of its cell on that level.
+//
+// OverlayCosts (the "customization") works out, for every cell on every
+// level, the length of the shortest path inside that cell from each of its
+// boundary vertices to each of the others -- a clique of shortcut edges.
+// Level 0 cliques come from searches over the graph itself, and each
+// coarser level's cliques come from searches over the cliques of the level
+// below, so the cells on one level are independent and are customized in
+// parallel.
+//
+// findShortestPathOverlay() then searches the graph itself only within the
+// smallest cells holding the start and end vertices, and elsewhere hops
+// across whole cells -- the biggest ones that hold neither end -- along
+// their cliques.  Each clique edge on the resulting path is turned back
+// into vertices by a search confined to its cell.
+
+#ifndef MULTILEVELOVERLAY_HPP
+#define MULTILEVELOVERLAY_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <utility>
+#include <vector>
+#include "CompactDigraph.hpp"
+#include "ParallelFor.hpp"
+#include "SearchWorkspace.hpp"
+
+
+
+class CellPartition
+{
+public:
+    // The default constructor initializes a partition with no levels.
+    CellPartition();
+
+    // This constructor partitions the vertices of the given graph, ignoring
+    // its weights and the directions of its edges.  cellSizes lists the
+    // largest number of vertices allowed in one cell on each level, from
+    // level 0 up, and must be increasing.
+    template <typename Weight>
+    CellPartition(const CompactDigraph<Weight>& graph, const std::vector<int>& cellSizes);
+
+    // levelCount() returns the number of levels.
+    int levelCount() const noexcept;
+
+    // cellCount() returns the number of cells on the given level.
+    int cellCount(int level) const;
+
+    // cellOf() returns the cell on the given level that holds the vertex
+    // with the given index.
+    int cellOf(int level, int vertex) const;
+
+    // boundaryVertices() returns the indexes of the boundary vertices of
+    // the given cell on the given level, in increasing order.
+    const std::vector<int>& boundaryVertices(int level, int cell) const;
+
+    // boundaryPosition() returns the position of the vertex with the given
+    // index in boundaryVertices() for its cell on the given level, or -1
+    // if it isn't a boundary vertex on that level.
+    int boundaryPosition(int level, int vertex) const;
+
+    // byteCount() returns the number of bytes used to store the partition.
+    std::size_t byteCount() const noexcept;
+
+
+private:
+    //splits the vertices into two halves by growing a breadth-first
+    //search from a vertex on the outskirts of the piece
+    void bisect(
+        const std::vector<int>& piece,
+        std::vector<int>& firstHalf, std::vector<int>& secondHalf);
+
+    //gives the piece a cell on each level it now fits, then splits it
+    //further if there are finer levels left
+    void assignCells(const std::vector<int>& piece, int level);
+
+    std::vector<int> sizes;
+
+    //undirected adjacency lists, laid out the way CompactDigraph does it
+    std::vector<int> neighborOffsets;
+    std::vector<int> neighbors;
+
+    //scratch space for bisect(), marked with a new stamp for each piece
+    std::vector<int> pieceStamp;
+    std::vector<int> visitStamp;
+    int stamp;
+
+    //cells[level][vertex], boundaries[level][cell] and
+    //positions[level][vertex]
+    std::vector<std::vector<int>> cells;
+    std::vector<std::vector<std::vector<int>>> boundaries;
+    std::vector<std::vector<int>> positions;
+};
+
+
+
+class OverlayCosts
+{
+public:
+    // The default constructor initializes empty costs, which can't be
+    // used for searching.
+    OverlayCosts();
+
+    // This constructor customizes the given partition (which must have
+    // been built from a graph with the same vertices and edges) for the
+    // weights in the given graph, using up to threadCount threads (0 means
+    // one per hardware thread).
+    OverlayCosts(const CompactDigraph<double>& graph, const CellPartition& partition,
+                 unsigned int threadCount = 0);
+
+    // cost() returns the length of the shortest path inside the given
+    // cell on the given level, from the boundary vertex in position
+    // "from" to the one in position "to" (see boundaryVertices()), or
+    // infinity if there is no such path.
+    double cost(int level, int cell, int from, int to) const;
+
+    // byteCount() returns the number of bytes used to store the costs.
+    std::size_t byteCount() const noexcept;
+
+
+private:
+    //the clique for cell c on level l is the boundarySize * boundarySize
+    //block starting at cliques[l][offsets[l][c]], one row per "from"
+    std::vector<std::vector<std::size_t>> offsets;
+    std::vector<std::vector<double>> cliques;
+    std::vector<std::vector<int>> boundarySizes;
+};
+
+
+// findShortestPathOverlay() returns the vertex indexes along a shortest
+// path from startIndex to endIndex (empty if there is none), like
+// findShortestPath() in ShortestPath.hpp.  The partition and costs must
+// have been built for the given graph.
+inline std::vector<int> findShortestPathOverlay(
+    const CompactDigraph<double>& graph, const CellPartition& partition,
+    const OverlayCosts& costs, int startIndex, int endIndex);
+
+// This overload of findShortestPathOverlay() works in the given
+// workspaces (one for the search, one for expanding clique edges) and
+// fills in "path", like the similar overload of findShortestPath().
+inline void findShortestPathOverlay(
+    const CompactDigraph<double>& graph, const CellPartition& partition,
+    const OverlayCosts& costs, int startIndex, int endIndex,
+    SearchWorkspace<double>& workspace, SearchWorkspace<double>& unpackWorkspace,
+    std::vector<int>& path);
+
+
+
+namespace MultilevelOverlayDetail
+{
+    const double infinity = std::numeric_limits<double>::infinity();
+
+
+    // search() runs Dijkstra's algorithm in the given workspace from start
+    // until stop is settled (or everything reachable is, if stop is -1).
+    // expand(vertex, relax) must call relax(next, weight) for each edge
+    // leaving the vertex; relax() returns true if it shortened the
+    // distance to next, in which case the workspace's mark for next can
+    // be set to say how it was reached.
+    template <typename ExpandFunc>
+    void search(SearchWorkspace<double>& workspace, int vertexCount,
+                int start, int stop, ExpandFunc expand)
+    {
+        workspace.prepare(vertexCount);
+        workspace.reach(start, 0.0, start);
+        workspace.push(0.0, start);
+
+        while(!workspace.heapEmpty())
+        {
+            std::pair<double, int> top = workspace.pop();
+
+            int current = top.second;
+            if(top.first > workspace.distance(current))
+            {
+                continue;
+            }
+            if(current == stop)
+            {
+                break;
+            }
+
+            expand(current,
+                [&](int next, double weight)
+                {
+                    double candidate = top.first + weight;
+                    if(candidate < workspace.distance(next))
+                    {
+                        workspace.reach(next, candidate, current);
+                        workspace.push(candidate, next);
+                        return true;
+                    }
+                    return false;
+                });
+        }
+    }
+}
+
+
+
+inline CellPartition::CellPartition()
+    : stamp{0}
+{
+}
+
+
+template <typename Weight>
+CellPartition::CellPartition(
+    const CompactDigraph<Weight>& graph, const std::vector<int>& cellSizes)
+    : sizes{cellSizes}, stamp{0}
+{
+    int vertexCount = graph.vertexCount();
+
+    //an edge in either direction makes two vertices neighbors
+    std::vector<int> degree(vertexCount, 0);
+    for(int vertex = 0; vertex < vertexCount; ++vertex)
+    {
+        for(int edge = graph.edgesBegin(vertex); edge < graph.edgesEnd(vertex); ++edge)
+        {
+            ++degree[vertex];
+            ++degree[graph.target(edge)];
+        }
+    }
+
+    neighborOffsets.assign(vertexCount + 1, 0);
+    for(int vertex = 0; vertex < vertexCount; ++vertex)
+    {
+        neighborOffsets[vertex + 1] = neighborOffsets[vertex] + degree[vertex];
+    }
+
+    neighbors.resize(neighborOffsets[vertexCount]);
+    std::vector<int> filled(neighborOffsets.begin(), neighborOffsets.end() - 1);
+    for(int vertex = 0; vertex < vertexCount; ++vertex)
+    {
+        for(int edge = graph.edgesBegin(vertex); edge < graph.edgesEnd(vertex); ++edge)
+        {
+            neighbors[filled[vertex]++] = graph.target(edge);
+            neighbors[filled[graph.target(edge)]++] = vertex;
+        }
+    }
+
+    cells.assign(sizes.size(), std::vector<int>(vertexCount, -1));
+    boundaries.resize(sizes.size());
+    positions.assign(sizes.size(), std::vector<int>(vertexCount, -1));
+    pieceStamp.assign(vertexCount, 0);
+    visitStamp.assign(vertexCount, 0);
+
+    std::vector<int> everything(vertexCount);
+    for(int vertex = 0; vertex < vertexCount; ++vertex)
+    {
+        everything[vertex] = vertex;
+    }
+    if(vertexCount > 0)
+    {
+        assignCells(everything, levelCount() - 1);
+    }
+
+    for(int level = 0; level < levelCount(); ++level)
+    {
+        std::vector<std::vector<int>>& levelBoundaries = boundaries[level];
+
+        //vertices are visited in increasing order, so each boundary list
+        //comes out sorted
+        for(int vertex = 0; vertex < vertexCount; ++vertex)
+        {
+            int cell = cells[level][vertex];
+            for(int i = neighborOffsets[vertex]; i < neighborOffsets[vertex + 1]; ++i)
+            {
+                if(cells[level][neighbors[i]] != cell)
+                {
+                    positions[level][vertex] = levelBoundaries[cell].size();
+                    levelBoundaries[cell].push_back(vertex);
+                    break;
+                }
+            }
+        }
+    }
+
+    //the scratch space is only needed while partitioning
+    pieceStamp = std::vector<int>{};
+    visitStamp = std::vector<int>{};
+}
+
+
+inline void CellPartition::assignCells(const std::vector<int>& piece, int level)
+{
+    while(level >= 0 && static_cast<int>(piece.size()) <= sizes[level])
+    {
+        int cell = boundaries[level].size();
+        boundaries[level].emplace_back();
+        for(int vertex : piece)
+        {
+            cells[level][vertex] = cell;
+        }
+        --level;
+    }
+
+    if(level < 0)
+    {
+        return;
+    }
+
+    std::vector<int> firstHalf;
+    std::vector<int> secondHalf;
+    bisect(piece, firstHalf, secondHalf);
+    assignCells(firstHalf, level);
+    assignCells(secondHalf, level);
+}
+
+
+inline void CellPartition::bisect(
+    const std::vector<int>& piece,
+    std::vector<int>& firstHalf, std::vector<int>& secondHalf)
+{
+    int pieceMark = ++stamp;
+    for(int vertex : piece)
+    {
+        pieceStamp[vertex] = pieceMark;
+    }
+
+    //one search from anywhere to find a vertex on the outskirts, then a
+    //second from there; the first half is whatever the second search
+    //reaches first, which tends to leave a short border between halves
+    std::vector<int> order;
+    order.reserve(piece.size());
+
+    auto search = [&](int start)
+    {
+        int visitMark = ++stamp;
+        order.clear();
+
+        for(std::size_t next = 0; next <= piece.size(); ++next)
+        {
+            int root = next == 0 ? start : piece[next - 1];
+            if(visitStamp[root] == visitMark)
+            {
+                continue;
+            }
+
+            //another connected part of the piece
+            std::size_t head = order.size();
+            visitStamp[root] = visitMark;
+            order.push_back(root);
+
+            while(head < order.size())
+            {
+                int vertex = order[head++];
+                for(int i = neighborOffsets[vertex]; i < neighborOffsets[vertex + 1]; ++i)
+                {
+                    int neighbor = neighbors[i];
+                    if(pieceStamp[neighbor] == pieceMark && visitStamp[neighbor] != visitMark)
+                    {
+                        visitStamp[neighbor] = visitMark;
+                        order.push_back(neighbor);
+                    }
+                }
+            }
+        }
+    };
+
+    search(piece.front());
+    search(order.back());
+
+    std::size_t half = order.size() / 2;
+    firstHalf.assign(order.begin(), order.begin() + half);
+    secondHalf.assign(order.begin() + half, order.end());
+}
+
+
+inline std::size_t CellPartition::byteCount() const noexcept
+{
+    std::size_t ints = sizes.size() + neighborOffsets.size() + neighbors.size()
+        + pieceStamp.size() + visitStamp.size();
+
+    for(int level = 0; level < levelCount(); ++level)
+    {
+        ints += cells[level].size() + positions[level].size();
+        for(const std::vector<int>& boundary : boundaries[level])
+        {
+            ints += boundary.size();
+        }
+    }
+    return ints * sizeof(int);
+}
+
+
+inline int CellPartition::levelCount() const noexcept
+{
+    return sizes.size();
+}
+
+
+inline int CellPartition::cellCount(int level) const
+{
+    return boundaries[level].size();
+}
+
+
+inline int CellPartition::cellOf(int level, int vertex) const
+{
+    return cells[level][vertex];
+}
+
+
+inline const std::vector<int>& CellPartition::boundaryVertices(int level, int cell) const
+{
+    return boundaries[level][cell];
+}
+
+
+inline int CellPartition::boundaryPosition(int level, int vertex) const
+{
+    return positions[level][vertex];
+}
+
+
+
+inline OverlayCosts::OverlayCosts()
+{
+}
+
+
+inline OverlayCosts::OverlayCosts(
+    const CompactDigraph<double>& graph, const CellPartition& partition,
+    unsigned int threadCount)
+    : offsets(partition.levelCount()),
+      cliques(partition.levelCount()),
+      boundarySizes(partition.levelCount())
+{
+    if(threadCount == 0)
+    {
+        threadCount = defaultThreadCount();
+    }
+
+    //a mark of 1 means the vertex was reached along a clique edge
+    const int viaClique = 1;
+    std::vector<SearchWorkspace<double>> workspaces(threadCount);
+
+    for(int level = 0; level < partition.levelCount(); ++level)
+    {
+        int cellCount = partition.cellCount(level);
+        std::size_t total = 0;
+        for(int cell = 0; cell < cellCount; ++cell)
+        {
+            int size = partition.boundaryVertices(level, cell).size();
+            offsets[level].push_back(total);
+            boundarySizes[level].push_back(size);
+            total += static_cast<std::size_t>(size) * size;
+        }
+        cliques[level].assign(total, MultilevelOverlayDetail::infinity);
+
+        parallelFor(cellCount, threadCount,
+            [&](int cell, unsigned int threadIndex)
+            {
+                SearchWorkspace<double>& workspace = workspaces[threadIndex];
+                const std::vector<int>& boundary = partition.boundaryVertices(level, cell);
+                double* clique = cliques[level].data() + offsets[level][cell];
+
+                //on level 0, the edges of the graph itself inside the cell
+                auto expandGraph = [&](int vertex, auto relax)
+                {
+                    for(int edge = graph.edgesBegin(vertex); edge < graph.edgesEnd(vertex); ++edge)
+                    {
+                        int next = graph.target(edge);
+                        if(partition.cellOf(level, next) == cell)
+                        {
+                            relax(next, graph.weight(edge));
+                        }
+                    }
+                };
+
+                //on coarser levels, the cliques of the level below plus the
+                //edges between its cells, as long as they stay in this cell;
+                //a vertex reached along a clique edge can skip its own
+                //clique, since clique costs already obey the triangle
+                //inequality
+                auto expandOverlay = [&](int vertex, auto relax)
+                {
+                    int below = level - 1;
+                    int subcell = partition.cellOf(below, vertex);
+
+                    if(workspace.mark(vertex) != viaClique)
+                    {
+                        const std::vector<int>& subBoundary =
+                            partition.boundaryVertices(below, subcell);
+                        int from = partition.boundaryPosition(below, vertex);
+
+                        for(std::size_t to = 0; to < subBoundary.size(); ++to)
+                        {
+                            int next = subBoundary[to];
+                            if(relax(next, cost(below, subcell, from, to)))
+                            {
+                                workspace.setMark(next, viaClique);
+                            }
+                        }
+                    }
+
+                    for(int edge = graph.edgesBegin(vertex); edge < graph.edgesEnd(vertex); ++edge)
+                    {
+                        int next = graph.target(edge);
+                        if(partition.cellOf(level, next) == cell &&
+                           partition.cellOf(below, next) != subcell)
+                        {
+                            relax(next, graph.weight(edge));
+                        }
+                    }
+                };
+
+                for(std::size_t from = 0; from < boundary.size(); ++from)
+                {
+                    if(level == 0)
+                    {
+                        MultilevelOverlayDetail::search(
+                            workspace, graph.vertexCount(), boundary[from], -1, expandGraph);
+                    }
+                    else
+                    {
+                        MultilevelOverlayDetail::search(
+                            workspace, graph.vertexCount(), boundary[from], -1, expandOverlay);
+                    }
+
+                    for(std::size_t to = 0; to < boundary.size(); ++to)
+                    {
+                        clique[from * boundary.size() + to] = workspace.distance(boundary[to]);
+                    }
+                }
+            });
+    }
+}
+
+
+inline std::size_t OverlayCosts::byteCount() const noexcept
+{
+    std::size_t bytes = 0;
+    for(unsigned int level = 0; level < cliques.size(); ++level)
+    {
+        bytes += offsets[level].size() * sizeof(std::size_t)
+            + cliques[level].size() * sizeof(double)
+            + boundarySizes[level].size() * sizeof(int);
+    }
+    return bytes;
+}
+
+
+inline double OverlayCosts::cost(int level, int cell, int from, int to) const
+{
+    return cliques[level][offsets[level][cell] +
+        static_cast<std::size_t>(from) * boundarySizes[level][cell] + to];
+}
+
+
+
+inline std::vector<int> findShortestPathOverlay(
+    const CompactDigraph<double>& graph, const CellPartition& partition,
+    const OverlayCosts& costs, int startIndex, int endIndex)
+{
+    SearchWorkspace<double> workspace;
+    SearchWorkspace<double> unpackWorkspace;
+    std::vector<int> path;
+    findShortestPathOverlay(
+        graph, partition, costs, startIndex, endIndex, workspace, unpackWorkspace, path);
+    return path;
+}
+
+
+inline void findShortestPathOverlay(
+    const CompactDigraph<double>& graph, const CellPartition& partition,
+    const OverlayCosts& costs, int startIndex, int endIndex,
+    SearchWorkspace<double>& workspace, SearchWorkspace<double>& unpackWorkspace,
+    std::vector<int>& path)
+{
+    //the level a vertex is searched on is one more than the coarsest
+    //level on which its cell holds neither the start nor the end vertex,
+    //or 0 (the graph itself) if there's no such level; cells are nested,
+    //so every finer level's cell holds neither one, either
+    auto searchLevel = [&](int vertex)
+    {
+        for(int level = partition.levelCount() - 1; level >= 0; --level)
+        {
+            int cell = partition.cellOf(level, vertex);
+            if(cell != partition.cellOf(level, startIndex) &&
+               cell != partition.cellOf(level, endIndex))
+            {
+                return level + 1;
+            }
+        }
+        return 0;
+    };
+
+    //each vertex's mark is one more than the level of the clique it was
+    //reached along, or 0 for an edge of the graph itself
+    MultilevelOverlayDetail::search(workspace, graph.vertexCount(), startIndex, endIndex,
+        [&](int vertex, auto relax)
+        {
+            int level = searchLevel(vertex);
+            if(level == 0)
+            {
+                for(int edge = graph.edgesBegin(vertex); edge < graph.edgesEnd(vertex); ++edge)
+                {
+                    relax(graph.target(edge), graph.weight(edge));
+                }
+                return;
+            }
+
+            //a vertex on level l > 0 is always a boundary vertex of its
+            //cell on level l - 1, since it was reached from outside it
+            int cliqueLevel = level - 1;
+            int cell = partition.cellOf(cliqueLevel, vertex);
+            const std::vector<int>& boundary = partition.boundaryVertices(cliqueLevel, cell);
+            int from = partition.boundaryPosition(cliqueLevel, vertex);
+
+            //having come along this cell's clique already, there's no
+            //shorter way across it from here
+            if(workspace.mark(vertex) != cliqueLevel + 1)
+            {
+                for(std::size_t to = 0; to < boundary.size(); ++to)
+                {
+                    int next = boundary[to];
+                    if(relax(next, costs.cost(cliqueLevel, cell, from, to)))
+                    {
+                        workspace.setMark(next, cliqueLevel + 1);
+                    }
+                }
+            }
+
+            for(int edge = graph.edgesBegin(vertex); edge < graph.edgesEnd(vertex); ++edge)
+            {
+                int next = graph.target(edge);
+                if(partition.cellOf(cliqueLevel, next) != cell)
+                {
+                    relax(next, graph.weight(edge));
+                }
+            }
+        });
+
+    path.clear();
+    if(!workspace.reached(endIndex))
+    {
+        return;
+    }
+
+    //walk back, expanding each clique edge with a search confined to its
+    //cell; the pieces come out backward and are reversed at the end
+    for(int current = endIndex; current != startIndex; )
+    {
+        int previous = workspace.predecessor(current);
+        int level = workspace.mark(current) - 1;
+
+        if(level == -1)
+        {
+            path.push_back(current);
+        }
+        else
+        {
+            int cell = partition.cellOf(level, previous);
+            MultilevelOverlayDetail::search(
+                unpackWorkspace, graph.vertexCount(), previous, current,
+                [&](int vertex, auto relax)
+                {
+                    for(int edge = graph.edgesBegin(vertex); edge < graph.edgesEnd(vertex); ++edge)
+                    {
+                        int next = graph.target(edge);
+                        if(partition.cellOf(level, next) == cell)
+                        {
+                            relax(next, graph.weight(edge));
+                        }
+                    }
+                });
+
+            for(int step = current; step != previous; step = unpackWorkspace.predecessor(step))
+            {
+                path.push_back(step);
+            }
+        }
+
+        current = previous;
+    }
+    path.push_back(startIndex);
+
+    std::reverse(path.begin(), path.end());
+}
+
+
+
+#endif // MULTILEVELOVERLAY_HPP
@@ -0,0 +1,106 @@
+// ParallelFor.hpp
+//
+// ICS 46 Winter 2019
+// Project #4: Rock and Roll Stops the Traffic
+//
+// parallelFor() runs a function once for every index in a range, handing
+// the indexes out to a fixed number of threads one at a time, so that a
+// thread finishing a cheap index early simply picks up the next one.
+
+#ifndef PARALLELFOR_HPP
+#define PARALLELFOR_HPP
+
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+
+// defaultThreadCount() returns the number of threads parallelFor() uses
+// when it isn't told otherwise: one per hardware thread.
+inline unsigned int defaultThreadCount()
+{
+    unsigned int count = std::thread::hardware_concurrency();
+    return count == 0 ? 1 : count;
+}
+
+
+// parallelFor() calls indexFunc(index, threadIndex) for every index in
+// [0, count), using up to threadCount threads (0 means use
+// defaultThreadCount()).  threadIndex is in [0, threadCount) and is the
+// same for every call made on one thread, so it can be used to pick out
+// per-thread scratch space.  If any call throws, the first exception is
+// rethrown once all of the threads have stopped.
+template <typename IndexFunc>
+void parallelFor(int count, unsigned int threadCount, IndexFunc indexFunc)
+{
+    if(threadCount == 0)
+    {
+        threadCount = defaultThreadCount();
+    }
+    if(count <= 0)
+    {
+        return;
+    }
+    if(threadCount > static_cast<unsigned int>(count))
+    {
+        threadCount = count;
+    }
+
+    if(threadCount == 1)
+    {
+        for(int index = 0; index < count; ++index)
+        {
+            indexFunc(index, 0u);
+        }
+        return;
+    }
+
+    std::atomic<int> nextIndex{0};
+    std::exception_ptr failure;
+    std::mutex failureMutex;
+
+    auto worker = [&](unsigned int threadIndex)
+    {
+        try
+        {
+            for(int index = nextIndex++; index < count; index = nextIndex++)
+            {
+                indexFunc(index, threadIndex);
+            }
+        }
+        catch(...)
+        {
+            std::lock_guard<std::mutex> lock{failureMutex};
+            if(!failure)
+            {
+                failure = std::current_exception();
+            }
+            //stop everyone else from picking up new work
+            nextIndex = count;
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for(unsigned int i = 1; i < threadCount; ++i)
+    {
+        threads.emplace_back(worker, i);
+    }
+    worker(0);
+
+    for(std::thread& thread : threads)
+    {
+        thread.join();
+    }
+
+    if(failure)
+    {
+        std::rethrow_exception(failure);
+    }
+}
+
+
+
+#endif // PARALLELFOR_HPP
@@ -0,0 +1,151 @@
+// RadixHeap.hpp
+//
+// ICS 46 Winter 2019
+// Project #4: Rock and Roll Stops the Traffic
+//
+// A RadixHeap is a priority queue for unsigned integer keys that only
+// works when the keys come out in non-decreasing order, which is exactly
+// how Dijkstra's algorithm uses its queue when edge weights are never
+// negative.  In exchange for that restriction, it never compares two keys
+// against each other: each entry sits in one of 65 buckets, chosen by the
+// highest bit in which its key differs from the last key removed, and an
+// entry moves to a lower bucket at most 64 times over its life.
+
+#ifndef RADIXHEAP_HPP
+#define RADIXHEAP_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+
+
+template <typename Value>
+class RadixHeap
+{
+public:
+    // empty() returns true if there are no entries in the heap.
+    bool empty() const noexcept;
+
+    // size() returns the number of entries in the heap.
+    std::size_t size() const noexcept;
+
+    // push() adds an entry with the given key and value.  The key must
+    // be no smaller than the key of the entry most recently popped.
+    void push(std::uint64_t key, const Value& value);
+
+    // pop() removes and returns an entry with the smallest key.  The heap
+    // must not be empty.
+    std::pair<std::uint64_t, Value> pop();
+
+    // clear() removes every entry, allowing keys to start over from 0.
+    void clear();
+
+
+private:
+    static int bucketFor(std::uint64_t key, std::uint64_t last);
+
+    std::vector<std::pair<std::uint64_t, Value>> buckets[65];
+    std::uint64_t last = 0;
+    std::size_t count = 0;
+};
+
+
+
+template <typename Value>
+bool RadixHeap<Value>::empty() const noexcept
+{
+    return count == 0;
+}
+
+
+template <typename Value>
+std::size_t RadixHeap<Value>::size() const noexcept
+{
+    return count;
+}
+
+
+template <typename Value>
+int RadixHeap<Value>::bucketFor(std::uint64_t key, std::uint64_t last)
+{
+    std::uint64_t difference = key ^ last;
+    if(difference == 0)
+    {
+        return 0;
+    }
+#ifdef __GNUC__
+    return 64 - __builtin_clzll(difference);
+#else
+    int bucket = 0;
+    while(difference != 0)
+    {
+        difference >>= 1;
+        ++bucket;
+    }
+    return bucket;
+#endif
+}
+
+
+template <typename Value>
+void RadixHeap<Value>::push(std::uint64_t key, const Value& value)
+{
+    buckets[bucketFor(key, last)].push_back({key, value});
+    ++count;
+}
+
+
+template <typename Value>
+std::pair<std::uint64_t, Value> RadixHeap<Value>::pop()
+{
+    if(buckets[0].empty())
+    {
+        //the lowest non-empty bucket holds the next smallest key; making
+        //that key the new "last" spreads the bucket out into lower ones
+        int bucket = 1;
+        while(buckets[bucket].empty())
+        {
+            ++bucket;
+        }
+
+        std::uint64_t smallest = std::numeric_limits<std::uint64_t>::max();
+        for(const std::pair<std::uint64_t, Value>& entry : buckets[bucket])
+        {
+            if(entry.first < smallest)
+            {
+                smallest = entry.first;
+            }
+        }
+
+        last = smallest;
+        for(const std::pair<std::uint64_t, Value>& entry : buckets[bucket])
+        {
+            buckets[bucketFor(entry.first, last)].push_back(entry);
+        }
+        buckets[bucket].clear();
+    }
+
+    std::pair<std::uint64_t, Value> entry = buckets[0].back();
+    buckets[0].pop_back();
+    --count;
+    return entry;
+}
+
+
+template <typename Value>
+void RadixHeap<Value>::clear()
+{
+    for(std::vector<std::pair<std::uint64_t, Value>>& bucket : buckets)
+    {
+        bucket.clear();
+    }
+    last = 0;
+    count = 0;
+}
+
+
+
+#endif // RADIXHEAP_HPP
@@ -0,0 +1,221 @@
+// SearchWorkspace.hpp
+//
+// ICS 46 Winter 2019
+// Project #4: Rock and Roll Stops the Traffic
+//
+// A SearchWorkspace holds the scratch space a shortest path search needs
+// -- a distance, a predecessor and a small "mark" for every vertex, plus
+// the search's priority queue -- so that it can be allocated once and
+// reused for query after query instead of being rebuilt for each one.
+//
+// Vertices are identified by "slots", which are dense indexes: a vertex
+// index in a CompactDigraph, or a slot in a Digraph (see slotOf() in
+// Digraph.hpp).  Rather than clearing every slot between searches, each
+// slot remembers the "generation" (i.e., the search) in which it was
+// last written, and a slot written in an earlier generation reads as
+// unreached; so starting a new search takes constant time no matter how
+// big the graph is.
+//
+// A SearchWorkspace isn't safe to share between threads; the usual
+// arrangement is for every thread that answers queries to own one.
+
+#ifndef SEARCHWORKSPACE_HPP
+#define SEARCHWORKSPACE_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <utility>
+#include <vector>
+#include "RadixHeap.hpp"
+
+
+
+template <typename Distance>
+class SearchWorkspace
+{
+public:
+    // Initializes a SearchWorkspace with room for the given number of
+    // slots.
+    explicit SearchWorkspace(int slotCount = 0);
+
+    // prepare() starts a new search over slots 0 through slotCount - 1,
+    // making room for them if there isn't enough already.  Every slot
+    // reads as unreached afterward, and the priority queues are empty.
+    void prepare(int slotCount);
+
+    // reached() returns true if the given slot has been reached in the
+    // current search.
+    bool reached(int slot) const;
+
+    // distance() returns the distance recorded for the given slot, or
+    // unreachedDistance() if it hasn't been reached.
+    Distance distance(int slot) const;
+
+    // predecessor() returns the predecessor recorded for the given slot,
+    // or -1 if it hasn't been reached.
+    int predecessor(int slot) const;
+
+    // mark() returns the mark recorded for the given slot, which is 0
+    // until setMark() changes it.  Searches use it for whatever extra
+    // per-vertex state they need (e.g., whether a vertex is settled).
+    int mark(int slot) const;
+
+    // reach() records a distance and predecessor for the given slot,
+    // resetting its mark to 0.
+    void reach(int slot, Distance distance, int predecessor);
+
+    // setMark() changes the mark of a slot that has been reached.
+    void setMark(int slot, int mark);
+
+    // push(), pop() and heapEmpty() operate on a binary min-heap of
+    // (distance, slot) pairs.
+    void push(Distance distance, int slot);
+    std::pair<Distance, int> pop();
+    bool heapEmpty() const noexcept;
+
+    // radixHeap() returns a RadixHeap for searches over integer
+    // distances, which is also emptied by prepare().
+    RadixHeap<int>& radixHeap() noexcept;
+
+    // unreachedDistance() is the distance of a slot that hasn't been
+    // reached: infinity if Distance has one, its largest value if not.
+    static Distance unreachedDistance() noexcept;
+
+
+private:
+    std::vector<Distance> distances;
+    std::vector<int> predecessors;
+    std::vector<int> marks;
+    std::vector<std::uint32_t> generations;
+    std::uint32_t generation;
+
+    std::vector<std::pair<Distance, int>> heap;
+    RadixHeap<int> radix;
+};
+
+
+
+template <typename Distance>
+SearchWorkspace<Distance>::SearchWorkspace(int slotCount)
+    : distances(slotCount), predecessors(slotCount), marks(slotCount),
+      generations(slotCount, 0), generation{0}
+{
+}
+
+
+template <typename Distance>
+void SearchWorkspace<Distance>::prepare(int slotCount)
+{
+    if(slotCount > static_cast<int>(generations.size()))
+    {
+        distances.resize(slotCount);
+        predecessors.resize(slotCount);
+        marks.resize(slotCount);
+        generations.resize(slotCount, 0);
+    }
+
+    //once in four billion searches, the generation wraps around and old
+    //stamps would look current again, so they're wiped for real
+    if(++generation == 0)
+    {
+        std::fill(generations.begin(), generations.end(), 0);
+        generation = 1;
+    }
+
+    heap.clear();
+    radix.clear();
+}
+
+
+template <typename Distance>
+bool SearchWorkspace<Distance>::reached(int slot) const
+{
+    return generations[slot] == generation;
+}
+
+
+template <typename Distance>
+Distance SearchWorkspace<Distance>::distance(int slot) const
+{
+    return reached(slot) ? distances[slot] : unreachedDistance();
+}
+
+
+template <typename Distance>
+int SearchWorkspace<Distance>::predecessor(int slot) const
+{
+    return reached(slot) ? predecessors[slot] : -1;
+}
+
+
+template <typename Distance>
+int SearchWorkspace<Distance>::mark(int slot) const
+{
+    return reached(slot) ? marks[slot] : 0;
+}
+
+
+template <typename Distance>
+void SearchWorkspace<Distance>::reach(int slot, Distance distance, int predecessor)
+{
+    generations[slot] = generation;
+    distances[slot] = distance;
+    predecessors[slot] = predecessor;
+    marks[slot] = 0;
+}
+
+
+template <typename Distance>
+void SearchWorkspace<Distance>::setMark(int slot, int mark)
+{
+    marks[slot] = mark;
+}
+
+
+template <typename Distance>
+void SearchWorkspace<Distance>::push(Distance distance, int slot)
+{
+    heap.push_back({distance, slot});
+    std::push_heap(heap.begin(), heap.end(), std::greater<std::pair<Distance, int>>{});
+}
+
+
+template <typename Distance>
+std::pair<Distance, int> SearchWorkspace<Distance>::pop()
+{
+    std::pop_heap(heap.begin(), heap.end(), std::greater<std::pair<Distance, int>>{});
+    std::pair<Distance, int> top = heap.back();
+    heap.pop_back();
+    return top;
+}
+
+
+template <typename Distance>
+bool SearchWorkspace<Distance>::heapEmpty() const noexcept
+{
+    return heap.empty();
+}
+
+
+template <typename Distance>
+RadixHeap<int>& SearchWorkspace<Distance>::radixHeap() noexcept
+{
+    return radix;
+}
+
+
+template <typename Distance>
+Distance SearchWorkspace<Distance>::unreachedDistance() noexcept
+{
+    if(std::numeric_limits<Distance>::has_infinity)
+    {
+        return std::numeric_limits<Distance>::infinity();
+    }
+    return std::numeric_limits<Distance>::max();
+}
+
+
+
+#endif // SEARCHWORKSPACE_HPP
@@ -0,0 +1,372 @@
+// ShortestPath.hpp
+//
+// ICS 46 Winter 2019
+// Project #4: Rock and Roll Stops the Traffic
+//
+// findShortestPath() answers a single point-to-point query over a
+// CompactDigraph using Dijkstra's algorithm, stopping as soon as the end
+// vertex is settled rather than finishing the whole shortest path tree.
+// It's the building block for answering one trip at a time, as opposed
+// to the batched searches used when many trips are known up front.
+//
+// findShortestPathRadix() does the same for snapshots whose weights are
+// unsigned integers (e.g., distances or times scaled up and rounded),
+// replacing the comparison-based heap with a RadixHeap.
+//
+// Both come in two forms: one that allocates everything it needs and
+// returns the path, and one that works in a caller's SearchWorkspace and
+// fills in a caller's vector, for callers answering queries in a loop.
+// findShortestPath() also has a form that routes around the closures in
+// a GraphOverlay.
+//
+// findShortestPathTree() runs the very same search as findShortestPath()
+// but without an end vertex, so it goes on until everything reachable is
+// settled; anything that stores whole trees (or answers many trips from
+// one start) uses it, so that its paths are the ones findShortestPath()
+// would find.
+//
+// findEarliestArrivalPath() searches a snapshot whose edges take
+// different amounts of time to follow depending on when they're entered,
+// such as roads whose speeds change through the day.
+
+#ifndef SHORTESTPATH_HPP
+#define SHORTESTPATH_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "CompactDigraph.hpp"
+#include "GraphOverlay.hpp"
+#include "RadixHeap.hpp"
+#include "SearchWorkspace.hpp"
+
+
+
+// findShortestPath() returns the vertex indexes along a shortest path
+// from the vertex with index startIndex to the vertex with index
+// endIndex, including both ends.  If the end vertex can't be reached, an
+// empty vector is returned instead.
+template <typename Weight>
+std::vector<int> findShortestPath(
+    const CompactDigraph<Weight>& graph, int startIndex, int endIndex);
+
+
+// This overload of findShortestPath() does its work in the given
+// workspace and stores the path into "path", reusing the memory both
+// already have, so that a caller answering many queries doesn't allocate
+// anything once they've grown big enough.
+template <typename Weight>
+void findShortestPath(
+    const CompactDigraph<Weight>& graph, int startIndex, int endIndex,
+    SearchWorkspace<Weight>& workspace, std::vector<int>& path);
+
+
+// This overload of findShortestPath() searches the graph as changed by the
+// given overlay: closed vertices and edges are never used, and edges with
+// new weights are weighed by them.  If the start or end vertex is closed,
+// the path is empty.
+template <typename Weight>
+void findShortestPath(
+    const CompactDigraph<Weight>& graph, const GraphOverlay<Weight>& overlay,
+    int startIndex, int endIndex,
+    SearchWorkspace<Weight>& workspace, std::vector<int>& path);
+
+
+// findShortestPathTree() runs Dijkstra's algorithm from the vertex with
+// index startIndex until every vertex reachable from it is settled,
+// leaving the results in the given workspace: for each vertex index v,
+// workspace.reached(v), workspace.distance(v) and workspace.predecessor(v)
+// (the start is its own predecessor).  Ties are broken just as
+// findShortestPath() breaks them, so the path to any vertex traced back
+// through the predecessors is the one findShortestPath() returns.
+template <typename Weight>
+void findShortestPathTree(
+    const CompactDigraph<Weight>& graph, int startIndex, SearchWorkspace<Weight>& workspace);
+
+
+// findShortestPathRadix() is the same as findShortestPath(), but only for
+// unsigned integer weights.  Path lengths are summed in 64 bits, so they
+// can't overflow even if the weights themselves are 32 bits.
+template <typename Weight>
+std::vector<int> findShortestPathRadix(
+    const CompactDigraph<Weight>& graph, int startIndex, int endIndex);
+
+template <typename Weight>
+void findShortestPathRadix(
+    const CompactDigraph<Weight>& graph, int startIndex, int endIndex,
+    SearchWorkspace<std::uint64_t>& workspace, std::vector<int>& path);
+
+
+
+// findEarliestArrivalPath() finds the path that reaches the vertex with
+// index endIndex soonest after leaving the one with index startIndex at
+// departureTime, where travelTime(weight, time) returns how long it takes
+// to follow an edge with the given Weight if it's entered at the given
+// time.  The result is only right if entering an edge later never means
+// leaving it sooner (which is true of any travel times that come from
+// driving at whatever the speed is at the moment), since that's what lets
+// Dijkstra's algorithm settle each vertex at its earliest arrival time.
+// An edge whose travel time is infinity is never followed.  The
+// workspace's distances are arrival times.
+template <typename Weight, typename TravelTimeFunc>
+void findEarliestArrivalPath(
+    const CompactDigraph<Weight>& graph, int startIndex, int endIndex,
+    double departureTime, TravelTimeFunc travelTime,
+    SearchWorkspace<double>& workspace, std::vector<int>& path);
+
+
+
+namespace ShortestPathDetail
+{
+    // tracePath() follows the predecessors recorded in a workspace back
+    // from endIndex to startIndex, storing the path in forward order into
+    // "path", or leaving it empty if endIndex was never reached.
+    template <typename Distance>
+    void tracePath(
+        const SearchWorkspace<Distance>& workspace, int startIndex, int endIndex,
+        std::vector<int>& path)
+    {
+        path.clear();
+        if(!workspace.reached(endIndex))
+        {
+            return;
+        }
+
+        for(int current = endIndex; current != startIndex; current = workspace.predecessor(current))
+        {
+            path.push_back(current);
+        }
+        path.push_back(startIndex);
+
+        std::reverse(path.begin(), path.end());
+    }
+
+
+    // settle() is Dijkstra's algorithm for findShortestPath() and
+    // findShortestPathTree(), which calls edgeWeight(edge, weight) to weigh
+    // each edge it follows; if that returns false, the edge is skipped.  It
+    // stops when the vertex with index endIndex is settled, or when
+    // everything reachable is if endIndex is -1.
+    template <typename Weight, typename EdgeWeightFunc>
+    void settle(
+        const CompactDigraph<Weight>& graph, int startIndex, int endIndex,
+        SearchWorkspace<Weight>& workspace, EdgeWeightFunc edgeWeight)
+    {
+        workspace.prepare(graph.vertexCount());
+        workspace.reach(startIndex, Weight{}, startIndex);
+        workspace.push(Weight{}, startIndex);
+
+        while(!workspace.heapEmpty())
+        {
+            std::pair<Weight, int> top = workspace.pop();
+
+            int current = top.second;
+            if(top.first > workspace.distance(current))
+            {
+                continue;
+            }
+            if(current == endIndex)
+            {
+                break;
+            }
+
+            for(int edge = graph.edgesBegin(current); edge < graph.edgesEnd(current); ++edge)
+            {
+                Weight weight;
+                if(!edgeWeight(edge, weight))
+                {
+                    continue;
+                }
+
+                int next = graph.target(edge);
+                Weight candidate = top.first + weight;
+
+                if(!workspace.reached(next) || candidate < workspace.distance(next))
+                {
+                    workspace.reach(next, candidate, current);
+                    workspace.push(candidate, next);
+                }
+            }
+        }
+    }
+
+
+    // search() settles the end vertex and traces the path to it.
+    template <typename Weight, typename EdgeWeightFunc>
+    void search(
+        const CompactDigraph<Weight>& graph, int startIndex, int endIndex,
+        SearchWorkspace<Weight>& workspace, std::vector<int>& path,
+        EdgeWeightFunc edgeWeight)
+    {
+        settle(graph, startIndex, endIndex, workspace, edgeWeight);
+        tracePath(workspace, startIndex, endIndex, path);
+    }
+
+
+    // plainWeight() weighs every edge by the weight the snapshot gives it.
+    template <typename Weight>
+    auto plainWeight(const CompactDigraph<Weight>& graph)
+    {
+        return [&graph](int edge, Weight& weight)
+        {
+            weight = graph.weight(edge);
+            return true;
+        };
+    }
+}
+
+
+
+template <typename Weight>
+std::vector<int> findShortestPath(
+    const CompactDigraph<Weight>& graph, int startIndex, int endIndex)
+{
+    SearchWorkspace<Weight> workspace{graph.vertexCount()};
+    std::vector<int> path;
+    findShortestPath(graph, startIndex, endIndex, workspace, path);
+    return path;
+}
+
+
+template <typename Weight>
+void findShortestPath(
+    const CompactDigraph<Weight>& graph, int startIndex, int endIndex,
+    SearchWorkspace<Weight>& workspace, std::vector<int>& path)
+{
+    ShortestPathDetail::search(graph, startIndex, endIndex, workspace, path,
+        ShortestPathDetail::plainWeight(graph));
+}
+
+
+template <typename Weight>
+void findShortestPath(
+    const CompactDigraph<Weight>& graph, const GraphOverlay<Weight>& overlay,
+    int startIndex, int endIndex,
+    SearchWorkspace<Weight>& workspace, std::vector<int>& path)
+{
+    if(overlay.vertexClosed(startIndex) || overlay.vertexClosed(endIndex))
+    {
+        path.clear();
+        return;
+    }
+
+    ShortestPathDetail::search(graph, startIndex, endIndex, workspace, path,
+        [&](int edge, Weight& weight)
+        {
+            return overlay.edgeWeight(graph, edge, weight);
+        });
+}
+
+
+template <typename Weight>
+void findShortestPathTree(
+    const CompactDigraph<Weight>& graph, int startIndex, SearchWorkspace<Weight>& workspace)
+{
+    ShortestPathDetail::settle(graph, startIndex, -1, workspace,
+        ShortestPathDetail::plainWeight(graph));
+}
+
+
+template <typename Weight>
+std::vector<int> findShortestPathRadix(
+    const CompactDigraph<Weight>& graph, int startIndex, int endIndex)
+{
+    SearchWorkspace<std::uint64_t> workspace{graph.vertexCount()};
+    std::vector<int> path;
+    findShortestPathRadix(graph, startIndex, endIndex, workspace, path);
+    return path;
+}
+
+
+template <typename Weight>
+void findShortestPathRadix(
+    const CompactDigraph<Weight>& graph, int startIndex, int endIndex,
+    SearchWorkspace<std::uint64_t>& workspace, std::vector<int>& path)
+{
+    static_assert(std::is_integral<Weight>::value && std::is_unsigned<Weight>::value,
+                  "findShortestPathRadix() needs unsigned integer weights");
+
+    RadixHeap<int>& heap = workspace.radixHeap();
+
+    workspace.prepare(graph.vertexCount());
+    workspace.reach(startIndex, 0, startIndex);
+    heap.push(0, startIndex);
+
+    while(!heap.empty())
+    {
+        std::pair<std::uint64_t, int> top = heap.pop();
+
+        int current = top.second;
+        if(top.first > workspace.distance(current))
+        {
+            continue;
+        }
+        if(current == endIndex)
+        {
+            break;
+        }
+
+        for(int edge = graph.edgesBegin(current); edge < graph.edgesEnd(current); ++edge)
+        {
+            int next = graph.target(edge);
+            std::uint64_t candidate = top.first + graph.weight(edge);
+
+            if(!workspace.reached(next) || candidate < workspace.distance(next))
+            {
+                workspace.reach(next, candidate, current);
+                heap.push(candidate, next);
+            }
+        }
+    }
+
+    ShortestPathDetail::tracePath(workspace, startIndex, endIndex, path);
+}
+
+
+
+template <typename Weight, typename TravelTimeFunc>
+void findEarliestArrivalPath(
+    const CompactDigraph<Weight>& graph, int startIndex, int endIndex,
+    double departureTime, TravelTimeFunc travelTime,
+    SearchWorkspace<double>& workspace, std::vector<int>& path)
+{
+    workspace.prepare(graph.vertexCount());
+    workspace.reach(startIndex, departureTime, startIndex);
+    workspace.push(departureTime, startIndex);
+
+    while(!workspace.heapEmpty())
+    {
+        std::pair<double, int> top = workspace.pop();
+
+        int current = top.second;
+        if(top.first > workspace.distance(current))
+        {
+            continue;
+        }
+        if(current == endIndex)
+        {
+            break;
+        }
+
+        for(int edge = graph.edgesBegin(current); edge < graph.edgesEnd(current); ++edge)
+        {
+            int next = graph.target(edge);
+            double candidate = top.first + travelTime(graph.weight(edge), top.first);
+
+            //an edge that takes forever (infinity) leads nowhere
+            if(candidate < workspace.distance(next))
+            {
+                workspace.reach(next, candidate, current);
+                workspace.push(candidate, next);
+            }
+        }
+    }
+
+    ShortestPathDetail::tracePath(workspace, startIndex, endIndex, path);
+}
+
+
+
+#endif // SHORTESTPATH_HPP
@@ -0,0 +1,114 @@
+// StringPool.hpp
+//
+// ICS 46 Winter 2019
+// Project #4: Rock and Roll Stops the Traffic
+//
+// A StringPool stores many small strings packed end to end in a few large
+// blocks of memory, handing back a std::string_view of each one.  Adding a
+// string costs a copy into the current block rather than an allocation of
+// its own, and the strings sit next to each other in memory rather than
+// scattered across the heap.
+//
+// Strings are never moved or freed once added, so every std::string_view
+// a StringPool hands out stays valid for as long as the pool does.  Many
+// threads may add strings at once.
+
+#ifndef STRINGPOOL_HPP
+#define STRINGPOOL_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+
+
+class StringPool
+{
+public:
+    // Initializes an empty StringPool that allocates memory in blocks of
+    // (at least) the given number of bytes.
+    explicit StringPool(std::size_t blockSize = 64 * 1024);
+
+    // A StringPool can't be copied, since that would invalidate the views
+    // handed out by the copy's original.  Share one instead.
+    StringPool(const StringPool&) = delete;
+    StringPool& operator=(const StringPool&) = delete;
+
+    // add() copies the given string into the pool, returning a view of
+    // the copy.
+    std::string_view add(std::string_view s);
+
+    // byteCount() returns the total length of the strings added so far.
+    std::size_t byteCount() const;
+
+    // allocatedBytes() returns the number of bytes the pool has allocated
+    // for its blocks, which includes the unused end of each block.
+    std::size_t allocatedBytes() const;
+
+
+private:
+    std::size_t blockSize;
+    std::vector<std::unique_ptr<char[]>> blocks;
+    std::size_t blockUsed;
+    std::size_t blockCapacity;
+    std::size_t totalBytes;
+    std::size_t allocated;
+    mutable std::mutex mutex;
+};
+
+
+
+inline StringPool::StringPool(std::size_t blockSize)
+    : blockSize{blockSize}, blockUsed{0}, blockCapacity{0}, totalBytes{0}, allocated{0}
+{
+}
+
+
+inline std::string_view StringPool::add(std::string_view s)
+{
+    if(s.empty())
+    {
+        return std::string_view{};
+    }
+
+    std::lock_guard<std::mutex> lock{mutex};
+
+    //a string too long for a block gets a block to itself
+    if(s.size() > blockCapacity - blockUsed)
+    {
+        blockCapacity = std::max(blockSize, s.size());
+        blocks.emplace_back(new char[blockCapacity]);
+        allocated += blockCapacity;
+        blockUsed = 0;
+    }
+
+    char* copy = blocks.back().get() + blockUsed;
+    std::memcpy(copy, s.data(), s.size());
+    blockUsed += s.size();
+    totalBytes += s.size();
+
+    return std::string_view{copy, s.size()};
+}
+
+
+inline std::size_t StringPool::byteCount() const
+{
+    std::lock_guard<std::mutex> lock{mutex};
+    return totalBytes;
+}
+
+
+inline std::size_t StringPool::allocatedBytes() const
+{
+    std::lock_guard<std::mutex> lock{mutex};
+    return allocated;
+}
+
+
+
+#endif // STRINGPOOL_HPP
+